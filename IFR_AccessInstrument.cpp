@@ -0,0 +1,536 @@
+#include <stddef.h>
+#include <vector>
+#include <string>
+
+#include "IFR_AccessInstrument.h"
+#include "IFR_RoutineAnalysis.h"
+#include "IFR_Clock.h"
+
+using std::vector;
+using std::string;
+
+/*Full buffers queued for the consumer beyond this are processed by the
+ *thread that filled them, so a slow consumer cannot run memory away
+ */
+#define IFR_MAX_QUEUED_BUFFERS 64
+
+class IFR_AccessCounts{
+
+public:
+
+  UINT64 accesses;
+  UINT64 writes;
+  UINT64 bytes;
+
+  IFR_AccessCounts(){
+    accesses = writes = bytes = 0;
+  }
+
+  void add(const IFR_AccessCounts &c){
+    accesses += c.accesses;
+    writes += c.writes;
+    bytes += c.bytes;
+  }
+
+};
+
+class IFR_OpenRange{
+
+public:
+
+  const IFR_StridedRef *strided;
+  ADDRINT start;
+  ADDRINT rest;
+
+};
+
+class IFR_ThreadAccesses{
+
+public:
+
+  vector<IFR_OpenRange> open;
+  IFR_AccessCounts counts;
+  UINT64 ranges;
+  UINT64 rangeAccesses;     //accesses the ranges stand for
+  UINT64 unmatched;         //exits without an open range, e.g. after a longjmp
+  UINT64 elided;            //executions of redundant references (IFR_ACCESS_COUNT_ELIDED)
+  UINT64 checks;            //coalesced group checks, with callbacks
+  UINT64 checkAccesses;     //accesses the checks stand for
+  UINT64 buffers;           //filled so far, numbering the thread's trace frames
+  IFR_TraceCoder *coder;    //when tracing
+  vector<unsigned char> frame;
+
+  IFR_ThreadAccesses(){
+    ranges = rangeAccesses = unmatched = elided = checks = checkAccesses = buffers = 0;
+    coder = 0;
+  }
+
+};
+
+class IFR_FullBuffer{
+
+public:
+
+  IFR_AccessRecord *records;
+  UINT64 count;
+  THREADID tid;
+  UINT64 seq;
+
+};
+
+static TLS_KEY accessKey;
+static PIN_LOCK accessLock;
+static vector<IFR_ThreadAccesses *> allThreads;
+static double startTime;
+
+static BUFFER_ID bufferId = BUFFER_ID_INVALID;
+static UINT64 buffersFilled = 0;
+static UINT64 buffersInline = 0;    //processed by the filling thread while a consumer ran
+
+/*Consumer thread state, all under queueLock*/
+static bool useConsumer = false;
+static PIN_MUTEX queueLock;
+static PIN_SEMAPHORE queueReady;
+static vector<IFR_FullBuffer> queued;
+static vector<VOID *> spare;
+static volatile bool stopping = false;
+static PIN_THREAD_UID consumerUid;
+static IFR_AccessCounts consumerCounts;
+static double consumerBusy = 0;
+static IFR_TraceCoder *consumerCoder = 0;
+static vector<unsigned char> consumerFrame;
+
+/*Coalesced groups instrumented so far, and the operands they stand for*/
+static UINT64 groupSites = 0;
+static UINT64 groupOperands = 0;
+
+/*Trace of every buffered access; null when not tracing*/
+static IFR_TraceWriter *trace = 0;
+static string tracePath;
+
+static inline IFR_ThreadAccesses *threadAccesses(THREADID tid){
+  return (IFR_ThreadAccesses *)PIN_GetThreadData(accessKey, tid);
+}
+
+/*The bulk consumer: one pass over a buffer of records*/
+static void consume(const IFR_AccessRecord *records, UINT64 count, IFR_AccessCounts &c){
+
+  UINT64 writes = 0, bytes = 0;
+  for( UINT64 i = 0; i < count; i++ ){
+    writes += records[i].write;
+    bytes += records[i].size;
+  }
+  c.accesses += count;
+  c.writes += writes;
+  c.bytes += bytes;
+
+}
+
+static VOID *bufferFull(BUFFER_ID id, THREADID tid, const CONTEXT *ctxt, VOID *buf, UINT64 count, VOID *v){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  __sync_fetch_and_add(&buffersFilled, 1);
+  UINT64 seq = t != 0 ? t->buffers++ : 0;
+
+  if( useConsumer && !stopping ){
+
+    IFR_FullBuffer full;
+    full.records = (IFR_AccessRecord *)buf;
+    full.count = count;
+    full.tid = tid;
+    full.seq = seq;
+    VOID *next = 0;
+    bool handed = false;
+
+    /*stopping is checked again under the lock: once the consumer has seen
+     *it, nothing may be queued behind its last swap
+     */
+    PIN_MutexLock(&queueLock);
+    if( !stopping && queued.size() < IFR_MAX_QUEUED_BUFFERS ){
+      queued.push_back(full);
+      handed = true;
+      if( !spare.empty() ){
+        next = spare.back();
+        spare.pop_back();
+      }
+    }
+    PIN_MutexUnlock(&queueLock);
+
+    if( handed ){
+      PIN_SemaphoreSet(&queueReady);
+      return next != 0 ? next : PIN_AllocateBuffer(id);
+    }
+    __sync_fetch_and_add(&buffersInline, 1);
+
+  }
+
+  if( t != 0 ){
+    consume((IFR_AccessRecord *)buf, count, t->counts);
+    if( trace != 0 ){ trace->writeFrame(*t->coder, tid, seq, (IFR_AccessRecord *)buf, count, t->frame); }
+  }
+  return buf;
+
+}
+
+static VOID consumerMain(VOID *arg){
+
+  for( ;; ){
+
+    PIN_SemaphoreWait(&queueReady);
+    PIN_MutexLock(&queueLock);
+    vector<IFR_FullBuffer> work;
+    work.swap(queued);
+    PIN_SemaphoreClear(&queueReady);
+    bool done = stopping;
+    PIN_MutexUnlock(&queueLock);
+
+    double start = IFR_Clock();
+    for( unsigned i = 0; i < work.size(); i++ ){
+      consume(work[i].records, work[i].count, consumerCounts);
+      if( trace != 0 ){
+        trace->writeFrame(*consumerCoder, work[i].tid, work[i].seq, work[i].records, work[i].count, consumerFrame);
+      }
+    }
+    consumerBusy += IFR_Clock() - start;
+
+    PIN_MutexLock(&queueLock);
+    for( unsigned i = 0; i < work.size(); i++ ){
+      spare.push_back(work[i].records);
+    }
+    PIN_MutexUnlock(&queueLock);
+
+    /*The swap that saw stopping took everything queued, and bufferFull
+     *queues nothing once stopping is set, so there is no more to wait for
+     */
+    if( done ){ return; }
+
+  }
+
+}
+
+void IFR_AccessesInit(UINT32 bufferPages, bool consumer, const char *path){
+
+  accessKey = PIN_CreateThreadDataKey(0);
+  PIN_InitLock(&accessLock);
+  startTime = IFR_Clock();
+  if( bufferPages == 0 ){ return; }
+
+  bufferId = PIN_DefineTraceBuffer(sizeof(IFR_AccessRecord), bufferPages, bufferFull, 0);
+  if( bufferId == BUFFER_ID_INVALID ){
+    fprintf(stderr,"IFR accesses: cannot define a %u page trace buffer, using callbacks\n",bufferPages);
+    return;
+  }
+
+  if( path != 0 && path[0] != 0 ){
+    trace = new IFR_TraceWriter();
+    tracePath = path;
+    if( !trace->open(path) ){
+      fprintf(stderr,"IFR accesses: cannot write a trace to %s\n",path);
+      delete trace;
+      trace = 0;
+    }
+    consumerCoder = new IFR_TraceCoder();
+  }
+
+  if( consumer ){
+    PIN_MutexInit(&queueLock);
+    PIN_SemaphoreInit(&queueReady);
+    useConsumer = PIN_SpawnInternalThread(consumerMain, 0, 0, &consumerUid) != INVALID_THREADID;
+    if( !useConsumer ){
+      fprintf(stderr,"IFR accesses: cannot start the consumer thread, consuming inline\n");
+    }
+  }
+
+}
+
+void IFR_AccessesStop(){
+
+  if( !useConsumer ){ return; }
+
+  /*Threads still running fill their own buffers from here on*/
+  PIN_MutexLock(&queueLock);
+  stopping = true;
+  PIN_MutexUnlock(&queueLock);
+  PIN_SemaphoreSet(&queueReady);
+  PIN_WaitForThreadTermination(consumerUid, PIN_INFINITE_TIMEOUT, 0);
+  useConsumer = false;
+
+}
+
+void IFR_AccessesThreadStart(THREADID tid){
+
+  IFR_ThreadAccesses *t = new IFR_ThreadAccesses();
+  if( trace != 0 ){ t->coder = new IFR_TraceCoder(); }
+  PIN_SetThreadData(accessKey, t, tid);
+  PIN_GetLock(&accessLock, tid + 1);
+  allThreads.push_back(t);
+  PIN_ReleaseLock(&accessLock);
+
+}
+
+void IFR_AccessesThreadFini(THREADID tid){
+  /*Counts stay in allThreads for Fini; Pin has flushed the thread's buffer*/
+  PIN_SetThreadData(accessKey, 0, tid);
+}
+
+VOID PIN_FAST_ANALYSIS_CALL Read(THREADID tid, ADDRINT ea, UINT32 size){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t == 0 ){ return; }
+  t->counts.accesses++;
+  t->counts.bytes += size;
+
+}
+
+VOID PIN_FAST_ANALYSIS_CALL Write(THREADID tid, ADDRINT ea, UINT32 size){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t == 0 ){ return; }
+  t->counts.accesses++;
+  t->counts.writes++;
+  t->counts.bytes += size;
+
+}
+
+/*One event for the members of a coalesced group, at the leader's address*/
+static VOID PIN_FAST_ANALYSIS_CALL groupCheck(THREADID tid, ADDRINT ea, const IFR_CoalesceGroup *g){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t == 0 ){ return; }
+  t->checks++;
+  t->checkAccesses += g->members;
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL elidedEvent(THREADID tid){
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t != 0 ){ t->elided++; }
+}
+
+/*address = coeff * (iv + offset) + rest*/
+static VOID PIN_FAST_ANALYSIS_CALL rangeEnter(THREADID tid, const IFR_StridedRef *sr, const IFR_MemoryRef *ref,
+                                               ADDRINT iv, ADDRINT baseValue, ADDRINT indexValue){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t == 0 ){ return; }
+
+  IFR_OpenRange r;
+  r.strided = sr;
+  r.rest = ref->displacement;
+  if( ref->base != IFR_MemoryRef::NoReg && ref->base != sr->reg ){ r.rest += baseValue; }
+  if( ref->index != IFR_MemoryRef::NoReg && ref->index != sr->reg ){ r.rest += indexValue * ref->scale; }
+  r.start = sr->coeff * (iv + sr->offset) + r.rest;
+  t->open.push_back(r);
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL rangeExit(THREADID tid, const IFR_StridedRef *sr, ADDRINT iv, ADDRINT exitOffset){
+
+  IFR_ThreadAccesses *t = threadAccesses(tid);
+  if( t == 0 ){ return; }
+
+  unsigned i = t->open.size();
+  while( i > 0 && t->open[i - 1].strided != sr ){ i--; }
+  if( i == 0 ){
+    t->unmatched++;
+    return;
+  }
+
+  /*The header value of the register in the last iteration*/
+  IFR_OpenRange &r = t->open[i - 1];
+  ADDRINT last = sr->coeff * (iv - exitOffset + sr->offset) + r.rest;
+  ADDRINT span = last > r.start ? last - r.start : r.start - last;
+  ADDRINT stride = sr->stride < 0 ? -sr->stride : sr->stride;
+  t->ranges++;
+  t->rangeAccesses += span / stride + 1;
+  t->open.erase(t->open.begin() + (i - 1));
+
+}
+
+void IFR_InstrumentAccesses(INS ins, const IFR_Analysis &a, unsigned insNum, UINT32 blockBase, unsigned mode){
+
+  bool ranges = (mode & IFR_ACCESS_RANGES) != 0;
+  bool elide = (mode & IFR_ACCESS_ELIDE) != 0;
+  bool coalesce = (mode & IFR_ACCESS_COALESCE) != 0;
+
+  unsigned b = a.cfg.blockOf(insNum);
+  unsigned numRefs = a.memrefs.end(insNum) - a.memrefs.begin(insNum);
+  for( UINT32 m = 0; m < INS_MemoryOperandCount(ins); m++ ){
+
+    unsigned k = IFR_MemRefOfOperand(ins, m);
+    if( ranges && k < numRefs && a.ranges.summarized( a.memrefs.begin(insNum) + k ) ){
+      continue;
+    }
+    if( elide && k < numRefs && a.redundant.redundant( a.memrefs.begin(insNum) + k ) ){
+      if( mode & IFR_ACCESS_COUNT_ELIDED ){
+        INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)elidedEvent, IARG_FAST_ANALYSIS_CALL,
+                                 IARG_THREAD_ID, IARG_END);
+      }
+      continue;
+    }
+
+    /*Members after the leader have no check of their own; a group never
+     *crosses a block, so the leader runs whenever they do
+     */
+    const IFR_CoalesceGroup *group = 0;
+    if( coalesce && k < numRefs ){
+      unsigned r = a.memrefs.begin(insNum) + k;
+      if( a.coalesce.covered(r) ){ continue; }
+      group = a.coalesce.leads(r);
+      if( group != 0 ){
+        groupSites++;
+        groupOperands += group->members;
+      }
+    }
+
+    bool write = group != 0 ? group->write : INS_MemoryOperandIsWritten(ins, m);
+    UINT32 size = group != 0 ? group->length : INS_MemoryOperandSize(ins, m);
+    if( bufferId != BUFFER_ID_INVALID ){
+
+      /*Operands we have no memref for are numbered past the block's refs*/
+      UINT32 ref = (k < numRefs ? a.memrefs.begin(insNum) + k : a.memrefs.end(insNum) + m) -
+                   a.memrefs.begin( a.cfg.insBegin(b) );
+      if( group != 0 ){
+        /*One record for the group, sized to cover it; not predicated, as
+         *it stands for every member
+         */
+        INS_InsertFillBuffer(ins, IPOINT_BEFORE, bufferId,
+                             IARG_MEMORYOP_EA, m, offsetof(IFR_AccessRecord, ea),
+                             IARG_UINT32, blockBase + b, offsetof(IFR_AccessRecord, block),
+                             IARG_UINT32, ref, offsetof(IFR_AccessRecord, ref),
+                             IARG_UINT32, size, offsetof(IFR_AccessRecord, size),
+                             IARG_UINT32, (UINT32)write, offsetof(IFR_AccessRecord, write),
+                             IARG_END);
+        continue;
+      }
+      INS_InsertFillBufferPredicated(ins, IPOINT_BEFORE, bufferId,
+                                     IARG_MEMORYOP_EA, m, offsetof(IFR_AccessRecord, ea),
+                                     IARG_UINT32, blockBase + b, offsetof(IFR_AccessRecord, block),
+                                     IARG_UINT32, ref, offsetof(IFR_AccessRecord, ref),
+                                     IARG_UINT32, size, offsetof(IFR_AccessRecord, size),
+                                     IARG_UINT32, (UINT32)write, offsetof(IFR_AccessRecord, write),
+                                     IARG_END);
+
+    }else if( group != 0 ){
+
+      INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)groupCheck,
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_MEMORYOP_EA, m,
+                     IARG_PTR, group,
+                     IARG_END);
+
+    }else{
+
+      INS_InsertPredicatedCall(ins, IPOINT_BEFORE, write ? (AFUNPTR)Write : (AFUNPTR)Read,
+                               IARG_FAST_ANALYSIS_CALL,
+                               IARG_THREAD_ID,
+                               IARG_MEMORYOP_EA, m,
+                               IARG_UINT32, size,
+                               IARG_END);
+
+    }
+
+  }
+
+  if( !ranges ){ return; }
+
+  for( unsigned e = a.ranges.edgeBegin(insNum); e < a.ranges.edgeEnd(insNum); e++ ){
+
+    const IFR_RangeEdge &edge = a.ranges.edges[e];
+    const IFR_StridedRef *sr = &a.ranges.refs[edge.strided];
+    const IFR_MemoryRef *ref = &a.memrefs.refs[sr->ref];
+    IPOINT where = edge.taken ? IPOINT_TAKEN_BRANCH : IPOINT_AFTER;
+    REG iv = (REG)sr->reg;
+
+    if( edge.exit ){
+      INS_InsertCall(ins, where, (AFUNPTR)rangeExit,
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_PTR, sr,
+                     IARG_REG_VALUE, iv,
+                     IARG_ADDRINT, (ADDRINT)edge.offset,
+                     IARG_END);
+    }else{
+      /*Absent address registers are ignored by rangeEnter; pass iv instead*/
+      REG base = ref->base != IFR_MemoryRef::NoReg ? (REG)ref->base : iv;
+      REG index = ref->index != IFR_MemoryRef::NoReg ? (REG)ref->index : iv;
+      INS_InsertCall(ins, where, (AFUNPTR)rangeEnter,
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_PTR, sr,
+                     IARG_PTR, ref,
+                     IARG_REG_VALUE, iv,
+                     IARG_REG_VALUE, base,
+                     IARG_REG_VALUE, index,
+                     IARG_END);
+    }
+
+  }
+
+}
+
+void IFR_TraceRoutine(const IFR_Analysis &a, UINT32 blockBase){
+
+  if( trace == 0 ){ return; }
+  vector<unsigned char> payload;
+  IFR_TraceDictionary::encode(a, blockBase, payload);
+  trace->write(TraceBlocks, payload);
+
+}
+
+void IFR_PrintAccessStats(FILE *out){
+
+  double elapsed = IFR_Clock() - startTime;
+  IFR_AccessCounts total = consumerCounts;
+  UINT64 ranges = 0, rangeAccesses = 0, unmatched = 0, elided = 0, checks = 0, checkAccesses = 0;
+  for( unsigned i = 0; i < allThreads.size(); i++ ){
+    total.add(allThreads[i]->counts);
+    ranges += allThreads[i]->ranges;
+    rangeAccesses += allThreads[i]->rangeAccesses;
+    unmatched += allThreads[i]->unmatched;
+    elided += allThreads[i]->elided;
+    checks += allThreads[i]->checks;
+    checkAccesses += allThreads[i]->checkAccesses;
+  }
+
+  fprintf(out,"IFR accesses: %llu access events (%llu writes, %llu bytes), %llu range events standing for %llu accesses",
+          (unsigned long long)total.accesses, (unsigned long long)total.writes, (unsigned long long)total.bytes,
+          (unsigned long long)ranges, (unsigned long long)rangeAccesses);
+  if( unmatched > 0 ){ fprintf(out,", %llu unmatched loop exits", (unsigned long long)unmatched); }
+  fprintf(out,"\n");
+  if( elided > 0 ){
+    fprintf(out,"IFR accesses: %llu events elided as redundant, %.1f%% fewer\n", (unsigned long long)elided,
+            100.0 * elided / (total.accesses + elided));
+  }
+
+  if( groupSites > 0 ){
+    fprintf(out,"IFR accesses: %llu operand checks coalesced into %llu group checks at instrumentation, %.1f%% fewer",
+            (unsigned long long)groupOperands, (unsigned long long)groupSites,
+            100.0 * (groupOperands - groupSites) / groupOperands);
+    if( checks > 0 ){
+      fprintf(out,"; %llu group checks ran for %llu accesses, %.1f%% fewer analysis calls",
+              (unsigned long long)checks, (unsigned long long)checkAccesses,
+              100.0 * (checkAccesses - checks) / (total.accesses + checkAccesses));
+    }
+    fprintf(out,"\n");
+  }
+
+  fprintf(out,"IFR accesses: %.3f s, %.2f M access events/s (%s)\n",
+          elapsed, elapsed > 0 ? total.accesses / elapsed / 1e6 : 0.0,
+          bufferId == BUFFER_ID_INVALID ? "callbacks" : "buffered");
+  if( bufferId != BUFFER_ID_INVALID ){
+    fprintf(out,"IFR accesses: %llu buffers filled, %llu accesses consumed on the consumer thread in %.3f ms, %llu buffers consumed inline while it was busy\n",
+            (unsigned long long)buffersFilled, (unsigned long long)consumerCounts.accesses,
+            consumerBusy * 1e3, (unsigned long long)buffersInline);
+  }
+
+  if( trace == 0 ){ return; }
+  trace->close();
+  fprintf(out,"IFR trace: %llu accesses in %llu frames, %llu bytes (%.2f per access) to %s%s\n",
+          (unsigned long long)trace->accesses, (unsigned long long)trace->frames,
+          (unsigned long long)trace->bytesOut,
+          trace->accesses > 0 ? (double)trace->bytesOut / trace->accesses : 0.0, tracePath.c_str(),
+          trace->failed ? ", with write errors" : "");
+
+}
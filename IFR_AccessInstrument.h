@@ -0,0 +1,67 @@
+#ifndef _IFR_ACCESSINSTRUMENT_H_
+#define _IFR_ACCESSINSTRUMENT_H_
+
+#include <stdio.h>
+#include <pin.H>
+
+#include "IFR_Analysis.h"
+#include "IFR_Trace.h"
+
+/*Runtime memory access events for analyzed routines.
+ *
+ *Every memory operand gets an event each time it executes, except
+ *
+ *  - the strided references IFR_LoopRanges summarized: those get one range
+ *    event per execution of their loop instead, opened on the loop's entry
+ *    edges and closed on its exit edges.  Open ranges are kept on a
+ *    per-thread stack, so a loop re-entered through recursion nests
+ *    properly.
+ *  - the references IFR_RedundantRefs found covered by a dominating
+ *    access to the same address, which get nothing (or, to measure what
+ *    that saves, only a count).
+ *  - the members of an IFR_Coalesce group, whose leader gets one range
+ *    check for all of them: a single event for up to a cache line.
+ *
+ *Access events are delivered one of two ways:
+ *
+ *  callbacks  an analysis call (Read or Write) per executed operand
+ *  buffered   Pin's trace buffers: each operand appends an IFR_AccessRecord
+ *             to a per-thread buffer with no call at all, and full buffers
+ *             are consumed in bulk, on the application thread or on an
+ *             internal consumer thread
+ *
+ *Events are counted, and summed at Fini with the rate they were
+ *delivered at.  Buffered events can also be written to a trace file
+ *(IFR_Trace.h), one frame per full buffer.
+ */
+
+/*bufferPages is the size of each thread's buffer in 4KB pages; 0 means
+ *per-access callbacks.  With consumer, full buffers are processed on an
+ *internal thread, which IFR_AccessesStop must end before Fini.  With a
+ *tracePath (and buffers), every buffer is also appended to that trace.
+ */
+void IFR_AccessesInit(UINT32 bufferPages, bool consumer, const char *tracePath);
+void IFR_AccessesStop();
+void IFR_AccessesThreadStart(THREADID tid);
+void IFR_AccessesThreadFini(THREADID tid);
+
+/*Modes of IFR_InstrumentAccesses*/
+#define IFR_ACCESS_RANGES       0x1   //summarize strided references (needs IFR_PASS_RANGES)
+#define IFR_ACCESS_ELIDE        0x2   //skip redundant references (needs IFR_PASS_REDUNDANT)
+#define IFR_ACCESS_COUNT_ELIDED 0x4   //count the events skipped references would have had
+#define IFR_ACCESS_COALESCE     0x8   //one check per coalesced group (needs IFR_PASS_COALESCE)
+
+/*Instruments ins, which is instruction insNum of the routine analysis a
+ *describes; a's blocks are numbered from blockBase in the records.
+ */
+void IFR_InstrumentAccesses(INS ins, const IFR_Analysis &a, unsigned insNum, UINT32 blockBase, unsigned mode);
+
+/*Describes the blocks of a, numbered from blockBase, in the trace; must
+ *come before any of them executes
+ */
+void IFR_TraceRoutine(const IFR_Analysis &a, UINT32 blockBase);
+
+/*Prints the counts and closes the trace*/
+void IFR_PrintAccessStats(FILE *out);
+
+#endif
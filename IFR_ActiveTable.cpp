@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "IFR_ActiveTable.h"
+#include "IFR_Threads.h"
+
+using std::vector;
+
+const unsigned IFR_ActiveTable::MaxThreads;
+
+/*Initial capacity of each stripe and of a thread's set*/
+#define IFR_STRIPE_SLOTS 16
+#define IFR_SET_SLOTS 64
+
+#define IFR_SPINS_BEFORE_YIELD 128
+
+/*Words touched by one access beyond this are not tracked (e.g. the tail
+ *of a rep movs of unknown length reported as one huge operand); nine
+ *covers a cache line at any alignment, as IFR_Coalesce groups may span
+ */
+#define IFR_MAX_ACCESS_WORDS 9
+
+IFR_ActiveTable::IFR_ActiveTable(){
+  stripes = 0;
+  stripeMemory = 0;
+  bits = 0;
+}
+
+IFR_ActiveTable::~IFR_ActiveTable(){
+
+  if( stripes == 0 ){ return; }
+  for( unsigned s = 0; s < numStripes(); s++ ){
+    delete [] stripes[s].slots;
+  }
+  free(stripeMemory);
+
+}
+
+void IFR_ActiveTable::init(unsigned stripeBits){
+
+  bits = stripeBits;
+
+  /*Each stripe on its own cache line*/
+  stripeMemory = malloc(numStripes() * sizeof(Stripe) + 64);
+  stripes = (Stripe *)( ((ADDRINT)stripeMemory + 63) & ~(ADDRINT)63 );
+  for( unsigned s = 0; s < numStripes(); s++ ){
+    stripes[s].lock = 0;
+    stripes[s].count = 0;
+    stripes[s].mask = IFR_STRIPE_SLOTS - 1;
+    stripes[s].slots = new Entry[IFR_STRIPE_SLOTS];
+    memset(stripes[s].slots, 0, IFR_STRIPE_SLOTS * sizeof(Entry));
+  }
+
+}
+
+void IFR_ActiveTable::lock(Stripe &s){
+
+  /*Test and test-and-set, yielding now and then in case the holder is
+   *descheduled (more threads than cores)
+   */
+  while( __sync_lock_test_and_set(&s.lock, 1) ){
+    for( unsigned spins = 1; s.lock; spins++ ){
+      __asm__ __volatile__("pause");
+      if( spins % IFR_SPINS_BEFORE_YIELD == 0 ){ IFR_Yield(); }
+    }
+  }
+
+}
+
+IFR_ActiveTable::Entry *IFR_ActiveTable::find(Stripe &s, ADDRINT word, UINT64 h, bool add){
+
+  if( add && 2 * (s.count + 1) > s.mask + 1 ){ grow(s); }
+
+  /*Slot from the bits above the stripe's*/
+  for( UINT32 i = (UINT32)(h >> (32 + bits)) & s.mask; ; i = (i + 1) & s.mask ){
+    Entry &e = s.slots[i];
+    if( e.word == word ){ return &e; }
+    if( e.word == 0 ){
+      if( !add ){ return 0; }
+      e.word = word;
+      e.readers = 0;
+      e.writers = 0;
+      s.count++;
+      return &e;
+    }
+  }
+
+}
+
+void IFR_ActiveTable::grow(Stripe &s){
+
+  Entry *old = s.slots;
+  UINT32 oldSize = s.mask + 1;
+  s.mask = 2 * oldSize - 1;
+  s.slots = new Entry[2 * oldSize];
+  memset(s.slots, 0, 2 * oldSize * sizeof(Entry));
+  s.count = 0;
+  for( UINT32 i = 0; i < oldSize; i++ ){
+    if( old[i].word == 0 ){ continue; }
+    Entry *e = find(s, old[i].word, hash(old[i].word), true);
+    *e = old[i];
+  }
+  delete [] old;
+
+}
+
+void IFR_ActiveTable::remove(Stripe &s, Entry *e){
+
+  /*Backward shift: move later entries of the run into the hole if their
+   *home slot is at or before it
+   */
+  UINT32 hole = e - s.slots;
+  for( UINT32 i = (hole + 1) & s.mask; s.slots[i].word != 0; i = (i + 1) & s.mask ){
+    UINT32 home = (UINT32)(hash(s.slots[i].word) >> (32 + bits)) & s.mask;
+    if( ((i - home) & s.mask) >= ((i - hole) & s.mask) ){
+      s.slots[hole] = s.slots[i];
+      hole = i;
+    }
+  }
+  s.slots[hole].word = 0;
+  s.count--;
+
+}
+
+bool IFR_ActiveTable::begin(ADDRINT word, unsigned thread, bool write, ADDRINT pc, IFR_Conflict &c){
+
+  UINT64 h = hash(word);
+  Stripe &s = stripes[ (UINT32)(h >> 32) & ((1u << bits) - 1) ];
+  UINT64 me = 1ULL << thread;
+
+  lock(s);
+  Entry *e = find(s, word, h, true);
+
+  bool conflict = false;
+  if( (e->writers & ~me) != 0 ){
+    conflict = true;
+    UINT64 others = e->writers & ~me;
+    bool latest = e->writer != thread && (others & (1ULL << e->writer)) != 0;
+    c.thread = latest ? e->writer : __builtin_ctzll(others);
+    c.pc = latest ? e->writerPC : 0;
+    c.write = true;
+  }else if( write && (e->readers & ~me) != 0 ){
+    conflict = true;
+    UINT64 others = e->readers & ~me;
+    bool latest = e->reader != thread && (others & (1ULL << e->reader)) != 0;
+    c.thread = latest ? e->reader : __builtin_ctzll(others);
+    c.pc = latest ? e->readerPC : 0;
+    c.write = false;
+  }
+
+  if( write ){
+    e->writers |= me;
+    e->writer = thread;
+    e->writerPC = pc;
+  }else{
+    e->readers |= me;
+    e->reader = thread;
+    e->readerPC = pc;
+  }
+  unlock(s);
+
+  c.word = word;
+  return conflict;
+
+}
+
+void IFR_ActiveTable::end(ADDRINT word, unsigned thread){
+
+  UINT64 h = hash(word);
+  Stripe &s = stripes[ (UINT32)(h >> 32) & ((1u << bits) - 1) ];
+
+  lock(s);
+  Entry *e = find(s, word, h, false);
+  if( e != 0 ){
+    e->readers &= ~(1ULL << thread);
+    e->writers &= ~(1ULL << thread);
+    if( e->readers == 0 && e->writers == 0 ){ remove(s, e); }
+  }
+  unlock(s);
+
+}
+
+IFR_ActiveSet::IFR_ActiveSet(){
+  slots.assign(IFR_SET_SLOTS, 0);
+  mask = IFR_SET_SLOTS - 1;
+  begun = regions = checks = conflicts = 0;
+}
+
+/*Slot holding word, or the free slot where it would go*/
+unsigned IFR_ActiveSet::slotOf(ADDRINT word) const{
+
+  unsigned i = (unsigned)(((UINT64)word * 0x9E3779B97F4A7C15ULL) >> 40) & mask;
+  while( slots[i] != 0 && words[ slots[i] - 1 ] != word ){
+    i = (i + 1) & mask;
+  }
+  return i;
+
+}
+
+void IFR_ActiveSet::grow(){
+
+  slots.assign(2 * slots.size(), 0);
+  mask = slots.size() - 1;
+  for( unsigned w = 0; w < words.size(); w++ ){
+    slots[ slotOf(words[w]) ] = w + 1;
+  }
+
+}
+
+bool IFR_ActiveSet::access(IFR_ActiveTable &table, unsigned thread, ADDRINT ea, UINT32 size, bool write,
+                           ADDRINT pc, IFR_Conflict &c){
+
+  if( thread >= IFR_ActiveTable::MaxThreads ){ return false; }
+
+  ADDRINT first = ea >> 3;
+  ADDRINT last = (ea + (size > 0 ? size : 1) - 1) >> 3;
+  if( last - first >= IFR_MAX_ACCESS_WORDS ){ last = first + IFR_MAX_ACCESS_WORDS - 1; }
+
+  bool conflict = false;
+  for( ADDRINT word = first; word <= last; word++ ){
+
+    unsigned i = slotOf(word);
+    if( slots[i] != 0 && (writes[ slots[i] - 1 ] || !write) ){ continue; }
+
+    IFR_Conflict found;
+    if( table.begin(word, thread, write, pc, found) ){
+      if( !conflict ){ c = found; }
+      conflict = true;
+      conflicts++;
+    }
+    begun++;
+
+    if( slots[i] != 0 ){
+      writes[ slots[i] - 1 ] = 1;
+      continue;
+    }
+    words.push_back(word);
+    writes.push_back(write);
+    slots[i] = words.size();
+    if( 2 * words.size() > slots.size() ){ grow(); }
+
+  }
+  return conflict;
+
+}
+
+void IFR_ActiveSet::endAll(IFR_ActiveTable &table, unsigned thread){
+
+  /*Newest first: a word's probe run only crosses older words' slots, so
+   *it is still intact when the word is removed
+   */
+  if( words.empty() ){ return; }
+  for( unsigned w = words.size(); w-- > 0; ){
+    table.end(words[w], thread);
+    slots[ slotOf(words[w]) ] = 0;
+  }
+  words.clear();
+  writes.clear();
+  regions++;
+
+}
@@ -0,0 +1,134 @@
+#ifndef _IFR_ACTIVETABLE_H_
+#define _IFR_ACTIVETABLE_H_
+
+#include <vector>
+#include "IFR_Types.h"
+
+/*Interference-free regions (IFRs, Effinger-Dean et al., "IFRit:
+ *Interference-Free Regions for Dynamic Data-Race Detection", OOPSLA
+ *2012).  An access starts an IFR on its address that lasts until the
+ *thread's next region boundary (a call, return or synchronizing
+ *instruction).  Two threads' IFRs on the same address that overlap in
+ *time, at least one of them writing, are a data race.
+ *
+ *Addresses are tracked in 8 byte words.  Thread ids index 64 bit reader
+ *and writer masks, so only threads 0..MaxThreads-1 can be checked.
+ */
+
+/*The other side of a race found by IFR_ActiveTable::begin*/
+class IFR_Conflict{
+
+public:
+
+  ADDRINT word;
+  unsigned thread;
+  ADDRINT pc;         //an access of the other thread's IFR, 0 if not known
+  bool write;         //whether that IFR writes
+
+};
+
+/*Every thread's active IFRs, by word.
+ *
+ *The table is split into 2^stripeBits stripes by a hash of the word, each
+ *an open addressed table (linear probing, deletion by backward shift)
+ *behind its own spinlock on its own cache line.  Threads only meet when
+ *their words hash to the same stripe, so there is no global lock; with
+ *stripeBits 0 the table degenerates to one, for comparison.  A word's
+ *entry exists only while some IFR on it is active, so each stripe stays
+ *small.
+ */
+class IFR_ActiveTable{
+
+  class Entry{
+  public:
+    ADDRINT word;         //0: free (word 0 is never mapped)
+    UINT64 readers;       //thread bits
+    UINT64 writers;       //thread bits; more than one only once they race
+    UINT32 writer;        //the latest writer
+    ADDRINT writerPC;
+    UINT32 reader;        //the latest reader
+    ADDRINT readerPC;
+  };
+
+  class Stripe{
+  public:
+    Entry *slots;
+    volatile UINT32 lock;
+    UINT32 count;
+    UINT32 mask;          //capacity - 1
+    char pad[64 - sizeof(Entry *) - 3 * sizeof(UINT32)];
+  };
+
+  Stripe *stripes;
+  void *stripeMemory;
+  unsigned bits;
+
+  static UINT64 hash(ADDRINT word) { return (UINT64)word * 0x9E3779B97F4A7C15ULL; }
+
+  void lock(Stripe &s);
+  void unlock(Stripe &s) { __sync_lock_release(&s.lock); }
+  Entry *find(Stripe &s, ADDRINT word, UINT64 h, bool add);
+  void grow(Stripe &s);
+  void remove(Stripe &s, Entry *e);
+
+  IFR_ActiveTable(const IFR_ActiveTable &);
+  IFR_ActiveTable &operator=(const IFR_ActiveTable &);
+
+public:
+
+  static const unsigned MaxThreads = 64;
+
+  IFR_ActiveTable();
+  ~IFR_ActiveTable();
+
+  void init(unsigned stripeBits);
+  unsigned numStripes() const { return 1u << bits; }
+
+  /*Starts an IFR of thread on word, reading or writing (a write upgrades
+   *the thread's read IFR).  Returns true and fills c if another thread has
+   *a conflicting IFR active; the new one is added either way.
+   */
+  bool begin(ADDRINT word, unsigned thread, bool write, ADDRINT pc, IFR_Conflict &c);
+
+  /*Ends thread's IFR on word, reading or writing*/
+  void end(ADDRINT word, unsigned thread);
+
+};
+
+/*One thread's active IFRs: a small hash set of words it holds and how,
+ *cleared at each region boundary.  Not thread safe; each thread owns one.
+ */
+class IFR_ActiveSet{
+
+  std::vector<ADDRINT> words;
+  std::vector<unsigned char> writes;  //per word
+  std::vector<unsigned> slots;        //index into words + 1, 0 if free
+  unsigned mask;
+
+  unsigned slotOf(ADDRINT word) const;
+  void grow();
+
+public:
+
+  UINT64 begun;         //IFRs started in the table
+  UINT64 regions;       //boundaries that ended at least one IFR
+  UINT64 checks;        //instrumented boundaries reached, active or not
+  UINT64 conflicts;
+
+  IFR_ActiveSet();
+
+  /*An access of size bytes at ea by this thread (id thread), at pc.
+   *Starts IFRs on the words it touches that the thread does not already
+   *hold well enough.  Returns true and fills c on a conflict.
+   */
+  bool access(IFR_ActiveTable &table, unsigned thread, ADDRINT ea, UINT32 size, bool write,
+              ADDRINT pc, IFR_Conflict &c);
+
+  /*A region boundary: ends every active IFR*/
+  void endAll(IFR_ActiveTable &table, unsigned thread);
+
+  unsigned size() const { return words.size(); }
+
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include <assert.h>
+#include <algorithm>
+
+#include "IFR_Analysis.h"
+#include "IFR_Serialize.h"
+#include "IFR_Stats.h"
+
+unsigned IFR_Analysis::dependencies(unsigned pass){
+
+  switch( pass ){
+    case IFR_PASS_CFG:      return IFR_PASS_CODE;
+    case IFR_PASS_BLOCKS:   return IFR_PASS_CODE | IFR_PASS_CFG;
+    case IFR_PASS_DOMTREE:  return IFR_PASS_CFG;
+    case IFR_PASS_DF:       return IFR_PASS_CFG | IFR_PASS_DOMTREE;
+    case IFR_PASS_SSA:      return IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_DOMTREE | IFR_PASS_DF;
+    case IFR_PASS_LOOPS:    return IFR_PASS_CFG;
+    case IFR_PASS_RANGES:   return IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_DOMTREE | IFR_PASS_SSA |
+                                   IFR_PASS_LOOPS;
+    case IFR_PASS_REDUNDANT: return IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_DOMTREE | IFR_PASS_SSA;
+    case IFR_PASS_REGIONS:  return IFR_PASS_CODE | IFR_PASS_CFG;
+    case IFR_PASS_LIVENESS: return IFR_PASS_CODE | IFR_PASS_CFG;
+    case IFR_PASS_COALESCE: return IFR_PASS_CODE | IFR_PASS_CFG;
+    case IFR_PASS_POSTDOM:  return IFR_PASS_CODE | IFR_PASS_CFG;
+    case IFR_PASS_HOISTENDS: return IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_DOMTREE | IFR_PASS_LOOPS |
+                                    IFR_PASS_REGIONS | IFR_PASS_POSTDOM;
+    case IFR_PASS_PATHS:    return IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_LOOPS;
+    default:                return 0;
+  }
+
+}
+
+IFR_Analysis::IFR_Analysis(ADDRINT rtnAddress, ADDRINT imageBase, IFR_AnalysisCache *c, IFR_DomAlgorithm alg){
+
+  address = rtnAddress;
+  imgBase = imageBase;
+  cache = c;
+  domAlg = alg;
+  done = 0;
+  cacheTried = false;
+  cacheHit = false;
+  unsaved = false;
+  unnarrowed = 0;
+  acrossPureCalls = true;
+  coalesceAround = 0;
+  profile = 0;
+
+}
+
+IFR_Analysis::~IFR_Analysis(){
+  delete profile;
+  delete unnarrowed;
+}
+
+void IFR_Analysis::enableProfile(){
+  if( profile == 0 ){ profile = new IFR_RoutineProfile(); }
+}
+
+/*Charges pass 1 << p with time and the heap its results hold*/
+void IFR_Analysis::record(unsigned p, double time){
+
+  size_t bytes = 0;
+  switch( 1u << p ){
+    case IFR_PASS_CODE:      bytes = code.bytes() + memrefs.bytes() + regOps.bytes(); break;
+    case IFR_PASS_CFG:       bytes = cfg.bytes(); break;
+    case IFR_PASS_DOMTREE:   bytes = domTree.bytes(); break;
+    case IFR_PASS_DF:        bytes = df.bytes(); break;
+    case IFR_PASS_SSA:       bytes = ssa.bytes(); break;
+    case IFR_PASS_LOOPS:     bytes = loops.bytes(); break;
+    case IFR_PASS_RANGES:    bytes = ranges.bytes(); break;
+    case IFR_PASS_REDUNDANT: bytes = redundant.bytes(); break;
+    case IFR_PASS_REGIONS:   bytes = regions.bytes(); break;
+    case IFR_PASS_LIVENESS:  bytes = liveness.bytes(); break;
+    case IFR_PASS_COALESCE:  bytes = coalesce.bytes(); break;
+    case IFR_PASS_POSTDOM:   bytes = postDom.bytes(); break;
+    case IFR_PASS_PATHS:     bytes = paths.bytes(); break;
+  }
+  profile->passTime[p] += time;
+  profile->passBytes[p] = bytes;
+  profile->ran |= 1u << p;
+
+}
+
+void IFR_Analysis::codeReady(){
+  done |= IFR_PASS_CODE;
+}
+
+unsigned IFR_Analysis::applyCallSummaries(const IFR_CallGraph &cg, const IFR_CallABI &abi){
+
+  assert( has(IFR_PASS_CODE) && !has(IFR_PASS_SSA) );
+
+  if( cache != 0 && !cacheHit && unnarrowed == 0 ){ unnarrowed = new IFR_RegOps(regOps); }
+  std::vector<unsigned char> drop(regOps.defs.size(), 0);
+  unsigned narrowed = 0;
+  for( unsigned i = 0; i < code.ins.size(); i++ ){
+
+    if( code.ins[i].kind != InsCall ){ continue; }
+    const IFR_RoutineSummary *s = cg.summaryAt(code.ins[i].target);
+    if( s == 0 || !s->known ){ continue; }
+
+    for( unsigned d = regOps.defStart[i]; d < regOps.defStart[i + 1]; d++ ){
+      unsigned reg = regOps.regName(regOps.defs[d]);
+      if( std::binary_search(abi.callerSaved.begin(), abi.callerSaved.end(), reg) &&
+          !std::binary_search(s->clobbers.begin(), s->clobbers.end(), reg) ){
+        drop[d] = 1;
+      }
+    }
+    if( !s->touchesMemory && !s->syncs ){ regOps.memFlags[i] |= IFR_INS_PURECALL; }
+    narrowed++;
+
+  }
+  regOps.dropDefs(drop);
+  return narrowed;
+
+}
+
+unsigned IFR_Analysis::closure(unsigned passes) const{
+
+  /*Dependencies have lower bits, so one sweep from the top closes the set*/
+  unsigned want = passes & ~done;
+  if( want & IFR_PASS_COALESCE ){ want |= coalesceAround & ~done; }
+  for( int p = IFR_NUM_PASSES - 1; p >= 0; p-- ){
+    if( want & (1u << p) ){ want |= dependencies(1u << p) & ~done; }
+  }
+  return want;
+
+}
+
+void IFR_Analysis::tryCache(){
+
+  if( cache == 0 || cacheTried ){ return; }
+  cacheTried = true;
+  double start = profile ? IFR_Clock() : 0;
+  cacheHit = loadCached();
+  if( profile ){ profile->cacheTime += IFR_Clock() - start; }
+  if( cacheHit ){ done |= IFR_PASS_CACHED; }
+
+}
+
+void IFR_Analysis::runFrontEnd(unsigned){
+  assert( !"no front end to run this pass" );
+}
+
+void IFR_Analysis::run(unsigned want){
+
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+
+    unsigned pass = 1u << p;
+    if( (want & pass) == 0 ){ continue; }
+    double start = profile ? IFR_Clock() : 0;
+
+    switch( pass ){
+
+      case IFR_PASS_BLOCKS:
+      case IFR_PASS_CODE:
+        runFrontEnd(pass);
+        break;
+
+      case IFR_PASS_CFG:
+        code.buildCFG(cfg);
+        break;
+
+      case IFR_PASS_DOMTREE: {
+        /*All dominance queries for this routine go through domTree*/
+        IFR_Dominators doms = IFR_Dominators();
+        doms.compute(cfg, domAlg);
+        domTree.build(doms);
+        if( profile ){ profile->domIterations = doms.iterations(); }
+        break;
+      }
+
+      case IFR_PASS_DF:
+        df.compute(cfg, domTree);
+        break;
+
+      case IFR_PASS_SSA:
+        ssa.build(cfg, domTree, df, regOps);
+        break;
+
+      case IFR_PASS_LOOPS:
+        loops.compute(cfg);
+        break;
+
+      case IFR_PASS_RANGES:
+        ranges.compute(code, cfg, domTree, memrefs, regOps, ssa, loops);
+        break;
+
+      case IFR_PASS_REDUNDANT:
+        redundant.compute(code, cfg, domTree, memrefs, regOps, ssa, acrossPureCalls);
+        break;
+
+      case IFR_PASS_REGIONS:
+        regions.compute(code, cfg, memrefs, regOps);
+        break;
+
+      case IFR_PASS_LIVENESS:
+        liveness.compute(code, cfg, regOps);
+        break;
+
+      case IFR_PASS_COALESCE:
+        coalesce.compute(code, cfg, memrefs, regOps,
+                         (coalesceAround & IFR_PASS_RANGES) ? &ranges : 0,
+                         (coalesceAround & IFR_PASS_REDUNDANT) ? &redundant : 0);
+        break;
+
+      case IFR_PASS_POSTDOM:
+        postDom.compute(code, cfg, domAlg);
+        break;
+
+      case IFR_PASS_HOISTENDS:
+        regions.hoistEnds(code, cfg, memrefs, regOps, domTree, postDom, loops);
+        break;
+
+      case IFR_PASS_PATHS:
+        paths.compute(code, cfg, loops);
+        break;
+
+    }
+    done |= pass;
+    if( profile ){ record(p, IFR_Clock() - start); }
+
+  }
+  if( want & IFR_PASS_CACHED ){ unsaved = true; }
+
+}
+
+void IFR_Analysis::compute(unsigned passes){
+
+  unsigned want = closure(passes);
+  assert( (want & IFR_PASS_FRONTEND) == 0 );
+  run(want);
+
+}
+
+void IFR_Analysis::require(unsigned passes){
+
+  if( cache != 0 && (passes & IFR_PASS_CACHED) != 0 ){
+    passes |= IFR_PASS_CACHED;
+    tryCache();
+  }
+
+  run( closure(passes) );
+
+  if( cache != 0 && !cacheHit && unsaved && has(IFR_PASS_CACHED) ){
+    saveCached();
+    unsaved = false;
+  }
+
+}
+
+/*Addresses are stored relative to the image base, which may differ
+ *between runs.
+ */
+bool IFR_Analysis::loadCached(){
+
+  const unsigned char *blob;
+  size_t blobSize;
+  if( !cache->lookup(address - imgBase, blob, blobSize) ){ return false; }
+
+  IFR_BlobReader r(blob, blobSize);
+  return code.load(r, imgBase) && cfg.load(r, imgBase) && domTree.load(r) && df.load(r) &&
+         memrefs.load(r) && regOps.load(r) &&
+         code.ins.size() == cfg.numIns() && domTree.size() == cfg.size() && df.size() == cfg.size() &&
+         memrefs.refStart.size() == cfg.numIns() + 1 && regOps.numIns() == cfg.numIns();
+
+}
+
+void IFR_Analysis::saveCached(){
+
+  IFR_BlobWriter w;
+  code.save(w, imgBase);
+  cfg.save(w, imgBase);
+  domTree.save(w);
+  df.save(w);
+  memrefs.save(w);
+  (unnarrowed != 0 ? *unnarrowed : regOps).save(w);
+  cache->insert(address - imgBase, w.bytes);
+  delete unnarrowed;
+  unnarrowed = 0;
+
+}
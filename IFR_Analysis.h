@@ -0,0 +1,169 @@
+#ifndef _IFR_ANALYSIS_H_
+#define _IFR_ANALYSIS_H_
+
+#include <vector>
+
+#include "IFR_Types.h"
+#include "IFR_InsRecord.h"
+#include "IFR_MemoryRef.h"
+#include "IFR_CFG.h"
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+#include "IFR_SSA.h"
+#include "IFR_Loops.h"
+#include "IFR_LoopRanges.h"
+#include "IFR_RedundantRefs.h"
+#include "IFR_Regions.h"
+#include "IFR_Liveness.h"
+#include "IFR_Coalesce.h"
+#include "IFR_PostDom.h"
+#include "IFR_PathProfile.h"
+#include "IFR_AnalysisCache.h"
+#include "IFR_CallGraph.h"
+
+class IFR_RoutineProfile;
+
+/*Analysis passes, as bits so a set of them fits in one word.  A pass only
+ *depends on passes with lower bits (see IFR_Analysis::dependencies).
+ */
+#define IFR_PASS_CODE     0x01   //instruction records, memrefs and regOps
+#define IFR_PASS_CFG      0x02
+#define IFR_PASS_BLOCKS   0x04   //front end's own view of the blocks (Pin: INS handles)
+#define IFR_PASS_DOMTREE  0x08
+#define IFR_PASS_DF       0x10
+#define IFR_PASS_SSA      0x20
+#define IFR_PASS_LOOPS    0x40
+#define IFR_PASS_RANGES   0x80   //strided references summarized per loop
+#define IFR_PASS_REDUNDANT 0x100 //memrefs covered by a dominating access
+#define IFR_PASS_REGIONS  0x200  //IFR boundaries for the IFRit runtime
+#define IFR_PASS_LIVENESS 0x400  //live registers at each instruction
+#define IFR_PASS_COALESCE 0x800  //memrefs of a block checked as one range
+#define IFR_PASS_POSTDOM  0x1000 //post-dominator tree and control dependences
+#define IFR_PASS_HOISTENDS 0x2000 //region ends moved out of loops (rewrites regions)
+#define IFR_PASS_PATHS    0x4000 //Ball-Larus path numbering and counter placement
+#define IFR_NUM_PASSES    15
+
+/*The passes that read instructions, supplied by the front end*/
+#define IFR_PASS_FRONTEND (IFR_PASS_BLOCKS | IFR_PASS_CODE)
+
+/*The passes whose results IFR_AnalysisCache stores*/
+#define IFR_PASS_CACHED (IFR_PASS_CODE | IFR_PASS_CFG | IFR_PASS_DOMTREE | IFR_PASS_DF)
+
+/*Analysis results of one routine, computed on demand.
+ *
+ *This is the decoder-independent core: a front end (the Pin tool, or the
+ *offline ELF driver) fills in the instruction records, memrefs and
+ *register operands, either ahead of time followed by codeReady(), or
+ *when asked through runFrontEnd().
+ *
+ *require() runs the requested passes and everything they depend on, each
+ *at most once.  With a cache, the first request for any cached pass
+ *either loads all of them from the routine's blob or computes all of them
+ *and stores a new blob, so every stored blob is complete.
+ *
+ *compute() runs only the core passes and touches nothing but this
+ *object, so routines can be computed on different threads.  A blob for
+ *work done by compute() is stored by a later require(), since the cache
+ *is not thread safe.
+ */
+class IFR_Analysis{
+
+protected:
+
+  ADDRINT address;
+  ADDRINT imgBase;
+  IFR_AnalysisCache *cache;
+  IFR_DomAlgorithm domAlg;
+
+  unsigned done;
+  bool cacheTried;
+  bool cacheHit;
+  bool unsaved;
+
+  /*regOps as the front end left them, before applyCallSummaries narrowed
+   *them: what the cache gets, so runs without call summaries never load
+   *narrowed calls.  Null unless narrowed calls are still to be saved.
+   */
+  IFR_RegOps *unnarrowed;
+
+  unsigned closure(unsigned passes) const;
+  void run(unsigned want);
+  void tryCache();
+  bool loadCached();
+  void saveCached();
+  void record(unsigned p, double time);
+
+  /*Runs one of IFR_PASS_FRONTEND*/
+  virtual void runFrontEnd(unsigned pass);
+
+private:
+
+  IFR_Analysis(const IFR_Analysis &);
+  IFR_Analysis &operator=(const IFR_Analysis &);
+
+public:
+
+  IFR_RoutineCode code;
+  IFR_MemRefTable memrefs;
+  IFR_RegOps regOps;
+  IFR_CFG cfg;
+  IFR_DomTree domTree;
+  IFR_DomFrontiers df;
+  IFR_SSA ssa;
+  IFR_LoopForest loops;
+  IFR_LoopRanges ranges;
+  IFR_RedundantRefs redundant;
+  IFR_Regions regions;
+  IFR_Liveness liveness;
+  IFR_Coalesce coalesce;
+  IFR_PostDom postDom;
+  IFR_PathProfile paths;
+
+  /*Whether redundant reference elimination may see past calls marked
+   *IFR_INS_PURECALL; not when references must stay in one IFR, since
+   *every call ends the caller's IFRs
+   */
+  bool acrossPureCalls;
+
+  /*IFR_PASS_RANGES and IFR_PASS_REDUNDANT, or neither: passes whose
+   *references the instrumentation handles its own way, so IFR_PASS_COALESCE
+   *runs them first and leaves those references out of its groups
+   */
+  unsigned coalesceAround;
+
+  /*Per-pass times and result sizes (IFR_Stats.h), recorded only once
+   *enableProfile() has been called; null otherwise
+   */
+  IFR_RoutineProfile *profile;
+
+  /*cache may be null; addresses are cached relative to imageBase*/
+  IFR_Analysis(ADDRINT rtnAddress, ADDRINT imageBase, IFR_AnalysisCache *c, IFR_DomAlgorithm alg);
+  virtual ~IFR_Analysis();
+
+  /*The front end has filled in code, memrefs and regOps*/
+  void codeReady();
+
+  void enableProfile();
+
+  /*Narrows this routine's calls to the callees' summaries in cg: calls
+   *no longer def the caller-saved registers the callee leaves alone, and
+   *are marked IFR_INS_PURECALL if it neither synchronizes nor touches
+   *non-stack memory.  Needs IFR_PASS_CODE, and must come before
+   *IFR_PASS_SSA.  Returns the number of calls narrowed.  The cache
+   *still gets the calls as they were.
+   */
+  unsigned applyCallSummaries(const IFR_CallGraph &cg, const IFR_CallABI &abi);
+
+  void require(unsigned passes);
+  void compute(unsigned passes);     //passes other than IFR_PASS_FRONTEND
+  bool has(unsigned passes) const { return (done & passes) == passes; }
+  bool fromCache() const { return cacheHit; }
+  ADDRINT entry() const { return address; }
+
+  /*Passes that must run before pass (a single bit)*/
+  static unsigned dependencies(unsigned pass);
+
+};
+
+#endif
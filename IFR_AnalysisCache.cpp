@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "IFR_AnalysisCache.h"
+#include "IFR_Serialize.h"
+
+using std::string;
+using std::vector;
+
+#define IFR_CACHE_MAGIC 0x43524649   //"IFRC"
+#define IFR_CACHE_HEADER 32
+#define IFR_CACHE_ENTRY 24
+
+static UINT64 fnv1a(const unsigned char *p, size_t n, UINT64 h){
+  for( size_t i = 0; i < n; i++ ){
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/*Finds the NT_GNU_BUILD_ID note among the SHT_NOTE sections of an ELF
+ *file.  Ehdr and Shdr are the 32 or 64 bit ELF types.
+ */
+template <class Ehdr, class Shdr>
+static bool findBuildId(const unsigned char *file, size_t size,
+                        const unsigned char *&id, size_t &idSize){
+
+  if( size < sizeof(Ehdr) ){ return false; }
+  const Ehdr *eh = (const Ehdr *)file;
+  if( eh->e_shoff == 0 || eh->e_shentsize != sizeof(Shdr) ||
+      eh->e_shoff + (UINT64)eh->e_shnum * sizeof(Shdr) > size ){
+    return false;
+  }
+
+  const Shdr *sh = (const Shdr *)(file + eh->e_shoff);
+  for( unsigned s = 0; s < eh->e_shnum; s++ ){
+
+    if( sh[s].sh_type != SHT_NOTE || sh[s].sh_offset + sh[s].sh_size > size ){ continue; }
+
+    const unsigned char *n = file + sh[s].sh_offset;
+    const unsigned char *end = n + sh[s].sh_size;
+    while( end - n >= 12 ){
+      UINT32 nameSize, descSize, type;
+      memcpy(&nameSize, n, 4);
+      memcpy(&descSize, n + 4, 4);
+      memcpy(&type, n + 8, 4);
+      size_t nameAligned = (nameSize + 3) & ~3u;
+      size_t descAligned = (descSize + 3) & ~3u;
+      if( (size_t)(end - n) < 12 + nameAligned + descAligned ){ break; }
+      if( type == NT_GNU_BUILD_ID && nameSize == 4 && memcmp(n + 12, "GNU", 4) == 0 ){
+        id = n + 12 + nameAligned;
+        idSize = descSize;
+        return true;
+      }
+      n += 12 + nameAligned + descAligned;
+    }
+
+  }
+  return false;
+
+}
+
+UINT64 IFR_AnalysisCache::imageKey(const string &imagePath){
+
+  int fd = ::open(imagePath.c_str(), O_RDONLY);
+  if( fd < 0 ){ return 0; }
+  struct stat st;
+  if( fstat(fd, &st) != 0 || st.st_size == 0 ){
+    ::close(fd);
+    return 0;
+  }
+  size_t size = st.st_size;
+  void *m = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if( m == MAP_FAILED ){ return 0; }
+  const unsigned char *file = (const unsigned char *)m;
+
+  /*A build-id identifies the binary without reading all of it*/
+  UINT64 h = fnv1a((const unsigned char *)&size, sizeof(size), 0xcbf29ce484222325ULL);
+  const unsigned char *id = 0;
+  size_t idSize = 0;
+  bool found = false;
+  if( size >= EI_NIDENT && memcmp(file, ELFMAG, SELFMAG) == 0 ){
+    if( file[EI_CLASS] == ELFCLASS64 ){
+      found = findBuildId<Elf64_Ehdr, Elf64_Shdr>(file, size, id, idSize);
+    }else if( file[EI_CLASS] == ELFCLASS32 ){
+      found = findBuildId<Elf32_Ehdr, Elf32_Shdr>(file, size, id, idSize);
+    }
+  }
+  h = found ? fnv1a(id, idSize, h) : fnv1a(file, size, h);
+
+  munmap(m, size);
+  return h == 0 ? 1 : h;
+
+}
+
+IFR_AnalysisCache::IFR_AnalysisCache(){
+  key = 0;
+  mapped = 0;
+  mapSize = 0;
+}
+
+IFR_AnalysisCache::~IFR_AnalysisCache(){
+  unmap();
+}
+
+void IFR_AnalysisCache::unmap(){
+
+  if( mapped != 0 ){ munmap((void *)mapped, mapSize); }
+  mapped = 0;
+  mapSize = 0;
+  index.clear();
+
+}
+
+bool IFR_AnalysisCache::open(const string &dir, const string &imagePath){
+
+  unmap();
+  added.clear();
+  path.clear();
+
+  key = imageKey(imagePath);
+  if( key == 0 ){ return false; }
+
+  /*One file per image path; characters that cannot appear in a file name
+   *are flattened, and a hash of the full path keeps same-named images in
+   *different directories apart.
+   */
+  string base = imagePath.substr( imagePath.find_last_of('/') + 1 );
+  char tag[32];
+  snprintf(tag, sizeof(tag), ".%016llx.ifrc",
+           (unsigned long long)fnv1a((const unsigned char *)imagePath.c_str(), imagePath.size(),
+                                     0xcbf29ce484222325ULL));
+  path = dir + "/" + base + tag;
+
+  mapFile();
+  return true;
+
+}
+
+bool IFR_AnalysisCache::mapFile(){
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if( fd < 0 ){ return false; }
+  struct stat st;
+  if( fstat(fd, &st) != 0 || st.st_size < IFR_CACHE_HEADER ){
+    ::close(fd);
+    return false;
+  }
+  void *m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if( m == MAP_FAILED ){ return false; }
+  mapped = (const unsigned char *)m;
+  mapSize = st.st_size;
+
+  IFR_BlobReader r(mapped, mapSize);
+  UINT32 magic = r.getWord();
+  UINT32 version = r.getWord();
+  UINT64 fileKey = r.getWide();
+  UINT32 count = r.getWord();
+  r.getWord();
+  UINT64 indexOffset = r.getWide();
+  if( !r.ok() || magic != IFR_CACHE_MAGIC || version != IFR_CACHE_VERSION || fileKey != key ||
+      indexOffset > mapSize || (mapSize - indexOffset) / IFR_CACHE_ENTRY < count ){
+    unmap();
+    return false;
+  }
+
+  IFR_BlobReader ir(mapped + indexOffset, mapSize - indexOffset);
+  index.resize(count);
+  for( unsigned e = 0; e < count; e++ ){
+    index[e].offset = ir.getWide();
+    index[e].blob = ir.getWide();
+    index[e].size = ir.getWide();
+    if( index[e].blob > indexOffset || index[e].size > indexOffset - index[e].blob ||
+        (e > 0 && index[e].offset <= index[e - 1].offset) ){
+      unmap();
+      return false;
+    }
+  }
+  return true;
+
+}
+
+bool IFR_AnalysisCache::lookup(UINT64 offset, const unsigned char *&data, size_t &size) const{
+
+  std::map< UINT64, vector<unsigned char> >::const_iterator a = added.find(offset);
+  if( a != added.end() ){
+    data = a->second.empty() ? 0 : &a->second[0];
+    size = a->second.size();
+    return true;
+  }
+
+  unsigned lo = 0, hi = index.size();
+  while( lo < hi ){
+    unsigned mid = (lo + hi) / 2;
+    if( index[mid].offset < offset ){ lo = mid + 1; }else{ hi = mid; }
+  }
+  if( lo == index.size() || index[lo].offset != offset ){ return false; }
+  data = mapped + index[lo].blob;
+  size = index[lo].size;
+  return true;
+
+}
+
+void IFR_AnalysisCache::insert(UINT64 offset, const vector<unsigned char> &blob){
+  if( key != 0 ){ added[offset] = blob; }
+}
+
+bool IFR_AnalysisCache::flush(){
+
+  if( key == 0 || added.empty() ){ return true; }
+
+  /*Merge the mapped entries with the new ones, new ones winning*/
+  IFR_BlobWriter w;
+  w.bytes.resize(IFR_CACHE_HEADER);
+  vector<Entry> merged;
+  std::map< UINT64, vector<unsigned char> >::iterator a = added.begin();
+  unsigned e = 0;
+  while( e < index.size() || a != added.end() ){
+
+    Entry out;
+    if( a == added.end() || (e < index.size() && index[e].offset < a->first) ){
+      out.offset = index[e].offset;
+      out.blob = w.bytes.size();
+      out.size = index[e].size;
+      w.bytes.insert(w.bytes.end(), mapped + index[e].blob, mapped + index[e].blob + index[e].size);
+      e++;
+    }else{
+      if( e < index.size() && index[e].offset == a->first ){ e++; }
+      out.offset = a->first;
+      out.blob = w.bytes.size();
+      out.size = a->second.size();
+      w.bytes.insert(w.bytes.end(), a->second.begin(), a->second.end());
+      a++;
+    }
+    merged.push_back(out);
+
+    /*Keep blobs word aligned*/
+    while( w.bytes.size() % 4 != 0 ){ w.bytes.push_back(0); }
+
+  }
+
+  UINT64 indexOffset = w.bytes.size();
+  for( unsigned m = 0; m < merged.size(); m++ ){
+    w.putWide(merged[m].offset);
+    w.putWide(merged[m].blob);
+    w.putWide(merged[m].size);
+  }
+
+  IFR_BlobWriter h;
+  h.putWord(IFR_CACHE_MAGIC);
+  h.putWord(IFR_CACHE_VERSION);
+  h.putWide(key);
+  h.putWord(merged.size());
+  h.putWord(0);
+  h.putWide(indexOffset);
+  std::copy(h.bytes.begin(), h.bytes.end(), w.bytes.begin());
+
+  /*Write next to the old file and rename over it, so a concurrent or
+   *interrupted run never sees a partial file.
+   */
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".tmp%d", (int)getpid());
+  string tmp = path + suffix;
+  FILE *f = fopen(tmp.c_str(), "wb");
+  if( f == 0 ){ return false; }
+  bool ok = fwrite(&w.bytes[0], 1, w.bytes.size(), f) == w.bytes.size();
+  ok = (fclose(f) == 0) && ok;
+  if( !ok || rename(tmp.c_str(), path.c_str()) != 0 ){
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  /*Serve later lookups from the new file*/
+  added.clear();
+  unmap();
+  mapFile();
+  return true;
+
+}
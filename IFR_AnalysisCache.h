@@ -0,0 +1,79 @@
+#ifndef _IFR_ANALYSISCACHE_H_
+#define _IFR_ANALYSISCACHE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include "IFR_Types.h"
+
+/*Bump whenever the layout of any saved analysis changes*/
+#define IFR_CACHE_VERSION 5
+
+/*On-disk cache of per-routine analysis blobs for one image.
+ *
+ *Each image gets one file in the cache directory, named after the image's
+ *path.  The file starts with a header carrying a key derived from the
+ *image contents (its GNU build-id when it has one, otherwise a hash of
+ *the whole file), followed by the routine blobs and an index of
+ *(routine offset, blob offset, blob size) sorted by routine offset:
+ *
+ *  u32 magic  u32 version  u64 key  u32 count  u32 0  u64 indexOffset
+ *  blobs...
+ *  index[count]
+ *
+ *The file is mapped read-only and blobs are handed out as pointers into
+ *the mapping.  A file whose magic, version or key does not match is
+ *ignored, so rebuilding the binary invalidates its entries; the next
+ *flush() overwrites it.  New blobs are kept in memory until flush(),
+ *which writes the old and new entries to a temporary file and renames it
+ *into place.
+ */
+class IFR_AnalysisCache{
+
+  class Entry{
+  public:
+    UINT64 offset;
+    UINT64 blob;
+    UINT64 size;
+  };
+
+  std::string path;
+  UINT64 key;
+
+  const unsigned char *mapped;
+  size_t mapSize;
+  std::vector<Entry> index;     //entries of the mapped file, sorted by offset
+
+  std::map< UINT64, std::vector<unsigned char> > added;
+
+  void unmap();
+  bool mapFile();
+
+  IFR_AnalysisCache(const IFR_AnalysisCache &);
+  IFR_AnalysisCache &operator=(const IFR_AnalysisCache &);
+
+public:
+
+  IFR_AnalysisCache();
+  ~IFR_AnalysisCache();
+
+  /*Opens the cache for the image at imagePath.  Returns false if the
+   *image cannot be read, in which case lookups miss and flush does nothing.
+   */
+  bool open(const std::string &dir, const std::string &imagePath);
+
+  /*Blob stored for the routine at offset from the image base*/
+  bool lookup(UINT64 offset, const unsigned char *&data, size_t &size) const;
+  void insert(UINT64 offset, const std::vector<unsigned char> &blob);
+
+  bool flush();
+
+  unsigned numEntries() const { return index.size(); }
+  unsigned numAdded() const { return added.size(); }
+
+  /*Content key of the file at path, 0 if it cannot be read*/
+  static UINT64 imageKey(const std::string &path);
+
+};
+
+#endif
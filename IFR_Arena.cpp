@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include "IFR_Arena.h"
+
+#define IFR_ARENA_ALIGN 16
+
+IFR_Arena::IFR_Arena(size_t chunkBytes){
+  chunkSize = chunkBytes;
+  cur = 0;
+  used = 0;
+  inUse = 0;
+  peak = 0;
+}
+
+IFR_Arena::~IFR_Arena(){
+  for( unsigned c = 0; c < chunks.size(); c++ ){
+    free(chunks[c]);
+  }
+}
+
+void *IFR_Arena::alloc(size_t bytes){
+
+  bytes = (bytes + IFR_ARENA_ALIGN - 1) & ~(size_t)(IFR_ARENA_ALIGN - 1);
+
+  /*Move on to the next kept chunk that fits, or add one*/
+  while( cur < chunks.size() && used + bytes > sizes[cur] ){
+    cur++;
+    used = 0;
+  }
+  if( cur == chunks.size() ){
+    size_t size = bytes > chunkSize ? bytes : chunkSize;
+    chunks.push_back( (char *)malloc(size) );
+    sizes.push_back(size);
+    used = 0;
+  }
+
+  void *p = chunks[cur] + used;
+  used += bytes;
+  inUse += bytes;
+  if( inUse > peak ){ peak = inUse; }
+  return p;
+
+}
+
+void IFR_Arena::reset(){
+  cur = 0;
+  used = 0;
+  inUse = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef _IFR_ARENA_H_
+#define _IFR_ARENA_H_
+
+#include <stddef.h>
+#include <vector>
+
+/*Bump allocator for short-lived per-routine storage.
+ *
+ *Allocations are carved out of large chunks and never freed one by one;
+ *reset() rewinds to the first chunk in one step and keeps the chunks for
+ *the next routine, so steady state costs no heap traffic at all.  Only
+ *types without destructors may live here.
+ */
+class IFR_Arena{
+
+  std::vector<char *> chunks;
+  std::vector<size_t> sizes;
+  size_t chunkSize;
+  unsigned cur;           //chunk being carved
+  size_t used;            //bytes used in chunks[cur]
+  size_t inUse;           //bytes handed out since reset
+  size_t peak;
+
+  IFR_Arena(const IFR_Arena &);
+  IFR_Arena &operator=(const IFR_Arena &);
+
+public:
+
+  IFR_Arena(size_t chunkBytes = 64 * 1024);
+  ~IFR_Arena();
+
+  void *alloc(size_t bytes);
+  void reset();
+
+  template <class T> T *allocArray(size_t n){
+    return n == 0 ? 0 : (T *)alloc(n * sizeof(T));
+  }
+
+  size_t bytesInUse() const { return inUse; }
+  size_t peakBytes() const { return peak; }
+  unsigned numChunks() const { return chunks.size(); }
+
+};
+
+#endif
@@ -1,33 +1,32 @@
-#include <vector>
-#include <pin.H>
+#ifndef _IFR_BASICBLOCK_H_
+#define _IFR_BASICBLOCK_H_
+
+#include "IFR_Types.h"
+#include "IFR_InsRecord.h"
+#include "IFR_CFG.h"
+
+/*A basic block as a range [first, last) of routine instruction numbers,
+ *indexing the routine's IFR_RoutineCode and any per-instruction arrays
+ *alongside it.  Blocks own no storage, so they are cheap to copy and can
+ *live in an IFR_Arena.
+ */
 class IFR_BasicBlock{
 
-  ADDRINT target;
-  ADDRINT fallthrough;
-  bool isReturn;
-
 public:
 
-  IFR_BasicBlock();
-
-  IFR_BasicBlock(const IFR_BasicBlock&); //copy constructor
-  IFR_BasicBlock operator=(const IFR_BasicBlock&); //to handle explicit assignment
-
-  void add(INS ins);
-  
-  ADDRINT getEntryAddr();
-  void setTarget(ADDRINT targ);
-  void setFallthrough(ADDRINT ft);
-  ADDRINT getTarget();
-  ADDRINT getFallthrough();
- 
-  void setIsReturn(bool is);
+  unsigned first;
+  unsigned last;
+  ADDRINT target;         //direct jump target, 0 if none
+  ADDRINT fallthrough;    //next instruction if control can fall into it, else 0
+  bool isReturn;
 
-  void print();
+  IFR_BasicBlock();
 
-  void clear();
-  
+  /*Block b of cfg, built from code*/
+  void set(const IFR_RoutineCode &code, const IFR_CFG &cfg, unsigned b);
 
-  std::vector<INS> insns;
+  unsigned size() const { return last - first; }
 
 };
+
+#endif
@@ -0,0 +1,147 @@
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IFR_VEC_WORDS 4
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IFR_VEC_WORDS 2
+#else
+#define IFR_VEC_WORDS 1
+#endif
+
+#include "IFR_Bitset.h"
+
+/*Each kernel runs whole vectors first, then the leftover words*/
+
+void IFR_BitsCopy(UINT64 *dst, const UINT64 *src, unsigned n){
+  memcpy(dst, src, n * sizeof(UINT64));
+}
+
+void IFR_BitsFill(UINT64 *dst, bool ones, unsigned n){
+  memset(dst, ones ? 0xff : 0, n * sizeof(UINT64));
+}
+
+bool IFR_BitsOr(UINT64 *dst, const UINT64 *src, unsigned n){
+
+  unsigned i = 0;
+  bool changed = false;
+#if defined(__AVX2__)
+  for( ; i + 4 <= n; i += 4 ){
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i r = _mm256_or_si256(d, _mm256_loadu_si256((const __m256i *)(src + i)));
+    changed |= !_mm256_testc_si256(d, r);     //r has a bit d lacks
+    _mm256_storeu_si256((__m256i *)(dst + i), r);
+  }
+#elif defined(__SSE2__)
+  for( ; i + 2 <= n; i += 2 ){
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i r = _mm_or_si128(d, _mm_loadu_si128((const __m128i *)(src + i)));
+    changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(d, r)) != 0xffff;
+    _mm_storeu_si128((__m128i *)(dst + i), r);
+  }
+#endif
+  for( ; i < n; i++ ){
+    UINT64 r = dst[i] | src[i];
+    changed |= r != dst[i];
+    dst[i] = r;
+  }
+  return changed;
+
+}
+
+bool IFR_BitsAnd(UINT64 *dst, const UINT64 *src, unsigned n){
+
+  unsigned i = 0;
+  bool changed = false;
+#if defined(__AVX2__)
+  for( ; i + 4 <= n; i += 4 ){
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i r = _mm256_and_si256(d, _mm256_loadu_si256((const __m256i *)(src + i)));
+    changed |= !_mm256_testc_si256(r, d);     //d has a bit r lost
+    _mm256_storeu_si256((__m256i *)(dst + i), r);
+  }
+#elif defined(__SSE2__)
+  for( ; i + 2 <= n; i += 2 ){
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i r = _mm_and_si128(d, _mm_loadu_si128((const __m128i *)(src + i)));
+    changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(d, r)) != 0xffff;
+    _mm_storeu_si128((__m128i *)(dst + i), r);
+  }
+#endif
+  for( ; i < n; i++ ){
+    UINT64 r = dst[i] & src[i];
+    changed |= r != dst[i];
+    dst[i] = r;
+  }
+  return changed;
+
+}
+
+bool IFR_BitsTransfer(UINT64 *dst, const UINT64 *gen, const UINT64 *in, const UINT64 *kill, unsigned n){
+
+  unsigned i = 0;
+  bool changed = false;
+#if defined(__AVX2__)
+  for( ; i + 4 <= n; i += 4 ){
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i r = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(gen + i)),
+                                _mm256_andnot_si256(_mm256_loadu_si256((const __m256i *)(kill + i)),
+                                                    _mm256_loadu_si256((const __m256i *)(in + i))));
+    __m256i x = _mm256_xor_si256(d, r);
+    changed |= !_mm256_testz_si256(x, x);
+    _mm256_storeu_si256((__m256i *)(dst + i), r);
+  }
+#elif defined(__SSE2__)
+  for( ; i + 2 <= n; i += 2 ){
+    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i r = _mm_or_si128(_mm_loadu_si128((const __m128i *)(gen + i)),
+                             _mm_andnot_si128(_mm_loadu_si128((const __m128i *)(kill + i)),
+                                              _mm_loadu_si128((const __m128i *)(in + i))));
+    changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(d, r)) != 0xffff;
+    _mm_storeu_si128((__m128i *)(dst + i), r);
+  }
+#endif
+  for( ; i < n; i++ ){
+    UINT64 r = gen[i] | (in[i] & ~kill[i]);
+    changed |= r != dst[i];
+    dst[i] = r;
+  }
+  return changed;
+
+}
+
+unsigned IFR_BitsCount(const UINT64 *src, unsigned n){
+  unsigned c = 0;
+  for( unsigned i = 0; i < n; i++ ){
+    c += __builtin_popcountll(src[i]);
+  }
+  return c;
+}
+
+const char *IFR_BitsKernel(){
+#if IFR_VEC_WORDS == 4
+  return "avx2";
+#elif IFR_VEC_WORDS == 2
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+IFR_BitMatrix::IFR_BitMatrix(){
+  numRows = 0;
+  rowWords = 0;
+}
+
+void IFR_BitMatrix::init(unsigned rows, unsigned width){
+  numRows = rows;
+  rowWords = (width + 63) / 64;
+  bits.assign((size_t)rows * rowWords + 1, 0);     //+1 so row() of an empty matrix has storage
+}
+
+void IFR_BitMatrix::clear(){
+  bits.clear();
+  numRows = 0;
+  rowWords = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef _IFR_BITSET_H_
+#define _IFR_BITSET_H_
+
+#include <vector>
+#include "IFR_Types.h"
+
+/*Kernels over dense bitsets of n 64-bit words.  They use AVX2 or SSE2
+ *when the compiler targets them and plain words otherwise; the sets do not
+ *have to be aligned.
+ */
+void IFR_BitsCopy(UINT64 *dst, const UINT64 *src, unsigned n);
+void IFR_BitsFill(UINT64 *dst, bool ones, unsigned n);
+
+/*dst |= src and dst &= src; both return whether dst changed*/
+bool IFR_BitsOr(UINT64 *dst, const UINT64 *src, unsigned n);
+bool IFR_BitsAnd(UINT64 *dst, const UINT64 *src, unsigned n);
+
+/*The bit-vector transfer function: dst = gen | (in & ~kill).  Returns
+ *whether dst changed.
+ */
+bool IFR_BitsTransfer(UINT64 *dst, const UINT64 *gen, const UINT64 *in, const UINT64 *kill, unsigned n);
+
+unsigned IFR_BitsCount(const UINT64 *src, unsigned n);
+
+/*"avx2", "sse2" or "scalar"*/
+const char *IFR_BitsKernel();
+
+/*Equal-length bitsets, one row per block or instruction, in one array*/
+class IFR_BitMatrix{
+
+  std::vector<UINT64> bits;
+  unsigned numRows;
+  unsigned rowWords;
+
+public:
+
+  IFR_BitMatrix();
+
+  /*rows rows of at least width bits each, all clear*/
+  void init(unsigned rows, unsigned width);
+  void clear();
+
+  unsigned rows() const { return numRows; }
+  unsigned words() const { return rowWords; }
+
+  UINT64 *row(unsigned r) { return &bits[0] + (size_t)r * rowWords; }
+  const UINT64 *row(unsigned r) const { return &bits[0] + (size_t)r * rowWords; }
+
+  bool test(unsigned r, unsigned bit) const { return (row(r)[bit >> 6] >> (bit & 63)) & 1; }
+  void set(unsigned r, unsigned bit) { row(r)[bit >> 6] |= (UINT64)1 << (bit & 63); }
+  void reset(unsigned r, unsigned bit) { row(r)[bit >> 6] &= ~((UINT64)1 << (bit & 63)); }
+
+  size_t bytes() const { return IFR_Bytes(bits); }
+
+};
+
+#endif
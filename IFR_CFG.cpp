@@ -0,0 +1,147 @@
+#include <algorithm>
+#include "IFR_CFG.h"
+
+using std::vector;
+using std::pair;
+
+const unsigned IFR_CFG::NoBlock;
+
+IFR_CFG::IFR_CFG(){
+  clear();
+}
+
+void IFR_CFG::clear(){
+
+  entries.clear();
+  insStarts.assign(1, 0);
+  succStarts.assign(1, 0);
+  succs.clear();
+  predStarts.assign(1, 0);
+  preds.clear();
+  pending.clear();
+
+}
+
+unsigned IFR_CFG::addBlock(ADDRINT entry, unsigned numIns){
+
+  entries.push_back(entry);
+  insStarts.push_back(insStarts.back() + numIns);
+  return entries.size() - 1;
+
+}
+
+void IFR_CFG::addEdge(unsigned from, ADDRINT to){
+  pending.push_back( pair<unsigned, ADDRINT>(from, to) );
+}
+
+unsigned IFR_CFG::index(ADDRINT addr) const{
+
+  vector<ADDRINT>::const_iterator e = std::lower_bound(entries.begin(), entries.end(), addr);
+  if( e == entries.end() || *e != addr ){ return NoBlock; }
+  return e - entries.begin();
+
+}
+
+unsigned IFR_CFG::blockOf(unsigned ins) const{
+
+  if( ins >= numIns() ){ return NoBlock; }
+  return std::upper_bound(insStarts.begin(), insStarts.end(), ins) - insStarts.begin() - 1;
+
+}
+
+void IFR_CFG::finish(){
+
+  unsigned n = entries.size();
+
+  /*Resolve targets to block indices; the pending list is reused to hold
+   *(from, to index) pairs so they can be sorted and deduplicated in place.
+   */
+  unsigned kept = 0;
+  for( unsigned e = 0; e < pending.size(); e++ ){
+    unsigned to = index(pending[e].second);
+    if( to == NoBlock ){ continue; }
+    pending[kept++] = pair<unsigned, ADDRINT>(pending[e].first, to);
+  }
+  pending.resize(kept);
+  std::sort(pending.begin(), pending.end());
+  pending.erase( std::unique(pending.begin(), pending.end()), pending.end() );
+
+  succStarts.assign(n + 1, 0);
+  predStarts.assign(n + 1, 0);
+  for( unsigned e = 0; e < pending.size(); e++ ){
+    succStarts[ pending[e].first + 1 ]++;
+    predStarts[ pending[e].second + 1 ]++;
+  }
+  for( unsigned b = 0; b < n; b++ ){
+    succStarts[b + 1] += succStarts[b];
+    predStarts[b + 1] += predStarts[b];
+  }
+
+  /*Edges are sorted by (from, to), so filling in order leaves every
+   *successor and predecessor list sorted.
+   */
+  succs.resize(pending.size());
+  preds.resize(pending.size());
+  vector<unsigned> fill(predStarts.begin(), predStarts.end() - 1);
+  for( unsigned e = 0; e < pending.size(); e++ ){
+    succs[e] = pending[e].second;
+    preds[ fill[ pending[e].second ]++ ] = pending[e].first;
+  }
+
+  pending.clear();
+
+}
+
+void IFR_CFG::save(IFR_BlobWriter &w, ADDRINT base) const{
+
+  w.putWord( entries.size() );
+  for( unsigned b = 0; b < entries.size(); b++ ){
+    w.putWide( entries[b] - base );
+  }
+  w.putWords(insStarts);
+  w.putWords(succStarts);
+  w.putWords(succs);
+  w.putWords(predStarts);
+  w.putWords(preds);
+
+}
+
+bool IFR_CFG::load(IFR_BlobReader &r, ADDRINT base){
+
+  clear();
+  unsigned n = r.getWord();
+  if( !r.ok() ){ return false; }
+  entries.resize(n);
+  bool sorted = true;
+  for( unsigned b = 0; b < n; b++ ){
+    entries[b] = base + (ADDRINT)r.getWide();
+    if( b > 0 && entries[b] <= entries[b - 1] ){ sorted = false; }
+  }
+  r.getWords(insStarts);
+  r.getWords(succStarts);
+  r.getWords(succs);
+  r.getWords(predStarts);
+  r.getWords(preds);
+
+  /*Stored block numbers and instruction spans are used as indices
+   *unchecked from here on, and index() searches entries in order
+   */
+  if( !r.ok() || !sorted || insStarts.size() != n + 1 || succStarts.size() != n + 1 || predStarts.size() != n + 1 ||
+      !IFR_ValidStarts(insStarts, insStarts.back()) || !IFR_ValidStarts(succStarts, succs.size()) ||
+      !IFR_ValidStarts(predStarts, preds.size()) || !IFR_ValidIndices(succs, n) || !IFR_ValidIndices(preds, n) ){
+    clear();
+    return false;
+  }
+  return true;
+
+}
+
+size_t IFR_CFG::bytes() const{
+  return IFR_Bytes(entries) +
+         IFR_Bytes(insStarts) +
+         IFR_Bytes(succStarts) +
+         IFR_Bytes(succs) +
+         IFR_Bytes(predStarts) +
+         IFR_Bytes(preds) +
+         IFR_Bytes(pending);
+}
@@ -0,0 +1,80 @@
+#ifndef _IFR_CFG_H_
+#define _IFR_CFG_H_
+
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_Serialize.h"
+
+/*Compact control flow graph of one routine.
+ *
+ *Blocks are numbered 0..N-1 in address order and block 0 is the entry.
+ *Successors and predecessors are stored CSR-style: the successors of b are
+ *succs[succStart[b]..succStart[b+1]), sorted by index.  Each block also
+ *records the range of routine instruction numbers it covers, so per
+ *instruction side tables can be flat arrays too.
+ *
+ *Build with addBlock (in ascending address order) and addEdge, then
+ *finish().  Edges to addresses that are not a block entry in this routine
+ *are dropped.
+ */
+class IFR_CFG{
+
+  std::vector<ADDRINT> entries;
+  std::vector<unsigned> insStarts;
+  std::vector<unsigned> succStarts;
+  std::vector<unsigned> succs;
+  std::vector<unsigned> predStarts;
+  std::vector<unsigned> preds;
+
+  std::vector< std::pair<unsigned, ADDRINT> > pending;  //edges until finish()
+
+  static const unsigned *edgeData(const std::vector<unsigned> &v){
+    return v.empty() ? 0 : &v[0];
+  }
+
+public:
+
+  static const unsigned NoBlock = (unsigned)-1;
+
+  IFR_CFG();
+
+  void clear();
+  unsigned addBlock(ADDRINT entry, unsigned numIns);
+  void addEdge(unsigned from, ADDRINT to);
+  void finish();
+
+  /*Block entries are stored relative to base, so a cached CFG stays valid
+   *when the image is loaded at a different address.
+   */
+  void save(IFR_BlobWriter &w, ADDRINT base) const;
+  bool load(IFR_BlobReader &r, ADDRINT base);
+
+  size_t bytes() const;
+
+  unsigned size() const { return entries.size(); }
+  unsigned numEdges() const { return succs.size(); }
+  unsigned numIns() const { return insStarts.empty() ? 0 : insStarts.back(); }
+
+  ADDRINT entry(unsigned b) const { return entries[b]; }
+
+  /*Block whose entry is addr, or NoBlock*/
+  unsigned index(ADDRINT addr) const;
+
+  /*Block holding routine instruction ins, or NoBlock*/
+  unsigned blockOf(unsigned ins) const;
+
+  /*Routine instruction numbers of block b are [insBegin(b), insEnd(b))*/
+  unsigned insBegin(unsigned b) const { return insStarts[b]; }
+  unsigned insEnd(unsigned b) const { return insStarts[b + 1]; }
+
+  const unsigned *succBegin(unsigned b) const { return edgeData(succs) + succStarts[b]; }
+  const unsigned *succEnd(unsigned b) const { return edgeData(succs) + succStarts[b + 1]; }
+  unsigned numSuccs(unsigned b) const { return succStarts[b + 1] - succStarts[b]; }
+
+  const unsigned *predBegin(unsigned b) const { return edgeData(preds) + predStarts[b]; }
+  const unsigned *predEnd(unsigned b) const { return edgeData(preds) + predStarts[b + 1]; }
+  unsigned numPreds(unsigned b) const { return predStarts[b + 1] - predStarts[b]; }
+
+};
+
+#endif
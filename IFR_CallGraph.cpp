@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <assert.h>
+
+#include "IFR_CallGraph.h"
+#include "IFR_Analysis.h"
+#include "IFR_WorkPool.h"
+
+using std::vector;
+
+const unsigned IFR_CallGraph::NoNode;
+
+IFR_RoutineSummary::IFR_RoutineSummary(){
+  touchesMemory = false;
+  syncs = false;
+  known = true;
+}
+
+void IFR_RoutineSummary::worst(const IFR_CallABI &abi){
+  clobbers = abi.callerSaved;
+  touchesMemory = true;
+  syncs = true;
+  known = false;
+}
+
+void IFR_RoutineSummary::merge(const IFR_RoutineSummary &s){
+
+  vector<unsigned> u;
+  std::set_union(clobbers.begin(), clobbers.end(), s.clobbers.begin(), s.clobbers.end(),
+                 std::back_inserter(u));
+  clobbers.swap(u);
+  touchesMemory = touchesMemory || s.touchesMemory;
+  syncs = syncs || s.syncs;
+  known = known && s.known;
+
+}
+
+IFR_CallGraph::IFR_CallGraph(){
+  abi = 0;
+}
+
+static bool entryBefore(IFR_Analysis *a, IFR_Analysis *b){
+  return a->entry() < b->entry();
+}
+
+unsigned IFR_CallGraph::find(ADDRINT entry) const{
+
+  vector<ADDRINT>::const_iterator e = std::lower_bound(entries.begin(), entries.end(), entry);
+  if( e == entries.end() || *e != entry ){ return NoNode; }
+  return e - entries.begin();
+
+}
+
+const IFR_RoutineSummary *IFR_CallGraph::summaryAt(ADDRINT entry) const{
+
+  unsigned n = find(entry);
+  if( n == NoNode || n >= summaries.size() ){ return 0; }
+  return &summaries[n];
+
+}
+
+void IFR_CallGraph::build(const vector<IFR_Analysis *> &routines){
+
+  nodes = routines;
+  std::sort(nodes.begin(), nodes.end(), entryBefore);
+  entries.resize(nodes.size());
+  for( unsigned n = 0; n < nodes.size(); n++ ){
+    entries[n] = nodes[n]->entry();
+  }
+
+  calleeStart.assign(1, 0);
+  callees.clear();
+  opaque.assign(nodes.size(), 0);
+  summaries.clear();
+
+  for( unsigned n = 0; n < nodes.size(); n++ ){
+
+    const IFR_RoutineCode &code = nodes[n]->code;
+    assert( nodes[n]->has(IFR_PASS_CODE) );
+    unsigned first = callees.size();
+    for( unsigned i = 0; i < code.ins.size(); i++ ){
+
+      const IFR_InsRecord &r = code.ins[i];
+      bool jump = r.kind == InsJump || r.kind == InsCondJump;
+      if( (r.kind == InsIndirectJump && !code.resolved(i)) || (r.kind == InsCall && r.target == 0) ){
+        opaque[n] = 1;
+        continue;
+      }
+      if( r.kind != InsCall && !(jump && code.find(r.target) == IFR_RoutineCode::NoIns) ){ continue; }
+
+      unsigned callee = find(r.target);
+      if( callee == NoNode ){
+        opaque[n] = 1;
+      }else{
+        callees.push_back(callee);
+      }
+
+    }
+
+    std::sort(callees.begin() + first, callees.end());
+    callees.erase(std::unique(callees.begin() + first, callees.end()), callees.end());
+    calleeStart.push_back(callees.size());
+
+  }
+
+  findSCCs();
+  findLevels();
+
+}
+
+/*Tarjan's algorithm, iteratively.  Components are finished callees
+ *first, which is the bottom-up order.
+ */
+void IFR_CallGraph::findSCCs(){
+
+  unsigned n = nodes.size();
+  const unsigned NoIndex = (unsigned)-1;
+  vector<unsigned> index(n, NoIndex), low(n, 0), next(n, 0);
+  vector<unsigned char> onStack(n, 0);
+  vector<unsigned> stack, call;
+  unsigned counter = 0;
+
+  sccOf.assign(n, 0);
+  sccStart.assign(1, 0);
+  sccMembers.clear();
+
+  for( unsigned root = 0; root < n; root++ ){
+
+    if( index[root] != NoIndex ){ continue; }
+    call.push_back(root);
+
+    while( !call.empty() ){
+
+      unsigned v = call.back();
+      if( index[v] == NoIndex ){
+        index[v] = low[v] = counter++;
+        next[v] = calleeStart[v];
+        stack.push_back(v);
+        onStack[v] = 1;
+      }
+
+      if( next[v] < calleeStart[v + 1] ){
+        unsigned w = callees[ next[v]++ ];
+        if( index[w] == NoIndex ){
+          call.push_back(w);
+        }else if( onStack[w] ){
+          low[v] = std::min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      call.pop_back();
+      if( !call.empty() ){
+        unsigned u = call.back();
+        low[u] = std::min(low[u], low[v]);
+      }
+      if( low[v] != index[v] ){ continue; }
+
+      unsigned s = sccStart.size() - 1;
+      unsigned w;
+      do{
+        w = stack.back();
+        stack.pop_back();
+        onStack[w] = 0;
+        sccOf[w] = s;
+        sccMembers.push_back(w);
+      }while( w != v );
+      sccStart.push_back(sccMembers.size());
+
+    }
+
+  }
+
+}
+
+void IFR_CallGraph::findLevels(){
+
+  unsigned numS = numSCCs();
+  vector<unsigned> level(numS, 0);
+  unsigned numL = 0;
+  for( unsigned s = 0; s < numS; s++ ){
+    for( unsigned m = sccStart[s]; m < sccStart[s + 1]; m++ ){
+      unsigned v = sccMembers[m];
+      for( unsigned c = calleeStart[v]; c < calleeStart[v + 1]; c++ ){
+        unsigned t = sccOf[ callees[c] ];
+        if( t != s ){ level[s] = std::max(level[s], level[t] + 1); }
+      }
+    }
+    numL = std::max(numL, level[s] + 1);
+  }
+
+  /*Counting sort by level*/
+  levelStart.assign(numL + 1, 0);
+  for( unsigned s = 0; s < numS; s++ ){
+    levelStart[ level[s] + 1 ]++;
+  }
+  for( unsigned l = 0; l < numL; l++ ){
+    levelStart[l + 1] += levelStart[l];
+  }
+  levelSccs.resize(numS);
+  vector<unsigned> fill(levelStart.begin(), levelStart.end() - (numL > 0 ? 1 : 0));
+  for( unsigned s = 0; s < numS; s++ ){
+    levelSccs[ fill[ level[s] ]++ ] = s;
+  }
+
+}
+
+/*The summary of one component: its members' own effects, and those of
+ *the components they call, which are on lower levels and so done
+ */
+void IFR_CallGraph::summarizeSCC(unsigned s){
+
+  IFR_RoutineSummary sum;
+  for( unsigned m = sccStart[s]; m < sccStart[s + 1] && sum.known; m++ ){
+
+    unsigned v = sccMembers[m];
+    if( opaque[v] ){
+      sum.worst(*abi);
+      break;
+    }
+
+    const IFR_Analysis &a = *nodes[v];
+    IFR_RoutineSummary own;
+    for( unsigned i = 0; i < a.code.ins.size(); i++ ){
+
+      if( a.regOps.memFlags[i] & IFR_INS_SYNC ){ own.syncs = true; }
+
+      /*A call's defs are its callee's clobbers, covered below*/
+      if( a.code.ins[i].kind != InsCall ){
+        for( unsigned d = a.regOps.defStart[i]; d < a.regOps.defStart[i + 1]; d++ ){
+          unsigned reg = a.regOps.regName( a.regOps.defs[d] );
+          if( std::binary_search(abi->callerSaved.begin(), abi->callerSaved.end(), reg) ){
+            own.clobbers.push_back(reg);
+          }
+        }
+      }
+
+      for( unsigned k = a.memrefs.begin(i); k < a.memrefs.end(i); k++ ){
+        const IFR_MemoryRef &ref = a.memrefs.refs[k];
+        if( ref.base != abi->stackPointer || ref.index != IFR_MemoryRef::NoReg ){ own.touchesMemory = true; }
+      }
+
+    }
+    std::sort(own.clobbers.begin(), own.clobbers.end());
+    own.clobbers.erase(std::unique(own.clobbers.begin(), own.clobbers.end()), own.clobbers.end());
+    sum.merge(own);
+
+    for( unsigned c = calleeStart[v]; c < calleeStart[v + 1]; c++ ){
+      if( sccOf[ callees[c] ] != s ){ sum.merge( summaries[ callees[c] ] ); }
+    }
+
+  }
+
+  for( unsigned m = sccStart[s]; m < sccStart[s + 1]; m++ ){
+    summaries[ sccMembers[m] ] = sum;
+  }
+
+}
+
+void IFR_CallGraph::summarizeTask(unsigned item, void *arg){
+  IFR_CallGraph *g = (IFR_CallGraph *)arg;
+  g->summarizeSCC(item);
+}
+
+void IFR_CallGraph::summarize(const IFR_CallABI &a, unsigned threads){
+
+  abi = &a;
+  summaries.assign(nodes.size(), IFR_RoutineSummary());
+
+  for( unsigned l = 0; l < numLevels(); l++ ){
+
+    vector<unsigned> items(levelSccs.begin() + levelStart[l], levelSccs.begin() + levelStart[l + 1]);
+    if( threads == 0 || items.size() < 2 * threads ){
+      for( unsigned i = 0; i < items.size(); i++ ){
+        summarizeSCC(items[i]);
+      }
+      continue;
+    }
+
+    IFR_WorkPool pool;
+    pool.start(threads, items, summarizeTask, this);
+    pool.join();
+
+  }
+  abi = 0;
+
+}
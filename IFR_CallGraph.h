@@ -0,0 +1,105 @@
+#ifndef _IFR_CALLGRAPH_H_
+#define _IFR_CALLGRAPH_H_
+
+#include <vector>
+#include "IFR_Types.h"
+
+class IFR_Analysis;
+
+/*What the front end's calling convention says about calls, in its
+ *machine register numbers
+ */
+class IFR_CallABI{
+
+public:
+
+  std::vector<unsigned> callerSaved;    //sorted; what a callee may clobber
+  unsigned stackPointer;
+
+};
+
+/*What calling a routine may do, over everything it can reach*/
+class IFR_RoutineSummary{
+
+public:
+
+  std::vector<unsigned> clobbers;       //caller-saved registers written, sorted
+  bool touchesMemory;                   //accesses other than through the stack pointer
+  bool syncs;                           //atomic updates or fences (IFR_INS_SYNC)
+  bool known;                           //reaches only routines in the graph
+
+  IFR_RoutineSummary();
+
+  /*Anything at all: what the front ends assume of an unknown callee*/
+  void worst(const IFR_CallABI &abi);
+  void merge(const IFR_RoutineSummary &s);
+
+};
+
+/*Call graph of an image's routines, with bottom-up summaries.
+ *
+ *Edges are direct calls, and direct jumps to another routine's entry
+ *(tail calls).  A routine is opaque when it can transfer control where
+ *the graph cannot follow: indirect calls, unresolved indirect jumps, or
+ *direct ones to addresses that are not a routine entry (PLT stubs are
+ *routines, but their indirect jumps make them opaque).
+ *
+ *Summaries are computed per strongly connected component (Tarjan), since
+ *every routine in a cycle can reach the others, so each shares its
+ *component's summary.  Components are grouped into levels, each one
+ *above the highest component it calls, and the components of a level run
+ *in parallel on an IFR_WorkPool; only the analyses' instruction records,
+ *memrefs and register operands are read.
+ */
+class IFR_CallGraph{
+
+  std::vector<IFR_Analysis *> nodes;    //by entry address
+  std::vector<ADDRINT> entries;
+  std::vector<unsigned> calleeStart;    //callees of n are callees[calleeStart[n]..calleeStart[n+1])
+  std::vector<unsigned> callees;
+  std::vector<unsigned char> opaque;
+
+  std::vector<unsigned> sccOf;
+  std::vector<unsigned> sccStart;       //members of s are sccMembers[sccStart[s]..sccStart[s+1])
+  std::vector<unsigned> sccMembers;     //components in bottom-up order
+  std::vector<unsigned> levelStart;     //components of level l are levelSccs[levelStart[l]..levelStart[l+1])
+  std::vector<unsigned> levelSccs;
+
+  std::vector<IFR_RoutineSummary> summaries;
+  const IFR_CallABI *abi;
+
+  void findSCCs();
+  void findLevels();
+  void summarizeSCC(unsigned s);
+  static void summarizeTask(unsigned item, void *arg);
+
+public:
+
+  static const unsigned NoNode = (unsigned)-1;
+
+  IFR_CallGraph();
+
+  /*routines must all have IFR_PASS_CODE*/
+  void build(const std::vector<IFR_Analysis *> &routines);
+
+  /*On threads workers, or the calling thread if 0*/
+  void summarize(const IFR_CallABI &a, unsigned threads);
+
+  unsigned size() const { return nodes.size(); }
+  unsigned numEdges() const { return callees.size(); }
+  unsigned find(ADDRINT entry) const;
+  IFR_Analysis *node(unsigned n) const { return nodes[n]; }
+  bool isOpaque(unsigned n) const { return opaque[n] != 0; }
+
+  unsigned numSCCs() const { return sccStart.size() - 1; }
+  unsigned sccSize(unsigned s) const { return sccStart[s + 1] - sccStart[s]; }
+  unsigned numLevels() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+
+  const IFR_RoutineSummary &summary(unsigned n) const { return summaries[n]; }
+
+  /*Summary of the routine entered at entry, or null if not in the graph*/
+  const IFR_RoutineSummary *summaryAt(ADDRINT entry) const;
+
+};
+
+#endif
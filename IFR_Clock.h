@@ -0,0 +1,16 @@
+#ifndef _IFR_CLOCK_H_
+#define _IFR_CLOCK_H_
+
+#include <stddef.h>
+#include <sys/time.h>
+
+/*Wall clock seconds, for timing passes and tools.  Inline so that tools
+ *linking none of the analyses (the readers, the benchmarks) can use it.
+ */
+inline double IFR_Clock(){
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "IFR_Coalesce.h"
+#include "IFR_Regions.h"
+
+using std::vector;
+
+const unsigned IFR_Coalesce::NoGroup;
+
+/*A group still being filled*/
+class OpenGroup{
+
+public:
+
+  unsigned base;            //machine registers, as in IFR_MemoryRef
+  unsigned index;
+  UINT32 scale;
+  bool write;
+  unsigned baseDense;       //IFR_RegOps ids, NoReg when absent
+  unsigned indexDense;
+  ADDRDELTA low;            //displacement span so far
+  ADDRDELTA high;
+  vector<unsigned> refs;
+
+};
+
+IFR_Coalesce::IFR_Coalesce(){
+  numCandidates = 0;
+  numCoalesced = 0;
+}
+
+static bool definesAny(const IFR_RegOps &regOps, unsigned ins, unsigned a, unsigned b){
+  for( unsigned d = regOps.defStart[ins]; d < regOps.defStart[ins + 1]; d++ ){
+    if( regOps.defs[d] == a || regOps.defs[d] == b ){ return true; }
+  }
+  return false;
+}
+
+/*Records g as a group if it has more than one member*/
+static void closeGroup(const OpenGroup &g, const IFR_MemRefTable &memrefs, vector<IFR_CoalesceGroup> &groups,
+                       vector<unsigned> &groupOf, unsigned &numCoalesced){
+
+  if( g.refs.size() < 2 ){ return; }
+
+  IFR_CoalesceGroup c;
+  c.leader = g.refs[0];
+  c.members = g.refs.size();
+  c.length = g.high - g.low;
+  c.mask = 0;
+  c.write = g.write;
+  for( unsigned i = 0; i < g.refs.size(); i++ ){
+    const IFR_MemoryRef &ref = memrefs.refs[ g.refs[i] ];
+    if( ref.displacement < memrefs.refs[c.leader].displacement ){ c.leader = g.refs[i]; }
+    unsigned at = ref.displacement - g.low;
+    c.mask |= (ref.size + at >= 64 ? ~(UINT64)0 : ((UINT64)1 << (ref.size + at)) - 1) & ~(((UINT64)1 << at) - 1);
+    groupOf[ g.refs[i] ] = groups.size();
+  }
+  groups.push_back(c);
+  numCoalesced += c.members - 1;
+
+}
+
+void IFR_Coalesce::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                           const IFR_RegOps &regOps, const IFR_LoopRanges *ranges,
+                           const IFR_RedundantRefs *redundant){
+
+  groupOf.assign(memrefs.refs.size(), NoGroup);
+  groups.clear();
+  numCandidates = 0;
+  numCoalesced = 0;
+
+  vector<OpenGroup> open;
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+
+      if( IFR_Regions::endsAll(code, regOps, in) ){
+        for( unsigned g = 0; g < open.size(); g++ ){ closeGroup(open[g], memrefs, groups, groupOf, numCoalesced); }
+        open.clear();
+        continue;
+      }
+
+      for( unsigned k = memrefs.begin(in); k < memrefs.end(in); k++ ){
+
+        const IFR_MemoryRef &ref = memrefs.refs[k];
+        if( ref.size == 0 || ref.size > IFR_COALESCE_SPAN ||
+            (ref.base == IFR_MemoryRef::NoReg && ref.index == IFR_MemoryRef::NoReg) ){
+          continue;
+        }
+        if( (ranges != 0 && ranges->summarized(k)) || (redundant != 0 && redundant->redundant(k)) ){ continue; }
+        unsigned baseDense = ref.base == IFR_MemoryRef::NoReg ? IFR_RegOps::NoReg : regOps.lookup(ref.base);
+        unsigned indexDense = ref.index == IFR_MemoryRef::NoReg ? IFR_RegOps::NoReg : regOps.lookup(ref.index);
+        if( (ref.base != IFR_MemoryRef::NoReg && baseDense == IFR_RegOps::NoReg) ||
+            (ref.index != IFR_MemoryRef::NoReg && indexDense == IFR_RegOps::NoReg) ||
+            definesAny(regOps, in, baseDense, indexDense) ){
+          continue;
+        }
+        numCandidates++;
+
+        bool write = ref.type != MemRead;
+        UINT32 scale = ref.index == IFR_MemoryRef::NoReg ? 0 : ref.scale;
+        unsigned g = 0;
+        while( g < open.size() && (open[g].base != ref.base || open[g].index != ref.index ||
+                                   open[g].scale != scale || open[g].write != write) ){
+          g++;
+        }
+
+        ADDRDELTA end = ref.displacement + (ADDRDELTA)ref.size;
+        if( g < open.size() ){
+          OpenGroup &o = open[g];
+          ADDRDELTA low = ref.displacement < o.low ? ref.displacement : o.low;
+          ADDRDELTA high = end > o.high ? end : o.high;
+          if( high - low <= IFR_COALESCE_SPAN ){
+            o.low = low;
+            o.high = high;
+            o.refs.push_back(k);
+            continue;
+          }
+          /*Past a line from the group: start the next window here*/
+          closeGroup(o, memrefs, groups, groupOf, numCoalesced);
+        }else{
+          open.push_back(OpenGroup());
+        }
+
+        OpenGroup &o = open[g];
+        o.base = ref.base;
+        o.index = ref.index;
+        o.scale = scale;
+        o.write = write;
+        o.baseDense = baseDense;
+        o.indexDense = indexDense;
+        o.low = ref.displacement;
+        o.high = end;
+        o.refs.assign(1, k);
+
+      }
+
+      /*Later references off a redefined register have a new address*/
+      for( unsigned g = 0; g < open.size(); ){
+        if( definesAny(regOps, in, open[g].baseDense, open[g].indexDense) ){
+          closeGroup(open[g], memrefs, groups, groupOf, numCoalesced);
+          open[g] = open.back();
+          open.pop_back();
+        }else{
+          g++;
+        }
+      }
+
+    }
+
+    for( unsigned g = 0; g < open.size(); g++ ){ closeGroup(open[g], memrefs, groups, groupOf, numCoalesced); }
+    open.clear();
+
+  }
+
+}
+
+size_t IFR_Coalesce::bytes() const{
+  return IFR_Bytes(groupOf) + IFR_Bytes(groups);
+}
@@ -0,0 +1,90 @@
+#ifndef _IFR_COALESCE_H_
+#define _IFR_COALESCE_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_MemoryRef.h"
+#include "IFR_CFG.h"
+#include "IFR_LoopRanges.h"
+#include "IFR_RedundantRefs.h"
+
+/*Widest group, in bytes: one cache line*/
+#define IFR_COALESCE_SPAN 64
+
+/*Memory references of one block instrumented as a single range check.
+ *
+ *Every member has the same base, index and scale and the same direction
+ *(MemWrite and MemBoth both count as writes), and neither address register
+ *is written between the first member and the last, so their addresses
+ *differ only by their displacements.  The group covers
+ *[min displacement, max displacement + size), at most IFR_COALESCE_SPAN
+ *bytes, and mask says which of those bytes a member touches.
+ */
+class IFR_CoalesceGroup{
+
+public:
+
+  unsigned leader;      //the memref with the lowest displacement; the group's address is its address
+  unsigned members;
+  UINT32 length;
+  UINT64 mask;          //bit i: byte leader address + i
+  bool write;
+
+};
+
+/*Intra-block coalescing of memory references: struct fields and stack
+ *slots off one register, which would otherwise cost an analysis call
+ *each, become one range check at the group's leader.
+ *
+ *A block is walked once with a group open per address (base, index,
+ *scale, direction).  A reference joins the open group with its address if
+ *the group stays within IFR_COALESCE_SPAN bytes; otherwise it closes that
+ *group and opens its own, so a run of fields wider than a line splits at
+ *line-sized windows.  A def of either address register closes the group,
+ *and instructions that end every IFR (calls, returns, synchronization;
+ *see IFR_Regions) close all of them, so a group never spans an IFR
+ *boundary and the check can go at whichever member comes first.  Groups
+ *left with one member are dropped.
+ *
+ *Left out: references of unknown size, with no address register or one
+ *missing from IFR_RegOps (the instruction pointer), whose instruction
+ *writes its own address register (push, pop, string instructions), and
+ *those the caller hands over as summarized or redundant, which are
+ *instrumented their own way.
+ */
+class IFR_Coalesce{
+
+  std::vector<unsigned> groupOf;    //per memref: its group, or NoGroup
+
+public:
+
+  static const unsigned NoGroup = (unsigned)-1;
+
+  std::vector<IFR_CoalesceGroup> groups;
+  unsigned numCandidates;
+  unsigned numCoalesced;            //members that are not leaders: checks saved
+
+  IFR_Coalesce();
+
+  /*ranges and redundant may be null; the references they summarize or
+   *find redundant stay out of groups
+   */
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+               const IFR_RegOps &regOps, const IFR_LoopRanges *ranges, const IFR_RedundantRefs *redundant);
+
+  size_t bytes() const;
+
+  /*The group k leads, or null*/
+  const IFR_CoalesceGroup *leads(unsigned k) const{
+    if( k >= groupOf.size() || groupOf[k] == NoGroup ){ return 0; }
+    return groups[ groupOf[k] ].leader == k ? &groups[ groupOf[k] ] : 0;
+  }
+
+  /*Whether k's access is checked by another reference's group*/
+  bool covered(unsigned k) const{
+    return k < groupOf.size() && groupOf[k] != NoGroup && groups[ groupOf[k] ].leader != k;
+  }
+
+};
+
+#endif
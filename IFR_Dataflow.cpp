@@ -0,0 +1,141 @@
+#include "IFR_Dataflow.h"
+
+using std::vector;
+
+IFR_Dataflow::IFR_Dataflow(){
+  sweeps = 0;
+  visits = 0;
+}
+
+void IFR_Dataflow::init(const IFR_CFG &cfg, unsigned width){
+
+  unsigned n = cfg.size();
+  gen.init(n, width);
+  kill.init(n, width);
+  in.init(n, width);
+  out.init(n, width);
+  boundary.init(1, width);
+  atBoundary.assign(n, 0);
+  sweeps = 0;
+  visits = 0;
+
+}
+
+/*Postorder of a DFS forest along the flow's edges, rooted at the entry
+ *first; reversed for forward problems.  Backward problems use the
+ *forward postorder, which puts a block after its successors in most
+ *cases.
+ */
+void IFR_Dataflow::computeOrder(const IFR_CFG &cfg, IFR_FlowDirection dir){
+
+  unsigned n = cfg.size();
+  order.clear();
+  vector<unsigned> stack;
+  vector<const unsigned *> edge;
+  vector<unsigned char> seen(n, 0);
+
+  for( unsigned root = 0; root < n; root++ ){
+
+    if( seen[root] ){ continue; }
+    seen[root] = 1;
+    stack.push_back(root);
+    edge.push_back(cfg.succBegin(root));
+    while( !stack.empty() ){
+
+      unsigned b = stack.back();
+      if( edge.back() != cfg.succEnd(b) ){
+        unsigned s = *(edge.back()++);
+        if( !seen[s] ){
+          seen[s] = 1;
+          stack.push_back(s);
+          edge.push_back(cfg.succBegin(s));
+        }
+      }else{
+        order.push_back(b);
+        stack.pop_back();
+        edge.pop_back();
+      }
+
+    }
+
+  }
+
+  if( dir == FlowForward ){
+    for( unsigned i = 0, j = order.size(); i + 1 < j; i++, j-- ){
+      unsigned t = order[i];
+      order[i] = order[j - 1];
+      order[j - 1] = t;
+    }
+  }
+
+}
+
+void IFR_Dataflow::solve(const IFR_CFG &cfg, IFR_FlowDirection dir, IFR_FlowMeet meet){
+
+  unsigned n = cfg.size();
+  unsigned w = gen.words();
+  sweeps = 0;
+  visits = 0;
+  if( n == 0 ){ return; }
+  computeOrder(cfg, dir);
+
+  /*Union starts from nothing, intersection from everything*/
+  bool top = meet == MeetIntersect;
+  IFR_BitMatrix &meetSet = dir == FlowForward ? in : out;
+  IFR_BitMatrix &result = dir == FlowForward ? out : in;
+  for( unsigned b = 0; b < n; b++ ){
+    IFR_BitsFill(result.row(b), top, w);
+  }
+
+  vector<unsigned char> pending(n, 1);
+  bool any = true;
+  while( any ){
+
+    any = false;
+    sweeps++;
+    for( unsigned k = 0; k < order.size(); k++ ){
+
+      unsigned b = order[k];
+      if( !pending[b] ){ continue; }
+      pending[b] = 0;
+      visits++;
+
+      /*Meet over the neighbours the flow comes from*/
+      const unsigned *nb = dir == FlowForward ? cfg.predBegin(b) : cfg.succBegin(b);
+      const unsigned *ne = dir == FlowForward ? cfg.predEnd(b) : cfg.succEnd(b);
+      UINT64 *m = meetSet.row(b);
+      if( atBoundary[b] ){
+        IFR_BitsCopy(m, boundary.row(0), w);
+      }else if( nb != ne ){
+        IFR_BitsCopy(m, result.row(*nb++), w);
+      }else{
+        IFR_BitsFill(m, false, w);
+      }
+      for( ; nb != ne; nb++ ){
+        if( top ){
+          IFR_BitsAnd(m, result.row(*nb), w);
+        }else{
+          IFR_BitsOr(m, result.row(*nb), w);
+        }
+      }
+
+      if( !IFR_BitsTransfer(result.row(b), gen.row(b), m, kill.row(b), w) ){ continue; }
+
+      /*Blocks downstream see a new input*/
+      const unsigned *db = dir == FlowForward ? cfg.succBegin(b) : cfg.predBegin(b);
+      const unsigned *de = dir == FlowForward ? cfg.succEnd(b) : cfg.predEnd(b);
+      for( ; db != de; db++ ){
+        pending[*db] = 1;
+        any = true;
+      }
+
+    }
+
+  }
+
+}
+
+size_t IFR_Dataflow::bytes() const{
+  return gen.bytes() + kill.bytes() + in.bytes() + out.bytes() + boundary.bytes() +
+         IFR_Bytes(order) + IFR_Bytes(atBoundary);
+}
@@ -0,0 +1,61 @@
+#ifndef _IFR_DATAFLOW_H_
+#define _IFR_DATAFLOW_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+#include "IFR_Bitset.h"
+
+enum IFR_FlowDirection { FlowForward = 0, FlowBackward = 1 };
+enum IFR_FlowMeet { MeetUnion = 0, MeetIntersect = 1 };
+
+/*Iterative solver for bit-vector dataflow problems over a routine's CFG.
+ *
+ *A client sizes the problem with init(), fills in each block's gen and
+ *kill sets and the boundary value, marks the boundary blocks (the entry
+ *for a forward problem, exits for a backward one), and calls solve().
+ *Each block's transfer function is out = gen | (in & ~kill), where in and
+ *out are in the direction of the flow:
+ *
+ *  forward   in[b] = meet of out[p] over predecessors p, out[b] = f(in[b])
+ *  backward  out[b] = meet of in[s] over successors s, in[b] = f(out[b])
+ *
+ *so for a backward problem in[b] is the set at b's first instruction.
+ *Boundary blocks also meet the boundary value.  Blocks are visited in
+ *reverse postorder of the flow (postorder for backward problems), and
+ *each sweep only revisits blocks whose inputs changed, so reducible CFGs
+ *settle in a couple of sweeps.  Blocks no DFS from the entry reaches
+ *(e.g. targets of unresolved indirect jumps) are ordered after it, each
+ *starting its own DFS.
+ */
+class IFR_Dataflow{
+
+  std::vector<unsigned> order;      //blocks in visiting order
+  std::vector<unsigned char> atBoundary;
+
+  void computeOrder(const IFR_CFG &cfg, IFR_FlowDirection dir);
+
+public:
+
+  IFR_BitMatrix gen;
+  IFR_BitMatrix kill;
+  IFR_BitMatrix in;
+  IFR_BitMatrix out;
+  IFR_BitMatrix boundary;           //one row
+
+  unsigned sweeps;                  //over the order, including the last that changed nothing
+  unsigned visits;                  //block transfer functions applied
+
+  IFR_Dataflow();
+
+  /*Sizes every set to width bits and clears them and the boundary marks*/
+  void init(const IFR_CFG &cfg, unsigned width);
+
+  void setBoundary(unsigned b) { atBoundary[b] = 1; }
+
+  void solve(const IFR_CFG &cfg, IFR_FlowDirection dir, IFR_FlowMeet meet);
+
+  size_t bytes() const;
+
+};
+
+#endif
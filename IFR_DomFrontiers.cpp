@@ -0,0 +1,188 @@
+#include <algorithm>
+#include "IFR_DomFrontiers.h"
+
+using std::vector;
+
+IFR_DomFrontiers::IFR_DomFrontiers(){
+  dfStart.assign(1, 0);
+}
+
+void IFR_DomFrontiers::compute(const IFR_CFG &cfg, const IFR_DomTree &domTree){
+
+  unsigned n = cfg.size();
+  const unsigned NoBlock = IFR_Dominators::NoBlock;
+
+  /*Cooper/Harvey/Kennedy: walk up from each predecessor of a join block
+   *until reaching the join's idom, emitting (runner, join) pairs.  lastJoin
+   *drops the repeats that come from several predecessors sharing a path.
+   */
+  vector<unsigned> pairs;
+  vector<unsigned> lastJoin(n, NoBlock);
+  dfStart.assign(n + 1, 0);
+  for( unsigned b = 0; b < n; b++ ){
+
+    if( cfg.numPreds(b) < 2 || !domTree.reachable(b) ){ continue; }
+
+    for( const unsigned *p = cfg.predBegin(b); p != cfg.predEnd(b); p++ ){
+
+      if( !domTree.reachable(*p) ){ continue; }
+
+      unsigned runner = *p;
+      while( runner != domTree.idom(b) && lastJoin[runner] != b ){
+        lastJoin[runner] = b;
+        pairs.push_back(runner);
+        pairs.push_back(b);
+        dfStart[runner + 1]++;
+        runner = domTree.idom(runner);
+      }
+
+    }
+
+  }
+
+  /*Counting sort into CSR.  Joins were visited in index order, so every
+   *frontier list comes out sorted.
+   */
+  for( unsigned b = 0; b < n; b++ ){
+    dfStart[b + 1] += dfStart[b];
+  }
+  dfs.resize(pairs.size() / 2);
+  vector<unsigned> fill(dfStart.begin(), dfStart.end() - 1);
+  for( unsigned i = 0; i < pairs.size(); i += 2 ){
+    dfs[ fill[ pairs[i] ]++ ] = pairs[i + 1];
+  }
+
+}
+
+IFR_IDF::IFR_IDF(){
+  cfg = 0;
+  domTree = 0;
+  frontiers = 0;
+  stamp = 0;
+}
+
+void IFR_IDF::init(const IFR_CFG &c, const IFR_DomTree &d, const IFR_DomFrontiers *df){
+
+  cfg = &c;
+  domTree = &d;
+  frontiers = df;
+  stamp = 0;
+  queued.assign(c.size(), 0);
+  walked.assign(c.size(), 0);
+  isDef.assign(c.size(), 0);
+  piggybank.clear();
+
+}
+
+void IFR_IDF::compute(const vector<unsigned> &defs, vector<unsigned> &idf){
+
+  stamp++;
+  unsigned first = idf.size();
+
+  if( frontiers != 0 ){
+
+    /*queued marks DF+ membership; isDef marks blocks already on the worklist*/
+    for( vector<unsigned>::const_iterator d = defs.begin(); d != defs.end(); d++ ){
+      if( !domTree->reachable(*d) || isDef[*d] == stamp ){ continue; }
+      isDef[*d] = stamp;
+      worklist.push_back(*d);
+    }
+    while( !worklist.empty() ){
+      unsigned x = worklist.back();
+      worklist.pop_back();
+      for( const unsigned *y = frontiers->begin(x); y != frontiers->end(x); y++ ){
+        if( queued[*y] == stamp ){ continue; }
+        queued[*y] = stamp;
+        idf.push_back(*y);
+        if( isDef[*y] != stamp ){
+          isDef[*y] = stamp;
+          worklist.push_back(*y);
+        }
+      }
+    }
+    std::sort(idf.begin() + first, idf.end());
+    return;
+
+  }
+
+  unsigned top = 0;  //deepest non-empty piggybank level
+
+  for( vector<unsigned>::const_iterator d = defs.begin(); d != defs.end(); d++ ){
+
+    if( !domTree->reachable(*d) || isDef[*d] == stamp ){ continue; }
+    isDef[*d] = stamp;
+    unsigned level = domTree->depth(*d);
+    if( piggybank.size() <= level ){ piggybank.resize(level + 1); }
+    piggybank[level].push_back(*d);
+    if( level > top ){ top = level; }
+
+  }
+
+  while( true ){
+
+    while( top > 0 && piggybank[top].empty() ){ top--; }
+    if( piggybank.empty() || piggybank[top].empty() ){ break; }
+
+    unsigned root = piggybank[top].back();
+    piggybank[top].pop_back();
+    unsigned rootLevel = top;
+
+    worklist.push_back(root);
+    walked[root] = stamp;
+    while( !worklist.empty() ){
+
+      unsigned x = worklist.back();
+      worklist.pop_back();
+
+      /*J edges out of root's subtree that reach root's level or above land
+       *in DF+.  D edges always go one level deeper and fail the test.
+       */
+      for( const unsigned *s = cfg->succBegin(x); s != cfg->succEnd(x); s++ ){
+
+        unsigned level = domTree->depth(*s);
+        if( level > rootLevel || queued[*s] == stamp ){ continue; }
+        queued[*s] = stamp;
+        idf.push_back(*s);
+        if( isDef[*s] != stamp ){
+          piggybank[level].push_back(*s);
+        }
+
+      }
+
+      for( const unsigned *c = domTree->childBegin(x); c != domTree->childEnd(x); c++ ){
+        if( walked[*c] != stamp ){
+          walked[*c] = stamp;
+          worklist.push_back(*c);
+        }
+      }
+
+    }
+
+  }
+
+  std::sort(idf.begin() + first, idf.end());
+
+}
+
+void IFR_DomFrontiers::save(IFR_BlobWriter &w) const{
+  w.putWords(dfStart);
+  w.putWords(dfs);
+}
+
+bool IFR_DomFrontiers::load(IFR_BlobReader &r){
+
+  r.getWords(dfStart);
+  r.getWords(dfs);
+  if( !r.ok() || !IFR_ValidStarts(dfStart, dfs.size()) || !IFR_ValidIndices(dfs, dfStart.size() - 1) ){
+    dfStart.assign(1, 0);
+    dfs.clear();
+    return false;
+  }
+  return true;
+
+}
+
+size_t IFR_DomFrontiers::bytes() const{
+  return IFR_Bytes(dfStart) +
+         IFR_Bytes(dfs);
+}
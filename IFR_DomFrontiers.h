@@ -0,0 +1,73 @@
+#ifndef _IFR_DOMFRONTIERS_H_
+#define _IFR_DOMFRONTIERS_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+#include "IFR_DomTree.h"
+
+/*Dominance frontiers of every block, stored CSR-style: DF(b) is
+ *dfs[dfStart[b]..dfStart[b+1]), sorted by block index.
+ */
+class IFR_DomFrontiers{
+
+  std::vector<unsigned> dfStart;
+  std::vector<unsigned> dfs;
+
+public:
+
+  IFR_DomFrontiers();
+
+  void compute(const IFR_CFG &cfg, const IFR_DomTree &domTree);
+
+  void save(IFR_BlobWriter &w) const;
+  bool load(IFR_BlobReader &r);
+
+  size_t bytes() const;
+
+  unsigned size() const { return dfStart.size() - 1; }
+  unsigned numEntries() const { return dfs.size(); }
+  const unsigned *begin(unsigned b) const { return dfs.empty() ? 0 : &dfs[0] + dfStart[b]; }
+  const unsigned *end(unsigned b) const { return dfs.empty() ? 0 : &dfs[0] + dfStart[b + 1]; }
+
+};
+
+/*Iterated dominance frontier (DF+) queries, e.g. for phi placement.
+ *
+ *Without frontiers this is Sreedhar and Gao's linear-time walk over the DJ
+ *graph ("A Linear Time Algorithm for Placing phi-nodes"): def blocks are
+ *drained deepest dominator-tree level first, and each one's dominator
+ *subtree is searched for join edges that climb to its level or above.
+ *That bounds every query by O(N + E) even when frontiers are quadratic.
+ *
+ *Given flat frontiers it instead runs Cytron's worklist over them, which
+ *costs only the frontier entries it touches and wins on the small frontiers
+ *of structured code (see Tests/DFBench).
+ *
+ *Scratch state is kept between calls and reset by generation stamps, so
+ *asking once per register never pays O(N) to clear it.
+ */
+class IFR_IDF{
+
+  const IFR_CFG *cfg;
+  const IFR_DomTree *domTree;
+  const IFR_DomFrontiers *frontiers;
+
+  unsigned stamp;
+  std::vector<unsigned> queued;     //== stamp once the block entered the piggybank
+  std::vector<unsigned> walked;     //== stamp once the block was visited by a subtree walk
+  std::vector<unsigned> isDef;      //== stamp for the current def blocks
+  std::vector< std::vector<unsigned> > piggybank;  //blocks waiting, bucketed by tree depth
+  std::vector<unsigned> worklist;
+
+public:
+
+  IFR_IDF();
+
+  void init(const IFR_CFG &c, const IFR_DomTree &d, const IFR_DomFrontiers *df);
+
+  /*Appends DF+(defs) to idf, sorted by block index*/
+  void compute(const std::vector<unsigned> &defs, std::vector<unsigned> &idf);
+
+};
+
+#endif
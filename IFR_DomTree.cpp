@@ -0,0 +1,188 @@
+#include "IFR_DomTree.h"
+
+using std::vector;
+
+IFR_DomTree::IFR_DomTree(){
+  levels = 0;
+}
+
+void IFR_DomTree::build(const IFR_Dominators &doms){
+
+  vector<unsigned> idomList(doms.size());
+  for( unsigned b = 0; b < idomList.size(); b++ ){
+    idomList[b] = doms.idom(b);
+  }
+  build(idomList);
+
+}
+
+void IFR_DomTree::build(const vector<unsigned> &idomList){
+
+  unsigned n = idomList.size();
+  const unsigned NoBlock = IFR_Dominators::NoBlock;
+
+  idoms = idomList;
+  pre.assign(n, NoBlock);
+  post.assign(n, NoBlock);
+  depths.assign(n, 0);
+  first.assign(n, NoBlock);
+  kidStart.assign(1, 0);
+  kids.clear();
+  tour.clear();
+  sparse.clear();
+  levels = 0;
+  if( n == 0 ){ return; }
+
+  /*Children of each block as one flat array: kids[kidStart[b]..kidStart[b+1])*/
+  kidStart.assign(n + 1, 0);
+  for( unsigned b = 0; b < n; b++ ){
+    if( idoms[b] != NoBlock ){ kidStart[ idoms[b] + 1 ]++; }
+  }
+  for( unsigned b = 0; b < n; b++ ){
+    kidStart[b + 1] += kidStart[b];
+  }
+  kids.resize(kidStart[n]);
+  vector<unsigned> fill(kidStart.begin(), kidStart.end() - 1);
+  for( unsigned b = 0; b < n; b++ ){
+    if( idoms[b] != NoBlock ){ kids[ fill[ idoms[b] ]++ ] = b; }
+  }
+
+  /*Iterative DFS of the tree from the entry, recording pre/post numbers and
+   *the Euler tour (a block is re-emitted each time a child returns to it).
+   */
+  unsigned preCount = 0, postCount = 0;
+  vector<unsigned> stack;
+  vector<unsigned> next;
+  stack.push_back(0);
+  next.push_back(kidStart[0]);
+  pre[0] = preCount++;
+  first[0] = 0;
+  tour.push_back(0);
+  while( !stack.empty() ){
+
+    unsigned b = stack.back();
+    if( next.back() < kidStart[b + 1] ){
+
+      unsigned c = kids[ next.back()++ ];
+      depths[c] = depths[b] + 1;
+      pre[c] = preCount++;
+      first[c] = tour.size();
+      tour.push_back(c);
+      stack.push_back(c);
+      next.push_back(kidStart[c]);
+
+    }else{
+
+      post[b] = postCount++;
+      stack.pop_back();
+      next.pop_back();
+      if( !stack.empty() ){ tour.push_back( stack.back() ); }
+
+    }
+
+  }
+
+  /*Sparse table: level k holds the shallowest block in tour[i, i + 2^k)*/
+  unsigned m = tour.size();
+  levels = 1;
+  while( (1u << levels) <= m ){ levels++; }
+  sparse.resize(levels * m);
+  for( unsigned i = 0; i < m; i++ ){
+    sparse[i] = tour[i];
+  }
+  for( unsigned k = 1; k < levels; k++ ){
+    unsigned half = 1u << (k - 1);
+    for( unsigned i = 0; i + (1u << k) <= m; i++ ){
+      sparse[k * m + i] = shallower( sparse[(k - 1) * m + i], sparse[(k - 1) * m + i + half] );
+    }
+  }
+
+}
+
+void IFR_DomTree::save(IFR_BlobWriter &w) const{
+  w.putWords(idoms);
+}
+
+bool IFR_DomTree::load(IFR_BlobReader &r){
+
+  vector<unsigned> idomList;
+  r.getWords(idomList);
+  if( !r.ok() || (!idomList.empty() && idomList[0] != IFR_Dominators::NoBlock) ){ return false; }
+  for( unsigned b = 0; b < idomList.size(); b++ ){
+    if( idomList[b] != IFR_Dominators::NoBlock && idomList[b] >= idomList.size() ){
+      return false;
+    }
+  }
+
+  /*Every block with an idom must hang off the entry; a cycle would leave
+   *children the tree walk never reaches
+   */
+  build(idomList);
+  for( unsigned b = 0; b < idomList.size(); b++ ){
+    if( idomList[b] != IFR_Dominators::NoBlock && !reachable(b) ){
+      build( vector<unsigned>() );
+      return false;
+    }
+  }
+  return true;
+
+}
+
+bool IFR_DomTree::reachable(unsigned b) const{
+  return b < pre.size() && pre[b] != IFR_Dominators::NoBlock;
+}
+
+unsigned IFR_DomTree::shallower(unsigned a, unsigned b) const{
+  return depths[a] <= depths[b] ? a : b;
+}
+
+unsigned IFR_DomTree::size() const{
+  return idoms.size();
+}
+
+unsigned IFR_DomTree::idom(unsigned b) const{
+  return b < idoms.size() ? idoms[b] : IFR_Dominators::NoBlock;
+}
+
+unsigned IFR_DomTree::depth(unsigned b) const{
+  return reachable(b) ? depths[b] : 0;
+}
+
+bool IFR_DomTree::dominates(unsigned a, unsigned b) const{
+  return reachable(a) && reachable(b) && pre[a] <= pre[b] && post[b] <= post[a];
+}
+
+bool IFR_DomTree::strictlyDominates(unsigned a, unsigned b) const{
+  return a != b && dominates(a, b);
+}
+
+bool IFR_DomTree::immediatelyDominates(unsigned a, unsigned b) const{
+  return reachable(a) && reachable(b) && idoms[b] == a;
+}
+
+unsigned IFR_DomTree::nearestCommonDominator(unsigned a, unsigned b) const{
+
+  if( !reachable(a) || !reachable(b) ){ return IFR_Dominators::NoBlock; }
+
+  unsigned lo = first[a], hi = first[b];
+  if( lo > hi ){ unsigned t = lo; lo = hi; hi = t; }
+
+  unsigned k = 0;
+  while( (2u << k) <= hi - lo + 1 ){ k++; }
+
+  unsigned m = tour.size();
+  return shallower( sparse[k * m + lo], sparse[k * m + hi + 1 - (1u << k)] );
+
+}
+
+size_t IFR_DomTree::bytes() const{
+  return IFR_Bytes(idoms) +
+         IFR_Bytes(pre) +
+         IFR_Bytes(post) +
+         IFR_Bytes(depths) +
+         IFR_Bytes(kidStart) +
+         IFR_Bytes(kids) +
+         IFR_Bytes(first) +
+         IFR_Bytes(tour) +
+         IFR_Bytes(sparse);
+}
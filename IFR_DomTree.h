@@ -0,0 +1,68 @@
+#ifndef _IFR_DOMTREE_H_
+#define _IFR_DOMTREE_H_
+
+#include <vector>
+#include "IFR_Dominators.h"
+#include "IFR_Serialize.h"
+
+/*Read-only index over a dominator tree, built once per routine.
+ *
+ *Each reachable block gets a preorder and postorder number from a DFS of
+ *the tree, so a dominates b iff pre[a] <= pre[b] and post[b] <= post[a].
+ *Nearest common dominators are LCA queries answered by a sparse table over
+ *the tree's Euler tour.  Unreachable blocks and out-of-range indices
+ *(e.g. NoBlock from a failed address lookup) dominate nothing and are
+ *dominated by nothing.
+ */
+class IFR_DomTree{
+
+  std::vector<unsigned> idoms;
+  std::vector<unsigned> pre;
+  std::vector<unsigned> post;
+  std::vector<unsigned> depths;
+
+  std::vector<unsigned> kidStart; //children of b are kids[kidStart[b]..kidStart[b+1])
+  std::vector<unsigned> kids;
+
+  std::vector<unsigned> first;    //first position of each block in the tour
+  std::vector<unsigned> tour;     //Euler tour of the tree, as blocks
+  std::vector<unsigned> sparse;   //level k, position i at [k * tour.size() + i]
+  unsigned levels;
+
+  unsigned shallower(unsigned a, unsigned b) const;
+
+public:
+
+  IFR_DomTree();
+
+  void build(const IFR_Dominators &doms);
+
+  /*Builds from a list of immediate dominators (NoBlock for the entry and
+   *unreachable blocks)
+   */
+  void build(const std::vector<unsigned> &idomList);
+
+  /*Only the idoms are stored; load rebuilds the index from them*/
+  void save(IFR_BlobWriter &w) const;
+  bool load(IFR_BlobReader &r);
+
+  size_t bytes() const;
+
+  unsigned size() const;
+  bool reachable(unsigned b) const;
+  unsigned idom(unsigned b) const;
+  unsigned depth(unsigned b) const;
+
+  const unsigned *childBegin(unsigned b) const { return kids.empty() ? 0 : &kids[0] + kidStart[b]; }
+  const unsigned *childEnd(unsigned b) const { return kids.empty() ? 0 : &kids[0] + kidStart[b + 1]; }
+
+  bool dominates(unsigned a, unsigned b) const;
+  bool strictlyDominates(unsigned a, unsigned b) const;
+  bool immediatelyDominates(unsigned a, unsigned b) const;
+
+  /*Deepest block dominating both a and b; NoBlock if either is unreachable*/
+  unsigned nearestCommonDominator(unsigned a, unsigned b) const;
+
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "IFR_Dominators.h"
+
+using std::vector;
+
+const unsigned IFR_Dominators::NoBlock;
+
+IFR_Dominators::IFR_Dominators(){
+  rounds = 0;
+}
+
+void IFR_Dominators::compute(const IFR_CFG &cfg, IFR_DomAlgorithm alg){
+
+  unsigned n = cfg.size();
+  idoms.assign(n, NoBlock);
+  order.clear();
+  rpoNum.assign(n, NoBlock);
+  rounds = 0;
+  if( n == 0 ){ return; }
+
+  if( alg == DomAuto ){
+    alg = (n > IFR_DOM_LT_THRESHOLD) ? DomLT : DomCHK;
+  }
+
+  computeRPO(cfg);
+  if( alg == DomLT ){
+    computeLT(cfg);
+  }else{
+    computeCHK(cfg);
+  }
+
+}
+
+void IFR_Dominators::computeRPO(const IFR_CFG &cfg){
+
+  /*Iterative DFS from the entry; blocks are appended in postorder and the
+   *list is reversed at the end.
+   */
+  vector<unsigned> stack;
+  vector<const unsigned *> edge;  //next successor to visit for each stacked block
+  vector<bool> seen(cfg.size(), false);
+
+  stack.push_back(0);
+  edge.push_back(cfg.succBegin(0));
+  seen[0] = true;
+  while( !stack.empty() ){
+
+    unsigned b = stack.back();
+    if( edge.back() != cfg.succEnd(b) ){
+
+      unsigned s = *(edge.back()++);
+      if( !seen[s] ){
+        seen[s] = true;
+        stack.push_back(s);
+        edge.push_back(cfg.succBegin(s));
+      }
+
+    }else{
+
+      order.push_back(b);
+      stack.pop_back();
+      edge.pop_back();
+
+    }
+
+  }
+
+  for( unsigned i = 0, j = order.size() - 1; i < j; i++, j-- ){
+    unsigned t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+
+  for( unsigned i = 0; i < order.size(); i++ ){
+    rpoNum[ order[i] ] = i;
+  }
+
+}
+
+void IFR_Dominators::computeCHK(const IFR_CFG &cfg){
+
+  /*During the fixpoint the entry is its own idom so the intersection walk
+   *terminates there; it is reset to NoBlock afterwards.
+   */
+  idoms[0] = 0;
+
+  bool anyChange;
+  do{
+
+    anyChange = false;
+    rounds++;
+    for( unsigned i = 1; i < order.size(); i++ ){
+
+      unsigned b = order[i];
+      unsigned newIDom = NoBlock;
+      for( const unsigned *p = cfg.predBegin(b); p != cfg.predEnd(b); p++ ){
+
+        if( idoms[*p] == NoBlock ){ continue; }  //not processed yet, or unreachable
+
+        if( newIDom == NoBlock ){
+          newIDom = *p;
+          continue;
+        }
+
+        /*Intersect: walk both fingers up the current tree until they meet*/
+        unsigned f1 = *p;
+        unsigned f2 = newIDom;
+        while( f1 != f2 ){
+          while( rpoNum[f1] > rpoNum[f2] ){ f1 = idoms[f1]; }
+          while( rpoNum[f2] > rpoNum[f1] ){ f2 = idoms[f2]; }
+        }
+        newIDom = f1;
+
+      }
+
+      if( idoms[b] != newIDom ){
+        idoms[b] = newIDom;
+        anyChange = true;
+      }
+
+    }
+
+  }while(anyChange);
+
+  idoms[0] = NoBlock;
+
+}
+
+static unsigned ltEval(unsigned v,
+                       vector<unsigned> &ancestor,
+                       vector<unsigned> &label,
+                       const vector<unsigned> &semi,
+                       vector<unsigned> &path){
+
+  /*Lengauer/Tarjan EVAL: the vertex with minimal semi on v's forest path,
+   *compressing the path on the way.  path is scratch space.
+   */
+  if( ancestor[v] == IFR_Dominators::NoBlock ){ return v; }
+
+  unsigned u = v;
+  while( ancestor[ ancestor[u] ] != IFR_Dominators::NoBlock ){
+    path.push_back(u);
+    u = ancestor[u];
+  }
+  while( !path.empty() ){
+    unsigned x = path.back();
+    path.pop_back();
+    unsigned a = ancestor[x];
+    if( semi[ label[a] ] < semi[ label[x] ] ){
+      label[x] = label[a];
+    }
+    ancestor[x] = ancestor[a];
+  }
+  return label[v];
+
+}
+
+void IFR_Dominators::computeLT(const IFR_CFG &cfg){
+
+  /*Lengauer/Tarjan, "A Fast Algorithm for Finding Dominators in a Flowgraph",
+   *with simple linking and iterative path compression.  semi[] holds DFS
+   *preorder numbers; vertex[] maps them back to blocks.
+   */
+  unsigned n = cfg.size();
+  vector<unsigned> dfnum(n, NoBlock);
+  vector<unsigned> vertex;
+  vector<unsigned> parent(n, NoBlock);
+  vector<unsigned> semi(n, NoBlock);
+  vector<unsigned> ancestor(n, NoBlock);
+  vector<unsigned> label(n);
+  vector< vector<unsigned> > bucket(n);
+
+  vector<unsigned> stack;
+  vector<const unsigned *> edge;
+  dfnum[0] = 0;
+  vertex.push_back(0);
+  stack.push_back(0);
+  edge.push_back(cfg.succBegin(0));
+  while( !stack.empty() ){
+
+    unsigned b = stack.back();
+    if( edge.back() != cfg.succEnd(b) ){
+
+      unsigned s = *(edge.back()++);
+      if( dfnum[s] == NoBlock ){
+        dfnum[s] = vertex.size();
+        vertex.push_back(s);
+        parent[s] = b;
+        stack.push_back(s);
+        edge.push_back(cfg.succBegin(s));
+      }
+
+    }else{
+
+      stack.pop_back();
+      edge.pop_back();
+
+    }
+
+  }
+
+  for( unsigned i = 0; i < n; i++ ){
+    semi[i] = dfnum[i];
+    label[i] = i;
+  }
+
+  vector<unsigned> path;
+  for( unsigned i = vertex.size() - 1; i > 0; i-- ){
+
+    unsigned w = vertex[i];
+    for( const unsigned *p = cfg.predBegin(w); p != cfg.predEnd(w); p++ ){
+
+      if( dfnum[*p] == NoBlock ){ continue; }  //unreachable predecessor
+
+      unsigned u = ltEval(*p, ancestor, label, semi, path);
+      if( semi[u] < semi[w] ){
+        semi[w] = semi[u];
+      }
+
+    }
+
+    bucket[ vertex[ semi[w] ] ].push_back(w);
+    ancestor[w] = parent[w];
+
+    vector<unsigned> &bk = bucket[ parent[w] ];
+    for( vector<unsigned>::iterator vi = bk.begin(); vi != bk.end(); vi++ ){
+
+      unsigned v = *vi;
+      unsigned u = ltEval(v, ancestor, label, semi, path);
+      idoms[v] = (semi[u] < semi[v]) ? u : parent[w];
+
+    }
+    bk.clear();
+
+  }
+
+  for( unsigned i = 1; i < vertex.size(); i++ ){
+    unsigned w = vertex[i];
+    if( idoms[w] != vertex[ semi[w] ] ){
+      idoms[w] = idoms[ idoms[w] ];
+    }
+  }
+
+  idoms[0] = NoBlock;
+
+}
+
+unsigned IFR_Dominators::size() const{
+  return idoms.size();
+}
+
+unsigned IFR_Dominators::idom(unsigned b) const{
+  return idoms[b];
+}
+
+bool IFR_Dominators::reachable(unsigned b) const{
+  return rpoNum[b] != NoBlock;
+}
+
+const vector<unsigned> &IFR_Dominators::rpo() const{
+  return order;
+}
+
+bool IFR_Dominators::dominates(unsigned a, unsigned b) const{
+
+  if( !reachable(b) ){ return false; }
+  while( b != NoBlock ){
+    if( b == a ){ return true; }
+    b = idoms[b];
+  }
+  return false;
+
+}
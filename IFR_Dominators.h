@@ -0,0 +1,53 @@
+#ifndef _IFR_DOMINATORS_H_
+#define _IFR_DOMINATORS_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+
+/*Which algorithm computes the immediate dominator tree.
+ *DomCHK is the iterative Cooper/Harvey/Kennedy scheme over reverse postorder
+ *("A Simple, Fast Dominance Algorithm"), which is fastest on the CFGs that
+ *compilers produce.  DomLT is Lengauer/Tarjan with path compression, whose
+ *worst case stays near-linear on huge or pathological CFGs.
+ */
+enum IFR_DomAlgorithm { DomCHK = 0, DomLT = 1, DomAuto = 2 };
+
+/*Blocks above this count use Lengauer/Tarjan when DomAuto is requested*/
+#define IFR_DOM_LT_THRESHOLD 20000
+
+class IFR_Dominators{
+
+  std::vector<unsigned> idoms;    //idom of each block, NoBlock for entry/unreachable
+  std::vector<unsigned> order;    //reachable blocks in reverse postorder
+  std::vector<unsigned> rpoNum;   //position of each block in order, NoBlock if unreachable
+  unsigned rounds;                //CHK fixpoint sweeps
+
+  void computeRPO(const IFR_CFG &cfg);
+  void computeCHK(const IFR_CFG &cfg);
+  void computeLT(const IFR_CFG &cfg);
+
+public:
+
+  static const unsigned NoBlock = (unsigned)-1;
+
+  IFR_Dominators();
+
+  /*Block 0 of cfg is the entry*/
+  void compute(const IFR_CFG &cfg, IFR_DomAlgorithm alg);
+
+  unsigned size() const;
+  unsigned idom(unsigned b) const;
+  bool reachable(unsigned b) const;
+  const std::vector<unsigned> &rpo() const;
+
+  /*Sweeps the CHK fixpoint took, including the last one that changed
+   *nothing; 0 if Lengauer/Tarjan ran
+   */
+  unsigned iterations() const { return rounds; }
+
+  /*True if a dominates b.  Walks b's idom chain, so it costs O(depth)*/
+  bool dominates(unsigned a, unsigned b) const;
+
+};
+
+#endif
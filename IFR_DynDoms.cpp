@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <utility>
+
+#include "IFR_DynDoms.h"
+
+using std::vector;
+using std::pair;
+
+const unsigned IFR_DynDoms::NoDepth;
+
+static const unsigned NoBlock = IFR_CFG::NoBlock;
+
+/*Next generation of a stamped array, clearing it when the stamp wraps*/
+static unsigned bump(unsigned &stamp, vector<unsigned> &v){
+  if( ++stamp == 0 ){
+    std::fill(v.begin(), v.end(), 0);
+    stamp = 1;
+  }
+  return stamp;
+}
+
+static void unlink(vector<unsigned> &v, unsigned b){
+  vector<unsigned>::iterator i = std::find(v.begin(), v.end(), b);
+  if( i != v.end() ){
+    *i = v.back();
+    v.pop_back();
+  }
+}
+
+IFR_DynDoms::IFR_DynDoms(){
+  stamp = 0;
+  round = 0;
+  edgesAdded = 0;
+  blocksMoved = 0;
+  frontiersRebuilt = 0;
+  visits = 0;
+}
+
+void IFR_DynDoms::init(const IFR_CFG &cfg, const IFR_DomTree &domTree, const IFR_DomFrontiers &df){
+
+  unsigned n = cfg.size();
+  succs.assign(n, vector<unsigned>());
+  preds.assign(n, vector<unsigned>());
+  kids.assign(n, vector<unsigned>());
+  frontiers.assign(n, vector<unsigned>());
+  idoms.assign(n, NoBlock);
+  depths.assign(n, NoDepth);
+  seen.assign(n, 0);
+  climbed.assign(n, 0);
+  marked.assign(n, 0);
+  number.assign(n, 0);
+  stamp = 0;
+  round = 0;
+
+  for( unsigned b = 0; b < n; b++ ){
+    succs[b].assign(cfg.succBegin(b), cfg.succEnd(b));
+    preds[b].assign(cfg.predBegin(b), cfg.predEnd(b));
+    if( !domTree.reachable(b) ){ continue; }
+    depths[b] = domTree.depth(b);
+    idoms[b] = domTree.idom(b);
+    if( idoms[b] != NoBlock ){ kids[ idoms[b] ].push_back(b); }
+    frontiers[b].assign(df.begin(b), df.end(b));
+  }
+
+}
+
+bool IFR_DynDoms::insertEdge(unsigned x, unsigned y){
+
+  if( x >= size() || y >= size() ||
+      std::find(succs[x].begin(), succs[x].end(), y) != succs[x].end() ){
+    return false;
+  }
+
+  moved.clear();
+  reframed.clear();
+  dirty.clear();
+  bump(round, marked);
+  insert(x, y);
+  rebuildFrontiers();
+  edgesAdded++;
+  return true;
+
+}
+
+void IFR_DynDoms::insert(unsigned x, unsigned y){
+
+  succs[x].push_back(y);
+  preds[y].push_back(x);
+
+  /*The entry is in no frontier until its second predecessor, reachable or
+   *not, and then in those along both
+   */
+  if( reachable(y) && depths[y] == 0 && preds[y].size() == 2 ){
+    markDirty(y);
+    for( unsigned i = 0; i < 2; i++ ){
+      for( unsigned v = preds[y][i]; reachable(v) && v != y; v = idoms[v] ){ markDirty(v); }
+    }
+  }
+  if( !reachable(x) ){ return; }
+  if( reachable(y) ){
+    insertReachable(x, y);
+  }else{
+    reachRegion(x, y);
+  }
+
+}
+
+void IFR_DynDoms::markDirty(unsigned b){
+  if( marked[b] == round ){ return; }
+  marked[b] = round;
+  dirty.push_back(b);
+}
+
+void IFR_DynDoms::reparent(unsigned b, unsigned parent){
+  if( idoms[b] != NoBlock ){ unlink(kids[ idoms[b] ], b); }
+  idoms[b] = parent;
+  kids[parent].push_back(b);
+}
+
+/*Depths of root's subtree, from its idom's*/
+void IFR_DynDoms::setDepths(unsigned root){
+
+  depths[root] = depths[ idoms[root] ] + 1;
+  vector<unsigned> stack(1, root);
+  while( !stack.empty() ){
+    unsigned b = stack.back();
+    stack.pop_back();
+    for( unsigned k = 0; k < kids[b].size(); k++ ){
+      depths[ kids[b][k] ] = depths[b] + 1;
+      stack.push_back(kids[b][k]);
+    }
+  }
+
+}
+
+void IFR_DynDoms::insertReachable(unsigned x, unsigned y){
+
+  unsigned a = x, b = y;
+  while( depths[a] > depths[b] ){ a = idoms[a]; }
+  while( depths[b] > depths[a] ){ b = idoms[b]; }
+  while( a != b ){
+    a = idoms[a];
+    b = idoms[b];
+  }
+  unsigned nca = a;
+
+  for( unsigned v = x; v != nca; v = idoms[v] ){ markDirty(v); }
+  if( y == nca ){ markDirty(y); }
+  if( depths[y] <= depths[nca] + 1 ){ return; }
+
+  /*Affected blocks in decreasing depth order; from each, the search goes
+   *on through deeper blocks, which it cannot affect
+   */
+  unsigned s = bump(stamp, seen);
+  unsigned limit = depths[nca] + 1;
+  vector<unsigned> affected(1, y);
+  vector< pair<unsigned, unsigned> > heap(1, std::make_pair(depths[y], y));
+  vector<unsigned> stack;
+  seen[y] = s;
+
+  while( !heap.empty() ){
+
+    std::pop_heap(heap.begin(), heap.end());
+    unsigned z = heap.back().second, zDepth = heap.back().first;
+    heap.pop_back();
+    stack.assign(1, z);
+
+    while( !stack.empty() ){
+      unsigned u = stack.back();
+      stack.pop_back();
+      visits++;
+      for( unsigned k = 0; k < succs[u].size(); k++ ){
+        unsigned v = succs[u][k];
+        if( seen[v] == s || !reachable(v) ){ continue; }
+        if( depths[v] > zDepth ){
+          seen[v] = s;
+          stack.push_back(v);
+        }else if( depths[v] > limit ){
+          seen[v] = s;
+          affected.push_back(v);
+          heap.push_back(std::make_pair(depths[v], v));
+          std::push_heap(heap.begin(), heap.end());
+        }
+      }
+    }
+
+  }
+
+  /*Their former dominators below nca lose them from their subtrees*/
+  unsigned c = bump(stamp, climbed);
+  for( unsigned i = 0; i < affected.size(); i++ ){
+    for( unsigned v = idoms[ affected[i] ]; v != nca && climbed[v] != c; v = idoms[v] ){
+      climbed[v] = c;
+      markDirty(v);
+    }
+  }
+
+  for( unsigned i = 0; i < affected.size(); i++ ){ reparent(affected[i], nca); }
+  for( unsigned i = 0; i < affected.size(); i++ ){ setDepths(affected[i]); }
+  moved.insert(moved.end(), affected.begin(), affected.end());
+  blocksMoved += affected.size();
+
+}
+
+void IFR_DynDoms::reachRegion(unsigned x, unsigned y){
+
+  /*The region in postorder, by an iterative DFS from y*/
+  unsigned s = bump(stamp, seen);
+  vector<unsigned> region;
+  vector< pair<unsigned, unsigned> > stack(1, std::make_pair(y, 0u));
+  seen[y] = s;
+  while( !stack.empty() ){
+    unsigned u = stack.back().first;
+    unsigned &k = stack.back().second;
+    visits++;
+    while( k < succs[u].size() && (seen[ succs[u][k] ] == s || reachable(succs[u][k])) ){ k++; }
+    if( k == succs[u].size() ){
+      number[u] = region.size();
+      region.push_back(u);
+      stack.pop_back();
+      continue;
+    }
+    unsigned v = succs[u][k++];
+    seen[v] = s;
+    stack.push_back(std::make_pair(v, 0u));
+  }
+
+  /*Edges back out of the region wait until it is in the tree*/
+  vector< pair<unsigned, unsigned> > pending;
+  for( unsigned i = 0; i < region.size(); i++ ){
+    unsigned u = region[i];
+    for( unsigned k = 0; k < succs[u].size(); ){
+      unsigned v = succs[u][k];
+      if( reachable(v) ){
+        pending.push_back(std::make_pair(u, v));
+        succs[u][k] = succs[u].back();
+        succs[u].pop_back();
+        unlink(preds[v], u);
+      }else{
+        k++;
+      }
+    }
+  }
+
+  /*Cooper, Harvey and Kennedy's iteration over the region alone: its
+   *blocks' only reachable predecessors are each other, and x for y
+   */
+  idoms[y] = y;
+  bool changed = true;
+  while( changed ){
+    changed = false;
+    for( unsigned i = region.size() - 1; i-- > 0; ){
+      unsigned u = region[i], best = NoBlock;
+      for( unsigned p = 0; p < preds[u].size(); p++ ){
+        unsigned q = preds[u][p];
+        if( seen[q] != s || idoms[q] == NoBlock ){ continue; }
+        if( best == NoBlock ){
+          best = q;
+          continue;
+        }
+        unsigned a = q, b = best;
+        while( a != b ){
+          while( number[a] < number[b] ){ a = idoms[a]; }
+          while( number[b] < number[a] ){ b = idoms[b]; }
+        }
+        best = a;
+      }
+      if( idoms[u] != best ){
+        idoms[u] = best;
+        changed = true;
+      }
+    }
+  }
+
+  idoms[y] = NoBlock;
+  for( unsigned i = 0; i < region.size(); i++ ){
+    unsigned u = region[i];
+    unsigned parent = u == y ? x : idoms[u];
+    idoms[u] = NoBlock;
+    reparent(u, parent);
+  }
+  setDepths(y);
+  for( unsigned i = 0; i < region.size(); i++ ){ markDirty(region[i]); }
+  moved.insert(moved.end(), region.begin(), region.end());
+  blocksMoved += region.size();
+
+  for( unsigned i = 0; i < pending.size(); i++ ){ insert(pending[i].first, pending[i].second); }
+
+}
+
+static bool deeperFirst(const pair<unsigned, unsigned> &a, const pair<unsigned, unsigned> &b){
+  return a.first > b.first;
+}
+
+/*Cytron's DF(v) = DF_local(v) + DF_up of v's children, deepest first so
+ *every child's frontier is current
+ */
+void IFR_DynDoms::rebuildFrontiers(){
+
+  vector< pair<unsigned, unsigned> > order;
+  for( unsigned i = 0; i < dirty.size(); i++ ){ order.push_back(std::make_pair(depths[ dirty[i] ], dirty[i])); }
+  std::sort(order.begin(), order.end(), deeperFirst);
+
+  vector<unsigned> df;
+  for( unsigned i = 0; i < order.size(); i++ ){
+
+    unsigned v = order[i].second;
+    df.clear();
+    for( unsigned k = 0; k < succs[v].size(); k++ ){
+      unsigned w = succs[v][k];
+      if( idoms[w] != v && preds[w].size() >= 2 ){ df.push_back(w); }
+    }
+    for( unsigned k = 0; k < kids[v].size(); k++ ){
+      const vector<unsigned> &up = frontiers[ kids[v][k] ];
+      for( unsigned j = 0; j < up.size(); j++ ){
+        if( idoms[ up[j] ] != v ){ df.push_back(up[j]); }
+      }
+    }
+    std::sort(df.begin(), df.end());
+    df.erase(std::unique(df.begin(), df.end()), df.end());
+
+    frontiersRebuilt++;
+    if( df != frontiers[v] ){
+      frontiers[v] = df;
+      reframed.push_back(v);
+    }
+
+  }
+
+}
+
+void IFR_DynDoms::reachableFrom(unsigned b, vector<unsigned> &out){
+
+  out.clear();
+  if( b >= size() ){ return; }
+  unsigned s = bump(stamp, seen);
+  seen[b] = s;
+  out.push_back(b);
+  for( unsigned i = 0; i < out.size(); i++ ){
+    const vector<unsigned> &next = succs[ out[i] ];
+    for( unsigned k = 0; k < next.size(); k++ ){
+      if( seen[ next[k] ] == s ){ continue; }
+      seen[ next[k] ] = s;
+      out.push_back(next[k]);
+    }
+  }
+
+}
+
+bool IFR_DynDoms::dominates(unsigned a, unsigned b) const{
+
+  if( !reachable(a) || !reachable(b) ){ return false; }
+  while( depths[b] > depths[a] ){ b = idoms[b]; }
+  return a == b;
+
+}
+
+static size_t nestedBytes(const vector< vector<unsigned> > &v){
+  size_t bytes = IFR_Bytes(v);
+  for( unsigned i = 0; i < v.size(); i++ ){ bytes += IFR_Bytes(v[i]); }
+  return bytes;
+}
+
+size_t IFR_DynDoms::bytes() const{
+  return nestedBytes(succs) + nestedBytes(preds) + nestedBytes(kids) + nestedBytes(frontiers) +
+         IFR_Bytes(idoms) + IFR_Bytes(depths) + IFR_Bytes(seen) + IFR_Bytes(climbed) + IFR_Bytes(marked) +
+         IFR_Bytes(number) + IFR_Bytes(dirty) + IFR_Bytes(moved) + IFR_Bytes(reframed);
+}
@@ -0,0 +1,110 @@
+#ifndef _IFR_DYNDOMS_H_
+#define _IFR_DYNDOMS_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+
+/*Dominator tree and dominance frontiers of a routine whose CFG grows:
+ *edges found at run time (e.g. targets of indirect jumps findBlocks could
+ *not resolve) are inserted one at a time, and only what they change is
+ *recomputed.
+ *
+ *An edge (x, y) between reachable blocks uses the depth-based search of
+ *Georgiadis, Italiano, Laura and Santaroni ("An Experimental Study of
+ *Dynamic Dominators", after Ramalingam and Reps): with nca the nearest
+ *common dominator of x and y, the affected blocks are exactly those w
+ *deeper than nca's children that y reaches through blocks no shallower
+ *than w.  Each becomes a child of nca.  They are found by searching
+ *from y, deepest candidate first, and nothing else is looked at.
+ *
+ *An edge into blocks that were unreachable makes y and everything only it
+ *reaches reachable.  No reachable block had an edge into that region, so
+ *its dominators come from the region alone, rooted at y under x.  Its
+ *edges back into the rest of the routine are then inserted like any
+ *other.
+ *
+ *A frontier can only change for
+ *
+ *  - the blocks from x up to, but not including, nca (they now dominate a
+ *    predecessor of y without dominating y), and y when y is nca
+ *  - the former dominators of an affected block below nca, whose subtrees
+ *    lost it
+ *
+ *and those are rebuilt bottom-up from their children's frontiers, as in
+ *Cytron et al.  As in IFR_DomFrontiers, only blocks with two or more
+ *predecessors are in frontiers, which matters only for the entry.  Edges
+ *out of unreachable blocks are kept but change nothing until the blocks
+ *become reachable.
+ */
+class IFR_DynDoms{
+
+  std::vector< std::vector<unsigned> > succs;
+  std::vector< std::vector<unsigned> > preds;
+  std::vector< std::vector<unsigned> > kids;
+  std::vector< std::vector<unsigned> > frontiers;   //sorted
+  std::vector<unsigned> idoms;                      //NoBlock for the entry and unreachable blocks
+  std::vector<unsigned> depths;                     //NoDepth when unreachable
+
+  /*Scratch, reset by generation stamps*/
+  std::vector<unsigned> seen;                       //== stamp: reached by the current search
+  std::vector<unsigned> climbed;                    //== stamp: a former dominator, already dirty
+  std::vector<unsigned> marked;                     //== round: dirty in this insertEdge
+  std::vector<unsigned> number;                     //postorder within a newly reachable region
+  unsigned stamp;
+  unsigned round;
+
+  std::vector<unsigned> dirty;                      //frontiers to rebuild
+  std::vector<unsigned> moved;
+  std::vector<unsigned> reframed;
+
+  static const unsigned NoDepth = (unsigned)-1;
+
+  void insert(unsigned x, unsigned y);
+  void insertReachable(unsigned x, unsigned y);
+  void reachRegion(unsigned x, unsigned y);
+  void reparent(unsigned b, unsigned parent);
+  void setDepths(unsigned root);
+  void markDirty(unsigned b);
+  void rebuildFrontiers();
+
+public:
+
+  unsigned edgesAdded;      //over all insertions
+  unsigned blocksMoved;     //idoms changed, newly reachable blocks included
+  unsigned frontiersRebuilt;
+  unsigned visits;          //blocks the searches touched
+
+  IFR_DynDoms();
+
+  void init(const IFR_CFG &cfg, const IFR_DomTree &domTree, const IFR_DomFrontiers &df);
+
+  /*Adds edge (x, y) and updates the tree and frontiers; false if the edge
+   *was already there or a block is out of range
+   */
+  bool insertEdge(unsigned x, unsigned y);
+
+  /*What the last insertEdge changed: blocks whose immediate dominator
+   *changed (or that became reachable), and blocks whose frontier changed
+   */
+  const std::vector<unsigned> &movedBlocks() const { return moved; }
+  const std::vector<unsigned> &changedFrontiers() const { return reframed; }
+
+  /*Every block reachable from b, b included*/
+  void reachableFrom(unsigned b, std::vector<unsigned> &out);
+
+  size_t bytes() const;
+
+  unsigned size() const { return idoms.size(); }
+  bool reachable(unsigned b) const { return b < depths.size() && depths[b] != NoDepth; }
+  unsigned idom(unsigned b) const { return idoms[b]; }
+  unsigned depth(unsigned b) const { return depths[b]; }
+  bool dominates(unsigned a, unsigned b) const;
+
+  const std::vector<unsigned> &succ(unsigned b) const { return succs[b]; }
+  const std::vector<unsigned> &frontier(unsigned b) const { return frontiers[b]; }
+
+};
+
+#endif
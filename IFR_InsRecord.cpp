@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <assert.h>
+#include "IFR_InsRecord.h"
+#include "IFR_JumpTables.h"
+
+using std::vector;
+
+const unsigned IFR_RoutineCode::NoIns;
+const unsigned IFR_RoutineCode::NoTable;
+
+static bool addressBefore(const IFR_InsRecord &r, ADDRINT address){
+  return r.address < address;
+}
+
+unsigned IFR_RoutineCode::find(ADDRINT address) const{
+
+  vector<IFR_InsRecord>::const_iterator i = std::lower_bound(ins.begin(), ins.end(), address, addressBefore);
+  if( i == ins.end() || i->address != address ){ return NoIns; }
+  return i - ins.begin();
+
+}
+
+void IFR_RoutineCode::clear(){
+  ins.clear();
+  tableIns.clear();
+  tableStart.clear();
+  tableTargets.clear();
+}
+
+unsigned IFR_RoutineCode::table(unsigned jump) const{
+
+  vector<unsigned>::const_iterator t = std::lower_bound(tableIns.begin(), tableIns.end(), jump);
+  if( t == tableIns.end() || *t != jump ){ return NoTable; }
+  return t - tableIns.begin();
+
+}
+
+bool IFR_RoutineCode::leavesTaken(unsigned i) const{
+  const IFR_InsRecord &r = ins[i];
+  return (r.kind == InsJump || r.kind == InsCondJump) && find(r.target) == NoIns;
+}
+
+bool IFR_RoutineCode::leavesFall(unsigned i) const{
+  const IFR_InsRecord &r = ins[i];
+  if( r.kind == InsJump || r.kind == InsIndirectJump || r.kind == InsReturn ){ return false; }
+  return find(r.next()) == NoIns;
+}
+
+bool IFR_RoutineCode::leaves(unsigned i) const{
+  const IFR_InsRecord &r = ins[i];
+  if( r.kind == InsReturn || (r.kind == InsIndirectJump && !resolved(i)) ){ return true; }
+  return leavesTaken(i) || leavesFall(i);
+}
+
+bool IFR_RoutineCode::leavesBlock(const IFR_CFG &cfg, unsigned b) const{
+
+  if( cfg.numSuccs(b) == 0 || cfg.insEnd(b) == cfg.insBegin(b) ){ return true; }
+  for( unsigned i = cfg.insBegin(b); i < cfg.insEnd(b); i++ ){
+    if( leaves(i) ){ return true; }
+  }
+  return false;
+
+}
+
+void IFR_RoutineCode::addTable(unsigned jump, const vector<ADDRINT> &targets){
+
+  assert( tableIns.empty() || tableIns.back() < jump );
+  if( tableStart.empty() ){ tableStart.push_back(0); }
+  tableIns.push_back(jump);
+  tableTargets.insert(tableTargets.end(), targets.begin(), targets.end());
+  tableStart.push_back( tableTargets.size() );
+
+}
+
+void IFR_RoutineCode::add(ADDRINT address, UINT32 size, IFR_InsKind kind, ADDRINT target){
+
+  IFR_InsRecord r;
+  r.address = address;
+  r.target = target;
+  r.size = size;
+  r.kind = kind;
+  ins.push_back(r);
+
+}
+
+void IFR_RoutineCode::buildCFG(IFR_CFG &cfg) const{
+
+  cfg.clear();
+  if( ins.empty() ){
+    cfg.finish();
+    return;
+  }
+
+  /*Leaders: the first instruction, the target and fallthrough of every
+   *direct jump, and whatever follows an indirect jump along with the
+   *targets of its table
+   */
+  vector<ADDRINT> leaders;
+  leaders.push_back( ins[0].address );
+  for( unsigned i = 0; i < ins.size(); i++ ){
+    if( ins[i].kind == InsJump || ins[i].kind == InsCondJump ){
+      leaders.push_back( ins[i].target );
+      leaders.push_back( ins[i].next() );
+    }
+  }
+  for( unsigned i = 0; i < ins.size(); i++ ){
+    if( ins[i].kind == InsIndirectJump ){ leaders.push_back( ins[i].next() ); }
+  }
+  leaders.insert(leaders.end(), tableTargets.begin(), tableTargets.end());
+  std::sort(leaders.begin(), leaders.end());
+  leaders.erase( std::unique(leaders.begin(), leaders.end()), leaders.end() );
+
+  /*A block ends before the next leader or at the end of the routine*/
+  unsigned start = 0;
+  for( unsigned i = 0; i < ins.size(); i++ ){
+
+    if( i + 1 < ins.size() && !std::binary_search(leaders.begin(), leaders.end(), ins[i + 1].address) ){
+      continue;
+    }
+
+    unsigned b = cfg.addBlock( ins[start].address, i + 1 - start );
+    switch( ins[i].kind ){
+      case InsJump:
+        cfg.addEdge( b, ins[i].target );
+        break;
+      case InsCondJump:
+        cfg.addEdge( b, ins[i].target );
+        cfg.addEdge( b, ins[i].next() );
+        break;
+      case InsIndirectJump: {
+        /*Unresolved ones may go anywhere; no edges are assumed*/
+        unsigned t = table(i);
+        if( t == NoTable ){ break; }
+        for( const ADDRINT *e = tableBegin(t); e != tableEnd(t); e++ ){
+          cfg.addEdge( b, *e );
+        }
+        break;
+      }
+      case InsReturn:
+        break;
+      default:
+        cfg.addEdge( b, ins[i].next() );
+        break;
+    }
+    start = i + 1;
+
+  }
+  cfg.finish();
+
+}
+
+void IFR_RoutineCode::save(IFR_BlobWriter &w, ADDRINT base) const{
+
+  w.putWord( ins.size() );
+  for( unsigned i = 0; i < ins.size(); i++ ){
+    w.putWide( ins[i].address - base );
+    w.putWide( ins[i].target == 0 ? 0 : ins[i].target - base + 1 );
+    w.putWord( ins[i].size );
+    w.putWord( ins[i].kind );
+  }
+
+  w.putWord( tableIns.size() );
+  for( unsigned t = 0; t < tableIns.size(); t++ ){
+    w.putWord( tableIns[t] );
+    w.putWord( tableStart[t + 1] - tableStart[t] );
+    for( const ADDRINT *e = tableBegin(t); e != tableEnd(t); e++ ){
+      w.putWide( *e - base );
+    }
+  }
+
+}
+
+bool IFR_RoutineCode::load(IFR_BlobReader &r, ADDRINT base){
+
+  unsigned n = r.getWord();
+  clear();
+  for( unsigned i = 0; r.ok() && i < n; i++ ){
+    IFR_InsRecord rec;
+    rec.address = base + (ADDRINT)r.getWide();
+    UINT64 t = r.getWide();
+    rec.target = (t == 0) ? 0 : base + (ADDRINT)(t - 1);
+    rec.size = r.getWord();
+    rec.kind = r.getWord();
+    if( rec.kind > InsReturn ){
+      clear();
+      return false;
+    }
+    ins.push_back(rec);
+  }
+
+  unsigned numTables = r.getWord();
+  vector<ADDRINT> targets;
+  for( unsigned t = 0; r.ok() && t < numTables; t++ ){
+    unsigned jump = r.getWord();
+    unsigned count = r.getWord();
+    if( !r.ok() || jump >= ins.size() || count > IFR_MAX_TABLE_ENTRIES ||
+        (!tableIns.empty() && jump <= tableIns.back()) ){
+      clear();
+      return false;
+    }
+    targets.resize(count);
+    for( unsigned e = 0; e < count; e++ ){
+      targets[e] = base + (ADDRINT)r.getWide();
+    }
+    addTable(jump, targets);
+  }
+
+  if( !r.ok() ){
+    clear();
+    return false;
+  }
+  return true;
+
+}
+
+size_t IFR_RoutineCode::bytes() const{
+  return IFR_Bytes(ins) +
+         IFR_Bytes(tableIns) +
+         IFR_Bytes(tableStart) +
+         IFR_Bytes(tableTargets);
+}
@@ -0,0 +1,97 @@
+#ifndef _IFR_INSRECORD_H_
+#define _IFR_INSRECORD_H_
+
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_CFG.h"
+#include "IFR_Serialize.h"
+
+/*How an instruction transfers control.  Direct jumps, and indirect jumps
+ *resolved as jump tables, end a block with known successors; calls and
+ *returns fall through to the next instruction as far as the
+ *intraprocedural CFG is concerned.
+ */
+enum IFR_InsKind {
+  InsOther = 0,
+  InsJump = 1,          //direct unconditional jump
+  InsCondJump = 2,      //direct conditional jump
+  InsIndirectJump = 3,
+  InsCall = 4,
+  InsReturn = 5
+};
+
+/*What the analyses need to know about one instruction, copied out of the
+ *instrumentation API so it can be used after the routine is closed and
+ *from threads that may not call into Pin.
+ */
+class IFR_InsRecord{
+
+public:
+
+  ADDRINT address;
+  ADDRINT target;       //direct jump or call target, else 0
+  UINT32 size;
+  UINT32 kind;          //an IFR_InsKind
+
+  ADDRINT next() const { return address + size; }
+
+};
+
+/*A routine's instructions in address order*/
+class IFR_RoutineCode{
+
+public:
+
+  std::vector<IFR_InsRecord> ins;
+
+  /*Indirect jumps resolved as jump tables (IFR_JumpTables.h), in
+   *instruction order: jump tableIns[t] goes to
+   *tableTargets[tableStart[t]..tableStart[t+1]), sorted
+   */
+  std::vector<unsigned> tableIns;
+  std::vector<unsigned> tableStart;
+  std::vector<ADDRINT> tableTargets;
+
+  static const unsigned NoIns = (unsigned)-1;
+  static const unsigned NoTable = (unsigned)-1;
+
+  void clear();
+  void add(ADDRINT address, UINT32 size, IFR_InsKind kind, ADDRINT target);
+  void addTable(unsigned jump, const std::vector<ADDRINT> &targets);
+
+  /*Number of the instruction at address, or NoIns*/
+  unsigned find(ADDRINT address) const;
+
+  /*Table of indirect jump jump, or NoTable if it is unresolved*/
+  unsigned table(unsigned jump) const;
+  bool resolved(unsigned jump) const { return table(jump) != NoTable; }
+  unsigned numTables() const { return tableIns.size(); }
+  const ADDRINT *tableBegin(unsigned t) const { return &tableTargets[0] + tableStart[t]; }
+  const ADDRINT *tableEnd(unsigned t) const { return &tableTargets[0] + tableStart[t + 1]; }
+
+  /*Whether control can leave the routine from instruction i: by
+   *returning, by an unresolved indirect jump, or by its branch taken or
+   *its fall through going to an address outside the routine
+   */
+  bool leavesTaken(unsigned i) const;
+  bool leavesFall(unsigned i) const;
+  bool leaves(unsigned i) const;
+
+  /*Whether control can leave the routine from block b of cfg: from any of
+   *its instructions, or because it is empty or has no successors
+   */
+  bool leavesBlock(const IFR_CFG &cfg, unsigned b) const;
+
+  /*Splits the routine into basic blocks ("Engineering a Compiler" pg 439,
+   *Figure 9.1 'Finding Leaders') and builds their CFG.
+   */
+  void buildCFG(IFR_CFG &cfg) const;
+
+  void save(IFR_BlobWriter &w, ADDRINT base) const;
+  bool load(IFR_BlobReader &r, ADDRINT base);
+
+  size_t bytes() const;
+
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "IFR_JumpTableMatch.h"
+
+static xed_reg_enum_t fullReg(xed_reg_enum_t r){
+  return r == XED_REG_INVALID ? r : xed_get_largest_enclosing_register(r);
+}
+
+static xed_iclass_enum_t iclass(const xed_decoded_inst_t *d){
+  return xed_decoded_inst_get_iclass(d);
+}
+
+static bool writes(const xed_decoded_inst_t *d, xed_reg_enum_t reg){
+
+  const xed_inst_t *xi = xed_decoded_inst_inst(d);
+  for( unsigned o = 0; o < xed_inst_noperands(xi); o++ ){
+    const xed_operand_t *op = xed_inst_operand(xi, o);
+    xed_operand_enum_t name = xed_operand_name(op);
+    if( xed_operand_is_register(name) && xed_operand_written(op) &&
+        fullReg( xed_decoded_inst_get_reg(d, name) ) == reg ){
+      return true;
+    }
+  }
+  return false;
+
+}
+
+/*Last instruction before i that writes reg, or -1*/
+static int lastDef(const xed_decoded_inst_t *const *window, int i, xed_reg_enum_t reg){
+
+  for( int j = i - 1; j >= 0; j-- ){
+    if( writes(window[j], reg) ){ return j; }
+  }
+  return -1;
+
+}
+
+/*[table + idx*8] with no base: a table of absolute 8 byte targets*/
+static bool absoluteEntry(const xed_decoded_inst_t *d, xed_reg_enum_t &index, ADDRINT &table){
+
+  if( xed_decoded_inst_number_of_memory_operands(d) != 1 ||
+      xed_decoded_inst_get_base_reg(d, 0) != XED_REG_INVALID ||
+      xed_decoded_inst_get_index_reg(d, 0) == XED_REG_INVALID ||
+      xed_decoded_inst_get_scale(d, 0) != 8 || xed_decoded_inst_get_memory_operand_length(d, 0) != 8 ){
+    return false;
+  }
+  index = fullReg( xed_decoded_inst_get_index_reg(d, 0) );
+  table = (ADDRINT)xed_decoded_inst_get_memory_displacement(d, 0);
+  return true;
+
+}
+
+/*add r, b, where r was loaded by movsxd r, [b + idx*4] and b by
+ *lea b, [rip + table] before that
+ */
+static bool relativeEntry(const xed_decoded_inst_t *const *window, const ADDRINT *addrs, int add,
+                          xed_reg_enum_t entry, xed_reg_enum_t base,
+                          int &load, xed_reg_enum_t &index, ADDRINT &table){
+
+  int e = lastDef(window, add, entry);
+  int b = lastDef(window, add, base);
+  if( e < 0 || b < 0 || b > e ){ return false; }
+
+  const xed_decoded_inst_t *ld = window[e];
+  if( iclass(ld) != XED_ICLASS_MOVSXD || xed_decoded_inst_number_of_memory_operands(ld) != 1 ||
+      fullReg( xed_decoded_inst_get_base_reg(ld, 0) ) != base ||
+      xed_decoded_inst_get_index_reg(ld, 0) == XED_REG_INVALID ||
+      xed_decoded_inst_get_scale(ld, 0) != 4 || xed_decoded_inst_get_memory_displacement(ld, 0) != 0 ){
+    return false;
+  }
+
+  const xed_decoded_inst_t *lea = window[b];
+  if( iclass(lea) != XED_ICLASS_LEA || xed_decoded_inst_get_base_reg(lea, 0) != XED_REG_RIP ||
+      xed_decoded_inst_get_index_reg(lea, 0) != XED_REG_INVALID ){
+    return false;
+  }
+
+  load = e;
+  index = fullReg( xed_decoded_inst_get_index_reg(ld, 0) );
+  table = addrs[b] + xed_decoded_inst_get_length(lea) + (ADDRDELTA)xed_decoded_inst_get_memory_displacement(lea, 0);
+  return true;
+
+}
+
+/*Number of table entries the guard before load allows: the nearest
+ *conditional jump before it must be ja or jae right after a compare of
+ *idx with an immediate, with nothing in between but idx zero-extended
+ *onto itself.  guard gets the ja's address.
+ */
+static unsigned guardBound(const xed_decoded_inst_t *const *window, const ADDRINT *addrs, int load,
+                           xed_reg_enum_t index, ADDRINT &guard){
+
+  int j = load - 1;
+  for( ; j >= 0; j-- ){
+
+    const xed_decoded_inst_t *d = window[j];
+    xed_iclass_enum_t c = iclass(d);
+    if( c == XED_ICLASS_JNBE || c == XED_ICLASS_JNB ){ break; }
+
+    xed_category_enum_t cat = xed_decoded_inst_get_category(d);
+    if( cat == XED_CATEGORY_COND_BR || cat == XED_CATEGORY_UNCOND_BR ||
+        cat == XED_CATEGORY_CALL || cat == XED_CATEGORY_RET ){
+      return 0;
+    }
+    if( writes(d, index) &&
+        !(c == XED_ICLASS_MOV && fullReg( xed_decoded_inst_get_reg(d, XED_OPERAND_REG1) ) == index) ){
+      return 0;
+    }
+
+  }
+  if( j < 1 ){ return 0; }
+
+  const xed_decoded_inst_t *cmp = window[j - 1];
+  if( iclass(cmp) != XED_ICLASS_CMP || xed_decoded_inst_get_immediate_width(cmp) == 0 ||
+      fullReg( xed_decoded_inst_get_reg(cmp, XED_OPERAND_REG0) ) != index ){
+    return 0;
+  }
+  INT64 imm = xed_decoded_inst_get_signed_immediate(cmp);
+  if( imm < 0 || imm >= IFR_MAX_TABLE_ENTRIES ){ return 0; }
+  guard = addrs[j];
+  return iclass(window[j]) == XED_ICLASS_JNBE ? (unsigned)imm + 1 : (unsigned)imm;
+
+}
+
+bool IFR_MatchJumpTable(const xed_decoded_inst_t *const *window, const ADDRINT *addrs, unsigned n,
+                        IFR_JumpTableSite &site){
+
+  if( n == 0 || iclass(window[n - 1]) != XED_ICLASS_JMP ){ return false; }
+  const xed_decoded_inst_t *jump = window[n - 1];
+
+  int load = n - 1;
+  xed_reg_enum_t index;
+  site.relative = false;
+  site.entrySize = 8;
+  if( xed_decoded_inst_number_of_memory_operands(jump) == 1 ){
+
+    if( !absoluteEntry(jump, index, site.table) ){ return false; }
+
+  }else{
+
+    xed_reg_enum_t target = fullReg( xed_decoded_inst_get_reg(jump, XED_OPERAND_REG0) );
+    load = lastDef(window, n - 1, target);
+    if( load < 0 ){ return false; }
+    const xed_decoded_inst_t *d = window[load];
+
+    if( iclass(d) == XED_ICLASS_MOV ){
+      if( !absoluteEntry(d, index, site.table) ){ return false; }
+    }else if( iclass(d) == XED_ICLASS_ADD ){
+      xed_reg_enum_t r0 = fullReg( xed_decoded_inst_get_reg(d, XED_OPERAND_REG0) );
+      xed_reg_enum_t r1 = fullReg( xed_decoded_inst_get_reg(d, XED_OPERAND_REG1) );
+      if( r1 == XED_REG_INVALID ){ return false; }
+      int add = load;
+      if( !relativeEntry(window, addrs, add, r0, r1, load, index, site.table) &&
+          !relativeEntry(window, addrs, add, r1, r0, load, index, site.table) ){
+        return false;
+      }
+      site.relative = true;
+      site.entrySize = 4;
+    }else{
+      return false;
+    }
+
+  }
+
+  site.entries = guardBound(window, addrs, load, index, site.guard);
+  return site.entries > 0;
+
+}
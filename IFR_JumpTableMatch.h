@@ -0,0 +1,34 @@
+#ifndef _IFR_JUMPTABLEMATCH_H_
+#define _IFR_JUMPTABLEMATCH_H_
+
+extern "C" {
+#include "xed-interface.h"
+}
+
+#include "IFR_Types.h"
+#include "IFR_JumpTables.h"
+
+/*Instructions before an indirect jump that the matcher looks at*/
+#define IFR_JUMPTABLE_WINDOW 12
+
+/*Matches the x86-64 code leading up to an indirect jump against the
+ *switch idioms of gcc and clang:
+ *
+ *  cmp idx, n-1 ; ja default         (or jae with n)
+ *  jmp [table + idx*8]               (or mov r, [table + idx*8] ; jmp r)
+ *
+ *and, position independent,
+ *
+ *  cmp idx, n-1 ; ja default
+ *  lea b, [rip + table] ; movsxd r, dword [b + idx*4] ; add r, b ; jmp r
+ *
+ *window[0..n) are the decoded instructions in address order, ending with
+ *the jump, and addrs their addresses.  Both front ends decode with XED, so
+ *they share this; the table itself is read by IFR_ResolveJumpTables,
+ *which also checks that nothing enters between the guard and the jump.
+ *Fills in everything in site but ins.
+ */
+bool IFR_MatchJumpTable(const xed_decoded_inst_t *const *window, const ADDRINT *addrs, unsigned n,
+                        IFR_JumpTableSite &site);
+
+#endif
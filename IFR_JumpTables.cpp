@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <string.h>
+
+#include "IFR_JumpTables.h"
+
+using std::vector;
+
+/*The sorted, distinct targets of the table at site*/
+static bool readTable(const IFR_RoutineCode &code, const IFR_JumpTableSite &site, const IFR_MemoryReader &mem,
+                      vector<ADDRINT> &targets){
+
+  if( site.entries == 0 || site.entries > IFR_MAX_TABLE_ENTRIES ||
+      (site.entrySize != 4 && site.entrySize != 8) || code.ins[site.ins].kind != InsIndirectJump ){
+    return false;
+  }
+
+  vector<unsigned char> bytes(site.entries * site.entrySize);
+  if( !mem.read(site.table, &bytes[0], bytes.size()) ){ return false; }
+
+  /*Entries are little endian, like the host*/
+  targets.resize(site.entries);
+  for( unsigned e = 0; e < site.entries; e++ ){
+
+    const unsigned char *p = &bytes[e * site.entrySize];
+    ADDRINT t;
+    if( site.entrySize == 8 ){
+      UINT64 v;
+      memcpy(&v, p, sizeof(v));
+      t = (ADDRINT)v;
+    }else if( site.relative ){
+      INT32 v;
+      memcpy(&v, p, sizeof(v));
+      t = site.table + (ADDRDELTA)v;
+    }else{
+      UINT32 v;
+      memcpy(&v, p, sizeof(v));
+      t = (ADDRINT)v;
+    }
+    if( site.relative && site.entrySize == 8 ){ t += site.table; }
+
+    if( code.find(t) == IFR_RoutineCode::NoIns ){ return false; }
+    targets[e] = t;
+
+  }
+
+  std::sort(targets.begin(), targets.end());
+  targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  return true;
+
+}
+
+/*Whether the only way to the jump at site is through its guard: entered
+ *holds every address control may arrive at other than by falling through
+ */
+static bool guarded(const IFR_RoutineCode &code, const IFR_JumpTableSite &site, const vector<ADDRINT> &entered){
+
+  unsigned g = code.find(site.guard);
+  if( g == IFR_RoutineCode::NoIns || g >= site.ins ){ return false; }
+  for( unsigned i = g + 1; i <= site.ins; i++ ){
+    if( std::binary_search(entered.begin(), entered.end(), code.ins[i].address) ){ return false; }
+    if( i < site.ins && code.ins[i].kind != InsOther && code.ins[i].kind != InsCall ){ return false; }
+  }
+  return true;
+
+}
+
+unsigned IFR_ResolveJumpTables(IFR_RoutineCode &code, const vector<IFR_JumpTableSite> &sites,
+                               const IFR_MemoryReader &mem){
+
+  if( code.ins.empty() ){ return 0; }
+
+  vector< vector<ADDRINT> > targets(sites.size());
+  vector<unsigned char> read(sites.size(), 0);
+  vector<ADDRINT> entered(code.tableTargets);
+  entered.push_back(code.ins[0].address);
+  for( unsigned i = 0; i < code.ins.size(); i++ ){
+    UINT32 k = code.ins[i].kind;
+    if( k == InsJump || k == InsCondJump || k == InsCall ){ entered.push_back(code.ins[i].target); }
+  }
+  for( unsigned s = 0; s < sites.size(); s++ ){
+    read[s] = readTable(code, sites[s], mem, targets[s]);
+    if( read[s] ){ entered.insert(entered.end(), targets[s].begin(), targets[s].end()); }
+  }
+  std::sort(entered.begin(), entered.end());
+  entered.erase(std::unique(entered.begin(), entered.end()), entered.end());
+
+  unsigned resolved = 0;
+  for( unsigned s = 0; s < sites.size(); s++ ){
+    if( !read[s] || !guarded(code, sites[s], entered) ){ continue; }
+    code.addTable(sites[s].ins, targets[s]);
+    resolved++;
+  }
+  return resolved;
+
+}
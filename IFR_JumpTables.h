@@ -0,0 +1,56 @@
+#ifndef _IFR_JUMPTABLES_H_
+#define _IFR_JUMPTABLES_H_
+
+#include <stddef.h>
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_InsRecord.h"
+
+/*Most entries a jump table may have before the resolver gives up on it*/
+#define IFR_MAX_TABLE_ENTRIES 4096
+
+/*Read-only view of the analyzed image, for reading jump tables.  Front
+ *ends map addresses to wherever their copy of the image lives.
+ */
+class IFR_MemoryReader{
+
+public:
+
+  virtual ~IFR_MemoryReader() {}
+
+  /*Copies size bytes at addr to buf; false unless all of them lie in one
+   *read-only section of the image
+   */
+  virtual bool read(ADDRINT addr, void *buf, size_t size) const = 0;
+
+};
+
+/*An indirect jump through a bounded table, as a front end matched it
+ *(see IFR_JumpTableMatch.h).  Entry i is the target itself, or with
+ *relative, a signed offset from the table's address.
+ */
+class IFR_JumpTableSite{
+
+public:
+
+  unsigned ins;         //routine instruction number of the jump
+  ADDRINT guard;        //the ja or jae that bounds the index
+  ADDRINT table;
+  unsigned entries;
+  unsigned entrySize;   //4 or 8 bytes
+  bool relative;
+
+};
+
+/*Reads the tables at sites, in instruction order, and records their
+ *targets in code, which must hold the whole routine.  A jump is left
+ *unresolved, with no CFG edges, if its table cannot be read, any entry
+ *lands outside the routine's instructions, or the guard does not bound
+ *every path to it: some instruction after the guard, up to the jump, is
+ *the routine's entry or the target of a branch or of any table, or
+ *follows one that does not fall through.  Returns the number resolved.
+ */
+unsigned IFR_ResolveJumpTables(IFR_RoutineCode &code, const std::vector<IFR_JumpTableSite> &sites,
+                               const IFR_MemoryReader &mem);
+
+#endif
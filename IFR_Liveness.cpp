@@ -0,0 +1,81 @@
+#include "IFR_Liveness.h"
+
+using std::vector;
+
+IFR_Liveness::IFR_Liveness(){
+  numLive = 0;
+}
+
+void IFR_Liveness::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_RegOps &regOps){
+
+  unsigned width = regOps.numRegs();
+  unsigned w = (width + 63) / 64;
+  flow.init(cfg, width);
+  before.init(cfg.numIns(), width);
+  blockOfIns.assign(cfg.numIns(), 0);
+  numLive = 0;
+
+  for( unsigned reg = 0; reg < width; reg++ ){
+    flow.boundary.set(0, reg);
+  }
+
+  /*Walking each block backwards, a def hides later uses from the block's
+   *predecessors and a use exposes the register to them
+   */
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    if( cfg.insEnd(b) == cfg.insBegin(b) ){ continue; }
+    if( code.leavesBlock(cfg, b) ){ flow.setBoundary(b); }
+    for( unsigned i = cfg.insEnd(b); i-- > cfg.insBegin(b); ){
+      blockOfIns[i] = b;
+      for( unsigned d = regOps.defStart[i]; d < regOps.defStart[i + 1]; d++ ){
+        flow.kill.set(b, regOps.defs[d]);
+        flow.gen.reset(b, regOps.defs[d]);
+      }
+      if( regOps.memFlags[i] & IFR_INS_CALL ){
+        IFR_BitsCopy(flow.gen.row(b), flow.boundary.row(0), w);
+      }
+      for( unsigned u = regOps.useStart[i]; u < regOps.useStart[i + 1]; u++ ){
+        flow.gen.set(b, regOps.uses[u]);
+      }
+    }
+
+  }
+
+  flow.solve(cfg, FlowBackward, MeetUnion);
+
+  /*The same walk again, from each block's live-out set*/
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    const UINT64 *live = flow.out.row(b);
+    for( unsigned i = cfg.insEnd(b); i-- > cfg.insBegin(b); ){
+      UINT64 *cur = before.row(i);
+      IFR_BitsCopy(cur, live, w);
+      for( unsigned d = regOps.defStart[i]; d < regOps.defStart[i + 1]; d++ ){
+        before.reset(i, regOps.defs[d]);
+      }
+      if( regOps.memFlags[i] & IFR_INS_CALL ){
+        IFR_BitsCopy(cur, flow.boundary.row(0), w);
+      }
+      for( unsigned u = regOps.useStart[i]; u < regOps.useStart[i + 1]; u++ ){
+        before.set(i, regOps.uses[u]);
+      }
+      numLive += IFR_BitsCount(cur, w);
+      live = cur;
+    }
+
+  }
+
+}
+
+bool IFR_Liveness::liveAfter(unsigned ins, unsigned reg) const{
+
+  unsigned b = blockOfIns[ins];
+  if( ins + 1 < blockOfIns.size() && blockOfIns[ins + 1] == b ){ return before.test(ins + 1, reg); }
+  return flow.out.test(b, reg);
+
+}
+
+size_t IFR_Liveness::bytes() const{
+  return flow.bytes() + before.bytes() + IFR_Bytes(blockOfIns);
+}
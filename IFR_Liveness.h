@@ -0,0 +1,47 @@
+#ifndef _IFR_LIVENESS_H_
+#define _IFR_LIVENESS_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_CFG.h"
+#include "IFR_SSA.h"
+#include "IFR_Dataflow.h"
+
+/*Live registers at every instruction of a routine, over the dense ids of
+ *IFR_RegOps: the first client of IFR_Dataflow, as a backward union
+ *problem with gen = a block's upward-exposed uses and kill = its defs.
+ *
+ *Everything is live where control leaves the routine (returns, unresolved
+ *indirect jumps, jumps and fall-through out of it), since the caller or
+ *jump target is not seen.  A call is taken to read every register before
+ *it writes its defs, as its arguments are not known.
+ */
+class IFR_Liveness{
+
+  IFR_Dataflow flow;
+  IFR_BitMatrix before;               //per instruction
+  std::vector<unsigned> blockOfIns;
+
+public:
+
+  unsigned numLive;                   //sum over instructions of the registers live before them
+
+  IFR_Liveness();
+
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_RegOps &regOps);
+
+  size_t bytes() const;
+
+  unsigned sweeps() const { return flow.sweeps; }
+
+  /*Whether dense register reg is live just before / just after ins*/
+  bool liveBefore(unsigned ins, unsigned reg) const { return before.test(ins, reg); }
+  bool liveAfter(unsigned ins, unsigned reg) const;
+
+  /*The set live before ins, words() words long*/
+  const UINT64 *beforeSet(unsigned ins) const { return before.row(ins); }
+  unsigned words() const { return before.words(); }
+
+};
+
+#endif
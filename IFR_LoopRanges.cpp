@@ -0,0 +1,325 @@
+#include <algorithm>
+#include "IFR_LoopRanges.h"
+
+using std::vector;
+
+/*Longest chain of constant steps followed back to an induction phi*/
+#define IFR_MAX_STEPS 64
+
+IFR_LoopRanges::IFR_LoopRanges(){
+}
+
+static bool edgeBefore(const IFR_RangeEdge &a, const IFR_RangeEdge &b){
+  return a.ins < b.ins;
+}
+
+unsigned IFR_LoopRanges::edgeBegin(unsigned ins) const{
+
+  IFR_RangeEdge key;
+  key.ins = ins;
+  return std::lower_bound(edges.begin(), edges.end(), key, edgeBefore) - edges.begin();
+
+}
+
+unsigned IFR_LoopRanges::edgeEnd(unsigned ins) const{
+
+  IFR_RangeEdge key;
+  key.ins = ins;
+  return std::upper_bound(edges.begin(), edges.end(), key, edgeBefore) - edges.begin();
+
+}
+
+void IFR_LoopRanges::drop(unsigned s){
+
+  covered[ refs[s].ref ] = 0;
+  unsigned kept = 0;
+  for( unsigned e = 0; e < edges.size(); e++ ){
+    if( edges[e].strided != s ){ edges[kept++] = edges[e]; }
+  }
+  edges.resize(kept);
+
+}
+
+/*Per-routine state shared by the helpers below*/
+class RangeContext{
+
+public:
+
+  const IFR_RoutineCode *code;
+  const IFR_CFG *cfg;
+  const IFR_DomTree *domTree;
+  const IFR_RegOps *regOps;
+  const IFR_SSA *ssa;
+  const IFR_LoopForest *loops;
+
+  /*Follows constant steps inside loop l back from value v; returns the
+   *value the chain starts from and the total step in off.
+   */
+  unsigned root(unsigned v, unsigned l, ADDRDELTA &off) const{
+
+    off = 0;
+    for( unsigned n = 0; n < IFR_MAX_STEPS && v != IFR_SSA::NoValue; n++ ){
+      const IFR_SSAValue &val = ssa->value(v);
+      ADDRDELTA d;
+      if( val.kind != SSADef || !loops->contains(l, val.block) ||
+          !regOps->step(val.ins, val.var, d) ){
+        return v;
+      }
+      off += d;
+      v = ssa->reachingDef(*regOps, val.ins, val.var);
+    }
+    return IFR_SSA::NoValue;
+
+  }
+
+  /*Per-iteration step of header phi p of loop l, or 0 if p is not a basic
+   *induction variable
+   */
+  ADDRDELTA inductionStep(unsigned p, unsigned l) const{
+
+    unsigned h = loops->loop(l).header;
+    unsigned i = 0;
+    while( i < ssa->numPhis(h) && ssa->phi(h, i) != p ){ i++; }
+    if( i == ssa->numPhis(h) ){ return 0; }
+
+    ADDRDELTA step = 0;
+    for( unsigned k = 0; k < cfg->numPreds(h); k++ ){
+      if( !loops->contains(l, cfg->predBegin(h)[k]) ){ continue; }
+      ADDRDELTA s;
+      if( root(ssa->phiArg(h, i, k), l, s) != p || s == 0 || (step != 0 && s != step) ){ return 0; }
+      step = s;
+    }
+    return step;
+
+  }
+
+  /*SSA value of dense register reg at the end of block b*/
+  unsigned valueAtEnd(unsigned b, unsigned reg) const{
+
+    while( b != IFR_CFG::NoBlock ){
+
+      for( unsigned in = cfg->insEnd(b); in-- > cfg->insBegin(b); ){
+        for( unsigned d = regOps->defStart[in]; d < regOps->defStart[in + 1]; d++ ){
+          if( regOps->defs[d] == reg ){ return ssa->defValue[d]; }
+        }
+      }
+      for( unsigned i = 0; i < ssa->numPhis(b); i++ ){
+        if( ssa->value( ssa->phi(b, i) ).var == reg ){ return ssa->phi(b, i); }
+      }
+      b = domTree->idom(b);
+
+    }
+    return IFR_SSA::NoValue;
+
+  }
+
+  /*Whether control can leave the routine from block b other than along a
+   *CFG edge
+   */
+  bool leavesRoutine(unsigned b) const{
+    return code->leavesBlock(*cfg, b);
+  }
+
+  /*How control leaves block u for block v: on the branch taken, the fall
+   *through, or both.  Returns false if it cannot be instrumented (the
+   *fall through of a call).
+   */
+  bool edgeModes(unsigned u, unsigned v, bool &taken, bool &fall) const{
+
+    const IFR_InsRecord &end = code->ins[ cfg->insEnd(u) - 1 ];
+    ADDRINT to = cfg->entry(v);
+    taken = (end.kind == InsJump || end.kind == InsCondJump) && end.target == to;
+    fall = end.kind != InsJump && end.kind != InsIndirectJump && end.kind != InsReturn &&
+           end.next() == to;
+    if( fall && end.kind == InsCall ){ return false; }
+    return taken || fall;
+
+  }
+
+};
+
+void IFR_LoopRanges::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_DomTree &domTree,
+                             const IFR_MemRefTable &memrefs, const IFR_RegOps &regOps, const IFR_SSA &ssa,
+                             const IFR_LoopForest &loops){
+
+  refs.clear();
+  edges.clear();
+  covered.assign(memrefs.refs.size(), 0);
+  if( loops.size() == 0 ){ return; }
+
+  RangeContext c;
+  c.code = &code;
+  c.cfg = &cfg;
+  c.domTree = &domTree;
+  c.regOps = &regOps;
+  c.ssa = &ssa;
+  c.loops = &loops;
+
+  /*Which loops can be bracketed, and their entry and exit edges as
+   *(source block, target block) pairs
+   */
+  unsigned numLoops = loops.size();
+  vector<bool> usable(numLoops, true);
+  vector< vector<unsigned> > entries(numLoops);
+  vector< vector<unsigned> > exits(numLoops);
+  for( unsigned l = 0; l < numLoops; l++ ){
+    unsigned h = loops.loop(l).header;
+    if( loops.loop(l).kind == LoopIrreducible || h == 0 ){ usable[l] = false; }
+  }
+
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    if( cfg.insBegin(b) == cfg.insEnd(b) ){ continue; }
+    bool leaves = c.leavesRoutine(b);
+    for( unsigned l = loops.innermost(b); l != IFR_LoopForest::NoLoop; l = loops.loop(l).parent ){
+
+      if( leaves ){ usable[l] = false; }
+
+      for( const unsigned *s = cfg.succBegin(b); s != cfg.succEnd(b); s++ ){
+        if( !loops.contains(l, *s) ){
+          exits[l].push_back(b);
+          exits[l].push_back(*s);
+        }
+      }
+
+    }
+
+    for( const unsigned *s = cfg.succBegin(b); s != cfg.succEnd(b); s++ ){
+      for( unsigned l = loops.innermost(*s); l != IFR_LoopForest::NoLoop; l = loops.loop(l).parent ){
+        if( *s == loops.loop(l).header && !loops.contains(l, b) ){
+          entries[l].push_back(b);
+          entries[l].push_back(*s);
+        }
+      }
+    }
+
+  }
+
+  for( unsigned l = 0; l < numLoops; l++ ){
+    bool taken, fall;
+    for( unsigned e = 0; usable[l] && e < entries[l].size(); e += 2 ){
+      usable[l] = c.edgeModes(entries[l][e], entries[l][e + 1], taken, fall);
+    }
+    for( unsigned e = 0; usable[l] && e < exits[l].size(); e += 2 ){
+      usable[l] = c.edgeModes(exits[l][e], exits[l][e + 1], taken, fall);
+    }
+    if( entries[l].empty() ){ usable[l] = false; }
+  }
+
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    unsigned l = loops.innermost(b);
+    if( l == IFR_LoopForest::NoLoop || !usable[l] ){ continue; }
+
+    /*Once per iteration: dominates every latch*/
+    bool everyTrip = true;
+    for( const unsigned *t = loops.latchBegin(l); t != loops.latchEnd(l); t++ ){
+      if( !domTree.dominates(b, *t) ){ everyTrip = false; }
+    }
+    if( !everyTrip ){ continue; }
+
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      for( unsigned k = memrefs.begin(in); k < memrefs.end(in); k++ ){
+
+        const IFR_MemoryRef &ref = memrefs.refs[k];
+        if( ref.size == 0 ){ continue; }
+
+        /*Classify the address registers: one induction variable, the
+         *rest invariant
+         */
+        unsigned addrRegs[2] = { ref.base, ref.index };
+        ADDRDELTA weights[2] = { 1, (ADDRDELTA)ref.scale };
+        unsigned ivReg = IFR_MemoryRef::NoReg;
+        unsigned ivPhi = IFR_SSA::NoValue;
+        ADDRDELTA coeff = 0, offset = 0;
+        bool ok = true;
+        for( unsigned a = 0; ok && a < 2; a++ ){
+
+          if( addrRegs[a] == IFR_MemoryRef::NoReg ){ continue; }
+          unsigned dense = regOps.lookup(addrRegs[a]);
+          unsigned v = dense == IFR_RegOps::NoReg ? IFR_SSA::NoValue : ssa.reachingDef(regOps, in, dense);
+          if( v == IFR_SSA::NoValue ){
+            ok = false;
+            break;
+          }
+
+          /*Invariant registers are read on the entry edge, so the value
+           *itself must come from outside the loop
+           */
+          if( !loops.contains(l, ssa.value(v).block) ){ continue; }
+
+          ADDRDELTA off;
+          unsigned r = c.root(v, l, off);
+          if( r == IFR_SSA::NoValue ){
+            ok = false;
+          }else if( ssa.value(r).kind == SSAPhi && ssa.value(r).block == loops.loop(l).header &&
+                    (ivPhi == IFR_SSA::NoValue || ivPhi == r) && c.inductionStep(r, l) != 0 ){
+            ivReg = addrRegs[a];
+            ivPhi = r;
+            coeff += weights[a];
+            offset = off;
+          }else{
+            ok = false;
+          }
+
+        }
+        if( !ok || ivPhi == IFR_SSA::NoValue ){ continue; }
+
+        IFR_StridedRef sr;
+        sr.loop = l;
+        sr.ins = in;
+        sr.ref = k;
+        sr.reg = ivReg;
+        sr.coeff = coeff;
+        sr.offset = offset;
+        sr.stride = coeff * c.inductionStep(ivPhi, l);
+
+        /*The register's offset from the phi on every exit edge*/
+        vector<IFR_RangeEdge> added;
+        IFR_RangeEdge edge;
+        edge.strided = refs.size();
+        for( unsigned e = 0; ok && e < entries[l].size() + exits[l].size(); e += 2 ){
+
+          bool isExit = e >= entries[l].size();
+          unsigned u = isExit ? exits[l][e - entries[l].size()] : entries[l][e];
+          unsigned v = isExit ? exits[l][e - entries[l].size() + 1] : entries[l][e + 1];
+          edge.ins = cfg.insEnd(u) - 1;
+          edge.exit = isExit;
+          edge.offset = 0;
+          if( isExit ){
+            unsigned dense = regOps.lookup(ivReg);
+            ok = c.root(c.valueAtEnd(u, dense), l, edge.offset) == ivPhi;
+          }
+
+          bool taken, fall;
+          c.edgeModes(u, v, taken, fall);
+          if( taken ){
+            edge.taken = true;
+            added.push_back(edge);
+          }
+          if( fall ){
+            edge.taken = false;
+            added.push_back(edge);
+          }
+
+        }
+        if( !ok ){ continue; }
+
+        refs.push_back(sr);
+        edges.insert(edges.end(), added.begin(), added.end());
+        covered[k] = 1;
+
+      }
+    }
+
+  }
+
+  std::stable_sort(edges.begin(), edges.end(), edgeBefore);
+
+}
+
+size_t IFR_LoopRanges::bytes() const{
+  return IFR_Bytes(covered) +
+         IFR_Bytes(refs) +
+         IFR_Bytes(edges);
+}
@@ -0,0 +1,99 @@
+#ifndef _IFR_LOOPRANGES_H_
+#define _IFR_LOOPRANGES_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_MemoryRef.h"
+#include "IFR_CFG.h"
+#include "IFR_DomTree.h"
+#include "IFR_SSA.h"
+#include "IFR_Loops.h"
+
+/*A memory reference whose address moves by a constant every iteration of
+ *its innermost loop, e.g. M[rbx + rcx*8] with rcx += 1 per trip and rbx
+ *loop invariant.  Its accesses over one execution of the loop are the
+ *range start, start + stride, ..., end, where
+ *
+ *  address = coeff * (reg + offset) + rest
+ *
+ *rest is fixed on loop entry (displacement plus invariant registers) and
+ *reg is read on the entry and exit edges.
+ */
+class IFR_StridedRef{
+
+public:
+
+  unsigned loop;
+  unsigned ins;       //routine instruction number of the access
+  unsigned ref;       //index into IFR_MemRefTable::refs
+  unsigned reg;       //machine register of the induction variable
+  ADDRDELTA coeff;    //1, scale or 1 + scale
+  ADDRDELTA offset;   //reg at the access minus reg at the loop header
+  ADDRDELTA stride;   //bytes per iteration
+
+};
+
+/*A loop entry or exit edge where a strided reference's range is opened or
+ *closed.  Edges are placed on the last instruction of their source block,
+ *on the branch taken or on the fall through, so they run once per loop
+ *execution and never per iteration.
+ */
+class IFR_RangeEdge{
+
+public:
+
+  unsigned strided;   //index into IFR_LoopRanges::refs
+  unsigned ins;
+  bool taken;
+  bool exit;
+  ADDRDELTA offset;   //exits: reg on the edge minus reg at the loop header
+
+};
+
+/*Strided references of a routine and the edges that bracket them.
+ *
+ *A reference qualifies when its block runs exactly once per iteration of
+ *its innermost loop (it is in no inner loop and dominates every latch),
+ *one of its address registers is a basic induction variable of that loop
+ *(a header phi that every latch advances by the same constant, through
+ *add/sub/inc/dec/lea steps recorded in IFR_RegOps) and the other is
+ *defined outside the loop.  The loop must be reducible, not headed by the
+ *routine entry, left only through CFG edges (no returns or indirect jumps
+ *inside) and have every entry and exit edge instrumentable.
+ *
+ *The range closed on an exit includes the iteration the loop left from,
+ *even if it left before the access; it may be one element too large,
+ *never too small.
+ */
+class IFR_LoopRanges{
+
+  std::vector<unsigned char> covered;   //per memref
+
+public:
+
+  std::vector<IFR_StridedRef> refs;
+  std::vector<IFR_RangeEdge> edges;     //sorted by ins
+
+  IFR_LoopRanges();
+
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_DomTree &domTree,
+               const IFR_MemRefTable &memrefs, const IFR_RegOps &regOps, const IFR_SSA &ssa,
+               const IFR_LoopForest &loops);
+
+  size_t bytes() const;
+
+  /*Whether memref k is covered by a range, so needs no per-access event*/
+  bool summarized(unsigned k) const { return k < covered.size() && covered[k] != 0; }
+
+  /*Stops summarizing strided reference s (e.g. when the front end cannot
+   *instrument one of its edges); its accesses need events again
+   */
+  void drop(unsigned s);
+
+  /*Edges placed on instruction ins are edges[edgeBegin(ins)..edgeEnd(ins))*/
+  unsigned edgeBegin(unsigned ins) const;
+  unsigned edgeEnd(unsigned ins) const;
+
+};
+
+#endif
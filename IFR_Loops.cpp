@@ -0,0 +1,193 @@
+#include <algorithm>
+#include "IFR_Loops.h"
+
+using std::vector;
+
+const unsigned IFR_LoopForest::NoLoop;
+
+IFR_LoopForest::IFR_LoopForest(){
+  latchStart.assign(1, 0);
+}
+
+bool IFR_LoopForest::contains(unsigned l, unsigned b) const{
+
+  /*Parents have larger numbers, so stop once past l*/
+  for( unsigned x = loopOf[b]; x != NoLoop && x <= l; x = loops[x].parent ){
+    if( x == l ){ return true; }
+  }
+  return false;
+
+}
+
+static unsigned find(vector<unsigned> &uf, unsigned x){
+
+  unsigned root = x;
+  while( uf[root] != root ){ root = uf[root]; }
+  while( uf[x] != root ){
+    unsigned next = uf[x];
+    uf[x] = root;
+    x = next;
+  }
+  return root;
+
+}
+
+void IFR_LoopForest::compute(const IFR_CFG &cfg){
+
+  unsigned n = cfg.size();
+  const unsigned Unvisited = (unsigned)-1;
+
+  loops.clear();
+  loopOf.assign(n, NoLoop);
+  latchStart.assign(1, 0);
+  latches.clear();
+  if( n == 0 ){ return; }
+
+  /*Preorder numbers and the last descendant of each, from an iterative
+   *DFS; the rest of the algorithm works on preorder numbers.
+   */
+  vector<unsigned> number(n, Unvisited);
+  vector<unsigned> node;
+  vector<unsigned> last;
+  vector< std::pair<unsigned, unsigned> > stack;
+  number[0] = 0;
+  node.push_back(0);
+  last.push_back(0);
+  stack.push_back( std::make_pair(0u, 0u) );
+  while( !stack.empty() ){
+
+    unsigned b = stack.back().first;
+    unsigned &next = stack.back().second;
+    if( next < cfg.numSuccs(b) ){
+      unsigned s = cfg.succBegin(b)[next++];
+      if( number[s] == Unvisited ){
+        number[s] = node.size();
+        node.push_back(s);
+        last.push_back(0);
+        stack.push_back( std::make_pair(s, 0u) );
+      }
+      continue;
+    }
+    last[ number[b] ] = node.size() - 1;
+    stack.pop_back();
+
+  }
+  unsigned reached = node.size();
+
+  /*Split predecessors into back edges (from a DFS descendant, or a self
+   *loop) and the rest
+   */
+  vector< vector<unsigned> > backPreds(reached);
+  vector< vector<unsigned> > nonBackPreds(reached);
+  for( unsigned w = 0; w < reached; w++ ){
+    for( const unsigned *p = cfg.predBegin(node[w]); p != cfg.predEnd(node[w]); p++ ){
+      unsigned v = number[*p];
+      if( v == Unvisited ){ continue; }
+      if( w <= v && v <= last[w] ){
+        backPreds[w].push_back(v);
+      }else{
+        nonBackPreds[w].push_back(v);
+      }
+    }
+  }
+
+  /*Innermost headers first: collapse each loop body into its header with
+   *union-find, so outer loops see inner ones as single nodes.
+   */
+  vector<unsigned> uf(reached);
+  vector<unsigned> headed(reached, NoLoop);
+  vector<unsigned> inPool(reached, Unvisited);
+  vector<unsigned> pool;
+  vector<unsigned> work;
+  for( unsigned i = 0; i < reached; i++ ){ uf[i] = i; }
+
+  for( int wi = reached - 1; wi >= 0; wi-- ){
+
+    unsigned w = wi;
+    bool self = false;
+    IFR_LoopKind kind = LoopReducible;
+    pool.clear();
+    for( unsigned k = 0; k < backPreds[w].size(); k++ ){
+      unsigned v = backPreds[w][k];
+      if( v == w ){
+        self = true;
+        continue;
+      }
+      unsigned r = find(uf, v);
+      if( inPool[r] != w ){
+        inPool[r] = w;
+        pool.push_back(r);
+      }
+    }
+    if( pool.empty() && !self ){ continue; }
+
+    work = pool;
+    while( !work.empty() ){
+
+      unsigned x = work.back();
+      work.pop_back();
+      for( unsigned k = 0; k < nonBackPreds[x].size(); k++ ){
+
+        unsigned y = find(uf, nonBackPreds[x][k]);
+        if( !(w <= y && y <= last[w]) ){
+          /*Entered other than through w*/
+          kind = LoopIrreducible;
+          nonBackPreds[w].push_back(y);
+        }else if( y != w && inPool[y] != w ){
+          inPool[y] = w;
+          pool.push_back(y);
+          work.push_back(y);
+        }
+
+      }
+
+    }
+    if( pool.empty() && kind == LoopReducible ){ kind = LoopSelf; }
+
+    unsigned l = loops.size();
+    IFR_Loop loop;
+    loop.header = node[w];
+    loop.parent = NoLoop;
+    loop.depth = 0;
+    loop.numBlocks = 0;
+    loop.kind = kind;
+    loops.push_back(loop);
+    headed[w] = l;
+    loopOf[ node[w] ] = l;
+
+    for( unsigned k = 0; k < pool.size(); k++ ){
+      unsigned x = pool[k];
+      uf[x] = w;
+      if( headed[x] != NoLoop ){
+        loops[ headed[x] ].parent = l;
+      }else{
+        loopOf[ node[x] ] = l;
+      }
+    }
+
+    for( unsigned k = 0; k < backPreds[w].size(); k++ ){
+      latches.push_back( node[ backPreds[w][k] ] );
+    }
+    latchStart.push_back( latches.size() );
+
+  }
+
+  /*Parents are numbered after their children*/
+  for( int l = loops.size() - 1; l >= 0; l-- ){
+    unsigned p = loops[l].parent;
+    loops[l].depth = p == NoLoop ? 1 : loops[p].depth + 1;
+  }
+  for( unsigned b = 0; b < n; b++ ){
+    for( unsigned x = loopOf[b]; x != NoLoop; x = loops[x].parent ){
+      loops[x].numBlocks++;
+    }
+  }
+
+}
+
+size_t IFR_LoopForest::bytes() const{
+  return IFR_Bytes(loops) +
+         IFR_Bytes(loopOf) +
+         IFR_Bytes(latchStart) +
+         IFR_Bytes(latches);
+}
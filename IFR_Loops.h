@@ -0,0 +1,59 @@
+#ifndef _IFR_LOOPS_H_
+#define _IFR_LOOPS_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+
+enum IFR_LoopKind { LoopReducible = 0, LoopSelf = 1, LoopIrreducible = 2 };
+
+class IFR_Loop{
+
+public:
+
+  unsigned header;    //for irreducible loops, the entry the DFS reached first
+  unsigned parent;    //enclosing loop, or IFR_LoopForest::NoLoop
+  unsigned depth;     //1 for outermost loops
+  unsigned numBlocks; //including those of nested loops
+  IFR_LoopKind kind;
+
+};
+
+/*Loop nesting forest of a routine, by Havlak's algorithm ("Nesting of
+ *Reducible and Irreducible Loops", TOPLAS 1997) with Ramalingam's fix for
+ *the worst case.  Reducible loops come out as the natural loops of their
+ *back edges, the same ones dominance gives (a back edge's target dominates
+ *its source); irreducible regions become one loop headed by the block the
+ *DFS entered them through.
+ *
+ *Loops are numbered inner before outer, so a loop's parent always has a
+ *larger number.  Each block records its innermost loop; membership in an
+ *outer loop is a walk up the parents.
+ */
+class IFR_LoopForest{
+
+  std::vector<IFR_Loop> loops;
+  std::vector<unsigned> loopOf;       //innermost loop of each block, NoLoop if none
+  std::vector<unsigned> latchStart;   //back edge sources of loop l are
+  std::vector<unsigned> latches;      //latches[latchStart[l]..latchStart[l+1])
+
+public:
+
+  static const unsigned NoLoop = (unsigned)-1;
+
+  IFR_LoopForest();
+
+  void compute(const IFR_CFG &cfg);
+
+  size_t bytes() const;
+
+  unsigned size() const { return loops.size(); }
+  const IFR_Loop &loop(unsigned l) const { return loops[l]; }
+  unsigned innermost(unsigned b) const { return loopOf[b]; }
+  bool contains(unsigned l, unsigned b) const;
+
+  const unsigned *latchBegin(unsigned l) const { return latches.empty() ? 0 : &latches[0] + latchStart[l]; }
+  const unsigned *latchEnd(unsigned l) const { return latches.empty() ? 0 : &latches[0] + latchStart[l + 1]; }
+
+};
+
+#endif
@@ -1,14 +1,75 @@
 #include "IFR_MemoryRef.h"
 
-IFR_MemoryRef::IFR_MemoryRef(){
+const unsigned IFR_MemoryRef::NoReg;
 
+IFR_MemoryRef::IFR_MemoryRef(){
+  base = NoReg;
+  displacement = 0;
+  index = NoReg;
+  scale = 1;
+  size = 0;
+  type = MemRead;
 }
 
 
-IFR_MemoryRef::IFR_MemoryRef(REG b, ADDRDELTA d, REG i, UINT32 s, MemOpType t){
+IFR_MemoryRef::IFR_MemoryRef(unsigned b, ADDRDELTA d, unsigned i, UINT32 s, MemOpType t){
   base = b;
   displacement = d;
   index = i;
   scale = s;
+  size = 0;
   type = t;
 }
+
+IFR_MemRefTable::IFR_MemRefTable(){
+  clear();
+}
+
+void IFR_MemRefTable::clear(){
+  refs.clear();
+  refStart.assign(1, 0);
+}
+
+void IFR_MemRefTable::save(IFR_BlobWriter &w) const{
+
+  w.putWords(refStart);
+  w.putWord( refs.size() );
+  for( unsigned i = 0; i < refs.size(); i++ ){
+    w.putWord( refs[i].base );
+    w.putWide( (UINT64)refs[i].displacement );
+    w.putWord( refs[i].index );
+    w.putWord( refs[i].scale );
+    w.putWord( refs[i].size );
+    w.putWord( (UINT32)refs[i].type );
+  }
+
+}
+
+bool IFR_MemRefTable::load(IFR_BlobReader &r){
+
+  r.getWords(refStart);
+  unsigned n = r.getWord();
+  refs.clear();
+  for( unsigned i = 0; r.ok() && i < n; i++ ){
+    unsigned base = r.getWord();
+    ADDRDELTA disp = (ADDRDELTA)r.getWide();
+    unsigned index = r.getWord();
+    UINT32 scale = r.getWord();
+    UINT32 size = r.getWord();
+    MemOpType type = (MemOpType)r.getWord();
+    refs.push_back( IFR_MemoryRef(base, disp, index, scale, type) );
+    refs.back().size = size;
+  }
+
+  if( !r.ok() || !IFR_ValidStarts(refStart, refs.size()) ){
+    clear();
+    return false;
+  }
+  return true;
+
+}
+
+size_t IFR_MemRefTable::bytes() const{
+  return IFR_Bytes(refs) +
+         IFR_Bytes(refStart);
+}
@@ -1,16 +1,57 @@
-#include <pin.H>
+#ifndef _IFR_MEMORYREF_H_
+#define _IFR_MEMORYREF_H_
+
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_Serialize.h"
 
 enum MemOpType { MemRead = 0, MemWrite = 1, MemBoth = 2 };
+
+/*Address expression of one memory operand: M[base + displacement +
+ *index*scale], size bytes wide (0 if unknown).  Registers are the
+ *decoder's register numbers (Pin's REG in the Pin tool), NoReg when
+ *absent.
+ */
 class IFR_MemoryRef{
 
 public:
  
+  static const unsigned NoReg = (unsigned)-1;
+
   IFR_MemoryRef(); 
-  IFR_MemoryRef(REG,ADDRDELTA,REG,UINT32,MemOpType); 
-  REG base;
+  IFR_MemoryRef(unsigned,ADDRDELTA,unsigned,UINT32,MemOpType); 
+  unsigned base;
   ADDRDELTA displacement;
-  REG index;
+  unsigned index;
   UINT32 scale;
+  UINT32 size;
   MemOpType type;
 
 };
+
+/*The memory references of a whole routine, grouped by routine instruction
+ *number (see IFR_CFG::insBegin): instruction i's references are
+ *refs[refStart[i]..refStart[i+1]).
+ */
+class IFR_MemRefTable{
+
+public:
+
+  IFR_MemRefTable();
+
+  void clear();
+
+  void save(IFR_BlobWriter &w) const;
+  bool load(IFR_BlobReader &r);
+
+  size_t bytes() const;
+
+  unsigned begin(unsigned ins) const { return refStart[ins]; }
+  unsigned end(unsigned ins) const { return refStart[ins + 1]; }
+
+  std::vector<IFR_MemoryRef> refs;
+  std::vector<unsigned> refStart;
+
+};
+
+#endif
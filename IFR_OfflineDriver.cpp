@@ -0,0 +1,612 @@
+/*Offline front end: runs the analysis core over the functions of an ELF
+ *x86-64 executable without Pin, decoding .text with XED.
+ *
+ *  IFR_Offline [-threads N] [-domalg chk|lt|auto] [-pred] [-idom] [-df] [-ssa] [-loops] [-redundant] [-pdom] [-callgraph] [-stats [N]] binary
+ *
+ *Prints one summary line per function, the same per-block listings as the
+ *Pin tool's knobs of the same names, and timings at the end.  Functions
+ *come from .symtab (or .dynsym if stripped), so a fully stripped binary
+ *has nothing to analyze.  With -callgraph, functions are summarized
+ *bottom-up over the call graph first and calls to them narrowed.  -stats
+ *times every pass of every function and lists the N slowest (default 10).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+extern "C" {
+#include "xed-interface.h"
+}
+
+#include "IFR_Analysis.h"
+#include "IFR_WorkPool.h"
+#include "IFR_CallGraph.h"
+#include "IFR_JumpTableMatch.h"
+#include "IFR_Stats.h"
+
+using std::string;
+using std::vector;
+
+static const xed_reg_enum_t callerSaved[] = { XED_REG_RAX, XED_REG_RCX, XED_REG_RDX, XED_REG_RSI,
+                                              XED_REG_RDI, XED_REG_R8, XED_REG_R9, XED_REG_R10,
+                                              XED_REG_R11, XED_REG_RFLAGS };
+
+class Function{
+public:
+  string name;
+  ADDRINT address;
+  UINT64 size;
+  const unsigned char *bytes;
+  IFR_Analysis *analysis;
+};
+
+static bool byAddress(const Function &a, const Function &b){
+  return a.address < b.address;
+}
+
+/*Sized FUNC symbols that lie inside an executable section*/
+static void findFunctions(const unsigned char *file, size_t size, vector<Function> &funcs){
+
+  const Elf64_Ehdr *eh = (const Elf64_Ehdr *)file;
+  if( eh->e_shoff == 0 || eh->e_shoff + (UINT64)eh->e_shnum * sizeof(Elf64_Shdr) > size ){ return; }
+  const Elf64_Shdr *sh = (const Elf64_Shdr *)(file + eh->e_shoff);
+
+  unsigned symtab = 0;
+  for( unsigned s = 0; s < eh->e_shnum; s++ ){
+    if( sh[s].sh_type == SHT_SYMTAB ){ symtab = s; }
+    if( sh[s].sh_type == SHT_DYNSYM && symtab == 0 ){ symtab = s; }
+  }
+  if( symtab == 0 || sh[symtab].sh_link >= eh->e_shnum ){ return; }
+
+  const Elf64_Shdr &strs = sh[ sh[symtab].sh_link ];
+  const Elf64_Sym *syms = (const Elf64_Sym *)(file + sh[symtab].sh_offset);
+  unsigned numSyms = sh[symtab].sh_size / sizeof(Elf64_Sym);
+  if( sh[symtab].sh_offset + sh[symtab].sh_size > size || strs.sh_offset + strs.sh_size > size ){ return; }
+
+  for( unsigned i = 0; i < numSyms; i++ ){
+
+    const Elf64_Sym &sym = syms[i];
+    if( ELF64_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_size == 0 ||
+        sym.st_shndx == SHN_UNDEF || sym.st_shndx >= eh->e_shnum ){
+      continue;
+    }
+    const Elf64_Shdr &sec = sh[sym.st_shndx];
+    if( (sec.sh_flags & SHF_EXECINSTR) == 0 || sec.sh_type != SHT_PROGBITS ||
+        sym.st_value < sec.sh_addr || sym.st_value + sym.st_size > sec.sh_addr + sec.sh_size ||
+        sec.sh_offset + sec.sh_size > size || sym.st_name >= strs.sh_size ){
+      continue;
+    }
+
+    Function f;
+    f.name = (const char *)(file + strs.sh_offset + sym.st_name);
+    f.address = sym.st_value;
+    f.size = sym.st_size;
+    f.bytes = file + sec.sh_offset + (sym.st_value - sec.sh_addr);
+    f.analysis = 0;
+    funcs.push_back(f);
+
+  }
+
+  /*Aliases share an address; keep the first*/
+  std::stable_sort(funcs.begin(), funcs.end(), byAddress);
+  unsigned kept = 0;
+  for( unsigned i = 0; i < funcs.size(); i++ ){
+    if( kept > 0 && funcs[kept - 1].address == funcs[i].address ){ continue; }
+    funcs[kept++] = funcs[i];
+  }
+  funcs.resize(kept);
+
+}
+
+/*The file's allocated read-only sections, at their link addresses*/
+class FileReader : public IFR_MemoryReader{
+
+  class Section{
+  public:
+    ADDRINT address;
+    UINT64 size;
+    const unsigned char *bytes;
+  };
+  vector<Section> sections;
+
+public:
+
+  void open(const unsigned char *file, size_t size){
+
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)file;
+    if( eh->e_shoff == 0 || eh->e_shoff + (UINT64)eh->e_shnum * sizeof(Elf64_Shdr) > size ){ return; }
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(file + eh->e_shoff);
+    for( unsigned s = 0; s < eh->e_shnum; s++ ){
+      if( (sh[s].sh_flags & SHF_ALLOC) == 0 || (sh[s].sh_flags & SHF_WRITE) != 0 ||
+          sh[s].sh_type != SHT_PROGBITS || sh[s].sh_offset + sh[s].sh_size > size ){
+        continue;
+      }
+      Section sec;
+      sec.address = sh[s].sh_addr;
+      sec.size = sh[s].sh_size;
+      sec.bytes = file + sh[s].sh_offset;
+      sections.push_back(sec);
+    }
+
+  }
+
+  bool read(ADDRINT addr, void *buf, size_t size) const{
+
+    for( unsigned s = 0; s < sections.size(); s++ ){
+      const Section &sec = sections[s];
+      if( addr >= sec.address && addr - sec.address <= sec.size && size <= sec.size - (addr - sec.address) ){
+        memcpy(buf, sec.bytes + (addr - sec.address), size);
+        return true;
+      }
+    }
+    return false;
+
+  }
+
+};
+
+static FileReader image;
+
+static unsigned fullReg(xed_reg_enum_t r){
+  return xed_get_largest_enclosing_register(r);
+}
+
+static bool trackedReg(xed_reg_enum_t r){
+  return r != XED_REG_INVALID && xed_reg_class(r) != XED_REG_CLASS_IP;
+}
+
+/*reg += delta for add/sub with an immediate, inc, dec and lea r, [r + disp]
+ *on a full register
+ */
+static bool registerStep(const xed_decoded_inst_t *xedd, xed_reg_enum_t &reg, ADDRDELTA &delta){
+
+  reg = xed_decoded_inst_get_reg(xedd, XED_OPERAND_REG0);
+  if( !trackedReg(reg) || fullReg(reg) != (unsigned)reg ){ return false; }
+
+  switch( xed_decoded_inst_get_iclass(xedd) ){
+    case XED_ICLASS_ADD:
+    case XED_ICLASS_SUB:
+      if( xed_decoded_inst_get_immediate_width(xedd) == 0 ||
+          xed_decoded_inst_get_reg(xedd, XED_OPERAND_REG1) != XED_REG_INVALID ){
+        return false;
+      }
+      delta = (ADDRDELTA)xed_decoded_inst_get_signed_immediate(xedd);
+      if( xed_decoded_inst_get_iclass(xedd) == XED_ICLASS_SUB ){ delta = -delta; }
+      return true;
+    case XED_ICLASS_INC:
+      delta = 1;
+      return true;
+    case XED_ICLASS_DEC:
+      delta = -1;
+      return true;
+    case XED_ICLASS_LEA:
+      if( xed_decoded_inst_get_base_reg(xedd, 0) != reg ||
+          xed_decoded_inst_get_index_reg(xedd, 0) != XED_REG_INVALID ){
+        return false;
+      }
+      delta = (ADDRDELTA)xed_decoded_inst_get_memory_displacement(xedd, 0);
+      return true;
+    default:
+      return false;
+  }
+
+}
+
+/*Same records the Pin tool's snapshot produces*/
+static void decodeFunction(const xed_state_t &state, Function &f){
+
+  IFR_Analysis &a = *f.analysis;
+  a.code.clear();
+  a.memrefs.clear();
+  a.regOps.clear();
+
+  /*The last few instructions, for matching jump tables*/
+  xed_decoded_inst_t recent[IFR_JUMPTABLE_WINDOW];
+  ADDRINT recentAddr[IFR_JUMPTABLE_WINDOW];
+  unsigned numRecent = 0;
+  vector<IFR_JumpTableSite> sites;
+
+  UINT64 off = 0;
+  while( off < f.size ){
+
+    xed_decoded_inst_t xedd;
+    xed_decoded_inst_zero_set_mode(&xedd, &state);
+    unsigned avail = (f.size - off > XED_MAX_INSTRUCTION_BYTES) ? XED_MAX_INSTRUCTION_BYTES : f.size - off;
+    if( xed_decode(&xedd, f.bytes + off, avail) != XED_ERROR_NONE ){ break; }
+
+    ADDRINT addr = f.address + off;
+    unsigned len = xed_decoded_inst_get_length(&xedd);
+    xed_category_enum_t cat = xed_decoded_inst_get_category(&xedd);
+    bool direct = xed_decoded_inst_get_branch_displacement_width(&xedd) > 0;
+    ADDRINT target = direct ? addr + len + (ADDRDELTA)xed_decoded_inst_get_branch_displacement(&xedd) : 0;
+
+    IFR_InsKind kind = InsOther;
+    if( cat == XED_CATEGORY_UNCOND_BR ){
+      kind = direct ? InsJump : InsIndirectJump;
+    }else if( cat == XED_CATEGORY_COND_BR ){
+      kind = direct ? InsCondJump : InsIndirectJump;
+    }else if( cat == XED_CATEGORY_CALL ){
+      kind = InsCall;
+    }else if( cat == XED_CATEGORY_RET ){
+      kind = InsReturn;
+    }
+    a.code.add(addr, len, kind, target);
+
+    /*Memory operands; address generation (lea) neither reads nor writes*/
+    unsigned char flags = 0;
+    for( unsigned m = 0; m < xed_decoded_inst_number_of_memory_operands(&xedd); m++ ){
+
+      bool rd = xed_decoded_inst_mem_read(&xedd, m);
+      bool wr = xed_decoded_inst_mem_written(&xedd, m);
+      xed_reg_enum_t base = xed_decoded_inst_get_base_reg(&xedd, m);
+      xed_reg_enum_t index = xed_decoded_inst_get_index_reg(&xedd, m);
+      if( trackedReg(base) ){ a.regOps.addUse( fullReg(base) ); }
+      if( trackedReg(index) ){ a.regOps.addUse( fullReg(index) ); }
+      if( !rd && !wr ){ continue; }
+
+      IFR_MemoryRef ref( base == XED_REG_INVALID ? IFR_MemoryRef::NoReg : (unsigned)base,
+                         (ADDRDELTA)xed_decoded_inst_get_memory_displacement(&xedd, m),
+                         index == XED_REG_INVALID ? IFR_MemoryRef::NoReg : (unsigned)index,
+                         xed_decoded_inst_get_scale(&xedd, m),
+                         (rd && wr) ? MemBoth : (wr ? MemWrite : MemRead) );
+      ref.size = xed_decoded_inst_get_memory_operand_length(&xedd, m);
+      a.memrefs.refs.push_back(ref);
+      if( rd ){ flags |= IFR_INS_MEMREAD; }
+      if( wr ){ flags |= IFR_INS_MEMWRITE; }
+
+    }
+    a.memrefs.refStart.push_back( a.memrefs.refs.size() );
+
+    /*Register operands, including suppressed ones such as flags and the
+     *stack pointer
+     */
+    const xed_inst_t *xi = xed_decoded_inst_inst(&xedd);
+    for( unsigned o = 0; o < xed_inst_noperands(xi); o++ ){
+
+      const xed_operand_t *op = xed_inst_operand(xi, o);
+      xed_operand_enum_t name = xed_operand_name(op);
+      if( !xed_operand_is_register(name) ){ continue; }
+      xed_reg_enum_t r = xed_decoded_inst_get_reg(&xedd, name);
+      if( !trackedReg(r) ){ continue; }
+      if( xed_operand_read(op) ){ a.regOps.addUse( fullReg(r) ); }
+      if( xed_operand_written(op) ){ a.regOps.addDef( fullReg(r) ); }
+
+    }
+    xed_reg_enum_t stepped;
+    ADDRDELTA delta;
+    if( registerStep(&xedd, stepped, delta) ){ a.regOps.addStep(fullReg(stepped), delta); }
+    if( xed_decoded_inst_get_attribute(&xedd, XED_ATTRIBUTE_LOCKED) ||
+        xed_decoded_inst_get_iclass(&xedd) == XED_ICLASS_MFENCE ){
+      flags |= IFR_INS_SYNC;
+    }
+    if( kind == InsCall ){
+      flags |= IFR_INS_CALL;
+      for( unsigned r = 0; r < sizeof(callerSaved) / sizeof(callerSaved[0]); r++ ){
+        a.regOps.addDef(callerSaved[r]);
+      }
+    }
+    a.regOps.endIns(flags);
+
+    recent[numRecent % IFR_JUMPTABLE_WINDOW] = xedd;
+    recentAddr[numRecent % IFR_JUMPTABLE_WINDOW] = addr;
+    numRecent++;
+    if( kind == InsIndirectJump ){
+      const xed_decoded_inst_t *window[IFR_JUMPTABLE_WINDOW];
+      ADDRINT addrs[IFR_JUMPTABLE_WINDOW];
+      unsigned n = std::min(numRecent, (unsigned)IFR_JUMPTABLE_WINDOW);
+      for( unsigned w = 0; w < n; w++ ){
+        unsigned slot = (numRecent - n + w) % IFR_JUMPTABLE_WINDOW;
+        window[w] = &recent[slot];
+        addrs[w] = recentAddr[slot];
+      }
+      IFR_JumpTableSite site;
+      site.ins = a.code.ins.size() - 1;
+      if( IFR_MatchJumpTable(window, addrs, n, site) ){ sites.push_back(site); }
+    }
+
+    off += len;
+
+  }
+
+  IFR_ResolveJumpTables(a.code, sites, image);
+  a.codeReady();
+
+}
+
+static vector<Function> funcs;
+static unsigned passes;
+
+static void analyzeTask(unsigned item, void *){
+  funcs[item].analysis->compute(passes);
+}
+
+static bool costlier(unsigned a, unsigned b){
+  return funcs[a].analysis->code.ins.size() > funcs[b].analysis->code.ins.size();
+}
+
+static void printSSAValue(IFR_Analysis &a, unsigned v){
+
+  if( v == IFR_SSA::NoValue ){
+    printf("?");
+    return;
+  }
+  if( a.ssa.value(v).var == a.ssa.heapVar() ){
+    printf("mem.%u", v);
+  }else{
+    printf("%s.%u", xed_reg_enum_t2str( (xed_reg_enum_t)a.regOps.regName( a.ssa.value(v).var ) ), v);
+  }
+
+}
+
+static const char *loopKinds[] = { "reducible", "self", "irreducible" };
+
+static void printLoops(IFR_Analysis &a){
+
+  IFR_CFG &cfg = a.cfg;
+  for( unsigned l = 0; l < a.loops.size(); l++ ){
+    const IFR_Loop &loop = a.loops.loop(l);
+    printf("  Loop %u at %p: depth %u, %u blocks, %s", l, (void *)cfg.entry(loop.header),
+           loop.depth, loop.numBlocks, loopKinds[loop.kind]);
+    if( loop.parent != IFR_LoopForest::NoLoop ){ printf(", in loop %u", loop.parent); }
+    printf("\n");
+  }
+
+  for( unsigned s = 0; s < a.ranges.refs.size(); s++ ){
+    const IFR_StridedRef &sr = a.ranges.refs[s];
+    const IFR_MemoryRef &ref = a.memrefs.refs[sr.ref];
+    printf("  Strided %p: %u bytes every %ld bytes over %s, loop %u\n",
+           (void *)a.code.ins[sr.ins].address, ref.size, (long)sr.stride,
+           xed_reg_enum_t2str( (xed_reg_enum_t)sr.reg ), sr.loop);
+  }
+
+}
+
+static void printRedundant(IFR_Analysis &a){
+
+  for( unsigned in = 0; in < a.code.ins.size(); in++ ){
+    for( unsigned k = a.memrefs.begin(in); k < a.memrefs.end(in); k++ ){
+      if( !a.redundant.redundant(k) ){ continue; }
+      unsigned d = a.redundant.coveredBy(k);
+      unsigned din = std::upper_bound(a.memrefs.refStart.begin(), a.memrefs.refStart.end(), d) -
+                     a.memrefs.refStart.begin() - 1;
+      printf("  Redundant %p: covered by %p\n", (void *)a.code.ins[in].address, (void *)a.code.ins[din].address);
+    }
+  }
+
+}
+
+static void printPostDom(IFR_Analysis &a){
+
+  IFR_CFG &cfg = a.cfg;
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    unsigned d = a.postDom.ipdom(b);
+    if( d == IFR_PostDom::NoBlock ){
+      printf("  Block %p: reaches no exit", (void *)cfg.entry(b));
+    }else if( d == IFR_PostDom::Exit ){
+      printf("  Block %p: ipdom exit", (void *)cfg.entry(b));
+    }else{
+      printf("  Block %p: ipdom %p", (void *)cfg.entry(b), (void *)cfg.entry(d));
+    }
+    if( a.postDom.controlBegin(b) != a.postDom.controlEnd(b) ){
+      printf(", control dependent on");
+      for( const unsigned *c = a.postDom.controlBegin(b); c != a.postDom.controlEnd(b); c++ ){
+        printf(" %p", (void *)cfg.entry(*c));
+      }
+    }
+    printf("\n");
+  }
+
+}
+
+static void usage(){
+  fprintf(stderr,"usage: IFR_Offline [-threads N] [-domalg chk|lt|auto] [-pred] [-idom] [-df] [-ssa] [-loops] [-redundant] [-pdom] [-callgraph] [-stats [N]] binary\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned threads = 0;
+  IFR_DomAlgorithm alg = DomAuto;
+  bool pred = false, idom = false, showDF = false, showSSA = false, showLoops = false, showRedundant = false;
+  bool showPostDom = false, callGraph = false;
+  unsigned statsTop = 0;
+  bool stats = false;
+  const char *path = 0;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-threads") && i + 1 < argc ){ threads = atoi(argv[++i]); }
+    else if( !strcmp(argv[i], "-domalg") && i + 1 < argc ){
+      i++;
+      alg = !strcmp(argv[i], "chk") ? DomCHK : (!strcmp(argv[i], "lt") ? DomLT : DomAuto);
+    }
+    else if( !strcmp(argv[i], "-pred") ){ pred = true; }
+    else if( !strcmp(argv[i], "-idom") ){ idom = true; }
+    else if( !strcmp(argv[i], "-df") ){ showDF = true; }
+    else if( !strcmp(argv[i], "-ssa") ){ showSSA = true; }
+    else if( !strcmp(argv[i], "-loops") ){ showLoops = true; }
+    else if( !strcmp(argv[i], "-redundant") ){ showRedundant = true; }
+    else if( !strcmp(argv[i], "-pdom") ){ showPostDom = true; }
+    else if( !strcmp(argv[i], "-callgraph") ){ callGraph = true; }
+    else if( !strcmp(argv[i], "-stats") ){
+      stats = true;
+      statsTop = (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') ? atoi(argv[++i]) : 10;
+    }
+    else if( argv[i][0] == '-' || path != 0 ){ usage(); }
+    else{ path = argv[i]; }
+  }
+  if( path == 0 ){ usage(); }
+
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if( fd < 0 || fstat(fd, &st) != 0 ){
+    perror(path);
+    return 1;
+  }
+  size_t size = st.st_size;
+  const unsigned char *file = (const unsigned char *)mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if( (void *)file == MAP_FAILED || size < sizeof(Elf64_Ehdr) || memcmp(file, ELFMAG, SELFMAG) != 0 ||
+      file[EI_CLASS] != ELFCLASS64 || ((const Elf64_Ehdr *)file)->e_machine != EM_X86_64 ){
+    fprintf(stderr,"%s: not an x86-64 ELF file\n",path);
+    return 1;
+  }
+
+  double t0 = IFR_Clock();
+  findFunctions(file, size, funcs);
+  image.open(file, size);
+
+  xed_tables_init();
+  xed_state_t state;
+  xed_state_zero(&state);
+  state.mmode = XED_MACHINE_MODE_LONG_64;
+  state.stack_addr_width = XED_ADDRESS_WIDTH_64b;
+
+  unsigned long numIns = 0;
+  for( unsigned f = 0; f < funcs.size(); f++ ){
+    funcs[f].analysis = new IFR_Analysis(funcs[f].address, 0, 0, alg);
+    double start = stats ? IFR_Clock() : 0;
+    decodeFunction(state, funcs[f]);
+    if( stats ){
+      /*Decoding is this front end's code pass*/
+      IFR_Analysis &a = *funcs[f].analysis;
+      a.enableProfile();
+      a.profile->passTime[0] = IFR_Clock() - start;
+      a.profile->passBytes[0] = a.code.bytes() + a.memrefs.bytes() + a.regOps.bytes();
+      a.profile->ran |= IFR_PASS_CODE;
+    }
+    numIns += funcs[f].analysis->code.ins.size();
+  }
+  double t1 = IFR_Clock();
+
+  IFR_CallGraph cg;
+  unsigned narrowed = 0;
+  if( callGraph ){
+    vector<IFR_Analysis *> all(funcs.size());
+    for( unsigned f = 0; f < funcs.size(); f++ ){
+      all[f] = funcs[f].analysis;
+    }
+    cg.build(all);
+    IFR_CallABI abi;
+    abi.callerSaved.assign(callerSaved, callerSaved + sizeof(callerSaved) / sizeof(callerSaved[0]));
+    std::sort(abi.callerSaved.begin(), abi.callerSaved.end());
+    abi.stackPointer = XED_REG_RSP;
+    cg.summarize(abi, threads);
+    for( unsigned f = 0; f < funcs.size(); f++ ){
+      narrowed += funcs[f].analysis->applyCallSummaries(cg, abi);
+    }
+  }
+  double tcg = IFR_Clock();
+
+  passes = IFR_PASS_DF | (showSSA ? IFR_PASS_SSA : 0) | (showLoops ? IFR_PASS_RANGES : 0) |
+           (showRedundant ? IFR_PASS_REDUNDANT : 0) | (showPostDom ? IFR_PASS_POSTDOM : 0);
+  vector<unsigned> items(funcs.size());
+  for( unsigned i = 0; i < items.size(); i++ ){
+    items[i] = i;
+  }
+  if( threads > 0 ){
+    std::sort(items.begin(), items.end(), costlier);
+    IFR_WorkPool pool;
+    pool.start(threads, items, analyzeTask, 0);
+    pool.join();
+  }else{
+    for( unsigned i = 0; i < items.size(); i++ ){
+      analyzeTask(items[i], 0);
+    }
+  }
+  double t2 = IFR_Clock();
+
+  unsigned candidates = 0, redundant = 0, indirect = 0, tables = 0;
+  for( unsigned f = 0; f < funcs.size(); f++ ){
+
+    IFR_Analysis &a = *funcs[f].analysis;
+    IFR_CFG &cfg = a.cfg;
+    for( unsigned i = 0; i < a.code.ins.size(); i++ ){
+      if( a.code.ins[i].kind == InsIndirectJump ){ indirect++; }
+    }
+    tables += a.code.numTables();
+    printf("%s %p: %u ins, %u blocks, %u edges, %u DF entries, %u memrefs\n", funcs[f].name.c_str(),
+           (void *)funcs[f].address, (unsigned)a.code.ins.size(), cfg.size(), cfg.numEdges(),
+           a.df.numEntries(), (unsigned)a.memrefs.refs.size());
+
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+
+      if( pred ){
+        printf("  Predecessors to %p:", (void *)cfg.entry(b));
+        for( const unsigned *p = cfg.predBegin(b); p != cfg.predEnd(b); p++ ){
+          printf(" %p", (void *)cfg.entry(*p));
+        }
+        printf("\n");
+      }
+      if( idom ){
+        unsigned d = a.domTree.idom(b);
+        printf("  IDom of %p: %p\n", (void *)cfg.entry(b), d == IFR_Dominators::NoBlock ? 0 : (void *)cfg.entry(d));
+      }
+      if( showDF ){
+        printf("  DF of %p:", (void *)cfg.entry(b));
+        for( const unsigned *d = a.df.begin(b); d != a.df.end(b); d++ ){
+          printf(" %p", (void *)cfg.entry(*d));
+        }
+        printf("\n");
+      }
+      if( showSSA ){
+        for( unsigned p = 0; p < a.ssa.numPhis(b); p++ ){
+          printf("  %p: ", (void *)cfg.entry(b));
+          printSSAValue(a, a.ssa.phi(b, p));
+          printf(" = phi(");
+          for( unsigned k = 0; k < cfg.numPreds(b); k++ ){
+            if( k > 0 ){ printf(", "); }
+            printSSAValue(a, a.ssa.phiArg(b, p, k));
+          }
+          printf(")\n");
+        }
+      }
+
+    }
+    if( showLoops ){ printLoops(a); }
+    if( showPostDom ){ printPostDom(a); }
+    if( showRedundant ){
+      printf("  %u of %u comparable memrefs redundant\n", a.redundant.numRedundant, a.redundant.numCandidates);
+      printRedundant(a);
+      candidates += a.redundant.numCandidates;
+      redundant += a.redundant.numRedundant;
+    }
+
+  }
+
+  fprintf(stderr,"IFR_Offline: %u functions, %lu instructions; decode %.3f ms, analysis %.3f ms (%.1f ns/ins, %u threads)\n",
+          (unsigned)funcs.size(), numIns, (t1 - t0) * 1e3, (t2 - tcg) * 1e3,
+          numIns ? (t2 - tcg) * 1e9 / numIns : 0.0, threads);
+  fprintf(stderr,"IFR_Offline: %u of %u indirect jumps resolved as jump tables\n", tables, indirect);
+  if( callGraph ){
+    unsigned largest = 0, pure = 0;
+    for( unsigned s = 0; s < cg.numSCCs(); s++ ){
+      largest = std::max(largest, cg.sccSize(s));
+    }
+    for( unsigned n = 0; n < cg.size(); n++ ){
+      const IFR_RoutineSummary &s = cg.summary(n);
+      if( s.known && !s.touchesMemory && !s.syncs ){ pure++; }
+    }
+    fprintf(stderr,"IFR_Offline: call graph %u edges, %u SCCs (largest %u), %u levels; %u pure functions, %u calls narrowed, %.3f ms\n",
+            cg.numEdges(), cg.numSCCs(), largest, cg.numLevels(), pure, narrowed, (tcg - t1) * 1e3);
+  }
+  if( stats ){
+    IFR_StatsTable table(statsTop);
+    for( unsigned f = 0; f < funcs.size(); f++ ){
+      table.add(funcs[f].name, *funcs[f].analysis, funcs[f].analysis->profile->total());
+    }
+    table.print(stderr);
+  }
+  if( showRedundant ){
+    fprintf(stderr,"IFR_Offline: %u of %u comparable memrefs redundant (%.1f%%)\n", redundant, candidates,
+            candidates ? 100.0 * redundant / candidates : 0.0);
+  }
+  return 0;
+
+}
@@ -0,0 +1,340 @@
+#include <stdarg.h>
+#include <string.h>
+
+#include "IFR_Output.h"
+#include "IFR_Clock.h"
+
+using std::vector;
+using std::string;
+
+static const char *kindNames[] = { "", "routine", "preds", "doms", "idom", "df", "block", "ins", "text" };
+
+IFR_OutBuffer::IFR_OutBuffer(){
+  records = 0;
+}
+
+void IFR_OutBuffer::putVarint(UINT64 v){
+  while( v >= 0x80 ){
+    bytes.push_back( (unsigned char)(v | 0x80) );
+    v >>= 7;
+  }
+  bytes.push_back( (unsigned char)v );
+}
+
+void IFR_OutBuffer::record(unsigned kind, const char *text, size_t textLength, const ADDRINT *addrs, unsigned n){
+
+  bytes.push_back( (unsigned char)kind );
+  putVarint(textLength);
+  bytes.insert(bytes.end(), text, text + textLength);
+  putVarint(n);
+  for( unsigned i = 0; i < n; i++ ){
+    putVarint(addrs[i]);
+  }
+  records++;
+
+}
+
+void IFR_OutBuffer::record(unsigned kind, const ADDRINT *addrs, unsigned n){
+  record(kind, "", 0, addrs, n);
+}
+
+void IFR_OutBuffer::record(unsigned kind, ADDRINT a, ADDRINT b){
+  ADDRINT addrs[2] = { a, b };
+  record(kind, "", 0, addrs, 2);
+}
+
+void IFR_OutBuffer::routine(const string &name, ADDRINT entry){
+  record(OutRoutine, name.data(), name.size(), &entry, 1);
+}
+
+void IFR_OutBuffer::ins(ADDRINT address, const string &text){
+  record(OutIns, text.data(), text.size(), &address, 1);
+}
+
+void IFR_OutBuffer::line(const string &text){
+  record(OutText, text.data(), text.size(), 0, 0);
+}
+
+void IFR_OutBuffer::text(const char *fmt, ...){
+
+  char small[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(small, sizeof(small), fmt, ap);
+  va_end(ap);
+  if( n < 0 ){ return; }
+  if( (size_t)n < sizeof(small) ){
+    record(OutText, small, n, 0, 0);
+    return;
+  }
+
+  vector<char> big(n + 1);
+  va_start(ap, fmt);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  va_end(ap);
+  record(OutText, &big[0], n, 0, 0);
+
+}
+
+static bool getVarint(const unsigned char *&p, const unsigned char *end, UINT64 &v){
+
+  v = 0;
+  for( unsigned shift = 0; shift < 64; shift += 7 ){
+    if( p == end ){ return false; }
+    unsigned char b = *p++;
+    v |= (UINT64)(b & 0x7f) << shift;
+    if( (b & 0x80) == 0 ){ return true; }
+  }
+  return false;
+
+}
+
+static void printList(FILE *out, const char *title, const vector<ADDRINT> &a){
+  fprintf(out, "%s %p:\n\t", title, (void *)a[0]);
+  for( unsigned i = 1; i < a.size(); i++ ){
+    fprintf(out, "%p ", (void *)a[i]);
+  }
+  fprintf(out, "\n");
+}
+
+/*The layout the knobs always printed*/
+static bool printText(FILE *out, unsigned kind, const string &text, const vector<ADDRINT> &a){
+
+  switch( kind ){
+    case OutRoutine:
+      fprintf(out, ">>>>>>>>>>>>>>%s<<<<<<<<<<<<<<<\n", text.c_str());
+      return true;
+    case OutPreds:
+      if( a.empty() ){ return false; }
+      printList(out, "Predecessors to", a);
+      return true;
+    case OutDoms:
+      if( a.empty() ){ return false; }
+      printList(out, "Dominators of", a);
+      return true;
+    case OutIDom:
+      if( a.size() != 2 ){ return false; }
+      fprintf(out, "IDom of %p: %p\n", (void *)a[0], (void *)a[1]);
+      return true;
+    case OutDF:
+      if( a.empty() ){ return false; }
+      printList(out, "DF of", a);
+      return true;
+    case OutBlock:
+      if( a.size() != 3 ){ return false; }
+      fprintf(out, "E:%p T:%p F:%p\n", (void *)a[0], (void *)a[1], (void *)a[2]);
+      return true;
+    case OutIns:
+      if( a.size() != 1 ){ return false; }
+      fprintf(out, "%p %s\n", (void *)a[0], text.c_str());
+      return true;
+    case OutText:
+      fprintf(out, "%s\n", text.c_str());
+      return true;
+  }
+  return false;
+
+}
+
+static void printJSONString(FILE *out, const string &s){
+
+  fputc('"', out);
+  for( unsigned i = 0; i < s.size(); i++ ){
+    unsigned char c = s[i];
+    if( c == '"' || c == '\\' ){
+      fputc('\\', out);
+      fputc(c, out);
+    }else if( c < 0x20 ){
+      fprintf(out, "\\u%04x", c);
+    }else{
+      fputc(c, out);
+    }
+  }
+  fputc('"', out);
+
+}
+
+static void printJSON(FILE *out, unsigned kind, const string &text, const vector<ADDRINT> &a){
+
+  fprintf(out, "{\"kind\":\"%s\"", kindNames[kind]);
+  if( !text.empty() || kind == OutText ){
+    fprintf(out, ",\"text\":");
+    printJSONString(out, text);
+  }
+  if( !a.empty() ){
+    fprintf(out, ",\"addrs\":[");
+    for( unsigned i = 0; i < a.size(); i++ ){
+      fprintf(out, i ? ",%llu" : "%llu", (unsigned long long)a[i]);
+    }
+    fprintf(out, "]");
+  }
+  fprintf(out, "}\n");
+
+}
+
+bool IFR_WriteRecords(FILE *out, IFR_OutFormat format, const unsigned char *bytes, size_t size,
+                      unsigned &records){
+
+  records = 0;
+  if( format == OutFormatBinary ){
+    return fwrite(bytes, 1, size, out) == size;
+  }
+
+  const unsigned char *p = bytes;
+  const unsigned char *end = bytes + size;
+  string text;
+  vector<ADDRINT> addrs;
+  while( p != end ){
+
+    unsigned kind = *p++;
+    UINT64 length, n;
+    if( kind == 0 || kind >= OutNumKinds || !getVarint(p, end, length) || length > (UINT64)(end - p) ){
+      return false;
+    }
+    text.assign((const char *)p, length);
+    p += length;
+    if( !getVarint(p, end, n) || n > (UINT64)(end - p) ){ return false; }
+    addrs.resize(n);
+    for( unsigned i = 0; i < n; i++ ){
+      UINT64 v;
+      if( !getVarint(p, end, v) ){ return false; }
+      addrs[i] = (ADDRINT)v;
+    }
+
+    if( format == OutFormatJSON ){
+      printJSON(out, kind, text, addrs);
+    }else if( !printText(out, kind, text, addrs) ){
+      return false;
+    }
+    records++;
+
+  }
+  return true;
+
+}
+
+IFR_OutputWriter::IFR_OutputWriter(){
+  file = 0;
+  ownFile = false;
+  format = OutFormatText;
+  background = false;
+  stopping = false;
+  bytesIn = 0;
+  bytesOut = 0;
+  records = 0;
+  writeTime = 0;
+  failed = false;
+}
+
+IFR_OutputWriter::~IFR_OutputWriter(){
+  close();
+}
+
+bool IFR_OutputWriter::open(const string &path, IFR_OutFormat f, bool useThread){
+
+  close();
+  format = f;
+  if( path.empty() ){
+    file = stderr;
+    ownFile = false;
+  }else{
+    file = fopen(path.c_str(), f == OutFormatBinary ? "wb" : "w");
+    if( file == 0 ){ return false; }
+    ownFile = true;
+  }
+  /*Only the writer uses the file, so it can be fully buffered; stderr
+   *has been written already and stays as it is
+   */
+  if( ownFile ){ setvbuf(file, 0, _IOFBF, 1 << 16); }
+
+  if( format == OutFormatBinary ){
+    UINT32 header[2] = { IFR_OUT_MAGIC, IFR_OUT_VERSION };
+    fwrite(header, sizeof(header), 1, file);
+    bytesOut += sizeof(header);
+  }
+
+  IFR_MutexInit(&lock);
+  IFR_EventInit(&ready);
+  stopping = false;
+  background = useThread && IFR_SpawnThread(writerMain, this, &thread);
+  return true;
+
+}
+
+void IFR_OutputWriter::write(IFR_OutBuffer *b){
+
+  double start = IFR_Clock();
+  long before = ftell(file);
+  unsigned n;
+  if( !IFR_WriteRecords(file, format, b->bytes.empty() ? 0 : &b->bytes[0], b->bytes.size(), n) ){
+    failed = true;
+  }
+  long after = ftell(file);
+  if( before >= 0 && after >= before ){ bytesOut += after - before; }
+  records += b->records;
+  delete b;
+  writeTime += IFR_Clock() - start;
+
+}
+
+void IFR_OutputWriter::writerMain(void *arg){
+
+  IFR_OutputWriter *w = (IFR_OutputWriter *)arg;
+  vector<IFR_OutBuffer *> work;
+  while( true ){
+
+    IFR_EventWait(&w->ready);
+    IFR_EventClear(&w->ready);
+    IFR_MutexLock(&w->lock);
+    work.swap(w->queue);
+    bool stop = w->stopping;
+    IFR_MutexUnlock(&w->lock);
+
+    for( unsigned i = 0; i < work.size(); i++ ){
+      w->write(work[i]);
+    }
+    work.clear();
+    if( stop ){ return; }
+
+  }
+
+}
+
+void IFR_OutputWriter::submit(IFR_OutBuffer *b){
+
+  if( file == 0 ){
+    delete b;
+    return;
+  }
+  bytesIn += b->bytes.size();
+  if( !background ){
+    write(b);
+    return;
+  }
+  IFR_MutexLock(&lock);
+  queue.push_back(b);
+  IFR_MutexUnlock(&lock);
+  IFR_EventSet(&ready);
+
+}
+
+void IFR_OutputWriter::close(){
+
+  if( file == 0 ){ return; }
+
+  if( background ){
+    IFR_MutexLock(&lock);
+    stopping = true;
+    IFR_MutexUnlock(&lock);
+    IFR_EventSet(&ready);
+    IFR_JoinThread(thread);
+    background = false;
+  }
+  IFR_EventFini(&ready);
+  IFR_MutexFini(&lock);
+
+  fflush(file);
+  if( ownFile ){ fclose(file); }
+  file = 0;
+
+}
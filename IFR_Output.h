@@ -0,0 +1,123 @@
+#ifndef _IFR_OUTPUT_H_
+#define _IFR_OUTPUT_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_Threads.h"
+
+/*Kinds of records in the tool's per-routine output*/
+enum IFR_OutKind {
+  OutRoutine = 1,     //text: name; addrs: entry
+  OutPreds = 2,       //addrs: block, its predecessors
+  OutDoms = 3,        //addrs: block, its dominators
+  OutIDom = 4,        //addrs: block, its immediate dominator (0 if none)
+  OutDF = 5,          //addrs: block, its dominance frontier
+  OutBlock = 6,       //addrs: entry, target, fallthrough
+  OutIns = 7,         //text: category and disassembly; addrs: address
+  OutText = 8,        //text: one preformatted line
+  OutNumKinds = 9
+};
+
+enum IFR_OutFormat {
+  OutFormatText = 0,  //what the knobs always printed
+  OutFormatBinary = 1,
+  OutFormatJSON = 2   //one object per line
+};
+
+#define IFR_OUT_MAGIC 0x4f524649    //"IFRO"
+#define IFR_OUT_VERSION 1
+
+/*Records of one routine, built by the thread reporting it.
+ *
+ *Records are always kept in the binary encoding, which is also the body
+ *of a binary output file (after an 8 byte header: magic, version):
+ *
+ *  u8 kind, varint textLength, text bytes, varint count, count varint addrs
+ *
+ *with unsigned LEB128 varints.  Formatting as text or JSON is left to
+ *the writer, off the thread that filled the buffer.
+ */
+class IFR_OutBuffer{
+
+  void putVarint(UINT64 v);
+
+public:
+
+  std::vector<unsigned char> bytes;
+  unsigned records;
+
+  IFR_OutBuffer();
+
+  void record(unsigned kind, const char *text, size_t textLength, const ADDRINT *addrs, unsigned n);
+  void record(unsigned kind, const ADDRINT *addrs, unsigned n);
+  void record(unsigned kind, ADDRINT a, ADDRINT b);
+  void routine(const std::string &name, ADDRINT entry);
+  void ins(ADDRINT address, const std::string &text);
+  void line(const std::string &text);
+
+  /*printf into an OutText record*/
+  void text(const char *fmt, ...);
+
+};
+
+/*Writes the records in bytes[0..size) to out in format.  Returns false if
+ *they are malformed; whatever came before is written.
+ */
+bool IFR_WriteRecords(FILE *out, IFR_OutFormat format, const unsigned char *bytes, size_t size,
+                      unsigned &records);
+
+/*Writes submitted buffers to one file, in submission order.
+ *
+ *With a background thread, submit() only queues the buffer and the
+ *thread formats and writes it; without one (or if it cannot start),
+ *submit() writes it on the calling thread.  In the Pin tool the thread is
+ *an internal thread, so close() has to run before the process exits
+ *(from a prepare-for-fini callback).
+ */
+class IFR_OutputWriter{
+
+  FILE *file;
+  bool ownFile;
+  IFR_OutFormat format;
+
+  IFR_Mutex lock;
+  IFR_Event ready;
+  std::vector<IFR_OutBuffer *> queue;
+  IFR_Thread thread;
+  bool background;
+  volatile bool stopping;
+
+  void write(IFR_OutBuffer *b);
+  static void writerMain(void *arg);
+
+  IFR_OutputWriter(const IFR_OutputWriter &);
+  IFR_OutputWriter &operator=(const IFR_OutputWriter &);
+
+public:
+
+  UINT64 bytesIn;           //encoded bytes submitted
+  UINT64 bytesOut;          //bytes written to the file
+  unsigned records;
+  double writeTime;         //spent formatting and writing, on whichever thread
+  bool failed;
+
+  IFR_OutputWriter();
+  ~IFR_OutputWriter();
+
+  /*path "" is stderr.  Returns false if the file cannot be opened.*/
+  bool open(const std::string &path, IFR_OutFormat f, bool useThread);
+
+  /*Takes ownership of b*/
+  void submit(IFR_OutBuffer *b);
+
+  /*Writes everything queued, stops the thread and closes the file*/
+  void close();
+
+  bool isOpen() const { return file != 0; }
+  bool threaded() const { return background; }
+
+};
+
+#endif
@@ -0,0 +1,430 @@
+#include <math.h>
+#include <algorithm>
+#include <utility>
+
+#include "IFR_PathProfile.h"
+
+using std::vector;
+using std::pair;
+
+static const unsigned NoEdge = (unsigned)-1;
+
+IFR_PathProfile::IFR_PathProfile(){
+  clear();
+}
+
+void IFR_PathProfile::clear(){
+
+  edges.clear();
+  outStart.clear();
+  outEdges.clear();
+  probes.clear();
+  numNodes = 0;
+  status = PathsProfiled;
+  numPaths = 0;
+  numBlocks = 0;
+  numChords = 0;
+  numAdds = 0;
+
+}
+
+void IFR_PathProfile::drop(){
+  clear();
+  status = PathsUnplaceable;
+}
+
+static void addEdge(vector<IFR_PathEdge> &edges, vector<double> &weights, unsigned from, unsigned to,
+                    IFR_PathEdgeKind kind, double weight){
+  IFR_PathEdge e;
+  e.from = from;
+  e.to = to;
+  e.kind = kind;
+  e.val = 0;
+  edges.push_back(e);
+  weights.push_back(weight);
+}
+
+static unsigned root(vector<unsigned> &uf, unsigned x){
+  while( uf[x] != x ){
+    uf[x] = uf[ uf[x] ];
+    x = uf[x];
+  }
+  return x;
+}
+
+static bool heavier(const pair<double, unsigned> &a, const pair<double, unsigned> &b){
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+static bool probeBefore(const IFR_PathProbe &a, const IFR_PathProbe &b){
+  return a.ins < b.ins;
+}
+
+/*One way out of the routine from a block, and where its probe goes*/
+class IFR_PathLeave{
+
+public:
+
+  unsigned edge;
+  unsigned ins;
+  IFR_ProbePoint point;
+
+};
+
+/*How many ways control leaves the routine from instruction i*/
+static unsigned exitsOf(const IFR_RoutineCode &code, unsigned i){
+  const IFR_InsRecord &r = code.ins[i];
+  if( r.kind == InsReturn || (r.kind == InsIndirectJump && !code.resolved(i)) ){ return 1; }
+  return (code.leavesTaken(i) ? 1 : 0) + (code.leavesFall(i) ? 1 : 0);
+}
+
+/*The ways out of the routine from block u: before a return or unresolved
+ *indirect jump, on each side of its last instruction that goes outside,
+ *or before that instruction if it is its only way out.  A block that
+ *leaves only by having no successors leaves before its last instruction.
+ *False if u is empty.
+ */
+static bool findLeaves(const IFR_RoutineCode &code, const IFR_CFG &cfg, unsigned u, vector<IFR_PathLeave> &out){
+
+  out.clear();
+  if( !code.leavesBlock(cfg, u) ){ return true; }
+  if( cfg.insEnd(u) == cfg.insBegin(u) ){ return false; }
+  unsigned last = cfg.insEnd(u) - 1;
+  IFR_PathLeave l;
+  l.edge = 0;
+  for( unsigned i = cfg.insBegin(u); i <= last; i++ ){
+    l.ins = i;
+    unsigned exits = exitsOf(code, i);
+    if( exits == 0 ){ continue; }
+    if( code.ins[i].kind != InsCondJump || exits + cfg.numSuccs(u) == 1 ){
+      l.point = ProbeBefore;
+      out.push_back(l);
+      continue;
+    }
+    if( code.leavesTaken(i) ){
+      l.point = ProbeTaken;
+      out.push_back(l);
+    }
+    if( code.leavesFall(i) ){
+      l.point = ProbeFall;
+      out.push_back(l);
+    }
+  }
+  if( out.empty() ){
+    l.ins = last;
+    l.point = ProbeBefore;
+    out.push_back(l);
+  }
+  return true;
+
+}
+
+/*The probe point of the edge from u to block v: before u's last
+ *instruction if that is its only way out, else on its branch taken or
+ *fall through, or before a jump table with the target to look for
+ */
+bool IFR_PathProfile::place(const IFR_RoutineCode &code, const IFR_CFG &cfg, unsigned u, unsigned v,
+                            IFR_PathProbe &p) const{
+
+  if( cfg.insEnd(u) == cfg.insBegin(u) ){ return false; }
+  unsigned last = cfg.insEnd(u) - 1;
+  const IFR_InsRecord &r = code.ins[last];
+  p.ins = last;
+  p.point = ProbeBefore;
+  p.target = 0;
+  if( cfg.numSuccs(u) + exitsOf(code, last) == 1 ){ return true; }
+  if( r.kind == InsCondJump ){
+    p.point = cfg.entry(v) == r.target ? ProbeTaken : ProbeFall;
+    return true;
+  }
+  if( r.kind == InsIndirectJump ){
+    p.target = cfg.entry(v);
+    return true;
+  }
+  return false;
+
+}
+
+void IFR_PathProfile::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_LoopForest &loops){
+
+  clear();
+  unsigned n = cfg.size();
+  if( n == 0 ){
+    status = PathsUnplaceable;
+    return;
+  }
+
+  /*Back edges, by their position among all CFG edges*/
+  const unsigned *first = cfg.succBegin(0);
+  vector<unsigned char> back(cfg.numEdges(), 0);
+  for( unsigned l = 0; l < loops.size(); l++ ){
+    unsigned h = loops.loop(l).header;
+    if( h == 0 ){
+      status = PathsEntryLoop;
+      return;
+    }
+    for( const unsigned *u = loops.latchBegin(l); u != loops.latchEnd(l); u++ ){
+      for( const unsigned *s = cfg.succBegin(*u); s != cfg.succEnd(*u); s++ ){
+        if( *s == h ){ back[s - first] = 1; }
+      }
+    }
+  }
+
+  vector<unsigned char> reached(n, 0);
+  vector<unsigned> work(1, 0);
+  reached[0] = 1;
+  while( !work.empty() ){
+    unsigned u = work.back();
+    work.pop_back();
+    for( const unsigned *s = cfg.succBegin(u); s != cfg.succEnd(u); s++ ){
+      if( !reached[*s] ){
+        reached[*s] = 1;
+        work.push_back(*s);
+      }
+    }
+  }
+
+  /*The acyclic graph; a back edge's two dummies are adjacent, out first.
+   *Each block's weight is split evenly among its ways out.
+   */
+  unsigned exit = n;
+  numNodes = n + 1;
+  vector<double> weights;
+  vector<unsigned> dagOf(cfg.numEdges(), NoEdge);
+  vector<IFR_PathLeave> leaves, blockLeaves;
+  vector<unsigned> leaveStart(n + 1, 0);
+  for( unsigned u = 0; u < n; u++ ){
+
+    leaveStart[u] = leaves.size();
+    if( !reached[u] ){ continue; }
+    numBlocks++;
+    if( !findLeaves(code, cfg, u, blockLeaves) ){
+      drop();
+      return;
+    }
+    unsigned l = loops.innermost(u);
+    unsigned depth = l == IFR_LoopForest::NoLoop ? 0 : std::min(loops.loop(l).depth, (unsigned)IFR_PATH_MAX_DEPTH);
+    double w = pow(IFR_PATH_LOOP_WEIGHT, (double)depth) / (cfg.numSuccs(u) + blockLeaves.size());
+
+    for( const unsigned *s = cfg.succBegin(u); s != cfg.succEnd(u); s++ ){
+      dagOf[s - first] = edges.size();
+      if( back[s - first] ){
+        addEdge(edges, weights, u, exit, PathEdgeBackOut, w);
+        addEdge(edges, weights, 0, *s, PathEdgeBackIn, w);
+      }else{
+        addEdge(edges, weights, u, *s, PathEdgeNormal, w);
+      }
+    }
+    for( unsigned k = 0; k < blockLeaves.size(); k++ ){
+      blockLeaves[k].edge = edges.size();
+      leaves.push_back(blockLeaves[k]);
+      addEdge(edges, weights, u, exit, PathEdgeLeave, w);
+    }
+
+  }
+  leaveStart[n] = leaves.size();
+
+  outStart.assign(numNodes + 1, 0);
+  for( unsigned e = 0; e < edges.size(); e++ ){ outStart[ edges[e].from + 1 ]++; }
+  for( unsigned v = 0; v < numNodes; v++ ){ outStart[v + 1] += outStart[v]; }
+  outEdges.resize(edges.size());
+  vector<unsigned> fill(outStart.begin(), outStart.end() - 1);
+  for( unsigned e = 0; e < edges.size(); e++ ){ outEdges[ fill[ edges[e].from ]++ ] = e; }
+
+  /*Numbering in postorder, so every successor's path count is known*/
+  vector<UINT64> paths(numNodes, 0);
+  vector<unsigned char> visited(numNodes, 0);
+  vector< pair<unsigned, unsigned> > stack(1, std::make_pair(0u, outStart[0]));
+  visited[0] = 1;
+  while( !stack.empty() ){
+
+    unsigned v = stack.back().first;
+    unsigned &i = stack.back().second;
+    if( i < outStart[v + 1] ){
+      unsigned w = edges[ outEdges[i++] ].to;
+      if( !visited[w] ){
+        visited[w] = 1;
+        stack.push_back( std::make_pair(w, outStart[w]) );
+      }
+      continue;
+    }
+    stack.pop_back();
+
+    if( v == exit ){
+      paths[v] = 1;
+      continue;
+    }
+    UINT64 np = 0;
+    for( unsigned k = outStart[v]; k < outStart[v + 1]; k++ ){
+      IFR_PathEdge &e = edges[ outEdges[k] ];
+      e.val = np;
+      np += paths[e.to];
+      if( np > IFR_MAX_PATHS ){
+        clear();
+        status = PathsOverflow;
+        return;
+      }
+    }
+    paths[v] = np;
+
+  }
+  numPaths = paths[0];
+
+  /*Kruskal, heaviest first, with exit->entry already in the tree*/
+  vector< pair<double, unsigned> > order(edges.size());
+  for( unsigned e = 0; e < edges.size(); e++ ){ order[e] = std::make_pair(weights[e], e); }
+  std::sort(order.begin(), order.end(), heavier);
+  vector<unsigned> uf(numNodes);
+  for( unsigned v = 0; v < numNodes; v++ ){ uf[v] = v; }
+  uf[exit] = 0;
+  vector<unsigned char> tree(edges.size(), 0);
+  for( unsigned k = 0; k < order.size(); k++ ){
+    unsigned e = order[k].second;
+    unsigned a = root(uf, edges[e].from), b = root(uf, edges[e].to);
+    if( a == b ){
+      numChords++;
+      continue;
+    }
+    uf[a] = b;
+    tree[e] = 1;
+  }
+
+  /*Potentials: every tree edge's value is the difference across it*/
+  vector<unsigned> adjStart(numNodes + 1, 0);
+  for( unsigned e = 0; e < edges.size(); e++ ){
+    if( !tree[e] ){ continue; }
+    adjStart[ edges[e].from + 1 ]++;
+    adjStart[ edges[e].to + 1 ]++;
+  }
+  for( unsigned v = 0; v < numNodes; v++ ){ adjStart[v + 1] += adjStart[v]; }
+  vector<unsigned> adj(adjStart[numNodes]);
+  fill.assign(adjStart.begin(), adjStart.end() - 1);
+  for( unsigned e = 0; e < edges.size(); e++ ){
+    if( !tree[e] ){ continue; }
+    adj[ fill[ edges[e].from ]++ ] = e;
+    adj[ fill[ edges[e].to ]++ ] = e;
+  }
+
+  vector<UINT64> phi(numNodes, 0);
+  visited.assign(numNodes, 0);
+  visited[0] = visited[exit] = 1;
+  work.assign(1, 0);
+  work.push_back(exit);
+  while( !work.empty() ){
+    unsigned v = work.back();
+    work.pop_back();
+    for( unsigned k = adjStart[v]; k < adjStart[v + 1]; k++ ){
+      const IFR_PathEdge &e = edges[ adj[k] ];
+      unsigned w = e.from == v ? e.to : e.from;
+      if( visited[w] ){ continue; }
+      visited[w] = 1;
+      phi[w] = e.from == v ? phi[v] + e.val : phi[v] - e.val;
+      work.push_back(w);
+    }
+  }
+
+  /*Increments telescope: on a path from entry to exit the potentials
+   *cancel, leaving the sum of the values
+   */
+  vector<UINT64> inc(edges.size(), 0);
+  for( unsigned e = 0; e < edges.size(); e++ ){
+    if( !tree[e] ){ inc[e] = edges[e].val + phi[ edges[e].from ] - phi[ edges[e].to ]; }
+  }
+
+  if( cfg.insEnd(0) == cfg.insBegin(0) ){
+    drop();
+    return;
+  }
+  IFR_PathProbe p;
+  p.kind = ProbeEnter;
+  p.inc = p.reset = 0;
+  p.ins = cfg.insBegin(0);
+  p.point = ProbeBefore;
+  p.target = 0;
+  probes.push_back(p);
+
+  for( unsigned u = 0; u < n; u++ ){
+
+    if( !reached[u] ){ continue; }
+    for( const unsigned *s = cfg.succBegin(u); s != cfg.succEnd(u); s++ ){
+      unsigned e = dagOf[s - first];
+      if( edges[e].kind == PathEdgeBackOut ){
+        p.kind = ProbeRestart;
+        p.inc = inc[e];
+        p.reset = inc[e + 1];
+      }else if( inc[e] != 0 ){
+        p.kind = ProbeAdd;
+        p.inc = inc[e];
+        p.reset = 0;
+        numAdds++;
+      }else{
+        continue;
+      }
+      if( !place(code, cfg, u, *s, p) ){
+        drop();
+        return;
+      }
+      probes.push_back(p);
+    }
+
+    for( unsigned k = leaveStart[u]; k < leaveStart[u + 1]; k++ ){
+      p.kind = ProbeEnd;
+      p.inc = inc[ leaves[k].edge ];
+      p.reset = 0;
+      p.ins = leaves[k].ins;
+      p.point = leaves[k].point;
+      p.target = 0;
+      probes.push_back(p);
+    }
+
+  }
+  std::stable_sort(probes.begin(), probes.end(), probeBefore);
+
+}
+
+unsigned IFR_PathProfile::probeBegin(unsigned ins) const{
+
+  IFR_PathProbe key;
+  key.ins = ins;
+  return std::lower_bound(probes.begin(), probes.end(), key, probeBefore) - probes.begin();
+
+}
+
+unsigned IFR_PathProfile::probeEnd(unsigned ins) const{
+
+  IFR_PathProbe key;
+  key.ins = ins;
+  return std::upper_bound(probes.begin(), probes.end(), key, probeBefore) - probes.begin();
+
+}
+
+/*From the entry, the out edge with the largest value not above what is
+ *left of id, as in Ball and Larus's regeneration
+ */
+unsigned IFR_PathProfile::path(UINT64 id, vector<unsigned> &blocks) const{
+
+  blocks.clear();
+  if( id >= numPaths ){ return 0; }
+  unsigned flags = 0, v = 0, exit = size();
+  while( v != exit ){
+    unsigned best = outEdges[ outStart[v] ];
+    for( unsigned k = outStart[v] + 1; k < outStart[v + 1] && edges[ outEdges[k] ].val <= id; k++ ){
+      best = outEdges[k];
+    }
+    const IFR_PathEdge &e = edges[best];
+    if( e.kind == PathEdgeBackIn ){
+      flags |= IFR_PATH_FROM_LOOP;
+    }else{
+      blocks.push_back(v);
+    }
+    if( e.kind == PathEdgeBackOut ){ flags |= IFR_PATH_TO_LOOP; }
+    id -= e.val;
+    v = e.to;
+  }
+  return flags;
+
+}
+
+size_t IFR_PathProfile::bytes() const{
+  return IFR_Bytes(edges) + IFR_Bytes(outStart) + IFR_Bytes(outEdges) + IFR_Bytes(probes);
+}
@@ -0,0 +1,139 @@
+#ifndef _IFR_PATHPROFILE_H_
+#define _IFR_PATHPROFILE_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_CFG.h"
+#include "IFR_Loops.h"
+
+/*Routines with more acyclic paths than this are not profiled*/
+#define IFR_MAX_PATHS ((UINT64)1 << 40)
+
+/*Static frequency estimate: each loop level multiplies a block's weight
+ *by this, up to IFR_PATH_MAX_DEPTH levels
+ */
+#define IFR_PATH_LOOP_WEIGHT 8.0
+#define IFR_PATH_MAX_DEPTH 8
+
+enum IFR_PathStatus { PathsProfiled = 0, PathsEntryLoop = 1, PathsOverflow = 2, PathsUnplaceable = 3 };
+
+/*What a probe does to the executing routine's path register r:
+ *
+ *  enter    r = 0, on entry to the routine
+ *  add      r += inc
+ *  end      count path r + inc, on leaving the routine
+ *  restart  count path r + inc, then r = reset, on a loop back edge
+ *
+ *All arithmetic is modulo 2^64; increments may be "negative".
+ */
+enum IFR_ProbeKind { ProbeEnter = 0, ProbeAdd = 1, ProbeEnd = 2, ProbeRestart = 3 };
+
+/*Where on its instruction a probe goes: before it, on its branch taken,
+ *or on its fall through
+ */
+enum IFR_ProbePoint { ProbeBefore = 0, ProbeTaken = 1, ProbeFall = 2 };
+
+class IFR_PathProbe{
+
+public:
+
+  unsigned ins;
+  IFR_ProbePoint point;
+  IFR_ProbeKind kind;
+  ADDRINT target;     //ProbeBefore on a jump table: only when it goes here; else 0
+  UINT64 inc;
+  UINT64 reset;
+
+};
+
+enum IFR_PathEdgeKind { PathEdgeNormal = 0, PathEdgeLeave = 1, PathEdgeBackOut = 2, PathEdgeBackIn = 3 };
+
+/*An edge of the acyclic graph paths are numbered over; to is a block or
+ *the virtual exit, IFR_PathProfile::size()
+ */
+class IFR_PathEdge{
+
+public:
+
+  unsigned from;
+  unsigned to;
+  IFR_PathEdgeKind kind;
+  UINT64 val;
+
+};
+
+/*Path flags*/
+#define IFR_PATH_FROM_LOOP 0x1    //starts at a loop header, after a back edge
+#define IFR_PATH_TO_LOOP   0x2    //ends on a back edge
+
+/*Ball-Larus path profiling ("Efficient Path Profiling", MICRO 1996).
+ *
+ *Each back edge u->h the loop forest found is replaced by two dummy edges,
+ *u->exit and entry->h, and every block that can leave the routine (see
+ *IFR_RoutineCode::leavesBlock) gets an edge to a virtual exit.  That
+ *leaves an acyclic graph whose entry-to-exit paths are numbered
+ *0..numPaths-1: visiting blocks sinks first, each out edge of v is given
+ *the number of paths through the edges before it, so the values along
+ *any path sum to its number.
+ *
+ *Only the chords of a spanning tree of that graph (plus an edge exit->
+ *entry) need code.  The tree is a maximum spanning tree over a static
+ *frequency estimate, edges weighted by their source's loop depth and
+ *split evenly among its out edges, so the hot edges are the free ones.
+ *Each chord's increment is its value plus the difference of the
+ *potentials the tree edges fix at its ends, which makes the increments
+ *along any path sum to the same number as the values.  Back edges and
+ *exits always count a path; other edges get a probe only when they are
+ *chords with a nonzero increment.
+ *
+ *Not profiled: routines whose entry block heads a loop (the entry probe
+ *could not tell a call from an iteration), routines with more than
+ *IFR_MAX_PATHS paths, and routines with an edge no probe point tells
+ *apart from the block's other edges.
+ */
+class IFR_PathProfile{
+
+  std::vector<IFR_PathEdge> edges;
+  std::vector<unsigned> outStart;   //out edges of v are edges[outEdges[outStart[v]..outStart[v+1])],
+  std::vector<unsigned> outEdges;   //by increasing val
+  unsigned numNodes;                //blocks plus the exit
+
+  void clear();
+  bool place(const IFR_RoutineCode &code, const IFR_CFG &cfg, unsigned u, unsigned v, IFR_PathProbe &p) const;
+
+public:
+
+  IFR_PathStatus status;
+  UINT64 numPaths;
+  unsigned numBlocks;       //reachable blocks, the probes per-block counting needs
+  unsigned numChords;
+  unsigned numAdds;
+
+  std::vector<IFR_PathProbe> probes;   //sorted by ins, the entry probe first
+
+  IFR_PathProfile();
+
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_LoopForest &loops);
+
+  /*Stops profiling the routine, e.g. when the front end cannot put one of
+   *its probes where it should go
+   */
+  void drop();
+
+  size_t bytes() const;
+
+  bool profiled() const { return status == PathsProfiled; }
+  unsigned size() const { return numNodes == 0 ? 0 : numNodes - 1; }
+
+  /*Probes placed on instruction ins are probes[probeBegin(ins)..probeEnd(ins))*/
+  unsigned probeBegin(unsigned ins) const;
+  unsigned probeEnd(unsigned ins) const;
+
+  /*The blocks of path id in order, and its IFR_PATH_ flags; no blocks if
+   *there is no such path
+   */
+  unsigned path(UINT64 id, std::vector<unsigned> &blocks) const;
+
+};
+
+#endif
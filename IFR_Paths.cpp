@@ -0,0 +1,425 @@
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+
+#include "IFR_Paths.h"
+
+using std::map;
+using std::pair;
+using std::vector;
+using std::string;
+
+/*Routines with at most this many paths count into an array, the rest
+ *into a map
+ */
+#define IFR_PATHS_DENSE 4096
+
+/*Blocks of a path printed before eliding the rest*/
+#define IFR_PATHS_PRINT_BLOCKS 12
+
+class IFR_PathRoutine{
+
+public:
+
+  unsigned id;
+  string name;
+  ADDRINT address;
+  const IFR_Analysis *a;
+
+};
+
+class IFR_PathFrame{
+
+public:
+
+  ADDRINT sp;
+  const IFR_PathRoutine *routine;
+  UINT64 reg;
+
+};
+
+class IFR_PathCounts{
+
+public:
+
+  vector<UINT64> dense;
+  map<UINT64, UINT64> sparse;
+
+};
+
+class IFR_ThreadPaths{
+
+public:
+
+  vector<IFR_PathFrame> frames;
+  vector<IFR_PathCounts *> counts;    //by routine id, made on its first path
+  vector<UINT64> blocks;              //by global block id, when counting blocks
+  UINT64 probes;
+  UINT64 lost;        //probes with no frame of their routine
+  UINT64 unwound;     //frames popped without their routine's exit
+
+  IFR_ThreadPaths(){
+    probes = lost = unwound = 0;
+  }
+
+};
+
+static TLS_KEY pathKey;
+static PIN_LOCK pathLock;
+static vector<IFR_ThreadPaths *> allThreads;
+static unsigned topN = 10;
+static bool countBlocks = false;
+
+/*Routines seen at instrumentation, which Pin serializes*/
+static map<const IFR_Analysis *, IFR_PathRoutine *> registry;
+static vector<IFR_PathRoutine *> routines;
+static unsigned byStatus[PathsUnplaceable + 1];
+static UINT64 probeSites = 0;
+static UINT64 routineBlocks = 0;    //blocks per-block counting instruments, or would in the routines profiled
+
+static inline IFR_ThreadPaths *threadPaths(THREADID tid){
+  return (IFR_ThreadPaths *)PIN_GetThreadData(pathKey, tid);
+}
+
+static void countPath(IFR_ThreadPaths *t, const IFR_PathRoutine *r, UINT64 id){
+
+  const IFR_PathProfile &p = r->a->paths;
+  if( id >= p.numPaths ){
+    t->lost++;
+    return;
+  }
+  if( r->id >= t->counts.size() ){ t->counts.resize(r->id + 1, 0); }
+  IFR_PathCounts *&c = t->counts[r->id];
+  if( c == 0 ){
+    c = new IFR_PathCounts();
+    if( p.numPaths <= IFR_PATHS_DENSE ){ c->dense.assign(p.numPaths, 0); }
+  }
+  if( !c->dense.empty() ){
+    c->dense[id]++;
+  }else{
+    c->sparse[id]++;
+  }
+
+}
+
+/*The nearest frame of r below the top: the frames above it belong to
+ *routines that left without running an exit probe
+ */
+static IFR_PathFrame *unwind(IFR_ThreadPaths *t, const IFR_PathRoutine *r){
+
+  for( unsigned i = t->frames.size(); i > 0; i-- ){
+    if( t->frames[i - 1].routine == r ){
+      t->unwound += t->frames.size() - i;
+      t->frames.resize(i);
+      return &t->frames.back();
+    }
+  }
+  t->lost++;
+  return 0;
+
+}
+
+static inline IFR_PathFrame *frameOf(IFR_ThreadPaths *t, const IFR_PathRoutine *r){
+  if( !t->frames.empty() && t->frames.back().routine == r ){ return &t->frames.back(); }
+  return unwind(t, r);
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL pathEnter(THREADID tid, ADDRINT sp, const IFR_PathRoutine *r){
+
+  IFR_ThreadPaths *t = threadPaths(tid);
+  if( t == 0 ){ return; }
+  t->probes++;
+  while( !t->frames.empty() && t->frames.back().sp <= sp ){
+    t->frames.pop_back();
+    t->unwound++;
+  }
+  IFR_PathFrame f;
+  f.sp = sp;
+  f.routine = r;
+  f.reg = 0;
+  t->frames.push_back(f);
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL pathAdd(THREADID tid, const IFR_PathRoutine *r, const IFR_PathProbe *p){
+
+  IFR_ThreadPaths *t = threadPaths(tid);
+  if( t == 0 ){ return; }
+  t->probes++;
+  IFR_PathFrame *f = frameOf(t, r);
+  if( f != 0 ){ f->reg += p->inc; }
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL pathEnd(THREADID tid, const IFR_PathRoutine *r, const IFR_PathProbe *p){
+
+  IFR_ThreadPaths *t = threadPaths(tid);
+  if( t == 0 ){ return; }
+  t->probes++;
+  IFR_PathFrame *f = frameOf(t, r);
+  if( f == 0 ){ return; }
+  countPath(t, r, f->reg + p->inc);
+  t->frames.pop_back();
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL pathRestart(THREADID tid, const IFR_PathRoutine *r, const IFR_PathProbe *p){
+
+  IFR_ThreadPaths *t = threadPaths(tid);
+  if( t == 0 ){ return; }
+  t->probes++;
+  IFR_PathFrame *f = frameOf(t, r);
+  if( f == 0 ){ return; }
+  countPath(t, r, f->reg + p->inc);
+  f->reg = p->reset;
+
+}
+
+static ADDRINT PIN_FAST_ANALYSIS_CALL goesTo(ADDRINT target, const IFR_PathProbe *p){
+  return target == p->target;
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL blockEvent(THREADID tid, UINT32 block){
+
+  IFR_ThreadPaths *t = threadPaths(tid);
+  if( t == 0 ){ return; }
+  t->probes++;
+  if( block >= t->blocks.size() ){ t->blocks.resize(block + 1 + block / 2, 0); }
+  t->blocks[block]++;
+
+}
+
+void IFR_PathsInit(unsigned top, bool blocks){
+  pathKey = PIN_CreateThreadDataKey(0);
+  PIN_InitLock(&pathLock);
+  topN = top;
+  countBlocks = blocks;
+  for( unsigned s = 0; s <= PathsUnplaceable; s++ ){ byStatus[s] = 0; }
+}
+
+void IFR_PathsThreadStart(THREADID tid){
+
+  IFR_ThreadPaths *t = new IFR_ThreadPaths();
+  PIN_SetThreadData(pathKey, t, tid);
+  PIN_GetLock(&pathLock, tid + 1);
+  allThreads.push_back(t);
+  PIN_ReleaseLock(&pathLock);
+
+}
+
+void IFR_PathsThreadFini(THREADID tid){
+  /*Counts stay in allThreads for Fini*/
+  PIN_SetThreadData(pathKey, 0, tid);
+}
+
+static IFR_PathRoutine *routineOf(INS ins, const IFR_Analysis &a){
+
+  map<const IFR_Analysis *, IFR_PathRoutine *>::iterator i = registry.find(&a);
+  if( i != registry.end() ){ return i->second; }
+
+  IFR_PathRoutine *r = new IFR_PathRoutine();
+  r->id = routines.size();
+  RTN rtn = INS_Rtn(ins);
+  r->name = RTN_Valid(rtn) ? RTN_Name(rtn) : "?";
+  r->address = RTN_Valid(rtn) ? RTN_Address(rtn) : INS_Address(ins);
+  r->a = &a;
+  registry[&a] = r;
+  routines.push_back(r);
+  if( countBlocks ){
+    routineBlocks += a.cfg.size();
+  }else{
+    byStatus[a.paths.status]++;
+    if( a.paths.profiled() ){
+      probeSites += a.paths.probes.size();
+      routineBlocks += a.paths.numBlocks;
+    }
+  }
+  return r;
+
+}
+
+static void insertProbe(INS ins, const IFR_PathRoutine *r, const IFR_PathProbe *p){
+
+  IPOINT where = IPOINT_BEFORE;
+  if( p->point == ProbeTaken ){ where = IPOINT_TAKEN_BRANCH; }
+  if( p->point == ProbeFall ){ where = IPOINT_AFTER; }
+
+  AFUNPTR f = (AFUNPTR)pathAdd;
+  if( p->kind == ProbeEnd ){ f = (AFUNPTR)pathEnd; }
+  if( p->kind == ProbeRestart ){ f = (AFUNPTR)pathRestart; }
+
+  /*A jump table's edges share the instruction; the target tells them apart*/
+  if( p->target != 0 ){
+    INS_InsertIfCall(ins, IPOINT_BEFORE, (AFUNPTR)goesTo, IARG_FAST_ANALYSIS_CALL,
+                     IARG_BRANCH_TARGET_ADDR, IARG_PTR, p, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_BEFORE, f, IARG_FAST_ANALYSIS_CALL,
+                       IARG_THREAD_ID, IARG_PTR, r, IARG_PTR, p, IARG_END);
+    return;
+  }
+  INS_InsertCall(ins, where, f, IARG_FAST_ANALYSIS_CALL,
+                 IARG_THREAD_ID, IARG_PTR, r, IARG_PTR, p, IARG_END);
+
+}
+
+void IFR_InstrumentPaths(INS ins, const IFR_Analysis &a, unsigned insNum, UINT32 blockBase){
+
+  IFR_PathRoutine *r = routineOf(ins, a);
+
+  if( countBlocks ){
+    unsigned b = a.cfg.blockOf(insNum);
+    if( a.cfg.insBegin(b) == insNum ){
+      INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)blockEvent, IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID, IARG_UINT32, blockBase + b, IARG_END);
+    }
+    return;
+  }
+
+  const IFR_PathProfile &p = a.paths;
+  if( !p.profiled() ){ return; }
+  for( unsigned k = p.probeBegin(insNum); k < p.probeEnd(insNum); k++ ){
+    const IFR_PathProbe *probe = &p.probes[k];
+    if( probe->kind == ProbeEnter ){
+      INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)pathEnter, IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID, IARG_REG_VALUE, REG_STACK_PTR, IARG_PTR, r, IARG_END);
+    }else{
+      insertProbe(ins, r, probe);
+    }
+  }
+
+}
+
+class IFR_RoutinePaths{
+
+public:
+
+  const IFR_PathRoutine *routine;
+  vector< pair<UINT64, UINT64> > paths;   //(runs, path), hottest first
+  UINT64 runs;
+  UINT64 blocks;
+
+};
+
+static bool hotterPath(const pair<UINT64, UINT64> &a, const pair<UINT64, UINT64> &b){
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+static bool hotterRoutine(const IFR_RoutinePaths &a, const IFR_RoutinePaths &b){
+  return a.blocks > b.blocks || (a.blocks == b.blocks && a.routine->id < b.routine->id);
+}
+
+static void printPath(FILE *out, const IFR_RoutinePaths &rp, UINT64 id, UINT64 runs){
+
+  const IFR_Analysis &a = *rp.routine->a;
+  vector<unsigned> blocks;
+  unsigned flags = a.paths.path(id, blocks);
+  fprintf(out,"IFR paths:   path %llu: %llu runs (%.1f%%), %u blocks:",
+          (unsigned long long)id, (unsigned long long)runs, 100.0 * runs / rp.runs, (unsigned)blocks.size());
+  if( flags & IFR_PATH_FROM_LOOP ){ fprintf(out," loop"); }
+  for( unsigned i = 0; i < blocks.size() && i < IFR_PATHS_PRINT_BLOCKS; i++ ){
+    fprintf(out," %p", (void *)a.cfg.entry(blocks[i]));
+  }
+  if( blocks.size() > IFR_PATHS_PRINT_BLOCKS ){ fprintf(out," ..."); }
+  fprintf(out,"%s\n", (flags & IFR_PATH_TO_LOOP) ? " back" : "");
+
+}
+
+static void printBlockStats(FILE *out, UINT64 probes){
+
+  UINT64 runs = 0;
+  unsigned ran = 0;
+  vector<UINT64> merged;
+  for( unsigned i = 0; i < allThreads.size(); i++ ){
+    const vector<UINT64> &b = allThreads[i]->blocks;
+    if( b.size() > merged.size() ){ merged.resize(b.size(), 0); }
+    for( unsigned k = 0; k < b.size(); k++ ){ merged[k] += b[k]; }
+  }
+  for( unsigned k = 0; k < merged.size(); k++ ){
+    runs += merged[k];
+    ran += merged[k] > 0;
+  }
+  fprintf(out,"IFR paths: per-block counting: %llu blocks in %u routines, %u of them ran\n",
+          (unsigned long long)routineBlocks, (unsigned)routines.size(), ran);
+  fprintf(out,"IFR paths: %llu probes for %llu blocks run (%.3f per block)\n",
+          (unsigned long long)probes, (unsigned long long)runs, runs > 0 ? (double)probes / runs : 0.0);
+
+}
+
+void IFR_PrintPathStats(FILE *out){
+
+  UINT64 probes = 0, lost = 0, unwound = 0;
+  for( unsigned i = 0; i < allThreads.size(); i++ ){
+    probes += allThreads[i]->probes;
+    lost += allThreads[i]->lost;
+    unwound += allThreads[i]->unwound;
+  }
+  if( countBlocks ){
+    printBlockStats(out, probes);
+    return;
+  }
+
+  /*Merge every thread's counts by routine*/
+  vector<IFR_RoutinePaths> hot;
+  UINT64 totalRuns = 0, totalBlocks = 0, distinct = 0;
+  for( unsigned r = 0; r < routines.size(); r++ ){
+    map<UINT64, UINT64> merged;
+    for( unsigned i = 0; i < allThreads.size(); i++ ){
+      if( r >= allThreads[i]->counts.size() || allThreads[i]->counts[r] == 0 ){ continue; }
+      const IFR_PathCounts &c = *allThreads[i]->counts[r];
+      for( UINT64 id = 0; id < c.dense.size(); id++ ){
+        if( c.dense[id] > 0 ){ merged[id] += c.dense[id]; }
+      }
+      for( map<UINT64, UINT64>::const_iterator p = c.sparse.begin(); p != c.sparse.end(); p++ ){
+        merged[p->first] += p->second;
+      }
+    }
+    if( merged.empty() ){ continue; }
+
+    IFR_RoutinePaths rp;
+    rp.routine = routines[r];
+    rp.runs = rp.blocks = 0;
+    vector<unsigned> blocks;
+    for( map<UINT64, UINT64>::const_iterator p = merged.begin(); p != merged.end(); p++ ){
+      rp.paths.push_back( std::make_pair(p->second, p->first) );
+      rp.runs += p->second;
+      routines[r]->a->paths.path(p->first, blocks);
+      rp.blocks += p->second * blocks.size();
+    }
+    std::sort(rp.paths.begin(), rp.paths.end(), hotterPath);
+    totalRuns += rp.runs;
+    totalBlocks += rp.blocks;
+    distinct += rp.paths.size();
+    hot.push_back(rp);
+  }
+  std::sort(hot.begin(), hot.end(), hotterRoutine);
+
+  unsigned profiled = byStatus[PathsProfiled];
+  fprintf(out,"IFR paths: %u of %u routines profiled (not: %u entered in a loop, %u with over %llu paths, %u unplaceable)\n",
+          profiled, (unsigned)routines.size(), byStatus[PathsEntryLoop], byStatus[PathsOverflow],
+          (unsigned long long)IFR_MAX_PATHS, byStatus[PathsUnplaceable]);
+  fprintf(out,"IFR paths: %llu probes placed where per-block counting would place %llu\n",
+          (unsigned long long)probeSites, (unsigned long long)routineBlocks);
+  fprintf(out,"IFR paths: %llu runs of %llu distinct paths in %u routines, covering %llu blocks\n",
+          (unsigned long long)totalRuns, (unsigned long long)distinct, (unsigned)hot.size(),
+          (unsigned long long)totalBlocks);
+  fprintf(out,"IFR paths: %llu probes for %llu blocks run (%.3f per block)",
+          (unsigned long long)probes, (unsigned long long)totalBlocks,
+          totalBlocks > 0 ? (double)probes / totalBlocks : 0.0);
+  if( lost > 0 || unwound > 0 ){
+    fprintf(out,", %llu probes lost, %llu frames unwound", (unsigned long long)lost, (unsigned long long)unwound);
+  }
+  fprintf(out,"\n");
+
+  for( unsigned h = 0; h < hot.size() && h < topN; h++ ){
+    const IFR_RoutinePaths &rp = hot[h];
+    fprintf(out,"IFR paths: %s at %p: %llu runs over %llu of %llu paths, %llu blocks\n",
+            rp.routine->name.c_str(), (void *)rp.routine->address, (unsigned long long)rp.runs,
+            (unsigned long long)rp.paths.size(), (unsigned long long)rp.routine->a->paths.numPaths,
+            (unsigned long long)rp.blocks);
+    for( unsigned k = 0; k < rp.paths.size() && k < topN; k++ ){
+      printPath(out, rp, rp.paths[k].second, rp.paths[k].first);
+    }
+  }
+
+}
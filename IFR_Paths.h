@@ -0,0 +1,34 @@
+#ifndef _IFR_PATHS_H_
+#define _IFR_PATHS_H_
+
+#include <stdio.h>
+#include <pin.H>
+
+#include "IFR_Analysis.h"
+
+/*The path profiling runtime: runs the probes IFR_PathProfile places and
+ *counts the Ball-Larus paths each thread takes through analyzed routines.
+ *
+ *Each thread keeps a stack of frames, one per active profiled routine,
+ *holding the routine's path register.  A routine's entry probe pushes a
+ *frame, after popping any a longjmp or a missed exit left at or below
+ *the stack pointer; its other probes act on the nearest frame of the
+ *routine.  Counts are per thread and merged at Fini, which lists the
+ *hottest routines and their hottest paths.
+ *
+ *With blocks, every block counts instead, the naive profile paths are
+ *measured against; both report the probes they ran per block executed.
+ */
+void IFR_PathsInit(unsigned top, bool blocks);
+void IFR_PathsThreadStart(THREADID tid);
+void IFR_PathsThreadFini(THREADID tid);
+
+/*Instruments ins, which is instruction insNum of the routine analysis a
+ *describes; a must have IFR_PASS_PATHS, or IFR_PASS_CFG with blocks,
+ *where block b of the routine counts as global block blockBase + b
+ */
+void IFR_InstrumentPaths(INS ins, const IFR_Analysis &a, unsigned insNum, UINT32 blockBase);
+
+void IFR_PrintPathStats(FILE *out);
+
+#endif
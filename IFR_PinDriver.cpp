@@ -4,19 +4,34 @@
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <string.h>
 #include <dlfcn.h>
 #include <vector>
-#include <set>
 #include <algorithm>
-#include <ext/hash_map>
 #include <assert.h>
+#include <map>
+#include <set>
 
 #include "IFR_BasicBlock.h"
+#include "IFR_Arena.h"
 #include "IFR_MemoryRef.h"
-
-using __gnu_cxx::hash_map;
+#include "IFR_CFG.h"
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+#include "IFR_DynDoms.h"
+#include "IFR_SSA.h"
+#include "IFR_AnalysisCache.h"
+#include "IFR_RoutineAnalysis.h"
+#include "IFR_WorkPool.h"
+#include "IFR_AccessInstrument.h"
+#include "IFR_Races.h"
+#include "IFR_Paths.h"
+#include "IFR_CallGraph.h"
+#include "IFR_Output.h"
+#include "IFR_Stats.h"
 
 KNOB<bool> KnobPred(KNOB_MODE_WRITEONCE, "pintool", "pred", "false", "Print block predecessors");
 KNOB<bool> KnobDom(KNOB_MODE_WRITEONCE, "pintool", "dom", "false", "Print block dominators");
@@ -25,7 +40,146 @@ KNOB<bool> KnobDF(KNOB_MODE_WRITEONCE, "pintool", "df", "false", "Print block do
 KNOB<bool> KnobSSA(KNOB_MODE_WRITEONCE, "pintool", "ssa", "false", "Print ssa transformation");
 KNOB<bool> KnobMemRefs(KNOB_MODE_WRITEONCE, "pintool", "memrefs", "false", "Print mem refs for each ins");
 KNOB<bool> KnobBlocks(KNOB_MODE_WRITEONCE, "pintool", "blocks", "false", "Print disassembled code blocks ");
-
+KNOB<bool> KnobLoops(KNOB_MODE_WRITEONCE, "pintool", "loops", "false", "Print loop nests and strided references");
+KNOB<bool> KnobAccesses(KNOB_MODE_WRITEONCE, "pintool", "accesses", "false", "Count memory access events in analyzed routines");
+KNOB<bool> KnobLoopRanges(KNOB_MODE_WRITEONCE, "pintool", "loop_ranges", "true", "With -accesses, report strided loop accesses as one range per loop execution");
+KNOB<bool> KnobRedundant(KNOB_MODE_WRITEONCE, "pintool", "redundant", "false", "Print memory references covered by a dominating access");
+KNOB<bool> KnobElide(KNOB_MODE_WRITEONCE, "pintool", "elide_redundant", "true", "With -accesses or -ifrit, skip references covered by a dominating access");
+KNOB<bool> KnobCountElided(KNOB_MODE_WRITEONCE, "pintool", "count_elided", "false", "With -elide_redundant, count the events skipped references would have had");
+KNOB<bool> KnobCoalesce(KNOB_MODE_WRITEONCE, "pintool", "coalesce", "false", "With -accesses or -ifrit, check memory references off the same registers in a block as one range per cache line");
+KNOB<bool> KnobDynDoms(KNOB_MODE_WRITEONCE, "pintool", "dyn_doms", "false", "Update dominators and frontiers as unresolved indirect jumps reach new targets, and reinstrument the blocks whose skipped references the new edges invalidate");
+KNOB<bool> KnobPostDom(KNOB_MODE_WRITEONCE, "pintool", "pdom", "false", "Print block immediate post-dominators and control dependences");
+KNOB<bool> KnobHoistEnds(KNOB_MODE_WRITEONCE, "pintool", "hoist_ends", "false", "With -ifrit, end IFRs before loops whose boundaries post-dominate an access-free way in, instead of checking on every iteration");
+KNOB<bool> KnobLiveness(KNOB_MODE_WRITEONCE, "pintool", "liveness", "false", "Print the registers live into each block; with -accesses or -ifrit, count the caller-saved ones live where analysis calls go");
+KNOB<bool> KnobIFRit(KNOB_MODE_WRITEONCE, "pintool", "ifrit", "false", "Detect data races with interference-free regions in analyzed routines");
+KNOB<UINT32> KnobIFRStripes(KNOB_MODE_WRITEONCE, "pintool", "ifr_stripes", "12", "log2 of the number of lock stripes in the global IFR table (-ifrit)");
+KNOB<UINT32> KnobIFRReports(KNOB_MODE_WRITEONCE, "pintool", "ifr_reports", "20", "Most races to print (-ifrit)");
+KNOB<bool> KnobBuffered(KNOB_MODE_WRITEONCE, "pintool", "buffered", "false", "With -accesses, write access records to per-thread trace buffers instead of calling out per access");
+KNOB<UINT32> KnobBufferSize(KNOB_MODE_WRITEONCE, "pintool", "buffer_size", "64", "Per-thread access buffer size in 4KB pages (-buffered)");
+KNOB<string> KnobTrace(KNOB_MODE_WRITEONCE, "pintool", "trace", "", "With -accesses, also write every access to this compact trace file (see IFR_ReadTrace); implies -buffered");
+KNOB<bool> KnobBufferConsumer(KNOB_MODE_WRITEONCE, "pintool", "buffer_consumer", "false", "Consume full access buffers on an internal thread (-buffered)");
+KNOB<bool> KnobPaths(KNOB_MODE_WRITEONCE, "pintool", "paths", "false", "Profile Ball-Larus paths through analyzed routines and list the hottest at exit");
+KNOB<UINT32> KnobPathsTop(KNOB_MODE_WRITEONCE, "pintool", "paths_top", "10", "Hottest routines, and paths in each, to list (-paths)");
+KNOB<bool> KnobPathsBlocks(KNOB_MODE_WRITEONCE, "pintool", "paths_blocks", "false", "With -paths, count every block instead, the naive profile to compare overhead against");
+KNOB<string> KnobDomAlg(KNOB_MODE_WRITEONCE, "pintool", "domalg", "auto", "Dominator algorithm: chk, lt or auto");
+KNOB<bool> KnobLazy(KNOB_MODE_WRITEONCE, "pintool", "lazy", "true", "Analyze routines when they first execute instead of at image load");
+KNOB<UINT32> KnobThreads(KNOB_MODE_WRITEONCE, "pintool", "threads", "0", "Analyze the main executable at load on this many threads (0: one routine at a time, on the application thread)");
+KNOB<bool> KnobCallGraph(KNOB_MODE_WRITEONCE, "pintool", "callgraph", "false", "Summarize the main executable's routines bottom-up over its call graph at load, and narrow calls to them");
+KNOB<string> KnobOutput(KNOB_MODE_WRITEONCE, "pintool", "o", "", "File for the per-routine output of the print knobs (stderr if empty)");
+KNOB<string> KnobFormat(KNOB_MODE_WRITEONCE, "pintool", "format", "text", "Output format: text, binary (see IFR_ReadOutput) or json (one record per line)");
+KNOB<bool> KnobOutputThread(KNOB_MODE_WRITEONCE, "pintool", "output_thread", "true", "Format and write output on an internal thread instead of in the instrumentation callbacks");
+KNOB<bool> KnobStats(KNOB_MODE_WRITEONCE, "pintool", "stats", "false", "Time every pass of every reported routine and print histograms and the slowest routines at exit");
+KNOB<UINT32> KnobStatsTop(KNOB_MODE_WRITEONCE, "pintool", "stats_top", "10", "Slowest routines to list (-stats)");
+KNOB<string> KnobCacheDir(KNOB_MODE_WRITEONCE, "pintool", "cache_dir", "", "Directory for the persistent analysis cache (off if empty)");
+
+
+
+/*Analysis cache of each image, by IMG_Id, and what it saved us*/
+std::map<UINT32, IFR_AnalysisCache *> imageCaches;
+unsigned cacheHits = 0;
+unsigned cacheMisses = 0;
+double hitTime = 0;
+double missTime = 0;
+
+/*A routine's analysis and how far it has got.  Routines queued for the
+ *pool go Queued -> Running -> Computed, claimed by whichever of a worker
+ *or the application thread gets there first; routines analyzed on the
+ *application thread start out Computed.
+ */
+enum SlotState { SlotQueued = 0, SlotRunning = 1, SlotComputed = 2 };
+
+class RoutineSlot{
+public:
+  IFR_RoutineAnalysis *ra;
+  volatile unsigned state;
+  bool reported;
+  double time;
+  UINT32 blockBase;     //global id of the routine's first block in access records
+
+  /*-dyn_doms: the tree kept current as indirect jumps find new targets
+   *(created at the first), blocks instrumented without elision since, and
+   *whether the whole routine lost its static optimizations
+   */
+  IFR_DynDoms *dyn;
+  vector<unsigned char> stale;
+  bool fallback;
+};
+
+/*Every routine analyzed or queued so far, by address*/
+std::map<ADDRINT, RoutineSlot *> routines;
+unsigned totalRoutines = 0;
+UINT32 totalBlocks = 0;
+
+/*Redundant memrefs over all reported routines*/
+unsigned totalCandidates = 0;
+unsigned totalRedundant = 0;
+
+/*IFR region boundaries over all reported routines, and how many needed
+ *instrumenting
+ */
+unsigned totalBoundaries = 0;
+unsigned totalEnds = 0;
+unsigned totalHoisted = 0;
+unsigned totalUnhoisted = 0;
+
+/*Coalesced memrefs over all reported routines*/
+unsigned totalCoalesceCandidates = 0;
+unsigned totalCoalesced = 0;
+unsigned totalGroups = 0;
+
+/*Indirect jumps in reported routines, and those resolved as jump tables*/
+unsigned totalIndirect = 0;
+unsigned totalTables = 0;
+
+/*An unresolved indirect jump watched for new targets (-dyn_doms)*/
+class IndirectSite{
+public:
+  ADDRINT last;           //most recent target, checked inline
+  RoutineSlot *slot;
+  unsigned block;
+  std::set<ADDRINT> seen;
+};
+
+/*Watched jumps by address, and what their new targets cost*/
+std::map<ADDRINT, IndirectSite *> indirectSites;
+unsigned dynEdges = 0;
+unsigned dynMoved = 0;
+unsigned dynReframed = 0;
+unsigned dynStale = 0;
+unsigned dynFallbacks = 0;
+double dynTime = 0;
+
+/*Instrumented instructions (-liveness), and the caller-saved registers
+ *live before them, which an analysis call there has to preserve
+ */
+IFR_CallABI callABI;
+UINT64 livePoints = 0;
+UINT64 liveScratch = 0;
+
+/*Per-routine output, and what building it cost the instrumentation
+ *callbacks
+ */
+IFR_OutputWriter output;
+bool outputThreaded = false;
+unsigned outRecords = 0;
+double outputTime = 0;
+
+/*Per-pass costs of reported routines (-stats); null when off*/
+IFR_StatsTable *stats = 0;
+
+/*INS handles and blocks of the open routine (-blocks); reset at RTN_Close*/
+IFR_Arena routineArena;
+
+/*Routines handed to the pool at image load*/
+IFR_WorkPool pool;
+vector<RoutineSlot *> pooled;
+unsigned poolPasses = 0;
+double snapshotTime = 0;
+
+/*Call graph of the main executable (-callgraph)*/
+IFR_CallGraph callGraph;
+unsigned narrowedCalls = 0;
+double callGraphTime = 0;
 
 INT32 usage()
 {
@@ -35,573 +189,866 @@ INT32 usage()
     return -1;
 }
 
-void findBlocks(RTN rtn, 
-                vector<IFR_BasicBlock> &bblist, 
-                hash_map<ADDRINT, IFR_BasicBlock> &blocks){
+IFR_DomAlgorithm domAlgorithm(){
 
-  /*Takes a PIN RTN object and returns a set containing the 
-   *addresses of the instructions that are entry points to basic blocks
-   *"Engineering a Compiler pg 439, Figure 9.1 'Finding Leaders'"
-   */
-  set<ADDRINT> leaders = set<ADDRINT>();
-  bool first = true;
-  for (INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins)){
+  if( KnobDomAlg.Value() == "chk" ){ return DomCHK; }
+  if( KnobDomAlg.Value() == "lt" ){ return DomLT; }
+  return DomAuto;
 
-    if( first ){
-      first = false;
-      leaders.insert( INS_Address(ins) );
-    }
+}
 
-    if( INS_IsBranch(ins) ){
+void printMemRef(ostream &os, IFR_MemoryRef &ref){
 
-      assert( !INS_IsRet(ins) );
-      if( !INS_IsIndirectBranchOrCall(ins) ){
-      
-        leaders.insert(INS_DirectBranchOrCallTargetAddress(ins));
-        leaders.insert(INS_NextAddress(ins));
+  //assumes operand op to instruction i is a memory operation 
+  os << (ref.type == MemRead ? "R" : (ref.type == MemWrite ? "W" : "RW"))  << "( M[ ";
 
-      }/*else{
+  if( ref.base != IFR_MemoryRef::NoReg ){
+    os << "r" << ref.base << " + "; 
+  }
 
-        Calls and Indirect Branches may go anywhere, so we conservatively assume they jump to the moon
+  os << ref.displacement;
 
-      }*/
+  if( ref.index != IFR_MemoryRef::NoReg ){
 
-    }
+    os << " + r" << ref.index << "*" << ref.scale;
 
   }
 
-  int ii = 0;
+  os << " ])";
 
-  IFR_BasicBlock bb = IFR_BasicBlock();   
-  for (INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins)){
+}
 
-    bb.add(ins);
 
-    INS next = INS_Next(ins);
-    if(   (INS_Valid(next) &&  leaders.find(INS_Address(next)) != leaders.end()) || !INS_Valid(next) ){
+void printSSAValue(ostream &os, IFR_SSA &ssa, IFR_RegOps &regOps, unsigned v){
 
-      /*Next is a block leader or end of routine -- End the block here*/
+  if( v == IFR_SSA::NoValue ){
+    os << "?";
+    return;
+  }
+  if( ssa.value(v).var == ssa.heapVar() ){
+    os << "mem";
+  }else{
+    os << REG_StringShort( (REG)regOps.regName( ssa.value(v).var ) );
+  }
+  os << "." << v;
 
-      if( INS_IsBranch(ins) ){
+}
 
-        /*Block ends with a branch insn*/
+void printAddressValue(ostream &os, IFR_SSA &ssa, IFR_RegOps &regOps, unsigned in, unsigned r){
 
-        assert( !INS_IsRet(ins) );
-        if( !INS_IsIndirectBranchOrCall(ins) ){
+  /*SSA value of an address register as read by instruction in*/
+  unsigned dense = regOps.lookup( REG_FullRegName( (REG)r ) );
+  unsigned v = (dense == IFR_RegOps::NoReg) ? IFR_SSA::NoValue : ssa.reachingDef(regOps, in, dense);
+  printSSAValue(os, ssa, regOps, v);
 
-          /*End of block with Direct Branch insns*/        
-          bb.setTarget(INS_DirectBranchOrCallTargetAddress(ins));
-          if( INS_Category(ins) != XED_CATEGORY_UNCOND_BR ){
-            bb.setFallthrough(INS_NextAddress(ins));
-          }else{
-            bb.setFallthrough(0);
-          }
+}
 
-        }
+const char *loopKinds[] = { "reducible", "self", "irreducible" };
 
-      }else{
+void printLoops(IFR_OutBuffer &out, IFR_Analysis &a){
 
-        /*Block ends with a non-branch insn*/
-        bb.setTarget(0);
-        bb.setFallthrough(INS_NextAddress(ins));
+  IFR_CFG &cfg = a.cfg;
+  for( unsigned l = 0; l < a.loops.size(); l++ ){
+    const IFR_Loop &loop = a.loops.loop(l);
+    if( loop.parent != IFR_LoopForest::NoLoop ){
+      out.text("Loop %u at %p: depth %u, %u blocks, %s, in loop %u",l,(void *)cfg.entry(loop.header),
+               loop.depth,loop.numBlocks,loopKinds[loop.kind],loop.parent);
+    }else{
+      out.text("Loop %u at %p: depth %u, %u blocks, %s",l,(void *)cfg.entry(loop.header),
+               loop.depth,loop.numBlocks,loopKinds[loop.kind]);
+    }
+  }
 
-      }
+  for( unsigned s = 0; s < a.ranges.refs.size(); s++ ){
+    const IFR_StridedRef &sr = a.ranges.refs[s];
+    if( !a.ranges.summarized(sr.ref) ){ continue; }
+    IFR_MemoryRef &ref = a.memrefs.refs[sr.ref];
+    ostringstream os;
+    os << "Strided " << (void *)a.code.ins[sr.ins].address << ": ";
+    printMemRef(os, ref);
+    os << " " << ref.size << " bytes every " << sr.stride << " bytes over "
+       << REG_StringShort( (REG)sr.reg ) << ", loop " << sr.loop;
+    out.line(os.str());
+  }
 
-      blocks.insert( std::pair<ADDRINT,IFR_BasicBlock>(bb.getEntryAddr(), IFR_BasicBlock(bb)) ); 
-      bblist.push_back(IFR_BasicBlock(bb));
-      bb.clear();
+}
 
+void printRedundant(IFR_OutBuffer &out, IFR_Analysis &a){
+
+  for( unsigned in = 0; in < a.code.ins.size(); in++ ){
+    for( unsigned k = a.memrefs.begin(in); k < a.memrefs.end(in); k++ ){
+      if( !a.redundant.redundant(k) ){ continue; }
+      unsigned d = a.redundant.coveredBy(k);
+      unsigned din = std::upper_bound(a.memrefs.refStart.begin(), a.memrefs.refStart.end(), d) -
+                     a.memrefs.refStart.begin() - 1;
+      ostringstream os;
+      os << "Redundant " << (void *)a.code.ins[in].address << ": ";
+      printMemRef(os, a.memrefs.refs[k]);
+      os << " covered by " << (void *)a.code.ins[din].address;
+      out.line(os.str());
     }
+  }
+  out.text("%u of %u comparable memrefs redundant",a.redundant.numRedundant,a.redundant.numCandidates);
+
+}
 
+void printPostDom(IFR_OutBuffer &out, IFR_Analysis &a){
+
+  IFR_CFG &cfg = a.cfg;
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    ostringstream os;
+    unsigned d = a.postDom.ipdom(b);
+    os << "Block " << (void *)cfg.entry(b) << ": ";
+    if( d == IFR_PostDom::NoBlock ){
+      os << "reaches no exit";
+    }else if( d == IFR_PostDom::Exit ){
+      os << "ipdom exit";
+    }else{
+      os << "ipdom " << (void *)cfg.entry(d);
+    }
+    if( a.postDom.controlBegin(b) != a.postDom.controlEnd(b) ){
+      os << ", control dependent on";
+      for( const unsigned *c = a.postDom.controlBegin(b); c != a.postDom.controlEnd(b); c++ ){
+        os << " " << (void *)cfg.entry(*c);
+      }
+    }
+    out.line(os.str());
   }
+  out.text("%u exits, %u control dependences",a.postDom.numExits,a.postDom.numDependences());
 
-  return;
-   
 }
 
-void computePredecessors(RTN rtn, 
-                         vector<IFR_BasicBlock> &bblist, 
-                         hash_map<ADDRINT, set<ADDRINT> > &pred){
+void printLiveness(IFR_OutBuffer &out, IFR_Analysis &a){
 
-  
-  pred[ bblist.begin()->getEntryAddr() ] = set<ADDRINT>(); 
-  for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
+  IFR_CFG &cfg = a.cfg;
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    if( cfg.insEnd(b) == cfg.insBegin(b) ){ continue; }
+    ostringstream os;
+    os << "Live into " << (void *)cfg.entry(b) << ":";
+    for( unsigned r = 0; r < a.regOps.numRegs(); r++ ){
+      if( a.liveness.liveBefore(cfg.insBegin(b), r) ){ os << " " << REG_StringShort( (REG)a.regOps.regName(r) ); }
+    }
+    out.line(os.str());
+  }
+  out.text("%u live registers over %u instructions, %u sweeps",a.liveness.numLive,cfg.numIns(),a.liveness.sweeps());
 
-    if( pred.find( i->getTarget() ) == pred.end() ){
-      pred[ i->getTarget() ] = set<ADDRINT>();
-    }    
-    
-    if( pred.find( i->getFallthrough() ) == pred.end() ){
-      pred[ i->getFallthrough() ] = set<ADDRINT>();
-    }    
+}
 
-    pred[ i->getTarget() ].insert( i->getEntryAddr() );
-    pred[ i->getFallthrough() ].insert( i->getEntryAddr() );
+/*Caller-saved registers live before instruction in*/
+unsigned liveCallerSaved(const IFR_Analysis &a, unsigned in){
 
+  unsigned live = 0;
+  for( unsigned k = 0; k < callABI.callerSaved.size(); k++ ){
+    unsigned dense = a.regOps.lookup(callABI.callerSaved[k]);
+    if( dense != IFR_RegOps::NoReg && a.liveness.liveBefore(in, dense) ){ live++; }
   }
-  return;
+  return live;
 
 }
 
-void computeDominators(RTN rtn, 
-                       vector<IFR_BasicBlock> &bblist, 
-                       hash_map<ADDRINT, set<ADDRINT> > &pred, 
-                       hash_map<ADDRINT, set<ADDRINT> > &dom){
+IFR_AnalysisCache *imageCache(IMG img){
 
+  if( KnobCacheDir.Value().empty() ){ return 0; }
 
-  set<ADDRINT> allNodes = set<ADDRINT>(); 
-  for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-    allNodes.insert( i->getEntryAddr() ); 
-  }
+  std::map<UINT32, IFR_AnalysisCache *>::iterator c = imageCaches.find( IMG_Id(img) );
+  if( c != imageCaches.end() ){ return c->second; }
 
-  /*Set the dominator set of the entry node to be empty*/
-  dom.insert(std::pair<ADDRINT,set<ADDRINT> >(bblist.begin()->getEntryAddr(), set<ADDRINT>()));
-  dom[ bblist.begin()->getEntryAddr() ].insert( bblist.begin()->getEntryAddr() );
+  IFR_AnalysisCache *cache = new IFR_AnalysisCache();
+  if( !cache->open(KnobCacheDir.Value(), IMG_Name(img)) ){
+    fprintf(stderr,"IFR cache: cannot read %s, not caching it\n",IMG_Name(img).c_str());
+  }
+  imageCaches[ IMG_Id(img) ] = cache;
+  return cache;
 
-  
-  /*Set the dominator set for all other nodes to be all nodes*/
-  bool first = true;
-  for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-
-    if( first ){
-      /*Skip the first block*/
-      first = false;
-      continue;
-    }
+}
 
-    dom.insert(std::pair<ADDRINT,set<ADDRINT> >(i->getEntryAddr(), set<ADDRINT>()));
-    dom[ i->getEntryAddr() ].insert( allNodes.begin(), allNodes.end() ); 
-     
-  }
+unsigned wantedPasses(){
 
-  /*Fixed-Point Part: Iteratively remove elems from each nodes dom set until
-   *                  no set changes.
+  /*What the print knobs need; with a cache, everything it stores so
+   *later runs can skip the analysis entirely.
    */
-  int dbg_i = 0;
-  bool anyChange;
-  do{
-
-    anyChange = false;
-    dbg_i++;
+  unsigned passes = 0;
+  if( KnobPred.Value() ){ passes |= IFR_PASS_CFG; }
+  if( KnobDom.Value() || KnobIDom.Value() ){ passes |= IFR_PASS_DOMTREE; }
+  if( KnobDF.Value() ){ passes |= IFR_PASS_DF; }
+  if( KnobSSA.Value() ){ passes |= IFR_PASS_SSA; }
+  if( KnobBlocks.Value() ){ passes |= IFR_PASS_BLOCKS; }
+  if( KnobAccesses.Value() ){ passes |= IFR_PASS_CFG; }
+  if( KnobLoops.Value() || (KnobAccesses.Value() && KnobLoopRanges.Value()) ){ passes |= IFR_PASS_RANGES; }
+  if( KnobRedundant.Value() || ((KnobAccesses.Value() || KnobIFRit.Value()) && KnobElide.Value()) ){
+    passes |= IFR_PASS_REDUNDANT;
+  }
+  if( KnobIFRit.Value() ){ passes |= KnobHoistEnds.Value() ? IFR_PASS_HOISTENDS : IFR_PASS_REGIONS; }
+  if( KnobPostDom.Value() ){ passes |= IFR_PASS_POSTDOM; }
+  if( KnobLiveness.Value() ){ passes |= IFR_PASS_LIVENESS; }
+  if( KnobCoalesce.Value() && (KnobAccesses.Value() || KnobIFRit.Value()) ){ passes |= IFR_PASS_COALESCE; }
+  if( KnobDynDoms.Value() ){ passes |= IFR_PASS_DF; }
+  if( KnobPaths.Value() ){ passes |= KnobPathsBlocks.Value() ? IFR_PASS_CFG : IFR_PASS_PATHS; }
+  if( !KnobCacheDir.Value().empty() ){ passes |= IFR_PASS_CACHED; }
+  return passes;
 
-    bool first = true;
-    for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
+}
 
-      if( first ){
-        /*Skip the first block*/
-        first = false;
-        continue;
-      }
-      
-      /*Intersection over all p \in pred(n)( dom(p) ) ... */
-      set<ADDRINT> intDoms = set<ADDRINT>();
-      bool firstPred = true;
-      for(set<ADDRINT>::iterator p = pred[ i->getEntryAddr() ].begin();
-          p != pred[ i->getEntryAddr() ].end();
-          p++
-         ){
-
-        /*p is a predecessor of i*/
-        if( firstPred ){
-
-          /*If it is the first predecessor, intDoms is empty, so initialize it with p's doms*/
-          firstPred = false;
-          intDoms.insert( dom[ *p ].begin(), dom[ *p ].end() );
-
-        }else{
-
-          /*If p is non-empty, we've seen a predecessor, so we only want the common elems in intDoms and dom(p)*/
-          set<ADDRINT> intersection = set<ADDRINT>(); 
-          std::set_intersection( intDoms.begin(), intDoms.end(), 
-                                 dom[ *p ].begin(), dom[ *p ].end(), 
-                                 std::inserter( intersection, intersection.begin() ) ); 
-
-          intDoms.clear();
-          intDoms.insert(intersection.begin(), intersection.end());
-        
+bool analyzable(RTN rtn){
+  return RTN_Valid(rtn) && IMG_IsMainExecutable( IMG_FindByAddress( RTN_Address(rtn) ) );
+}
 
-        }
+RoutineSlot *newSlot(RTN rtn, unsigned state){
+
+  IMG img = IMG_FindByAddress( RTN_Address(rtn) );
+  RoutineSlot *slot = new RoutineSlot();
+  slot->ra = new IFR_RoutineAnalysis(rtn, IMG_LowAddress(img), imageCache(img), domAlgorithm(), &routineArena);
+  slot->state = state;
+  slot->reported = false;
+  slot->time = 0;
+  slot->blockBase = 0;
+  slot->dyn = 0;
+  slot->fallback = false;
+  /*Every call ends the caller's IFRs, pure or not*/
+  slot->ra->acrossPureCalls = !KnobIFRit.Value();
+  /*Summarized and elided references are left to their own instrumentation*/
+  if( KnobAccesses.Value() && KnobLoopRanges.Value() ){ slot->ra->coalesceAround |= IFR_PASS_RANGES; }
+  if( KnobElide.Value() ){ slot->ra->coalesceAround |= IFR_PASS_REDUNDANT; }
+  if( stats != 0 ){ slot->ra->enableProfile(); }
+  routines[ RTN_Address(rtn) ] = slot;
+  return slot;
 
-      } 
+}
 
-      /*... Unioned with n itself */
-      intDoms.insert( i->getEntryAddr() );
+/*Claims a queued slot and computes it on the calling thread*/
+bool computeSlot(RoutineSlot *slot){
 
-      
-      if( intDoms.size() != dom[ i->getEntryAddr() ].size() ){
+  if( !IFR_CompareAndSwap(&slot->state, SlotQueued, SlotRunning) ){ return false; }
+  double start = IFR_Clock();
+  slot->ra->compute(poolPasses);
+  slot->time += IFR_Clock() - start;
+  IFR_CompareAndSwap(&slot->state, SlotRunning, SlotComputed);
+  return true;
 
-        anyChange = true;
+}
 
-      }
+void analyzeTask(unsigned item, void *){
+  computeSlot( pooled[item] );
+}
 
-      dom[ i->getEntryAddr() ].clear(); 
-      dom[ i->getEntryAddr() ].insert( intDoms.begin(), intDoms.end() );
+/*Makes sure the wanted passes have run over rtn, which must be open, and
+ *prints their results.  Each routine is reported at most once.
+ */
+void analyzeRoutine(RTN rtn){
+
+  RoutineSlot *slot;
+  std::map<ADDRINT, RoutineSlot *>::iterator r = routines.find( RTN_Address(rtn) );
+  if( r == routines.end() ){
+    slot = newSlot(rtn, SlotComputed);
+  }else{
+    slot = r->second;
+    if( slot->reported ){ return; }
+
+    /*Do it here if no worker has started on it; else wait for the worker*/
+    if( !computeSlot(slot) ){
+      while( slot->state != SlotComputed ){ IFR_Yield(); }
+    }
+  }
+  slot->reported = true;
+
+  double start = IFR_Clock();
+  IFR_RoutineAnalysis *ra = slot->ra;
+  ra->require(rtn, wantedPasses());
+  slot->time += IFR_Clock() - start;
+  if( ra->has(IFR_PASS_CFG) ){
+    slot->blockBase = totalBlocks;
+    totalBlocks += ra->cfg.size();
+    if( KnobAccesses.Value() ){ IFR_TraceRoutine(*ra, slot->blockBase); }
+  }
 
+  if( !KnobCacheDir.Value().empty() ){
+    if( ra->fromCache() ){
+      cacheHits++;
+      hitTime += slot->time;
+    }else{
+      cacheMisses++;
+      missTime += slot->time;
     }
+  }
 
+  for( unsigned i = 0; i < ra->code.ins.size(); i++ ){
+    if( ra->code.ins[i].kind == InsIndirectJump ){ totalIndirect++; }
+  }
+  totalTables += ra->code.numTables();
 
-  }while(anyChange);
+  if( stats != 0 ){ stats->add(RTN_Name(rtn), *ra, slot->time); }
 
-}
+  if( ra->has(IFR_PASS_REDUNDANT) ){
+    totalCandidates += ra->redundant.numCandidates;
+    totalRedundant += ra->redundant.numRedundant;
+  }
 
-void computeIDoms(vector<IFR_BasicBlock> &bblist, 
-                  hash_map<ADDRINT, set<ADDRINT> > &dom, 
-                  hash_map<ADDRINT, ADDRINT> &idom){
+  if( ra->has(IFR_PASS_COALESCE) ){
+    totalCoalesceCandidates += ra->coalesce.numCandidates;
+    totalCoalesced += ra->coalesce.numCoalesced;
+    totalGroups += ra->coalesce.groups.size();
+  }
 
-  for( vector<IFR_BasicBlock>::iterator bi = bblist.begin();
-       bi != bblist.end();
-       bi++
-     ){
+  if( ra->has(IFR_PASS_REGIONS) ){
+    totalBoundaries += ra->regions.numBoundaries;
+    totalEnds += ra->regions.numEnds;
+    totalHoisted += ra->regions.numHoisted;
+    totalUnhoisted += ra->regions.numUnhoisted;
+  }
 
-    for( set<ADDRINT>::iterator di = dom[bi->getEntryAddr()].begin();
-         di != dom[bi->getEntryAddr()].end();
-         di++
-       ){
-  
-      if( *di == bi->getEntryAddr() ){ continue; }  //only strict dominators are considered
-      bool iDom = true; 
-      for( set<ADDRINT>::iterator odi = dom[bi->getEntryAddr()].begin();
-           odi != dom[bi->getEntryAddr()].end();
-           odi++
-         ){
-
-        if( *odi == bi->getEntryAddr() ){ continue; }  //bi-> is the one whose idom we're looking for
-        if( *odi == *di ){ continue; }  //only strict dominators are considered
-
-        /*If any other dominator in bi's dominator set is dominated by di, then
-         *di can't be bi's iDom.
-         */
-        if( dom[ *odi ].find( *di ) != dom[ *odi ].end()){
-          iDom = false;
-        }
+  /*Only records are built here; the writer formats them*/
+  double outStart = IFR_Clock();
+  IFR_OutBuffer *out = new IFR_OutBuffer();
+  out->routine(RTN_Name(rtn), RTN_Address(rtn));
 
-      }
+  IFR_CFG &cfg = ra->cfg;
+  IFR_DomTree &domTree = ra->domTree;
+  IFR_DomFrontiers &df = ra->df;
+  IFR_MemRefTable &memrefs = ra->memrefs;
+  IFR_RegOps &regOps = ra->regOps;
+  IFR_SSA &ssa = ra->ssa;
+  vector<ADDRINT> list;
 
-      if( iDom ){
-        assert( idom.find(bi->getEntryAddr()) == idom.end() );
-        idom.insert( std::pair<ADDRINT, ADDRINT>(bi->getEntryAddr(), *di) );
-      } 
+  if( KnobPred.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+      list.assign(1, cfg.entry(b));
+      for( const unsigned *pi = cfg.predBegin(b); pi != cfg.predEnd(b); pi++ ){
+        list.push_back( cfg.entry(*pi) );
+      }
+      out->record(OutPreds, &list[0], list.size());
+    }
+  }
 
+  if( KnobDom.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+      vector<unsigned> dset = vector<unsigned>();
+      for( unsigned d = b; d != IFR_Dominators::NoBlock; d = domTree.idom(d) ){
+        dset.push_back(d);
+      }
+      std::sort(dset.begin(), dset.end());
+      list.assign(1, cfg.entry(b));
+      for( vector<unsigned>::iterator di = dset.begin(); di != dset.end(); di++ ){
+        list.push_back( cfg.entry(*di) );
+      }
+      out->record(OutDoms, &list[0], list.size());
     }
+  }
 
-    if( idom.find(bi->getEntryAddr()) == idom.end() ){
+  if( KnobIDom.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
       /*an immediate dominator of 0 means this node has no immediate dominator*/
-      idom.insert( std::pair<ADDRINT, ADDRINT>(bi->getEntryAddr(), 0) );
+      unsigned d = domTree.idom(b);
+      out->record(OutIDom, cfg.entry(b), d == IFR_Dominators::NoBlock ? 0 : cfg.entry(d));
     }
+  }
 
+  if( KnobDF.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+      list.assign(1, cfg.entry(b));
+      for( const unsigned *di = df.begin(b); di != df.end(b); di++ ){
+        list.push_back( cfg.entry(*di) );
+      }
+      out->record(OutDF, &list[0], list.size());
+    }
+    out->line("");
   }
 
-}
+  if( KnobSSA.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+
+      out->text("Block %lx", (unsigned long)cfg.entry(b));
+
+      for( unsigned p = 0; p < ssa.numPhis(b); p++ ){
+        ostringstream os;
+        os << "\t";
+        printSSAValue(os, ssa, regOps, ssa.phi(b, p));
+        os << " = phi(";
+        for( unsigned k = 0; k < cfg.numPreds(b); k++ ){
+          if( k > 0 ){ os << ", "; }
+          printSSAValue(os, ssa, regOps, ssa.phiArg(b, p, k));
+        }
+        os << ")";
+        out->line(os.str());
+      }
 
+      for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
 
-bool dominates(ADDRINT b1, ADDRINT b2, hash_map<ADDRINT, set<ADDRINT> > &dom){
-  /*True if b2 is in b1's dominator set; AKA true if b2 dominates b1.*/
-  return dom[ b1 ].find( b2 ) != dom[ b1 ].end();
-}
+        ostringstream os;
+        os << "\tIns" << in - cfg.insBegin(b) << ": ";
+        for( unsigned d = regOps.defStart[in]; d < regOps.defStart[in + 1]; d++ ){
+          printSSAValue(os, ssa, regOps, ssa.defValue[d]);
+          os << " ";
+        }
+        if( ssa.heapDef[in] != IFR_SSA::NoValue ){
+          printSSAValue(os, ssa, regOps, ssa.heapDef[in]);
+          os << " ";
+        }
+        os << "<- ";
+        for( unsigned u = regOps.useStart[in]; u < regOps.useStart[in + 1]; u++ ){
+          printSSAValue(os, ssa, regOps, ssa.useDef[u]);
+          os << " ";
+        }
+        if( ssa.heapUse[in] != IFR_SSA::NoValue ){
+          printSSAValue(os, ssa, regOps, ssa.heapUse[in]);
+          os << " ";
+        }
 
-bool strictlyDominates(ADDRINT b1, ADDRINT b2, hash_map<ADDRINT, set<ADDRINT> > &dom){
-  /*True if b2 is in b1's dominator set; AKA true if b2 dominates b1.*/
-  return ((dom[ b1 ].find( b2 ) != dom[ b1 ].end()) && (b1 != b2));
-}
+        for( unsigned k = memrefs.begin(in); k < memrefs.end(in); k++ ){
+          IFR_MemoryRef &ref = memrefs.refs[k];
+          printMemRef( os, ref );
+          os << "{";
+          if( ref.base != IFR_MemoryRef::NoReg ){ printAddressValue(os, ssa, regOps, in, ref.base); }
+          if( ref.index != IFR_MemoryRef::NoReg ){
+            os << " ";
+            printAddressValue(os, ssa, regOps, in, ref.index);
+          }
+          os << "},";
+        }
+        out->line(os.str());
 
-bool immediatelyDominates(ADDRINT b1, ADDRINT b2, hash_map<ADDRINT, ADDRINT> &idom){
-  /*Returns true if b2 is b1's immediate dominator*/
-  return idom[ b1 ] == b2;
-}
+      }
 
+    }
+
+  }
 
-void computeDominanceFrontiers( vector<IFR_BasicBlock> &bblist, 
-                                hash_map<ADDRINT, set<ADDRINT> > &pred, 
-                                hash_map<ADDRINT, set<ADDRINT> > &dom, 
-                                hash_map<ADDRINT, ADDRINT> &idom ,
-                                hash_map<ADDRINT, set<ADDRINT> > &df ){
 
+  if( KnobLoops.Value() == true ){
+    printLoops(*out, *ra);
+  }
 
-  for( vector<IFR_BasicBlock>::iterator i = bblist.begin();
-       i != bblist.end();
-       i++ ){
+  if( KnobRedundant.Value() == true ){
+    printRedundant(*out, *ra);
+  }
 
-    //for each block 
-   
-    ADDRINT runner = 0; 
-    if( pred[ i->getEntryAddr() ].size() >= 2 ){
-      
-      for( set<ADDRINT>::iterator pi = pred[ i->getEntryAddr() ].begin();
-           pi != pred[ i->getEntryAddr() ].end();
-           pi++
-         ){
+  if( KnobPostDom.Value() == true ){
+    printPostDom(*out, *ra);
+  }
 
-        runner = idom[ *pi ]; 
-        while( runner != idom[ i->getEntryAddr() ] && runner != 0/*entry node*/ ){
-          df[ runner ].insert( i->getEntryAddr() );// = df[runner]; /*TODO: df[ runner ] <-- DF[runner] U {i}*/
-          runner = idom[ runner ];
-        }
+  if( KnobLiveness.Value() == true ){
+    printLiveness(*out, *ra);
+  }
 
+  if( KnobBlocks.Value() == true ){
+    for( unsigned b = 0; b < cfg.size(); b++ ){
+
+      IFR_BasicBlock &bb = ra->blocks[b];
+      ADDRINT block[3] = { cfg.entry(b), bb.target, bb.fallthrough };
+      out->record(OutBlock, block, 3);
+      for( unsigned i = bb.first; i < bb.last; i++ ){
+        INS ins = ra->insns[i];
+        out->ins(INS_Address(ins), CATEGORY_StringShort(INS_Category(ins)) + " " + INS_Disassemble(ins));
       }
- 
-    } 
+      out->line("-------------------------------------");
 
+    }
   }
 
-}
+  outRecords += out->records;
+  output.submit(out);
+  outputTime += IFR_Clock() - outStart;
 
+  /*The INS handles die with RTN_Close*/
+  ra->release();
 
-void computeMemRef(INS i, UINT32 op, IFR_MemoryRef &ref){
-
-  //assumes operand op to instruction i is a memory operation 
-  REG r = INS_OperandMemoryBaseReg( i, op );
-  ADDRDELTA d = INS_OperandMemoryDisplacement( i, op );
-  REG ind = INS_OperandMemoryIndexReg( i, op );
-  UINT32 s = INS_OperandMemoryScale( i, op );
-  ref.base = r;
-  ref.displacement = d;
-  ref.index = ind;
-  ref.scale = s;
+}
 
+void closeRoutine(RTN rtn){
+  RTN_Close(rtn);
+  routineArena.reset();
 }
 
-void printMemRef(IFR_MemoryRef &ref){
+VOID instrumentRoutine(RTN rtn, VOID *v){
 
-  //assumes operand op to instruction i is a memory operation 
-  cerr << (ref.type == MemRead ? "R" : (ref.type == MemWrite ? "W" : "RW"))  << "( M[ ";
+  if( !analyzable(rtn) ){ return; }
+  totalRoutines++;
 
-  REG r;
-  if( ref.base != REG_INVALID() ){
-    cerr << "r" << ref.base << " + "; 
+  if( KnobLazy.Value() == false || KnobThreads.Value() > 0 ){
+    RTN_Open(rtn);
+    analyzeRoutine(rtn);
+    closeRoutine(rtn);
   }
 
-  cerr << ref.displacement;
-
-  if( ref.index  != REG_INVALID() ){
+}
 
-    cerr << " + r" << ref.index << "*" << ref.scale;
+/*Instrumentation of routine instructions [first, last] is redone when next
+ *they run
+ */
+void reinstrument(const IFR_Analysis &a, unsigned first, unsigned last){
+  PIN_RemoveInstrumentationInRange(a.code.ins[first].address, a.code.ins[last].next() - 1);
+}
 
+/*Whether instructions in blocks carry strided ranges, which a new way into
+ *their loop would break
+ */
+bool touchesRanges(const IFR_Analysis &a, const vector<unsigned> &blocks){
+  if( !a.has(IFR_PASS_RANGES) || a.ranges.refs.empty() ){ return false; }
+  for( unsigned i = 0; i < blocks.size(); i++ ){
+    for( unsigned n = a.cfg.insBegin(blocks[i]); n < a.cfg.insEnd(blocks[i]); n++ ){
+      if( a.ranges.edgeBegin(n) != a.ranges.edgeEnd(n) ){ return true; }
+      for( unsigned k = a.memrefs.begin(n); k < a.memrefs.end(n); k++ ){
+        if( a.ranges.summarized(k) ){ return true; }
+      }
+    }
   }
+  return false;
+}
 
-  cerr << " ])";
+/*Whether block b has references left uninstrumented as redundant*/
+bool hasElided(const IFR_Analysis &a, unsigned b){
+  if( !a.has(IFR_PASS_REDUNDANT) ){ return false; }
+  for( unsigned k = a.memrefs.begin( a.cfg.insBegin(b) ); k < a.memrefs.begin( a.cfg.insEnd(b) ); k++ ){
+    if( a.redundant.redundant(k) ){ return true; }
+  }
+  return false;
+}
 
+ADDRINT PIN_FAST_ANALYSIS_CALL newTarget(IndirectSite *site, ADDRINT target){
+  return target != site->last;
 }
 
+/*A watched jump went somewhere it had not before.  A target inside the
+ *routine is a CFG edge findBlocks missed: the covering access a redundant
+ *reference was elided for may no longer be on every path to it, so the
+ *blocks the target reaches that skip references are reinstrumented
+ *without skipping.  A target in the middle of a block splits it, which
+ *the tree cannot follow, and a new way into a loop with ranges breaks
+ *them; the routine then loses its static optimizations altogether.
+ */
+VOID observeTarget(IndirectSite *site, ADDRINT target){
+
+  PIN_LockClient();
+  site->last = target;
+  RoutineSlot *slot = site->slot;
+  IFR_Analysis &a = *slot->ra;
+  if( slot->fallback || !site->seen.insert(target).second ){
+    PIN_UnlockClient();
+    return;
+  }
 
-void computeMemoryReferences(vector<IFR_BasicBlock> &bblist, 
-                             hash_map<ADDRINT, 
-                                      hash_map< unsigned, 
-                                                vector<IFR_MemoryRef> > > &memrefs){
+  double start = IFR_Clock();
+  unsigned y = a.cfg.index(target);
+  if( y == IFR_CFG::NoBlock ){
+    /*Targets outside the routine are tail calls, not edges*/
+    if( a.code.find(target) != IFR_RoutineCode::NoIns ){
+      slot->fallback = true;
+      dynFallbacks++;
+      reinstrument(a, 0, a.code.ins.size() - 1);
+    }
+    dynTime += IFR_Clock() - start;
+    PIN_UnlockClient();
+    return;
+  }
 
-  for( vector<IFR_BasicBlock>::iterator i = bblist.begin();
-       i != bblist.end();
-       i++ ){
+  if( slot->dyn == 0 ){
+    slot->dyn = new IFR_DynDoms();
+    slot->dyn->init(a.cfg, a.domTree, a.df);
+    slot->stale.assign(a.cfg.size(), 0);
+  }
+  if( slot->dyn->insertEdge(site->block, y) ){
+    dynEdges++;
+    dynMoved += slot->dyn->movedBlocks().size();
+    dynReframed += slot->dyn->changedFrontiers().size();
+
+    vector<unsigned> reached;
+    slot->dyn->reachableFrom(y, reached);
+    if( touchesRanges(a, reached) ){
+      slot->fallback = true;
+      dynFallbacks++;
+      reinstrument(a, 0, a.code.ins.size() - 1);
+    }else{
+      for( unsigned i = 0; i < reached.size(); i++ ){
+        unsigned b = reached[i];
+        if( slot->stale[b] || !hasElided(a, b) ){ continue; }
+        slot->stale[b] = 1;
+        dynStale++;
+        reinstrument(a, a.cfg.insBegin(b), a.cfg.insEnd(b) - 1);
+      }
+    }
+  }
+  dynTime += IFR_Clock() - start;
+  PIN_UnlockClient();
 
-    int in = 0;
-    for( vector<INS>::iterator ins_i = i->insns.begin();
-         ins_i != i->insns.end();
-         ins_i++ ){
+}
 
-      int op = 0;
-      for( op = 0; op < INS_OperandCount(*ins_i); op++ ){
-      
-        if( INS_OperandIsReg(*ins_i, op) ){
+/*Watches unresolved indirect jump n of slot's routine, if it is one*/
+void watchIndirect(INS ins, RoutineSlot *slot, unsigned n){
 
-          if( INS_OperandReadAndWritten(*ins_i, op) ){
+  const IFR_Analysis &a = *slot->ra;
+  if( a.code.ins[n].kind != InsIndirectJump || a.code.resolved(n) || !a.has(IFR_PASS_DF) ){ return; }
 
-            //cerr << "R/W Reg " << INS_OperandReg(*ins_i, op) << endl;
+  IndirectSite *&site = indirectSites[ INS_Address(ins) ];
+  if( site == 0 ){
+    site = new IndirectSite();
+    site->last = 0;
+    site->slot = slot;
+    site->block = a.cfg.blockOf(n);
+  }
+  INS_InsertIfCall(ins, IPOINT_BEFORE, (AFUNPTR)newTarget, IARG_FAST_ANALYSIS_CALL,
+                   IARG_PTR, site, IARG_BRANCH_TARGET_ADDR, IARG_END);
+  INS_InsertThenCall(ins, IPOINT_BEFORE, (AFUNPTR)observeTarget, IARG_PTR, site, IARG_BRANCH_TARGET_ADDR, IARG_END);
 
-          }else{
+}
 
-            if( INS_OperandRead(*ins_i, op) ){
+VOID instrumentTrace(TRACE trace, VOID *v){
 
-              //cerr << "R Reg " << INS_OperandReg(*ins_i, op) << endl;
+  /*Lazy mode: a routine is analyzed when code in it is first about to
+   *run, i.e. when its first trace is instrumented.  With -accesses or
+   *-ifrit, the trace is then instrumented from the analysis.
+   */
+  RTN rtn = TRACE_Rtn(trace);
+  if( !analyzable(rtn) ){ return; }
+  std::map<ADDRINT, RoutineSlot *>::iterator r = routines.find( RTN_Address(rtn) );
+  if( r == routines.end() || !r->second->reported ){
+    RTN_Open(rtn);
+    analyzeRoutine(rtn);
+    closeRoutine(rtn);
+    r = routines.find( RTN_Address(rtn) );
+  }
 
-            }
+  if( !KnobAccesses.Value() && !KnobIFRit.Value() && !KnobDynDoms.Value() && !KnobPaths.Value() ){ return; }
+  RoutineSlot *slot = r->second;
+  const IFR_Analysis &a = *slot->ra;
+  UINT32 blockBase = slot->blockBase;
+  unsigned mode = 0;
+  bool elide = KnobElide.Value(), coalesce = KnobCoalesce.Value();
+  if( KnobLoopRanges.Value() ){ mode |= IFR_ACCESS_RANGES; }
+  if( KnobElide.Value() ){ mode |= IFR_ACCESS_ELIDE; }
+  if( KnobCountElided.Value() ){ mode |= IFR_ACCESS_COUNT_ELIDED; }
+  if( KnobCoalesce.Value() ){ mode |= IFR_ACCESS_COALESCE; }
+  if( slot->fallback ){
+    mode = 0;
+    elide = coalesce = false;
+  }
+  for( BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl) ){
+    for( INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins) ){
+      unsigned n = a.code.find( INS_Address(ins) );
+      if( n == IFR_RoutineCode::NoIns ){ continue; }
+      if( KnobDynDoms.Value() ){ watchIndirect(ins, slot, n); }
+      /*Blocks a new edge reached keep no reference elided*/
+      bool stale = !slot->stale.empty() && slot->stale[ a.cfg.blockOf(n) ];
+      unsigned insMode = stale ? mode & ~(IFR_ACCESS_ELIDE | IFR_ACCESS_COUNT_ELIDED) : mode;
+      if( KnobAccesses.Value() ){ IFR_InstrumentAccesses(ins, a, n, blockBase, insMode); }
+      if( KnobIFRit.Value() ){ IFR_InstrumentRaces(ins, a, n, elide && !stale, coalesce); }
+      if( KnobPaths.Value() ){ IFR_InstrumentPaths(ins, a, n, blockBase); }
+      if( a.has(IFR_PASS_LIVENESS) && INS_MemoryOperandCount(ins) > 0 ){
+        livePoints++;
+        liveScratch += liveCallerSaved(a, n);
+      }
+    }
+  }
 
-            if( INS_OperandWritten(*ins_i, op) ){
+}
 
-              //cerr << "W Reg " << INS_OperandReg(*ins_i, op) << endl;
+bool costlier(RoutineSlot *a, RoutineSlot *b){
+  return a->ra->code.ins.size() > b->ra->code.ins.size();
+}
 
-            }
+/*Summarizes the snapshotted routines and narrows their calls before any
+ *of them gets to SSA.  Routines already past it (analyzed before image
+ *load) keep their conservative calls.
+ */
+void summarizeCalls(){
 
-         }
+  double start = IFR_Clock();
+  vector<IFR_Analysis *> all;
+  for( std::map<ADDRINT, RoutineSlot *>::iterator r = routines.begin(); r != routines.end(); r++ ){
+    if( r->second->ra->has(IFR_PASS_CODE) ){ all.push_back(r->second->ra); }
+  }
+  callGraph.build(all);
 
-        }else if( INS_OperandIsMemory(*ins_i, op) ){
-          IFR_MemoryRef ref = IFR_MemoryRef();
-          if( INS_OperandRead(*ins_i, op) && INS_OperandWritten(*ins_i, op) ){
-  
-            //cerr << "R/W "; //INS_OperandReg(*ins_i, mop) << endl;
-            computeMemRef(*ins_i, op, ref);
-            ref.type = MemBoth;
-  
-          }else{
-  
-            if( INS_OperandRead(*ins_i, op) ){
-  
-              //cerr << "R "; //INS_OperandReg(*ins_i, op) << endl;
-              computeMemRef(*ins_i, op, ref);
-              ref.type = MemRead;
-  
-            }
-  
-            if( INS_OperandWritten(*ins_i, op) ){
-  
-              //cerr << "W "; //INS_OperandReg(*ins_i, op) << endl;
-              computeMemRef(*ins_i, op, ref);
-              ref.type = MemWrite;
-  
-            }
-  
-          }
+  IFR_CallABI abi;
+  IFR_PinCallABI(abi);
+  callGraph.summarize(abi, KnobThreads.Value());
 
-          memrefs[ i->getEntryAddr() ][in].push_back(ref);
+  for( unsigned i = 0; i < pooled.size(); i++ ){
+    IFR_RoutineAnalysis *ra = pooled[i]->ra;
+    if( !ra->has(IFR_PASS_SSA) ){ narrowedCalls += ra->applyCallSummaries(callGraph, abi); }
+  }
+  callGraphTime += IFR_Clock() - start;
 
-        }
+}
 
-      }      
-      //cerr << "(" << INS_Disassemble(*ins_i) << ")" << endl;
-      in++; 
-    }
+void printCallGraphStats(){
 
+  unsigned largest = 0;
+  for( unsigned s = 0; s < callGraph.numSCCs(); s++ ){
+    largest = std::max(largest, callGraph.sccSize(s));
   }
+  unsigned opaque = 0;
+  unsigned pure = 0;
+  for( unsigned n = 0; n < callGraph.size(); n++ ){
+    if( callGraph.isOpaque(n) ){ opaque++; }
+    const IFR_RoutineSummary &s = callGraph.summary(n);
+    if( s.known && !s.touchesMemory && !s.syncs ){ pure++; }
+  }
+  fprintf(stderr,"IFR callgraph: %u routines (%u opaque), %u edges, %u SCCs (largest %u), %u levels\n",
+          callGraph.size(), opaque, callGraph.numEdges(), callGraph.numSCCs(), largest, callGraph.numLevels());
+  fprintf(stderr,"IFR callgraph: %u routines touch no memory but the stack, %u calls narrowed, %.3f ms\n",
+          pure, narrowedCalls, callGraphTime * 1e3);
 
 }
 
+VOID instrumentImage(IMG img, VOID *v)
+{
 
-VOID instrumentRoutine(RTN rtn, VOID *v){
- 
+  /*Parallel mode: copy every routine's instructions out of Pin here, then
+   *let the pool run the rest while the application starts.  The RTN
+   *callback only reports finished results (computing a routine itself if
+   *no worker has got to it yet).  -callgraph needs every routine's
+   *instructions up front too; without threads, the slots stay queued and
+   *are computed when first reported.
+   */
+  bool parallel = KnobThreads.Value() > 0;
+  if( (!parallel && !KnobCallGraph.Value()) || !IMG_IsMainExecutable(img) ){ return; }
 
-  RTN_Open(rtn);
-  if( !RTN_Valid(rtn) || !IMG_IsMainExecutable( IMG_FindByAddress( RTN_Address(rtn) ) )){
-    RTN_Close(rtn);
-    return;
-  }
+  pool.join();
+  pooled.clear();
+  poolPasses = wantedPasses() & ~IFR_PASS_FRONTEND;
 
-  fprintf(stderr,">>>>>>>>>>>>>>%s<<<<<<<<<<<<<<<\n",RTN_Name(rtn).c_str());
+  double start = IFR_Clock();
+  for( SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec) ){
+    for( RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn) ){
 
-  vector<IFR_BasicBlock> bblist = vector<IFR_BasicBlock>(); 
-  hash_map<ADDRINT, IFR_BasicBlock> blocks = hash_map<ADDRINT, IFR_BasicBlock>();
-  findBlocks(rtn,bblist,blocks); 
-  
-  hash_map<ADDRINT, set<ADDRINT> > pred = hash_map<ADDRINT, set<ADDRINT> >();
-  computePredecessors(rtn,bblist,pred);
+      if( routines.find( RTN_Address(rtn) ) != routines.end() ){ continue; }
+      RoutineSlot *slot = newSlot(rtn, SlotQueued);
+      RTN_Open(rtn);
+      slot->ra->snapshot(rtn);
+      closeRoutine(rtn);
+      pooled.push_back(slot);
 
-  if( KnobPred.Value() == true ){
-    for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-      fprintf(stderr,"Predecessors to %p:\n\t",i->getEntryAddr());
-      for( set<ADDRINT>::iterator pi = pred[ i->getEntryAddr() ].begin();
-           pi != pred[ i->getEntryAddr() ].end(); pi++ ){
-           fprintf(stderr,"%p ",*pi);
-      }
-      fprintf(stderr,"\n");
     }
   }
+  snapshotTime += IFR_Clock() - start;
 
-  hash_map<ADDRINT, set<ADDRINT> > dom = hash_map<ADDRINT, set<ADDRINT> >();
-  computeDominators(rtn, bblist, pred, dom);
-  
-  if( KnobDom.Value() == true ){
-    for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-      fprintf(stderr,"Dominators of %p:\n\t",i->getEntryAddr());
-      for( set<ADDRINT>::iterator di = dom[ i->getEntryAddr() ].begin();
-           di != dom[ i->getEntryAddr() ].end(); di++ ){
-           fprintf(stderr,"%p ",*di);
-      }
-      fprintf(stderr,"\n");
-    }
-  }
-  
-  hash_map<ADDRINT, ADDRINT > idom = hash_map<ADDRINT, ADDRINT >();
-  computeIDoms(bblist, dom, idom);
+  if( KnobCallGraph.Value() ){ summarizeCalls(); }
+  if( !parallel ){ return; }
 
-  if( KnobIDom.Value() == true ){
-    for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-      fprintf(stderr,"IDom of %p: %p\n",i->getEntryAddr(), idom[i->getEntryAddr()]);
-    }
+  /*Biggest routines first, so no worker is left with one at the end*/
+  std::stable_sort(pooled.begin(), pooled.end(), costlier);
+  vector<unsigned> items(pooled.size());
+  for( unsigned i = 0; i < items.size(); i++ ){
+    items[i] = i;
   }
+  pool.start(KnobThreads.Value(), items, analyzeTask, 0);
 
-  hash_map<ADDRINT, set<ADDRINT> > df = hash_map<ADDRINT, set<ADDRINT> >();
-  computeDominanceFrontiers(bblist, pred, dom, idom, df );
-  if( KnobDF.Value() == true ){
-    for( vector<IFR_BasicBlock>::iterator i = bblist.begin(); i != bblist.end(); i++){
-      fprintf(stderr,"DF of %p:\n\t",i->getEntryAddr());
-      for( set<ADDRINT>::iterator di = df[ i->getEntryAddr() ].begin();
-           di != df[ i->getEntryAddr() ].end(); di++ ){
-           fprintf(stderr,"%p ",*di);
-      }
-      fprintf(stderr,"\n");
-    }
-    fprintf(stderr,"\n");
-  }
+}
 
-  hash_map<ADDRINT, hash_map< unsigned, vector<IFR_MemoryRef> > > memrefs = 
-    hash_map<ADDRINT, hash_map< unsigned, vector<IFR_MemoryRef> > >();
-  computeMemoryReferences(bblist, memrefs);
-  if( KnobSSA.Value() == true ){
-    for( hash_map<ADDRINT, hash_map< unsigned, vector<IFR_MemoryRef> > >::iterator i = memrefs.begin();
-         i != memrefs.end(); i++){
-
-      cerr << "Block " << hex << i->first << dec << endl;
-      for( hash_map< unsigned, vector<IFR_MemoryRef> >::iterator j = i->second.begin();
-           j != i->second.end(); j++ ){
-        cerr << "\tIns" << j->first << ": ";
-        for( vector<IFR_MemoryRef>::iterator k = j->second.begin(); 
-             k != j->second.end(); k++ ){
-          printMemRef( *k );
-          cerr << ",";
-        }
-        cerr << endl;
-  
-      }
+VOID threadBegin(THREADID threadid, CONTEXT *sp, INT32 flags, VOID *v)
+{
+  if( KnobAccesses.Value() ){ IFR_AccessesThreadStart(threadid); }
+  if( KnobIFRit.Value() ){ IFR_RacesThreadStart(threadid); }
+  if( KnobPaths.Value() ){ IFR_PathsThreadStart(threadid); }
+}
+    
+VOID threadEnd(THREADID threadid, const CONTEXT *sp, INT32 flags, VOID *v)
+{
+  if( KnobAccesses.Value() ){ IFR_AccessesThreadFini(threadid); }
+  if( KnobIFRit.Value() ){ IFR_RacesThreadFini(threadid); }
+  if( KnobPaths.Value() ){ IFR_PathsThreadFini(threadid); }
+}
 
-    }
+VOID dumpInfo(){
+  if( stats != 0 ){ stats->print(stderr); }
+}
 
-  }
 
+VOID prepareForFini(VOID *v)
+{
 
-  if( KnobBlocks.Value() == true ){
-    for( std::vector<IFR_BasicBlock>::iterator i = bblist.begin();
-         i != bblist.end();
-         i++
-       ){
-  
-      i->print();
-      fprintf(stderr,"-------------------------------------\n");
-  
-    }
-  }
+  /*Pin's internal threads have to be gone before the process exits*/
+  if( KnobAccesses.Value() ){ IFR_AccessesStop(); }
+  output.close();
+  if( KnobThreads.Value() == 0 ){ return; }
 
-  RTN_Close(rtn);
+  pool.join();
+  for( unsigned w = 0; w < pool.numThreads(); w++ ){
+    fprintf(stderr,"IFR pool: worker %u analyzed %u routines (%u stolen)\n",
+            w, pool.itemsDone(w), pool.itemsStolen(w));
+  }
 
 }
 
-VOID instrumentImage(IMG img, VOID *v)
+VOID Fini(INT32 code, VOID *v)
 {
 
-}
+  unsigned analyzed = 0;
+  for( std::map<ADDRINT, RoutineSlot *>::iterator r = routines.begin(); r != routines.end(); r++ ){
+    if( r->second->state == SlotComputed ){ analyzed++; }
+  }
+  fprintf(stderr,"IFR: analyzed %u of %u routines (%s)\n", analyzed, totalRoutines,
+          KnobThreads.Value() > 0 ? "parallel" : (KnobLazy.Value() ? "lazy" : "eager"));
+  fprintf(stderr,"IFR: %u of %u indirect jumps in reported routines resolved as jump tables\n",
+          totalTables, totalIndirect);
+  fprintf(stderr,"IFR output: %u records, %.3f ms building them in instrumentation callbacks; "
+          "%llu bytes encoded, %llu written in %.3f ms (%s)%s\n",
+          outRecords, outputTime * 1e3, (unsigned long long)output.bytesIn,
+          (unsigned long long)output.bytesOut, output.writeTime * 1e3,
+          outputThreaded ? "output thread" : "in callbacks", output.failed ? ", with errors" : "");
+  if( KnobThreads.Value() > 0 ){
+    fprintf(stderr,"IFR pool: %u threads, %.3f ms copying instructions at image load\n",
+            KnobThreads.Value(), snapshotTime * 1e3);
+  }
 
-void Read(THREADID tid, ADDRINT addr, ADDRINT inst)
-{
+  if( KnobRedundant.Value() || ((KnobAccesses.Value() || KnobIFRit.Value()) && KnobElide.Value()) ){
+    fprintf(stderr,"IFR redundant: %u of %u comparable memrefs in reported routines need no instrumentation\n",
+            totalRedundant, totalCandidates);
+  }
 
-}
+  if( KnobCoalesce.Value() && (KnobAccesses.Value() || KnobIFRit.Value()) ){
+    fprintf(stderr,"IFR coalesce: %u of %u candidate memrefs in reported routines share a check, in %u groups\n",
+            totalCoalesced + totalGroups, totalCoalesceCandidates, totalGroups);
+  }
 
-void Write(THREADID tid, ADDRINT addr, ADDRINT inst)
-{
+  if( KnobDynDoms.Value() ){
+    fprintf(stderr,"IFR dyndoms: %u new edges from %u watched jumps moved %u blocks and changed %u frontiers in %.3f ms; "
+            "%u blocks reinstrumented, %u routines fell back\n",
+            dynEdges, (unsigned)indirectSites.size(), dynMoved, dynReframed, dynTime * 1e3, dynStale, dynFallbacks);
+  }
 
-}
+  if( KnobCallGraph.Value() ){ printCallGraphStats(); }
 
-VOID threadBegin(THREADID threadid, CONTEXT *sp, INT32 flags, VOID *v)
-{
-  
-}
-    
-VOID threadEnd(THREADID threadid, const CONTEXT *sp, INT32 flags, VOID *v)
-{
+  if( livePoints > 0 ){
+    fprintf(stderr,"IFR liveness: %.2f of %u caller-saved registers live on average at %llu instrumented instructions\n",
+            (double)liveScratch / livePoints, (unsigned)callABI.callerSaved.size(), (unsigned long long)livePoints);
+  }
 
-}
+  if( KnobAccesses.Value() ){ IFR_PrintAccessStats(stderr); }
 
-VOID dumpInfo(){
-}
+  if( KnobIFRit.Value() ){
+    fprintf(stderr,"IFRit: %u of %u region boundaries in reported routines instrumented\n",
+            totalEnds, totalBoundaries);
+    if( KnobHoistEnds.Value() ){
+      fprintf(stderr,"IFRit: %u ends hoisted out of loops took the check off %u boundaries\n",
+              totalHoisted, totalUnhoisted);
+    }
+    IFR_PrintRaceStats(stderr);
+  }
 
+  if( KnobPaths.Value() ){ IFR_PrintPathStats(stderr); }
+
+  if( KnobBlocks.Value() ){
+    fprintf(stderr,"IFR arena: %lu bytes at peak in %u chunks\n",
+            (unsigned long)routineArena.peakBytes(), routineArena.numChunks());
+  }
+
+  dumpInfo();
+
+  if( KnobCacheDir.Value().empty() ){ return; }
+
+  for( std::map<UINT32, IFR_AnalysisCache *>::iterator c = imageCaches.begin(); c != imageCaches.end(); c++ ){
+    unsigned added = c->second->numAdded();
+    if( !c->second->flush() ){
+      fprintf(stderr,"IFR cache: could not write %u entries to %s\n",added,KnobCacheDir.Value().c_str());
+    }
+    delete c->second;
+  }
+  imageCaches.clear();
+
+  fprintf(stderr,"IFR cache: %u hits in %.3f ms (%.3f us/routine), %u misses in %.3f ms (%.3f us/routine)\n",
+          cacheHits, hitTime * 1e3, cacheHits ? hitTime * 1e6 / cacheHits : 0.0,
+          cacheMisses, missTime * 1e3, cacheMisses ? missTime * 1e6 / cacheMisses : 0.0);
 
-VOID Fini(INT32 code, VOID *v)
-{
 }
 
 BOOL segvHandler(THREADID threadid,INT32 sig,CONTEXT *ctx,BOOL hasHndlr,const EXCEPTION_INFO *pExceptInfo, VOID*v){
@@ -621,13 +1068,36 @@ int main(int argc, char *argv[])
     return usage();
   }
 
+  IFR_OutFormat format = OutFormatText;
+  if( KnobFormat.Value() == "binary" ){ format = OutFormatBinary; }
+  if( KnobFormat.Value() == "json" ){ format = OutFormatJSON; }
+  if( !output.open(KnobOutput.Value(), format, KnobOutputThread.Value()) ){
+    fprintf(stderr,"IFR: cannot open %s, printing to stderr\n",KnobOutput.Value().c_str());
+    output.open("", format, KnobOutputThread.Value());
+  }
+  outputThreaded = output.threaded();
+  if( KnobStats.Value() ){ stats = new IFR_StatsTable(KnobStatsTop.Value()); }
+  IFR_PinCallABI(callABI);
+
+  IMG_AddInstrumentFunction(instrumentImage,0);
   RTN_AddInstrumentFunction(instrumentRoutine,0);
+  if( (KnobLazy.Value() && KnobThreads.Value() == 0) || KnobAccesses.Value() || KnobIFRit.Value() || KnobDynDoms.Value() ||
+      KnobPaths.Value() ){
+    TRACE_AddInstrumentFunction(instrumentTrace,0);
+  }
+  if( KnobIFRit.Value() ){ IFR_RacesInit(KnobIFRStripes.Value(), KnobIFRReports.Value()); }
+  if( KnobPaths.Value() ){ IFR_PathsInit(KnobPathsTop.Value(), KnobPathsBlocks.Value()); }
+  if( KnobAccesses.Value() ){
+    bool buffered = KnobBuffered.Value() || !KnobTrace.Value().empty();
+    IFR_AccessesInit(buffered ? KnobBufferSize.Value() : 0, KnobBufferConsumer.Value(), KnobTrace.Value().c_str());
+  }
 
   PIN_InterceptSignal(SIGTERM,termHandler,0);
   PIN_InterceptSignal(SIGSEGV,segvHandler,0);
 
   PIN_AddThreadStartFunction(threadBegin, 0);
   PIN_AddThreadFiniFunction(threadEnd, 0);
+  PIN_AddPrepareForFiniFunction(prepareForFini, 0);
   PIN_AddFiniFunction(Fini, 0);
  
   PIN_StartProgram();
@@ -0,0 +1,70 @@
+#include "IFR_PostDom.h"
+
+using std::vector;
+
+const unsigned IFR_PostDom::NoBlock;
+const unsigned IFR_PostDom::Exit;
+
+IFR_PostDom::IFR_PostDom(){
+  numExits = 0;
+}
+
+void IFR_PostDom::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, IFR_DomAlgorithm alg){
+
+  unsigned n = cfg.size();
+  numExits = 0;
+
+  /*The copy's entries are just its block numbers, which keeps them in the
+   *ascending order addBlock wants and makes edge targets easy to name
+   */
+  reversed.clear();
+  for( unsigned b = 0; b <= n; b++ ){ reversed.addBlock(b, 0); }
+  for( unsigned b = 0; b < n; b++ ){
+    if( code.leavesBlock(cfg, b) ){
+      reversed.addEdge(0, b + 1);
+      numExits++;
+    }
+    for( const unsigned *p = cfg.predBegin(b); p != cfg.predEnd(b); p++ ){ reversed.addEdge(b + 1, *p + 1); }
+  }
+  reversed.finish();
+
+  IFR_Dominators doms;
+  doms.compute(reversed, alg);
+  tree.build(doms);
+  IFR_DomFrontiers rdf;
+  rdf.compute(reversed, tree);
+
+  /*The exit has no predecessors in the copy, so is in no frontier*/
+  ctrlStart.assign(n + 1, 0);
+  ctrl.clear();
+  depStart.assign(n + 1, 0);
+  for( unsigned b = 0; b < n; b++ ){
+    for( const unsigned *a = rdf.begin(b + 1); a != rdf.end(b + 1); a++ ){
+      ctrl.push_back(*a - 1);
+      depStart[*a]++;
+    }
+    ctrlStart[b + 1] = ctrl.size();
+  }
+
+  /*Transposed; filling in block order keeps each list sorted*/
+  for( unsigned a = 0; a < n; a++ ){ depStart[a + 1] += depStart[a]; }
+  deps.resize(ctrl.size());
+  vector<unsigned> fill(depStart.begin(), depStart.end() - 1);
+  for( unsigned b = 0; b < n; b++ ){
+    for( unsigned i = ctrlStart[b]; i < ctrlStart[b + 1]; i++ ){ deps[ fill[ ctrl[i] ]++ ] = b; }
+  }
+
+}
+
+unsigned IFR_PostDom::ipdom(unsigned b) const{
+
+  if( !reachesExit(b) ){ return NoBlock; }
+  unsigned d = tree.idom(b + 1);
+  return d == 0 ? Exit : d - 1;
+
+}
+
+size_t IFR_PostDom::bytes() const{
+  return reversed.bytes() + tree.bytes() + IFR_Bytes(ctrlStart) + IFR_Bytes(ctrl) +
+         IFR_Bytes(depStart) + IFR_Bytes(deps);
+}
@@ -0,0 +1,69 @@
+#ifndef _IFR_POSTDOM_H_
+#define _IFR_POSTDOM_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_CFG.h"
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+
+/*Post-dominator tree and control dependence graph of a routine.
+ *
+ *Post-dominators are the dominators of the reverse CFG, so they are
+ *computed by IFR_Dominators and indexed by IFR_DomTree unchanged, over a
+ *reversed copy of the CFG whose block 0 is a virtual exit with an edge to
+ *every block that can leave the routine: returns, unresolved indirect
+ *jumps, jumps out of the routine and blocks with no successors.  Block b
+ *of the routine is block b + 1 of the copy.  Blocks that cannot reach an
+ *exit (infinite loops) have no post-dominators.
+ *
+ *Block b is control dependent on a, a branch, when a has one successor
+ *that b post-dominates and another it does not; those a are the reverse
+ *dominance frontier of b (Cytron et al.), which IFR_DomFrontiers computes
+ *over the copy.  Both directions are stored CSR-style and sorted.
+ */
+class IFR_PostDom{
+
+  IFR_CFG reversed;
+  IFR_DomTree tree;
+  std::vector<unsigned> ctrlStart;  //b is control dependent on ctrl[ctrlStart[b]..ctrlStart[b+1])
+  std::vector<unsigned> ctrl;
+  std::vector<unsigned> depStart;   //deps[depStart[a]..depStart[a+1]) are control dependent on a
+  std::vector<unsigned> deps;
+
+public:
+
+  static const unsigned NoBlock = IFR_CFG::NoBlock;
+  static const unsigned Exit = (unsigned)-2;    //the virtual exit, as an ipdom
+
+  unsigned numExits;
+
+  IFR_PostDom();
+
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, IFR_DomAlgorithm alg);
+
+  size_t bytes() const;
+
+  unsigned size() const { return ctrlStart.empty() ? 0 : ctrlStart.size() - 1; }
+  bool reachesExit(unsigned b) const { return b < size() && tree.reachable(b + 1); }
+
+  /*Immediate post-dominator of b, Exit if none in the routine, NoBlock if
+   *b cannot reach an exit
+   */
+  unsigned ipdom(unsigned b) const;
+
+  /*Whether every path from b to an exit goes through a (a block
+   *post-dominates itself); false for blocks that reach no exit
+   */
+  bool postDominates(unsigned a, unsigned b) const { return a < size() && b < size() && tree.dominates(a + 1, b + 1); }
+
+  const unsigned *controlBegin(unsigned b) const { return ctrl.empty() ? 0 : &ctrl[0] + ctrlStart[b]; }
+  const unsigned *controlEnd(unsigned b) const { return ctrl.empty() ? 0 : &ctrl[0] + ctrlStart[b + 1]; }
+  const unsigned *dependentBegin(unsigned a) const { return deps.empty() ? 0 : &deps[0] + depStart[a]; }
+  const unsigned *dependentEnd(unsigned a) const { return deps.empty() ? 0 : &deps[0] + depStart[a + 1]; }
+  unsigned numDependences() const { return ctrl.size(); }
+
+};
+
+#endif
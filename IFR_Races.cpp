@@ -0,0 +1,200 @@
+#include <set>
+#include <vector>
+#include <utility>
+
+#include "IFR_Races.h"
+#include "IFR_ActiveTable.h"
+#include "IFR_RoutineAnalysis.h"
+
+using std::set;
+using std::pair;
+using std::vector;
+
+static IFR_ActiveTable table;
+static TLS_KEY setKey;
+
+/*Every thread's set, for the totals at Fini; under raceLock*/
+static PIN_LOCK raceLock;
+static vector<IFR_ActiveSet *> allSets;
+static unsigned untracked = 0;
+
+/*Races reported so far, by instruction pair; under raceLock*/
+static set< pair<ADDRINT, ADDRINT> > seen;
+static unsigned maxPrinted = 0;
+static UINT64 conflicts = 0;
+
+/*Coalesced groups instrumented, and the operands they stand for*/
+static UINT64 groupSites = 0;
+static UINT64 groupOperands = 0;
+
+static inline IFR_ActiveSet *activeSet(THREADID tid){
+  return (IFR_ActiveSet *)PIN_GetThreadData(setKey, tid);
+}
+
+static void report(THREADID tid, ADDRINT pc, bool write, const IFR_Conflict &c){
+
+  PIN_GetLock(&raceLock, tid + 1);
+  conflicts++;
+  pair<ADDRINT, ADDRINT> key = pc < c.pc ? std::make_pair(pc, c.pc) : std::make_pair(c.pc, pc);
+  if( seen.insert(key).second && seen.size() <= maxPrinted ){
+    fprintf(stderr,"IFRit: race on %p: thread %u %s at %p, thread %u %s at %p\n",
+            (void *)(c.word << 3), tid, write ? "writes" : "reads", (void *)pc,
+            c.thread, c.write ? "writes" : "reads", (void *)c.pc);
+  }
+  PIN_ReleaseLock(&raceLock);
+
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL ifrAccess(THREADID tid, ADDRINT ea, UINT32 size, UINT32 write, ADDRINT pc){
+
+  IFR_ActiveSet *s = activeSet(tid);
+  if( s == 0 ){ return; }
+  IFR_Conflict c;
+  if( s->access(table, tid, ea, size, write != 0, pc, c) ){ report(tid, pc, write != 0, c); }
+
+}
+
+/*Each run of bytes the group's members touch, from the leader's address*/
+static VOID PIN_FAST_ANALYSIS_CALL ifrGroup(THREADID tid, ADDRINT ea, const IFR_CoalesceGroup *g, ADDRINT pc){
+
+  IFR_ActiveSet *s = activeSet(tid);
+  if( s == 0 ){ return; }
+  UINT64 mask = g->mask;
+  ADDRINT at = ea;
+  while( mask != 0 ){
+    unsigned skip = __builtin_ctzll(mask);
+    at += skip;
+    mask >>= skip;
+    unsigned run = ~mask == 0 ? 64 : __builtin_ctzll(~mask);
+    IFR_Conflict c;
+    if( s->access(table, tid, at, run, g->write, pc, c) ){ report(tid, pc, g->write, c); }
+    at += run;
+    mask = run == 64 ? 0 : mask >> run;
+  }
+
+}
+
+static ADDRINT PIN_FAST_ANALYSIS_CALL ifrActive(THREADID tid){
+  IFR_ActiveSet *s = activeSet(tid);
+  if( s == 0 ){ return 0; }
+  s->checks++;
+  return s->size() != 0;
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL ifrEnd(THREADID tid){
+  activeSet(tid)->endAll(table, tid);
+}
+
+void IFR_RacesInit(unsigned stripeBits, unsigned maxReports){
+
+  table.init(stripeBits);
+  setKey = PIN_CreateThreadDataKey(0);
+  PIN_InitLock(&raceLock);
+  maxPrinted = maxReports;
+
+}
+
+void IFR_RacesThreadStart(THREADID tid){
+
+  if( tid >= IFR_ActiveTable::MaxThreads ){
+    PIN_GetLock(&raceLock, tid + 1);
+    untracked++;
+    PIN_ReleaseLock(&raceLock);
+    return;
+  }
+
+  IFR_ActiveSet *s = new IFR_ActiveSet();
+  PIN_SetThreadData(setKey, s, tid);
+  PIN_GetLock(&raceLock, tid + 1);
+  allSets.push_back(s);
+  PIN_ReleaseLock(&raceLock);
+
+}
+
+void IFR_RacesThreadFini(THREADID tid){
+
+  /*Its stats stay in allSets for Fini*/
+  IFR_ActiveSet *s = activeSet(tid);
+  if( s == 0 ){ return; }
+  s->endAll(table, tid);
+  PIN_SetThreadData(setKey, 0, tid);
+
+}
+
+void IFR_InstrumentRaces(INS ins, const IFR_Analysis &a, unsigned insNum, bool elide, bool coalesce){
+
+  /*Boundaries come before the instruction's own accesses, which start
+   *nothing if it ends every IFR anyway
+   */
+  unsigned where = a.regions.endAt(insNum);
+  if( where == RegionBefore || (where == RegionTaken && INS_IsValidForIpointTakenBranch(ins)) ){
+    INS_InsertIfCall(ins, where == RegionBefore ? IPOINT_BEFORE : IPOINT_TAKEN_BRANCH, (AFUNPTR)ifrActive,
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID, IARG_END);
+    INS_InsertThenCall(ins, where == RegionBefore ? IPOINT_BEFORE : IPOINT_TAKEN_BRANCH, (AFUNPTR)ifrEnd,
+                       IARG_FAST_ANALYSIS_CALL,
+                       IARG_THREAD_ID, IARG_END);
+  }
+  if( !IFR_Regions::starts(a.code, a.memrefs, a.regOps, insNum) ){ return; }
+
+  unsigned numRefs = a.memrefs.end(insNum) - a.memrefs.begin(insNum);
+  for( UINT32 m = 0; m < INS_MemoryOperandCount(ins); m++ ){
+
+    unsigned k = IFR_MemRefOfOperand(ins, m);
+    if( elide && k < numRefs && a.redundant.redundant( a.memrefs.begin(insNum) + k ) ){ continue; }
+
+    const IFR_CoalesceGroup *group = 0;
+    if( coalesce && k < numRefs ){
+      if( a.coalesce.covered( a.memrefs.begin(insNum) + k ) ){ continue; }
+      group = a.coalesce.leads( a.memrefs.begin(insNum) + k );
+    }
+    if( group != 0 ){
+      groupSites++;
+      groupOperands += group->members;
+      INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)ifrGroup,
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_MEMORYOP_EA, m,
+                     IARG_PTR, group,
+                     IARG_INST_PTR,
+                     IARG_END);
+      continue;
+    }
+
+    INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)ifrAccess,
+                             IARG_FAST_ANALYSIS_CALL,
+                             IARG_THREAD_ID,
+                             IARG_MEMORYOP_EA, m,
+                             IARG_UINT32, INS_MemoryOperandSize(ins, m),
+                             IARG_UINT32, (UINT32)INS_MemoryOperandIsWritten(ins, m),
+                             IARG_INST_PTR,
+                             IARG_END);
+
+  }
+
+}
+
+void IFR_PrintRaceStats(FILE *out){
+
+  UINT64 begun = 0, regions = 0, checks = 0;
+  for( unsigned i = 0; i < allSets.size(); i++ ){
+    begun += allSets[i]->begun;
+    regions += allSets[i]->regions;
+    checks += allSets[i]->checks;
+  }
+
+  fprintf(out,"IFRit: %llu IFRs started, %llu boundary checks ended %llu regions, %u table stripes\n",
+          (unsigned long long)begun, (unsigned long long)checks, (unsigned long long)regions, table.numStripes());
+  fprintf(out,"IFRit: %llu conflicts, %u distinct races (%u printed)\n",
+          (unsigned long long)conflicts, (unsigned)seen.size(),
+          (unsigned)(seen.size() < maxPrinted ? seen.size() : maxPrinted));
+  if( groupSites > 0 ){
+    fprintf(out,"IFRit: %llu operand checks coalesced into %llu group checks, %.1f%% fewer\n",
+            (unsigned long long)groupOperands, (unsigned long long)groupSites,
+            100.0 * (groupOperands - groupSites) / groupOperands);
+  }
+  if( untracked > 0 ){
+    fprintf(out,"IFRit: %u threads past the first %u were not checked\n", untracked, IFR_ActiveTable::MaxThreads);
+  }
+
+}
@@ -0,0 +1,39 @@
+#ifndef _IFR_RACES_H_
+#define _IFR_RACES_H_
+
+#include <stdio.h>
+#include <pin.H>
+
+#include "IFR_Analysis.h"
+
+/*The IFRit runtime: data race detection with interference-free regions
+ *(see IFR_ActiveTable.h).
+ *
+ *Every memory access in an analyzed routine starts IFRs on the words it
+ *touches, in the thread's IFR_ActiveSet and the global IFR_ActiveTable,
+ *which reports any conflicting IFR another thread has active.  The
+ *boundaries IFR_Regions places end all of the thread's IFRs; so does the
+ *thread's end.  A race is printed once per pair of instructions.
+ *
+ *Threads 64 and up are not checked.
+ */
+
+/*2^stripeBits stripes in the global table; at most maxReports races are
+ *printed, the rest only counted
+ */
+void IFR_RacesInit(unsigned stripeBits, unsigned maxReports);
+void IFR_RacesThreadStart(THREADID tid);
+void IFR_RacesThreadFini(THREADID tid);
+
+/*Instruments ins, which is instruction insNum of the routine analysis a
+ *describes; a must have IFR_PASS_REGIONS, and IFR_PASS_REDUNDANT with
+ *elide, which skips accesses whose IFR a dominating access started.
+ *With coalesce (and IFR_PASS_COALESCE), each IFR_Coalesce group starts
+ *the IFRs of all its members at once, from its leader, and races on them
+ *are reported at the leader's pc.
+ */
+void IFR_InstrumentRaces(INS ins, const IFR_Analysis &a, unsigned insNum, bool elide, bool coalesce);
+
+void IFR_PrintRaceStats(FILE *out);
+
+#endif
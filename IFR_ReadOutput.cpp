@@ -0,0 +1,66 @@
+/*Converts the Pin tool's binary output (-format binary) to the text the
+ *knobs print, or to JSON lines:
+ *
+ *  IFR_ReadOutput [-json] file
+ *
+ *Needs no Pin; build with make reader.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "IFR_Output.h"
+
+using std::vector;
+
+static void usage(){
+  fprintf(stderr,"usage: IFR_ReadOutput [-json] file\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  IFR_OutFormat format = OutFormatText;
+  const char *path = 0;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-json") ){ format = OutFormatJSON; }
+    else if( argv[i][0] == '-' || path != 0 ){ usage(); }
+    else{ path = argv[i]; }
+  }
+  if( path == 0 ){ usage(); }
+
+  FILE *in = fopen(path, "rb");
+  if( in == 0 ){
+    perror(path);
+    return 1;
+  }
+  vector<unsigned char> bytes;
+  unsigned char chunk[1 << 16];
+  size_t n;
+  while( (n = fread(chunk, 1, sizeof(chunk), in)) > 0 ){
+    bytes.insert(bytes.end(), chunk, chunk + n);
+  }
+  fclose(in);
+
+  UINT32 header[2];
+  if( bytes.size() < sizeof(header) ){
+    fprintf(stderr,"%s: not IFR output\n",path);
+    return 1;
+  }
+  memcpy(header, &bytes[0], sizeof(header));
+  if( header[0] != IFR_OUT_MAGIC || header[1] != IFR_OUT_VERSION ){
+    fprintf(stderr,"%s: not IFR output, or version %u instead of %u\n",path,header[1],IFR_OUT_VERSION);
+    return 1;
+  }
+
+  unsigned records;
+  bool ok = IFR_WriteRecords(stdout, format, &bytes[0] + sizeof(header), bytes.size() - sizeof(header), records);
+  fflush(stdout);
+  if( !ok ){
+    fprintf(stderr,"%s: malformed after %u records\n",path,records);
+    return 1;
+  }
+  return 0;
+
+}
@@ -0,0 +1,173 @@
+/*Reads a memory access trace written by the Pin tool's -trace knob
+ *(IFR_Trace.h), one chunk at a time, and reports its size against the
+ *raw records it encodes and how fast it decodes:
+ *
+ *  IFR_ReadTrace [-dump] [-threads n] file
+ *
+ *-dump prints every frame's thread and number, then each of its accesses
+ *as "tid pc r|w size address", with the pc from the trace's blocks
+ *chunks ("?" for operands they do not describe).  -threads decodes
+ *batches of frames on n threads.  Needs no Pin; build with make
+ *tracereader.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "IFR_Trace.h"
+#include "IFR_WorkPool.h"
+#include "IFR_Clock.h"
+
+using std::vector;
+
+static void usage(){
+  fprintf(stderr,"usage: IFR_ReadTrace [-dump] [-threads n] file\n");
+  exit(1);
+}
+
+/*Frames read but not yet decoded, and what decoding them gave*/
+class Batch{
+
+public:
+
+  vector< vector<unsigned char> > payloads;
+  vector<IFR_TraceCoder> coders;
+  vector< vector<IFR_AccessRecord> > records;
+  vector<UINT32> tids;
+  vector<UINT64> seqs;
+  vector<unsigned char> ok;
+  unsigned size;
+
+};
+
+static void decodeTask(unsigned item, void *arg){
+  Batch *b = (Batch *)arg;
+  const vector<unsigned char> &p = b->payloads[item];
+  b->ok[item] = b->coders[item].decode(p.empty() ? 0 : &p[0], p.size(), b->tids[item], b->seqs[item],
+                                       b->records[item]);
+}
+
+static void dump(const IFR_TraceDictionary &dict, UINT32 tid, UINT64 seq, const vector<IFR_AccessRecord> &records){
+  printf("# thread %u frame %llu\n", tid, (unsigned long long)seq);
+  for( unsigned i = 0; i < records.size(); i++ ){
+    const IFR_AccessRecord &r = records[i];
+    const IFR_TraceRef *ref = dict.find(r.block, r.ref);
+    if( ref != 0 ){
+      printf("%u %p %c %u %p\n", tid, (void *)ref->ins, r.write ? 'w' : 'r', r.size, (void *)r.ea);
+    }else{
+      printf("%u ? %c %u %p\n", tid, r.write ? 'w' : 'r', r.size, (void *)r.ea);
+    }
+  }
+}
+
+int main(int argc, char *argv[]){
+
+  bool dumping = false;
+  unsigned threads = 0;
+  const char *path = 0;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-dump") ){ dumping = true; }
+    else if( !strcmp(argv[i], "-threads") && i + 1 < argc ){ threads = atoi(argv[++i]); }
+    else if( argv[i][0] == '-' || path != 0 ){ usage(); }
+    else{ path = argv[i]; }
+  }
+  if( path == 0 ){ usage(); }
+
+  IFR_TraceReader reader;
+  const char *error;
+  if( !reader.open(path, error) ){
+    fprintf(stderr,"%s: %s\n",path,error);
+    return 1;
+  }
+
+  /*Frames decode in batches, in order, so -dump output is the trace's*/
+  Batch batch;
+  unsigned batchSize = threads > 0 ? 4 * threads : 1;
+  batch.payloads.resize(batchSize);
+  batch.coders.resize(batchSize);
+  batch.records.resize(batchSize);
+  batch.tids.resize(batchSize);
+  batch.seqs.resize(batchSize);
+  batch.ok.resize(batchSize);
+  batch.size = 0;
+
+  IFR_TraceDictionary dict;
+  IFR_WorkPool pool;
+  UINT64 accesses = 0, frames = 0, blockChunks = 0, blockBytes = 0, frameBytes = 0;
+  vector<UINT32> seen;
+  double decodeTime = 0;
+  double start = IFR_Clock();
+  bool bad = false, more = true, truncated = false;
+
+  while( more && !bad ){
+
+    IFR_TraceChunkKind kind;
+    vector<unsigned char> payload;
+    more = reader.next(kind, payload, truncated);
+    if( more && kind == TraceBlocks ){
+      blockChunks++;
+      blockBytes += payload.size() + 5;
+      if( !dict.load(payload.empty() ? 0 : &payload[0], payload.size()) ){
+        fprintf(stderr,"%s: malformed blocks chunk\n",path);
+        bad = true;
+      }
+      continue;
+    }
+    if( more && kind == TraceFrame ){
+      frameBytes += payload.size() + 5;
+      batch.payloads[batch.size++].swap(payload);
+      if( batch.size < batchSize ){ continue; }
+    }
+    if( batch.size == 0 ){ continue; }
+
+    /*Blocks only ever get added, so frames decoded late still find theirs*/
+    double t0 = IFR_Clock();
+    if( threads > 0 ){
+      vector<unsigned> items;
+      for( unsigned i = 0; i < batch.size; i++ ){ items.push_back(i); }
+      pool.start(threads, items, decodeTask, &batch);
+      pool.join();
+    }else{
+      for( unsigned i = 0; i < batch.size; i++ ){ decodeTask(i, &batch); }
+    }
+    decodeTime += IFR_Clock() - t0;
+
+    for( unsigned i = 0; i < batch.size && !bad; i++ ){
+      if( !batch.ok[i] ){
+        fprintf(stderr,"%s: malformed frame after %llu accesses\n",path,(unsigned long long)accesses);
+        bad = true;
+        break;
+      }
+      frames++;
+      accesses += batch.records[i].size();
+      bool known = false;
+      for( unsigned t = 0; t < seen.size() && !known; t++ ){ known = seen[t] == batch.tids[i]; }
+      if( !known ){ seen.push_back(batch.tids[i]); }
+      if( dumping ){ dump(dict, batch.tids[i], batch.seqs[i], batch.records[i]); }
+    }
+    batch.size = 0;
+
+  }
+  double elapsed = IFR_Clock() - start;
+  if( truncated ){
+    fprintf(stderr,"%s: truncated after %llu accesses\n",path,(unsigned long long)accesses);
+    bad = true;
+  }
+
+  double perAccess = accesses > 0 ? (double)reader.bytesIn / accesses : 0;
+  fprintf(dumping ? stderr : stdout,
+          "IFR trace: %llu accesses by %u threads in %llu frames; %u blocks with %u references in %llu chunks\n"
+          "IFR trace: %llu bytes (%llu in frames, %llu describing blocks), %.2f bytes per access: %.1fx smaller than "
+          "%u-byte buffer records, %.1fx smaller than (tid, address, pc) triples\n"
+          "IFR trace: decoded in %.3f s (%.3f s reading), %.1f MB/s, %.1f M accesses/s%s\n",
+          (unsigned long long)accesses, (unsigned)seen.size(), (unsigned long long)frames,
+          (unsigned)dict.blocks.size(), (unsigned)dict.refs.size(), (unsigned long long)blockChunks,
+          (unsigned long long)reader.bytesIn, (unsigned long long)frameBytes, (unsigned long long)blockBytes,
+          perAccess, perAccess > 0 ? sizeof(IFR_AccessRecord) / perAccess : 0, (unsigned)sizeof(IFR_AccessRecord),
+          perAccess > 0 ? (4 + 2 * sizeof(ADDRINT)) / perAccess : 0,
+          elapsed, elapsed - decodeTime, decodeTime > 0 ? reader.bytesIn / decodeTime / 1e6 : 0,
+          decodeTime > 0 ? accesses / decodeTime / 1e6 : 0, threads > 0 ? " in parallel" : "");
+  return bad ? 1 : 0;
+
+}
@@ -0,0 +1,228 @@
+#include "IFR_RedundantRefs.h"
+
+using std::vector;
+using std::map;
+
+const unsigned IFR_RedundantRefs::NoRef;
+
+/*An address: SSA values of base and index (NoValue if absent), scale and
+ *displacement
+ */
+class RefKey{
+
+public:
+
+  unsigned base;
+  unsigned index;
+  UINT32 scale;
+  ADDRDELTA displacement;
+
+  bool operator<(const RefKey &o) const{
+    if( base != o.base ){ return base < o.base; }
+    if( index != o.index ){ return index < o.index; }
+    if( scale != o.scale ){ return scale < o.scale; }
+    return displacement < o.displacement;
+  }
+
+};
+
+/*A reference in the scoped table, linked to the one it shadows*/
+class RefEntry{
+
+public:
+
+  unsigned ref;
+  RefKey key;
+  unsigned prev;
+
+};
+
+/*A block on the dominator tree walk*/
+class RefFrame{
+
+public:
+
+  unsigned block;
+  const unsigned *child;
+  bool entered;
+  unsigned mark;        //table size when the block was entered
+  unsigned killMark;    //entries below this are unavailable
+
+};
+
+IFR_RedundantRefs::IFR_RedundantRefs(){
+  numCandidates = 0;
+  numRedundant = 0;
+}
+
+static bool addressKey(const IFR_MemoryRef &ref, unsigned ins, const IFR_RegOps &regOps,
+                       const IFR_SSA &ssa, RefKey &key){
+
+  unsigned regs[2] = { ref.base, ref.index };
+  unsigned values[2] = { IFR_SSA::NoValue, IFR_SSA::NoValue };
+  for( unsigned a = 0; a < 2; a++ ){
+    if( regs[a] == IFR_MemoryRef::NoReg ){ continue; }
+    unsigned dense = regOps.lookup(regs[a]);
+    if( dense == IFR_RegOps::NoReg ){ return false; }
+    values[a] = ssa.reachingDef(regOps, ins, dense);
+    if( values[a] == IFR_SSA::NoValue ){ return false; }
+  }
+
+  key.base = values[0];
+  key.index = values[1];
+  key.scale = ref.index == IFR_MemoryRef::NoReg ? 0 : ref.scale;
+  key.displacement = ref.displacement;
+  return true;
+
+}
+
+static bool covers(const IFR_MemoryRef &d, const IFR_MemoryRef &k){
+  if( k.type != MemRead && d.type == MemRead ){ return false; }
+  return k.size != 0 && d.size >= k.size;
+}
+
+/*Whether some path from the end of dominator p to the start of c may
+ *pass a call: any block that reaches c without going through p.  Blocks
+ *that only reach c through c itself are included too, which is
+ *conservative.
+ */
+static bool callBetween(const IFR_CFG &cfg, const IFR_DomTree &domTree, const vector<unsigned char> &hasCall,
+                        unsigned p, unsigned c, vector<unsigned> &seen, unsigned stamp, vector<unsigned> &work){
+
+  if( cfg.numPreds(c) == 1 && *cfg.predBegin(c) == p ){ return false; }
+
+  work.clear();
+  work.push_back(c);
+  while( !work.empty() ){
+    unsigned b = work.back();
+    work.pop_back();
+    for( const unsigned *q = cfg.predBegin(b); q != cfg.predEnd(b); q++ ){
+      if( *q == p || seen[*q] == stamp || !domTree.reachable(*q) ){ continue; }
+      if( hasCall[*q] ){ return true; }
+      seen[*q] = stamp;
+      work.push_back(*q);
+    }
+  }
+  return false;
+
+}
+
+static bool kills(const IFR_RoutineCode &code, const IFR_RegOps &regOps, unsigned ins, bool acrossPureCalls){
+  if( acrossPureCalls && (regOps.memFlags[ins] & IFR_INS_PURECALL) ){ return false; }
+  return IFR_Regions::endsAll(code, regOps, ins);
+}
+
+void IFR_RedundantRefs::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_DomTree &domTree,
+                                const IFR_MemRefTable &memrefs, const IFR_RegOps &regOps, const IFR_SSA &ssa,
+                                bool acrossPureCalls){
+
+  coverer.assign(memrefs.refs.size(), NoRef);
+  numCandidates = 0;
+  numRedundant = 0;
+  if( cfg.size() == 0 || !domTree.reachable(0) ){ return; }
+
+  vector<unsigned char> hasCall(cfg.size(), 0);
+  bool anyCall = false;
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      if( kills(code, regOps, in, acrossPureCalls) ){ hasCall[b] = 1; }
+    }
+    anyCall = anyCall || hasCall[b];
+  }
+
+  vector<RefEntry> table;
+  map<RefKey, unsigned> head;       //newest entry for each address
+  vector<unsigned> seen(cfg.size(), 0), work;
+  unsigned stamp = 0;
+
+  vector<RefFrame> stack;
+  RefFrame root;
+  root.block = 0;
+  root.child = 0;
+  root.entered = false;
+  root.mark = 0;
+  root.killMark = 0;
+  stack.push_back(root);
+
+  while( !stack.empty() ){
+
+    RefFrame &f = stack.back();
+
+    if( !f.entered ){
+
+      /*First visit: match and add the block's references*/
+      unsigned b = f.block;
+      if( b != 0 && anyCall && callBetween(cfg, domTree, hasCall, domTree.idom(b), b, seen, ++stamp, work) ){
+        f.killMark = table.size();
+      }
+
+      for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+
+        for( unsigned k = memrefs.begin(in); k < memrefs.end(in); k++ ){
+
+          RefKey key;
+          const IFR_MemoryRef &ref = memrefs.refs[k];
+          if( ref.size == 0 || !addressKey(ref, in, regOps, ssa, key) ){ continue; }
+          numCandidates++;
+
+          map<RefKey, unsigned>::iterator h = head.find(key);
+          unsigned prev = h == head.end() ? NoRef : h->second;
+          for( unsigned e = prev; e != NoRef && e >= f.killMark; e = table[e].prev ){
+            if( covers(memrefs.refs[ table[e].ref ], ref) ){
+              coverer[k] = table[e].ref;
+              break;
+            }
+          }
+          if( coverer[k] != NoRef ){
+            numRedundant++;
+            continue;
+          }
+
+          RefEntry entry;
+          entry.ref = k;
+          entry.key = key;
+          entry.prev = prev;
+          head[key] = table.size();
+          table.push_back(entry);
+
+        }
+
+        /*The call's own accesses (the return address) come before it*/
+        if( kills(code, regOps, in, acrossPureCalls) ){ f.killMark = table.size(); }
+
+      }
+      f.child = domTree.childBegin(b);
+      f.entered = true;
+
+    }
+
+    if( f.child != domTree.childEnd(f.block) ){
+      RefFrame kid;
+      kid.block = *f.child++;
+      kid.child = 0;
+      kid.entered = false;
+      kid.mark = table.size();
+      kid.killMark = f.killMark;
+      stack.push_back(kid);
+      continue;
+    }
+
+    /*Leaving the block: unshadow what its references hid*/
+    while( table.size() > f.mark ){
+      const RefEntry &e = table.back();
+      if( e.prev == NoRef ){
+        head.erase(e.key);
+      }else{
+        head[e.key] = e.prev;
+      }
+      table.pop_back();
+    }
+    stack.pop_back();
+
+  }
+
+}
+
+size_t IFR_RedundantRefs::bytes() const{
+  return IFR_Bytes(coverer);
+}
@@ -0,0 +1,65 @@
+#ifndef _IFR_REDUNDANTREFS_H_
+#define _IFR_REDUNDANTREFS_H_
+
+#include <vector>
+#include <map>
+#include "IFR_InsRecord.h"
+#include "IFR_MemoryRef.h"
+#include "IFR_CFG.h"
+#include "IFR_DomTree.h"
+#include "IFR_SSA.h"
+#include "IFR_Regions.h"
+
+/*Memory references whose instrumentation is redundant: every time one
+ *executes, an access to the same address, of a kind and size that covers
+ *it, has already executed with no call in between.  Synchronizing
+ *instructions and unresolved indirect jumps count as calls here, so a covering
+ *access is also still in the same IFR (see IFR_Regions).
+ *
+ *Reference d covers reference k when
+ *
+ *  - d's instruction dominates k's (d comes first within a block)
+ *  - base and index read the same SSA values and scale and displacement
+ *    are equal, so the address is the same
+ *  - d is at least as wide, and a write (MemWrite or MemBoth) unless k
+ *    only reads
+ *  - no path from d to k passes a call
+ *
+ *This is a scoped table walk of the dominator tree, in the style of
+ *dominator-based value numbering: the references available at a block
+ *are those of its dominator tree ancestors, less everything before a call
+ *that may run between the two.  References with an address register
+ *missing from IFR_RegOps (e.g. the instruction pointer) are never matched,
+ *and neither is anything of unknown size.  Segment overrides are not
+ *recorded in IFR_MemoryRef, so an fs: and gs: access with the same
+ *registers and displacement would match; neither has a register operand
+ *in practice except for TLS, where both use fs on x86-64 Linux.
+ */
+class IFR_RedundantRefs{
+
+  std::vector<unsigned> coverer;    //per memref: covering memref, or NoRef
+
+public:
+
+  static const unsigned NoRef = (unsigned)-1;
+
+  unsigned numCandidates;           //memrefs with a comparable address
+  unsigned numRedundant;
+
+  IFR_RedundantRefs();
+
+  /*With acrossPureCalls, calls marked IFR_INS_PURECALL are not kills*/
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_DomTree &domTree,
+               const IFR_MemRefTable &memrefs, const IFR_RegOps &regOps, const IFR_SSA &ssa,
+               bool acrossPureCalls);
+
+  size_t bytes() const;
+
+  bool redundant(unsigned k) const { return k < coverer.size() && coverer[k] != NoRef; }
+
+  /*The dominating memref that covers k (itself not redundant), or NoRef*/
+  unsigned coveredBy(unsigned k) const { return k < coverer.size() ? coverer[k] : NoRef; }
+
+};
+
+#endif
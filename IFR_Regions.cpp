@@ -0,0 +1,223 @@
+#include <utility>
+#include "IFR_Regions.h"
+
+using std::vector;
+
+IFR_Regions::IFR_Regions(){
+  numBoundaries = 0;
+  numEnds = 0;
+  numHoisted = 0;
+  numUnhoisted = 0;
+}
+
+bool IFR_Regions::endsAll(const IFR_RoutineCode &code, const IFR_RegOps &regOps, unsigned ins){
+
+  unsigned kind = code.ins[ins].kind;
+  return kind == InsCall || kind == InsReturn || (kind == InsIndirectJump && !code.resolved(ins)) ||
+         (regOps.memFlags[ins] & IFR_INS_SYNC) != 0;
+
+}
+
+unsigned IFR_Regions::boundary(const IFR_RoutineCode &code, const IFR_RegOps &regOps, unsigned ins){
+
+  if( endsAll(code, regOps, ins) ){ return RegionBefore; }
+
+  const IFR_InsRecord &r = code.ins[ins];
+  if( (r.kind == InsJump || r.kind == InsCondJump) && code.find(r.target) == IFR_RoutineCode::NoIns ){
+    return r.kind == InsJump ? RegionBefore : RegionTaken;
+  }
+  return RegionNone;
+
+}
+
+void IFR_Regions::compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                          const IFR_RegOps &regOps){
+  numUnhoisted = 0;
+  place(code, cfg, memrefs, regOps, vector<unsigned char>());
+}
+
+/*The may-active analysis and the ends it needs, with an end before each
+ *instruction marked in hoisted as well as at every boundary
+ */
+void IFR_Regions::place(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                        const IFR_RegOps &regOps, const vector<unsigned char> &hoisted){
+
+  ends.assign(cfg.numIns(), RegionNone);
+  numBoundaries = 0;
+  numEnds = 0;
+  numHoisted = 0;
+
+  /*Whether an IFR may be active at the end of each block*/
+  vector<unsigned char> activeIn(cfg.size(), 0), activeOut(cfg.size(), 0);
+  vector<unsigned char> queued(cfg.size(), 1);
+  vector<unsigned> work;
+  for( unsigned b = cfg.size(); b-- > 0; ){
+    work.push_back(b);
+  }
+
+  while( !work.empty() ){
+
+    unsigned b = work.back();
+    work.pop_back();
+    queued[b] = 0;
+
+    bool active = activeIn[b];
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      if( boundary(code, regOps, in) == RegionBefore || (!hoisted.empty() && hoisted[in]) ){ active = false; }
+      if( starts(code, memrefs, regOps, in) ){ active = true; }
+    }
+    if( active == (activeOut[b] != 0) ){ continue; }
+
+    activeOut[b] = active;
+    for( const unsigned *s = cfg.succBegin(b); s != cfg.succEnd(b); s++ ){
+      if( activeIn[*s] ){ continue; }
+      activeIn[*s] = 1;
+      if( !queued[*s] ){
+        queued[*s] = 1;
+        work.push_back(*s);
+      }
+    }
+
+  }
+
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    bool active = activeIn[b];
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      if( !hoisted.empty() && hoisted[in] ){
+        if( active ){
+          ends[in] = RegionBefore;
+          numHoisted++;
+        }
+        active = false;
+      }
+      unsigned where = boundary(code, regOps, in);
+      if( where != RegionNone ){
+        numBoundaries++;
+        if( active ){
+          ends[in] = where;
+          numEnds++;
+        }
+        if( where == RegionBefore ){ active = false; }
+      }
+      if( starts(code, memrefs, regOps, in) ){ active = true; }
+    }
+  }
+
+}
+
+/*Whether every block on a path from block from to block to, before it
+ *gets there, is free of accesses and boundaries.  from itself only counts
+ *if a path comes back to it.  Fails once budget blocks have been looked at.
+ */
+bool IFR_Regions::clearFrom(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                            const IFR_RegOps &regOps, unsigned from, unsigned to, vector<unsigned> &seen,
+                            unsigned stamp, unsigned &budget) const{
+
+  vector<unsigned> work(cfg.succBegin(from), cfg.succEnd(from));
+  while( !work.empty() ){
+
+    unsigned b = work.back();
+    work.pop_back();
+    if( b == to || seen[b] == stamp ){ continue; }
+    seen[b] = stamp;
+    if( budget-- == 0 ){ return false; }
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      if( boundary(code, regOps, in) != RegionNone || starts(code, memrefs, regOps, in) ){ return false; }
+    }
+    work.insert(work.end(), cfg.succBegin(b), cfg.succEnd(b));
+
+  }
+  return true;
+
+}
+
+void IFR_Regions::hoistEnds(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                            const IFR_RegOps &regOps, const IFR_DomTree &domTree, const IFR_PostDom &postDom,
+                            const IFR_LoopForest &loops){
+
+  /*Candidates: the first boundary of a loop block, with no access before
+   *it in the block, that needs an end
+   */
+  vector<unsigned char> hoisted(cfg.numIns(), 0);
+  vector< std::pair<unsigned, unsigned> > moves;    //(boundary, instruction its end went before)
+  vector<unsigned> seen(cfg.size(), 0);
+  unsigned stamp = 0;
+
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    unsigned loop = loops.innermost(b);
+    if( loop == IFR_LoopForest::NoLoop || !postDom.reachesExit(b) ){ continue; }
+
+    unsigned first = IFR_RoutineCode::NoIns;
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      if( boundary(code, regOps, in) != RegionNone ){
+        first = in;
+        break;
+      }
+      if( starts(code, memrefs, regOps, in) ){ break; }
+    }
+    if( first == IFR_RoutineCode::NoIns || ends[first] != RegionBefore ){ continue; }
+
+    /*Up the dominator tree to the first block outside the loop.  Every
+     *path from a dominator to b goes through the dominators below it, so
+     *each step only searches from the new block to the last one, which
+     *must now be clear as a whole.
+     */
+    unsigned budget = IFR_HOIST_LIMIT, below = b, to = IFR_CFG::NoBlock;
+    stamp++;
+    for( unsigned p = domTree.idom(b); p != IFR_CFG::NoBlock; p = domTree.idom(p) ){
+
+      if( !postDom.postDominates(b, p) || cfg.insEnd(p) == cfg.insBegin(p) ){ break; }
+      unsigned last = cfg.insEnd(p) - 1;
+      if( boundary(code, regOps, last) != RegionNone || starts(code, memrefs, regOps, last) ){ break; }
+      if( below != b ){
+        bool clear = true;
+        for( unsigned in = cfg.insBegin(below); in < cfg.insEnd(below) && clear; in++ ){
+          clear = boundary(code, regOps, in) == RegionNone && !starts(code, memrefs, regOps, in);
+        }
+        if( !clear ){ break; }
+      }
+      if( !clearFrom(code, cfg, memrefs, regOps, p, below, seen, stamp, budget) ){ break; }
+      if( !loops.contains(loop, p) ){
+        to = p;
+        break;
+      }
+      below = p;
+
+    }
+    if( to == IFR_CFG::NoBlock ){ continue; }
+
+    hoisted[ cfg.insEnd(to) - 1 ] = 1;
+    moves.push_back( std::make_pair(first, cfg.insEnd(to) - 1) );
+
+  }
+  if( moves.empty() ){ return; }
+
+  /*An end is only worth its check if a boundary it covers went quiet*/
+  vector<unsigned char> useful(cfg.numIns(), 0);
+  bool changed = true;
+  while( changed ){
+    place(code, cfg, memrefs, regOps, hoisted);
+    changed = false;
+    for( unsigned i = 0; i < moves.size(); i++ ){
+      if( ends[ moves[i].first ] == RegionNone ){ useful[ moves[i].second ] = 1; }
+    }
+    for( unsigned i = 0; i < moves.size(); i++ ){
+      if( hoisted[ moves[i].second ] && !useful[ moves[i].second ] ){
+        hoisted[ moves[i].second ] = 0;
+        changed = true;
+      }
+    }
+    for( unsigned i = 0; i < moves.size(); i++ ){ useful[ moves[i].second ] = 0; }
+  }
+
+  numUnhoisted = 0;
+  for( unsigned i = 0; i < moves.size(); i++ ){
+    if( ends[ moves[i].first ] == RegionNone ){ numUnhoisted++; }
+  }
+
+}
+
+size_t IFR_Regions::bytes() const{
+  return IFR_Bytes(ends);
+}
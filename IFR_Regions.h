@@ -0,0 +1,99 @@
+#ifndef _IFR_REGIONS_H_
+#define _IFR_REGIONS_H_
+
+#include <vector>
+#include "IFR_InsRecord.h"
+#include "IFR_MemoryRef.h"
+#include "IFR_CFG.h"
+#include "IFR_SSA.h"
+#include "IFR_DomTree.h"
+#include "IFR_PostDom.h"
+#include "IFR_Loops.h"
+
+/*Most blocks one hoisted end may search, so hoisting stays linear*/
+#define IFR_HOIST_LIMIT 256
+
+/*Where an instruction ends its thread's active IFRs (see
+ *IFR_ActiveTable.h)
+ */
+enum IFR_RegionEnd {
+  RegionNone = 0,
+  RegionBefore = 1,     //before it executes
+  RegionTaken = 2       //on its taken branch only
+};
+
+/*Region boundaries of a routine for the IFRit runtime.
+ *
+ *A thread's IFRs end at every call, return, unresolved indirect jump and
+ *synchronizing instruction (IFR_INS_SYNC), and on jumps out of the
+ *routine, since the analysis cannot see what happens next.  Jumps through
+ *a resolved jump table stay inside the routine.  The memory
+ *accesses of other instructions start IFRs.
+ *
+ *A boundary only needs instrumenting if some IFR may be active when it is
+ *reached: a forward may-analysis over the CFG, false at the routine entry
+ *(the call into the routine ended everything) and after each boundary,
+ *true after each access.  Blocks with no CFG predecessors are only
+ *reached through boundaries, so start out false too.
+ *
+ *hoistEnds() then moves ends out of loops.  A boundary in a loop that is
+ *only active because of IFRs started before the loop checks on every
+ *iteration; if it post-dominates a block p outside the loop, and every
+ *path from p to it is free of accesses and other boundaries, the IFRs
+ *active at p are bound to end there with nothing added in between.
+ *Ending them before p's last instruction instead (p's own accesses come
+ *first) is the same up to a few access-free instructions, and is checked
+ *once per loop entry.  An end that leaves its boundary still active is
+ *taken back.
+ */
+class IFR_Regions{
+
+  std::vector<unsigned char> ends;    //per instruction, an IFR_RegionEnd
+
+  void place(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+             const IFR_RegOps &regOps, const std::vector<unsigned char> &hoisted);
+  bool clearFrom(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                 const IFR_RegOps &regOps, unsigned from, unsigned to, std::vector<unsigned> &seen,
+                 unsigned stamp, unsigned &budget) const;
+
+public:
+
+  unsigned numBoundaries;
+  unsigned numEnds;                   //boundaries that need instrumenting
+  unsigned numHoisted;                //ends hoistEnds() added out of loops
+  unsigned numUnhoisted;              //boundaries they took the check off
+
+  IFR_Regions();
+
+  void compute(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+               const IFR_RegOps &regOps);
+
+  /*After compute(): moves ends out of loops where the boundaries
+   *post-dominate an access-free way in
+   */
+  void hoistEnds(const IFR_RoutineCode &code, const IFR_CFG &cfg, const IFR_MemRefTable &memrefs,
+                 const IFR_RegOps &regOps, const IFR_DomTree &domTree, const IFR_PostDom &postDom,
+                 const IFR_LoopForest &loops);
+
+  size_t bytes() const;
+
+  /*Where instruction ins must end IFRs (an IFR_RegionEnd)*/
+  unsigned endAt(unsigned ins) const { return ins < ends.size() ? (unsigned)ends[ins] : (unsigned)RegionNone; }
+
+  /*Whether ins is a boundary, and where, regardless of active IFRs*/
+  static unsigned boundary(const IFR_RoutineCode &code, const IFR_RegOps &regOps, unsigned ins);
+
+  /*Whether every path through ins ends every IFR*/
+  static bool endsAll(const IFR_RoutineCode &code, const IFR_RegOps &regOps, unsigned ins);
+
+  /*Whether ins's memory accesses start IFRs: those of boundaries that end
+   *every IFR (a call's push, a lock add) do not
+   */
+  static bool starts(const IFR_RoutineCode &code, const IFR_MemRefTable &memrefs, const IFR_RegOps &regOps,
+                     unsigned ins){
+    return memrefs.end(ins) > memrefs.begin(ins) && !endsAll(code, regOps, ins);
+  }
+
+};
+
+#endif
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <new>
+#include <assert.h>
+
+#include "IFR_RoutineAnalysis.h"
+#include "IFR_Serialize.h"
+#include "IFR_JumpTableMatch.h"
+
+using std::vector;
+
+#if defined(TARGET_IA32E)
+static const REG callerSaved[] = { LEVEL_BASE::REG_RAX, LEVEL_BASE::REG_RCX, LEVEL_BASE::REG_RDX,
+                                   LEVEL_BASE::REG_RSI, LEVEL_BASE::REG_RDI, LEVEL_BASE::REG_R8,
+                                   LEVEL_BASE::REG_R9, LEVEL_BASE::REG_R10, LEVEL_BASE::REG_R11,
+                                   REG_GFLAGS };
+#else
+static const REG callerSaved[] = { REG_GAX, REG_GCX, REG_GDX, REG_GFLAGS };
+#endif
+
+unsigned IFR_MemRefOfOperand(INS ins, UINT32 memOp){
+
+  UINT32 op = INS_MemoryOperandIndexToOperandIndex(ins, memOp);
+  if( !INS_OperandIsMemory(ins, op) ){ return IFR_MemoryRef::NoReg; }
+  unsigned k = 0;
+  for( UINT32 o = 0; o < op; o++ ){
+    if( INS_OperandIsMemory(ins, o) ){ k++; }
+  }
+  return k;
+
+}
+
+void IFR_PinCallABI(IFR_CallABI &abi){
+
+  abi.callerSaved.assign(callerSaved, callerSaved + sizeof(callerSaved) / sizeof(callerSaved[0]));
+  std::sort(abi.callerSaved.begin(), abi.callerSaved.end());
+  abi.stackPointer = REG_STACK_PTR;
+
+}
+
+/*Routine instruction handles and the blocks over them, in the arena.  The
+ *blocks come from cfg, so the leaders are found once, from the records.
+ */
+void findBlocks(RTN rtn, 
+                const IFR_RoutineCode &code, 
+                const IFR_CFG &cfg, 
+                IFR_Arena &arena, 
+                INS *&insns, 
+                IFR_BasicBlock *&blocks){
+
+  insns = arena.allocArray<INS>( code.ins.size() );
+  unsigned n = 0;
+  for( INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins) ){
+    assert( n < code.ins.size() && INS_Address(ins) == code.ins[n].address );
+    insns[n++] = ins;
+  }
+  assert( n == code.ins.size() );
+
+  blocks = arena.allocArray<IFR_BasicBlock>( cfg.size() );
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    new (&blocks[b]) IFR_BasicBlock();
+    blocks[b].set(code, cfg, b);
+  }
+
+}
+
+void computeMemRef(INS i, UINT32 op, IFR_MemoryRef &ref){
+
+  //assumes operand op to instruction i is a memory operation 
+  REG r = INS_OperandMemoryBaseReg( i, op );
+  ADDRDELTA d = INS_OperandMemoryDisplacement( i, op );
+  REG ind = INS_OperandMemoryIndexReg( i, op );
+  UINT32 s = INS_OperandMemoryScale( i, op );
+  ref.base = REG_valid(r) ? (unsigned)r : IFR_MemoryRef::NoReg;
+  ref.displacement = d;
+  ref.index = REG_valid(ind) ? (unsigned)ind : IFR_MemoryRef::NoReg;
+  ref.scale = s;
+  ref.size = INS_OperandWidth( i, op ) / 8;
+
+}
+
+void addMemoryReferences(INS ins, 
+                         IFR_MemRefTable &memrefs){
+
+  for( UINT32 op = 0; op < INS_OperandCount(ins); op++ ){
+
+    /*Register operands are collected by addRegisterOperands*/
+    if( INS_OperandIsMemory(ins, op) ){
+      IFR_MemoryRef ref = IFR_MemoryRef();
+      computeMemRef(ins, op, ref);
+      if( INS_OperandRead(ins, op) && INS_OperandWritten(ins, op) ){
+        ref.type = MemBoth;
+      }else if( INS_OperandWritten(ins, op) ){
+        ref.type = MemWrite;
+      }else{
+        ref.type = MemRead;
+      }
+      memrefs.refs.push_back(ref);
+    }
+
+  }
+  memrefs.refStart.push_back( memrefs.refs.size() );
+
+}
+
+void addRegisterOperands(INS ins, 
+                         IFR_RegOps &regOps){
+
+  /*Full registers each instruction reads and writes, for SSA.  The
+   *instruction pointer is left out since every instruction touches it.
+   *A call is treated as writing the caller-saved registers of the SysV
+   *ABI, as well as all of memory.
+   */
+  for( UINT32 r = 0; r < INS_MaxNumRRegs(ins); r++ ){
+    REG reg = REG_FullRegName( INS_RegR(ins, r) );
+    if( REG_valid(reg) && reg != REG_INST_PTR ){ regOps.addUse(reg); }
+  }
+
+  for( UINT32 r = 0; r < INS_MaxNumWRegs(ins); r++ ){
+    REG reg = REG_FullRegName( INS_RegW(ins, r) );
+    if( REG_valid(reg) && reg != REG_INST_PTR ){ regOps.addDef(reg); }
+  }
+
+  unsigned char flags = 0;
+  if( INS_IsMemoryRead(ins) ){ flags |= IFR_INS_MEMREAD; }
+  if( INS_IsMemoryWrite(ins) ){ flags |= IFR_INS_MEMWRITE; }
+  if( INS_IsAtomicUpdate(ins) || INS_Opcode(ins) == XED_ICLASS_MFENCE ){ flags |= IFR_INS_SYNC; }
+  if( INS_IsCall(ins) ){
+
+    flags |= IFR_INS_CALL;
+    for( unsigned r = 0; r < sizeof(callerSaved) / sizeof(callerSaved[0]); r++ ){
+      regOps.addDef(callerSaved[r]);
+    }
+
+  }
+  regOps.endIns(flags);
+
+}
+
+/*reg += delta for add/sub with an immediate, inc, dec and lea r, [r + disp]
+ *on a full register
+ */
+void addRegisterStep(INS ins, 
+                     IFR_RegOps &regOps){
+
+  if( INS_OperandCount(ins) == 0 || !INS_OperandIsReg(ins, 0) ){ return; }
+  REG reg = INS_OperandReg(ins, 0);
+  if( !REG_valid(reg) || REG_FullRegName(reg) != reg || reg == REG_INST_PTR ){ return; }
+
+  ADDRDELTA delta;
+  UINT32 op = INS_Opcode(ins);
+  if( (op == XED_ICLASS_ADD || op == XED_ICLASS_SUB) &&
+      INS_OperandCount(ins) > 1 && INS_OperandIsImmediate(ins, 1) ){
+    delta = (ADDRDELTA)INS_OperandImmediate(ins, 1);
+    if( op == XED_ICLASS_SUB ){ delta = -delta; }
+  }else if( op == XED_ICLASS_INC ){
+    delta = 1;
+  }else if( op == XED_ICLASS_DEC ){
+    delta = -1;
+  }else if( op == XED_ICLASS_LEA && INS_OperandCount(ins) > 1 && INS_OperandIsAddressGenerator(ins, 1) &&
+            INS_OperandMemoryBaseReg(ins, 1) == reg && !REG_valid( INS_OperandMemoryIndexReg(ins, 1) ) ){
+    delta = INS_OperandMemoryDisplacement(ins, 1);
+  }else{
+    return;
+  }
+  regOps.addStep(reg, delta);
+
+}
+
+IFR_InsKind insKind(INS ins){
+
+  if( INS_IsBranch(ins) ){
+    assert( !INS_IsRet(ins) );
+    if( INS_IsIndirectBranchOrCall(ins) ){ return InsIndirectJump; }
+    return INS_Category(ins) == XED_CATEGORY_UNCOND_BR ? InsJump : InsCondJump;
+  }
+  if( INS_IsCall(ins) ){ return InsCall; }
+  if( INS_IsRet(ins) ){ return InsReturn; }
+  return InsOther;
+
+}
+
+/*Read-only sections of an image, read in place*/
+class PinImageReader : public IFR_MemoryReader{
+
+  IMG img;
+
+public:
+
+  PinImageReader(IMG i) : img(i) {}
+
+  bool read(ADDRINT addr, void *buf, size_t size) const{
+
+    for( SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec) ){
+      ADDRINT start = SEC_Address(sec);
+      if( addr < start || addr - start > SEC_Size(sec) || size > SEC_Size(sec) - (addr - start) ){ continue; }
+      return SEC_IsReadable(sec) && !SEC_IsWriteable(sec) && PIN_SafeCopy(buf, (const VOID *)addr, size) == size;
+    }
+    return false;
+
+  }
+
+};
+
+/*Matches the jump-table idioms of IFR_JumpTableMatch.h ending in ins*/
+bool matchJumpTable(INS ins, IFR_JumpTableSite &site){
+
+  INS chain[IFR_JUMPTABLE_WINDOW];
+  unsigned n = 0;
+  for( INS i = ins; INS_Valid(i) && n < IFR_JUMPTABLE_WINDOW; i = INS_Prev(i) ){
+    chain[n++] = i;
+  }
+
+  const xed_decoded_inst_t *window[IFR_JUMPTABLE_WINDOW];
+  ADDRINT addrs[IFR_JUMPTABLE_WINDOW];
+  for( unsigned w = 0; w < n; w++ ){
+    window[w] = INS_XedDec( chain[n - 1 - w] );
+    addrs[w] = INS_Address( chain[n - 1 - w] );
+  }
+  return IFR_MatchJumpTable(window, addrs, n, site);
+
+}
+
+/*One walk over the routine copies out everything the other passes need*/
+void snapshotRoutine(RTN rtn, 
+                     IFR_RoutineCode &code, 
+                     IFR_MemRefTable &memrefs, 
+                     IFR_RegOps &regOps){
+
+  code.clear();
+  memrefs.clear();
+  regOps.clear();
+  vector<IFR_JumpTableSite> sites;
+  for( INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins) ){
+
+    IFR_InsKind kind = insKind(ins);
+    ADDRINT target = 0;
+    if( (kind == InsJump || kind == InsCondJump || kind == InsCall) && INS_IsDirectBranchOrCall(ins) ){
+      target = INS_DirectBranchOrCallTargetAddress(ins);
+    }
+    code.add( INS_Address(ins), INS_Size(ins), kind, target );
+    addMemoryReferences(ins, memrefs);
+    addRegisterStep(ins, regOps);
+    addRegisterOperands(ins, regOps);
+
+    IFR_JumpTableSite site;
+    site.ins = code.ins.size() - 1;
+    if( kind == InsIndirectJump && matchJumpTable(ins, site) ){ sites.push_back(site); }
+
+  }
+
+  /*Tables are resolved once the routine's instructions are all known*/
+  PinImageReader image( IMG_FindByAddress( RTN_Address(rtn) ) );
+  IFR_ResolveJumpTables(code, sites, image);
+
+}
+
+IFR_RoutineAnalysis::IFR_RoutineAnalysis(RTN rtn, ADDRINT imageBase, IFR_AnalysisCache *c, IFR_DomAlgorithm alg, IFR_Arena *a)
+  : IFR_Analysis(RTN_Address(rtn), imageBase, c, alg){
+  current = RTN_Invalid();
+  arena = a;
+  rangesPlaced = false;
+  pathsPlaced = false;
+  insns = 0;
+  blocks = 0;
+}
+
+void IFR_RoutineAnalysis::require(RTN rtn, unsigned passes){
+
+  current = rtn;
+  IFR_Analysis::require(passes);
+  if( has(IFR_PASS_RANGES) && !rangesPlaced ){ placeRanges(rtn); }
+  if( has(IFR_PASS_PATHS) && !pathsPlaced ){ placePaths(rtn); }
+  current = RTN_Invalid();
+
+}
+
+void IFR_RoutineAnalysis::placeRanges(RTN rtn){
+
+  /*The core only knows the edges are on a branch taken or a fall through;
+   *drop the references with an edge Pin cannot put a call on.
+   */
+  rangesPlaced = true;
+  unsigned n = 0;
+  for( INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins), n++ ){
+    for( unsigned e = ranges.edgeBegin(n); e < ranges.edgeEnd(n); e++ ){
+      const IFR_RangeEdge &edge = ranges.edges[e];
+      bool valid = edge.taken ? INS_IsValidForIpointTakenBranch(ins) : INS_IsValidForIpointAfter(ins);
+      if( !valid ){
+        ranges.drop(edge.strided);
+        e = ranges.edgeBegin(n) - 1;
+      }
+    }
+  }
+
+}
+
+void IFR_RoutineAnalysis::placePaths(RTN rtn){
+
+  /*Likewise for path probes, but a path profile missing one probe counts
+   *wrong paths, so the whole routine goes unprofiled
+   */
+  pathsPlaced = true;
+  unsigned n = 0;
+  for( INS ins = RTN_InsHead(rtn); INS_Valid(ins) && paths.profiled(); ins = INS_Next(ins), n++ ){
+    for( unsigned k = paths.probeBegin(n); k < paths.probeEnd(n); k++ ){
+      IFR_ProbePoint point = paths.probes[k].point;
+      if( (point == ProbeTaken && !INS_IsValidForIpointTakenBranch(ins)) ||
+          (point == ProbeFall && !INS_IsValidForIpointAfter(ins)) ){
+        paths.drop();
+        break;
+      }
+    }
+  }
+
+}
+
+void IFR_RoutineAnalysis::snapshot(RTN rtn){
+
+  tryCache();
+  if( !has(IFR_PASS_CODE) ){
+    current = rtn;
+    run(IFR_PASS_CODE);
+    current = RTN_Invalid();
+  }
+
+}
+
+void IFR_RoutineAnalysis::runFrontEnd(unsigned pass){
+
+  assert( RTN_Valid(current) && RTN_Address(current) == address );
+  if( pass == IFR_PASS_BLOCKS ){
+    assert( arena != 0 );
+    findBlocks(current, code, cfg, *arena, insns, blocks);
+  }else{
+    snapshotRoutine(current, code, memrefs, regOps);
+  }
+
+}
+
+void IFR_RoutineAnalysis::release(){
+  insns = 0;
+  blocks = 0;
+  done &= ~IFR_PASS_BLOCKS;
+}
@@ -0,0 +1,65 @@
+#ifndef _IFR_ROUTINEANALYSIS_H_
+#define _IFR_ROUTINEANALYSIS_H_
+
+#include <vector>
+#include <pin.H>
+
+#include "IFR_BasicBlock.h"
+#include "IFR_Arena.h"
+#include "IFR_Analysis.h"
+
+/*Pin front end for IFR_Analysis: reads a routine's instructions through
+ *the instrumentation API.
+ *
+ *require() must be called with the routine open.  The BLOCKS pass puts
+ *the INS handles and blocks in arena, since they are meaningless once the
+ *routine is closed; release() drops them before the caller closes the
+ *routine and resets the arena.  The other results stay valid.  Strided
+ *references whose loop edges Pin cannot instrument are dropped from
+ *ranges the first time require() sees it, and likewise the path profile
+ *when one of its probes cannot be placed.
+ *
+ *To analyze on another thread, call snapshot() with the routine open,
+ *which copies out the instructions (or loads the cache), then compute()
+ *from any thread.
+ */
+class IFR_RoutineAnalysis : public IFR_Analysis{
+
+  RTN current;      //the open routine during require() and snapshot()
+  IFR_Arena *arena;
+  bool rangesPlaced;
+  bool pathsPlaced;
+
+  void placeRanges(RTN rtn);
+  void placePaths(RTN rtn);
+
+protected:
+
+  void runFrontEnd(unsigned pass);
+
+public:
+
+  /*After IFR_PASS_BLOCKS: insns[i] is routine instruction i, blocks[b] is
+   *block b of cfg
+   */
+  INS *insns;
+  IFR_BasicBlock *blocks;
+
+  /*cache may be null; a is only needed for IFR_PASS_BLOCKS*/
+  IFR_RoutineAnalysis(RTN rtn, ADDRINT imageBase, IFR_AnalysisCache *c, IFR_DomAlgorithm alg, IFR_Arena *a);
+
+  void require(RTN rtn, unsigned passes);
+  void snapshot(RTN rtn);
+  void release();
+
+};
+
+/*Number of Pin memory operand memOp of ins among the instruction's memrefs
+ *(which are its memory operands in operand order), or IFR_MemoryRef::NoReg
+ */
+unsigned IFR_MemRefOfOperand(INS ins, UINT32 memOp);
+
+/*The calling convention the front end assumes at calls, for IFR_CallGraph*/
+void IFR_PinCallABI(IFR_CallABI &abi);
+
+#endif
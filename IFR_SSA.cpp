@@ -0,0 +1,499 @@
+#include <algorithm>
+#include "IFR_SSA.h"
+
+using std::vector;
+
+const unsigned IFR_RegOps::NoReg;
+const unsigned IFR_SSA::NoValue;
+const unsigned IFR_SSA::NoIns;
+
+IFR_RegOps::IFR_RegOps(){
+  clear();
+}
+
+void IFR_RegOps::clear(){
+
+  denseOf.clear();
+  names.clear();
+  uses.clear();
+  useStart.assign(1, 0);
+  defs.clear();
+  defStart.assign(1, 0);
+  memFlags.clear();
+  stepIns.clear();
+  stepReg.clear();
+  stepDelta.clear();
+
+}
+
+unsigned IFR_RegOps::intern(unsigned machineReg){
+
+  if( machineReg >= denseOf.size() ){
+    denseOf.resize(machineReg + 1, 0);
+  }
+  if( denseOf[machineReg] == 0 ){
+    names.push_back(machineReg);
+    denseOf[machineReg] = names.size();
+  }
+  return denseOf[machineReg] - 1;
+
+}
+
+unsigned IFR_RegOps::lookup(unsigned machineReg) const{
+
+  if( machineReg >= denseOf.size() || denseOf[machineReg] == 0 ){ return NoReg; }
+  return denseOf[machineReg] - 1;
+
+}
+
+void IFR_RegOps::addUse(unsigned machineReg){
+
+  unsigned r = intern(machineReg);
+  for( unsigned u = useStart.back(); u < uses.size(); u++ ){
+    if( uses[u] == r ){ return; }
+  }
+  uses.push_back(r);
+
+}
+
+void IFR_RegOps::addDef(unsigned machineReg){
+
+  unsigned r = intern(machineReg);
+  for( unsigned d = defStart.back(); d < defs.size(); d++ ){
+    if( defs[d] == r ){ return; }
+  }
+  defs.push_back(r);
+
+}
+
+void IFR_RegOps::addStep(unsigned machineReg, ADDRDELTA delta){
+
+  addUse(machineReg);
+  addDef(machineReg);
+  stepIns.push_back( memFlags.size() );
+  stepReg.push_back( intern(machineReg) );
+  stepDelta.push_back(delta);
+
+}
+
+void IFR_RegOps::dropDefs(const vector<unsigned char> &drop){
+
+  /*defStart[i + 1] is still the old value when instruction i is done*/
+  unsigned kept = 0;
+  for( unsigned i = 0; i + 1 < defStart.size(); i++ ){
+    unsigned begin = defStart[i];
+    defStart[i] = kept;
+    for( unsigned d = begin; d < defStart[i + 1]; d++ ){
+      ADDRDELTA delta;
+      if( d < drop.size() && drop[d] && !step(i, defs[d], delta) ){ continue; }
+      defs[kept++] = defs[d];
+    }
+  }
+  defs.resize(kept);
+  defStart.back() = kept;
+
+}
+
+bool IFR_RegOps::step(unsigned ins, unsigned reg, ADDRDELTA &delta) const{
+
+  vector<unsigned>::const_iterator s = std::lower_bound(stepIns.begin(), stepIns.end(), ins);
+  for( ; s != stepIns.end() && *s == ins; s++ ){
+    unsigned k = s - stepIns.begin();
+    if( stepReg[k] == reg ){
+      delta = stepDelta[k];
+      return true;
+    }
+  }
+  return false;
+
+}
+
+void IFR_RegOps::endIns(unsigned char flags){
+
+  useStart.push_back(uses.size());
+  defStart.push_back(defs.size());
+  memFlags.push_back(flags);
+
+}
+
+void IFR_RegOps::save(IFR_BlobWriter &w) const{
+
+  w.putWords(names);
+  w.putWords(uses);
+  w.putWords(useStart);
+  w.putWords(defs);
+  w.putWords(defStart);
+  vector<unsigned> flags(memFlags.begin(), memFlags.end());
+  w.putWords(flags);
+  w.putWords(stepIns);
+  w.putWords(stepReg);
+  for( unsigned k = 0; k < stepDelta.size(); k++ ){
+    w.putWide( (UINT64)stepDelta[k] );
+  }
+
+}
+
+bool IFR_RegOps::load(IFR_BlobReader &r){
+
+  clear();
+  vector<unsigned> machine, flags;
+  r.getWords(machine);
+  for( unsigned i = 0; i < machine.size(); i++ ){
+    intern(machine[i]);
+  }
+  r.getWords(uses);
+  r.getWords(useStart);
+  r.getWords(defs);
+  r.getWords(defStart);
+  r.getWords(flags);
+  memFlags.assign(flags.begin(), flags.end());
+  r.getWords(stepIns);
+  r.getWords(stepReg);
+  for( unsigned k = 0; r.ok() && k < stepIns.size(); k++ ){
+    stepDelta.push_back( (ADDRDELTA)r.getWide() );
+  }
+
+  bool stepsOk = stepReg.size() == stepIns.size();
+  for( unsigned k = 0; stepsOk && k < stepIns.size(); k++ ){
+    stepsOk = stepIns[k] < memFlags.size() && stepReg[k] < names.size() &&
+              (k == 0 || stepIns[k - 1] <= stepIns[k]);
+  }
+
+  if( !r.ok() || !stepsOk || names.size() != machine.size() || useStart.size() != memFlags.size() + 1 ||
+      defStart.size() != memFlags.size() + 1 || !IFR_ValidStarts(useStart, uses.size()) ||
+      !IFR_ValidStarts(defStart, defs.size()) || !IFR_ValidIndices(uses, names.size()) ||
+      !IFR_ValidIndices(defs, names.size()) ){
+    clear();
+    return false;
+  }
+  return true;
+
+}
+
+static bool readsHeap(unsigned char flags){
+  return (flags & (IFR_INS_MEMREAD | IFR_INS_CALL)) != 0;
+}
+
+static bool writesHeap(unsigned char flags){
+  return (flags & (IFR_INS_MEMWRITE | IFR_INS_CALL)) != 0;
+}
+
+IFR_SSA::IFR_SSA(){
+  nVars = 1;
+}
+
+unsigned IFR_SSA::newValue(IFR_SSAKind kind, unsigned var, unsigned block, unsigned ins){
+
+  IFR_SSAValue v;
+  v.kind = kind;
+  v.var = var;
+  v.block = block;
+  v.ins = ins;
+  values.push_back(v);
+  return values.size() - 1;
+
+}
+
+void IFR_SSA::build(const IFR_CFG &cfg, const IFR_DomTree &domTree,
+                    const IFR_DomFrontiers &df, const IFR_RegOps &ops){
+
+  nVars = ops.numRegs() + 1;
+  values.clear();
+  liveIn.resize(nVars);
+  for( unsigned v = 0; v < nVars; v++ ){
+    liveIn[v] = newValue(SSALiveIn, v, 0, NoIns);
+  }
+
+  unsigned nIns = ops.numIns();
+  useDef.assign(ops.uses.size(), NoValue);
+  defValue.assign(ops.defs.size(), NoValue);
+  heapUse.assign(nIns, NoValue);
+  heapDef.assign(nIns, NoValue);
+  useIns.resize(ops.uses.size());
+  for( unsigned i = 0; i < nIns; i++ ){
+    for( unsigned u = ops.useStart[i]; u < ops.useStart[i + 1]; u++ ){
+      useIns[u] = i;
+    }
+  }
+
+  placePhis(cfg, domTree, df, ops);
+  rename(cfg, domTree, ops);
+  buildUsers();
+
+}
+
+void IFR_SSA::placePhis(const IFR_CFG &cfg, const IFR_DomTree &domTree,
+                        const IFR_DomFrontiers &df, const IFR_RegOps &ops){
+
+  unsigned n = cfg.size();
+  unsigned heap = heapVar();
+
+  /*One pass over the code finds the variables read before being written
+   *in some block (the only ones that need phis) and each variable's def
+   *blocks, as (var, block) pairs bucketed by var.
+   */
+  vector<bool> global(nVars, false);
+  vector<unsigned> killedIn(nVars, IFR_CFG::NoBlock);
+  vector<unsigned> lastDefBlock(nVars, IFR_CFG::NoBlock);
+  vector<unsigned> defBlockStart(nVars + 1, 0);
+  vector<unsigned> defPairs;
+  for( unsigned b = 0; b < n; b++ ){
+
+    for( unsigned i = cfg.insBegin(b); i < cfg.insEnd(b); i++ ){
+
+      for( unsigned u = ops.useStart[i]; u < ops.useStart[i + 1]; u++ ){
+        if( killedIn[ ops.uses[u] ] != b ){ global[ ops.uses[u] ] = true; }
+      }
+      if( readsHeap(ops.memFlags[i]) && killedIn[heap] != b ){
+        global[heap] = true;
+      }
+
+      unsigned nd = ops.defStart[i + 1] - ops.defStart[i];
+      for( unsigned k = 0; k <= nd; k++ ){
+        unsigned var;
+        if( k < nd ){
+          var = ops.defs[ ops.defStart[i] + k ];
+        }else if( writesHeap(ops.memFlags[i]) ){
+          var = heap;
+        }else{
+          break;
+        }
+        killedIn[var] = b;
+        if( lastDefBlock[var] != b ){
+          lastDefBlock[var] = b;
+          defPairs.push_back(var);
+          defPairs.push_back(b);
+          defBlockStart[var + 1]++;
+        }
+      }
+
+    }
+
+  }
+
+  for( unsigned v = 0; v < nVars; v++ ){
+    defBlockStart[v + 1] += defBlockStart[v];
+  }
+  vector<unsigned> defBlocks(defPairs.size() / 2);
+  vector<unsigned> fill(defBlockStart.begin(), defBlockStart.end() - 1);
+  for( unsigned p = 0; p < defPairs.size(); p += 2 ){
+    defBlocks[ fill[ defPairs[p] ]++ ] = defPairs[p + 1];
+  }
+
+  /*DF+ of each global variable's def blocks gives its phi blocks*/
+  IFR_IDF idf;
+  idf.init(cfg, domTree, &df);
+  vector<unsigned> defs;
+  vector<unsigned> phiBlocks;
+  vector<unsigned> phiPairs;      //(block, var)
+  phiStart.assign(n + 1, 0);
+  for( unsigned v = 0; v < nVars; v++ ){
+
+    if( !global[v] ){ continue; }
+    defs.assign(defBlocks.begin() + defBlockStart[v], defBlocks.begin() + defBlockStart[v + 1]);
+    phiBlocks.clear();
+    idf.compute(defs, phiBlocks);
+    for( unsigned p = 0; p < phiBlocks.size(); p++ ){
+      phiPairs.push_back(phiBlocks[p]);
+      phiPairs.push_back(v);
+      phiStart[ phiBlocks[p] + 1 ]++;
+    }
+
+  }
+
+  for( unsigned b = 0; b < n; b++ ){
+    phiStart[b + 1] += phiStart[b];
+  }
+  phiList.resize(phiPairs.size() / 2);
+  fill.assign(phiStart.begin(), phiStart.end() - 1);
+  for( unsigned p = 0; p < phiPairs.size(); p += 2 ){
+    phiList[ fill[ phiPairs[p] ]++ ] = phiPairs[p + 1];  //var for now
+  }
+
+  /*Turn the vars into phi values and lay out one argument slot per
+   *predecessor.
+   */
+  phiArgStart.resize(phiList.size() + 1);
+  phiArgStart[0] = 0;
+  argPhi.clear();
+  for( unsigned b = 0; b < n; b++ ){
+    for( unsigned p = phiStart[b]; p < phiStart[b + 1]; p++ ){
+      phiList[p] = newValue(SSAPhi, phiList[p], b, NoIns);
+      phiArgStart[p + 1] = phiArgStart[p] + cfg.numPreds(b);
+      argPhi.insert(argPhi.end(), cfg.numPreds(b), phiList[p]);
+    }
+  }
+  phiArgs.assign(phiArgStart.back(), NoValue);
+
+}
+
+void IFR_SSA::rename(const IFR_CFG &cfg, const IFR_DomTree &domTree, const IFR_RegOps &ops){
+
+  if( cfg.size() == 0 ){ return; }
+
+  unsigned heap = heapVar();
+
+  /*cur holds the reaching value of every variable; each push is logged as
+   *(var, previous value) and undone when the walk leaves the block's
+   *dominator subtree.
+   */
+  vector<unsigned> cur(liveIn.begin(), liveIn.end());
+  vector<unsigned> undo;
+  vector<unsigned> stack;
+  vector<unsigned> mark;
+  vector<const unsigned *> child;
+
+  stack.push_back(0);
+  mark.push_back(0);
+  child.push_back(0);
+  bool entering = true;
+  while( !stack.empty() ){
+
+    unsigned b = stack.back();
+
+    if( entering ){
+
+      mark.back() = undo.size();
+
+      for( unsigned p = phiStart[b]; p < phiStart[b + 1]; p++ ){
+        unsigned var = values[ phiList[p] ].var;
+        undo.push_back(var);
+        undo.push_back(cur[var]);
+        cur[var] = phiList[p];
+      }
+
+      for( unsigned i = cfg.insBegin(b); i < cfg.insEnd(b); i++ ){
+
+        for( unsigned u = ops.useStart[i]; u < ops.useStart[i + 1]; u++ ){
+          useDef[u] = cur[ ops.uses[u] ];
+        }
+        if( readsHeap(ops.memFlags[i]) ){
+          heapUse[i] = cur[heap];
+        }
+
+        for( unsigned d = ops.defStart[i]; d < ops.defStart[i + 1]; d++ ){
+          unsigned var = ops.defs[d];
+          defValue[d] = newValue(SSADef, var, b, i);
+          undo.push_back(var);
+          undo.push_back(cur[var]);
+          cur[var] = defValue[d];
+        }
+        if( writesHeap(ops.memFlags[i]) ){
+          heapDef[i] = newValue(SSADef, heap, b, i);
+          undo.push_back(heap);
+          undo.push_back(cur[heap]);
+          cur[heap] = heapDef[i];
+        }
+
+      }
+
+      /*Fill this block's slot in each successor's phis*/
+      for( const unsigned *s = cfg.succBegin(b); s != cfg.succEnd(b); s++ ){
+        unsigned slot = std::lower_bound(cfg.predBegin(*s), cfg.predEnd(*s), b) - cfg.predBegin(*s);
+        for( unsigned p = phiStart[*s]; p < phiStart[*s + 1]; p++ ){
+          phiArgs[ phiArgStart[p] + slot ] = cur[ values[ phiList[p] ].var ];
+        }
+      }
+
+      child.back() = domTree.childBegin(b);
+      entering = false;
+
+    }
+
+    if( child.back() != domTree.childEnd(b) ){
+
+      unsigned c = *(child.back()++);
+      stack.push_back(c);
+      mark.push_back(0);
+      child.push_back(0);
+      entering = true;
+
+    }else{
+
+      while( undo.size() > mark.back() ){
+        unsigned prev = undo.back();
+        undo.pop_back();
+        cur[ undo.back() ] = prev;
+        undo.pop_back();
+      }
+      stack.pop_back();
+      mark.pop_back();
+      child.pop_back();
+
+    }
+
+  }
+
+}
+
+void IFR_SSA::buildUsers(){
+
+  unsigned nUses = useDef.size();
+  unsigned nArgs = phiArgs.size();
+
+  userStart.assign(values.size() + 1, 0);
+  for( unsigned u = 0; u < nUses; u++ ){
+    if( useDef[u] != NoValue ){ userStart[ useDef[u] + 1 ]++; }
+  }
+  for( unsigned a = 0; a < nArgs; a++ ){
+    if( phiArgs[a] != NoValue ){ userStart[ phiArgs[a] + 1 ]++; }
+  }
+  for( unsigned i = 0; i < heapUse.size(); i++ ){
+    if( heapUse[i] != NoValue ){ userStart[ heapUse[i] + 1 ]++; }
+  }
+  for( unsigned v = 0; v < values.size(); v++ ){
+    userStart[v + 1] += userStart[v];
+  }
+
+  users.resize(userStart.back());
+  vector<unsigned> fill(userStart.begin(), userStart.end() - 1);
+  for( unsigned u = 0; u < nUses; u++ ){
+    if( useDef[u] != NoValue ){ users[ fill[ useDef[u] ]++ ] = u; }
+  }
+  for( unsigned a = 0; a < nArgs; a++ ){
+    if( phiArgs[a] != NoValue ){ users[ fill[ phiArgs[a] ]++ ] = nUses + a; }
+  }
+  for( unsigned i = 0; i < heapUse.size(); i++ ){
+    if( heapUse[i] != NoValue ){ users[ fill[ heapUse[i] ]++ ] = nUses + nArgs + i; }
+  }
+
+}
+
+unsigned IFR_SSA::reachingDef(const IFR_RegOps &ops, unsigned ins, unsigned reg) const{
+
+  for( unsigned u = ops.useStart[ins]; u < ops.useStart[ins + 1]; u++ ){
+    if( ops.uses[u] == reg ){ return useDef[u]; }
+  }
+  return NoValue;
+
+}
+
+size_t IFR_RegOps::bytes() const{
+  return IFR_Bytes(denseOf) +
+         IFR_Bytes(names) +
+         IFR_Bytes(uses) +
+         IFR_Bytes(useStart) +
+         IFR_Bytes(defs) +
+         IFR_Bytes(defStart) +
+         IFR_Bytes(memFlags) +
+         IFR_Bytes(stepIns) +
+         IFR_Bytes(stepReg) +
+         IFR_Bytes(stepDelta);
+}
+
+size_t IFR_SSA::bytes() const{
+  return IFR_Bytes(values) +
+         IFR_Bytes(liveIn) +
+         IFR_Bytes(phiStart) +
+         IFR_Bytes(phiList) +
+         IFR_Bytes(phiArgStart) +
+         IFR_Bytes(phiArgs) +
+         IFR_Bytes(argPhi) +
+         IFR_Bytes(useIns) +
+         IFR_Bytes(userStart) +
+         IFR_Bytes(users) +
+         IFR_Bytes(useDef) +
+         IFR_Bytes(heapUse) +
+         IFR_Bytes(heapDef) +
+         IFR_Bytes(defValue);
+}
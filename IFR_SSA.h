@@ -0,0 +1,176 @@
+#ifndef _IFR_SSA_H_
+#define _IFR_SSA_H_
+
+#include <vector>
+#include "IFR_CFG.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+
+/*Flags describing an instruction's effect on memory*/
+#define IFR_INS_MEMREAD  0x1
+#define IFR_INS_MEMWRITE 0x2
+#define IFR_INS_CALL     0x4   //reads and clobbers all of memory
+#define IFR_INS_SYNC     0x8   //atomic update or fence
+#define IFR_INS_PURECALL 0x10  //call whose callees neither synchronize nor touch non-stack memory
+
+/*Registers read and written by every routine instruction (numbered as in
+ *IFR_CFG::insBegin), plus its memory effect.  Machine registers are
+ *interned to dense ids 0..numRegs()-1 so per-register tables stay small;
+ *regName() maps them back.
+ *
+ *Fill with addUse / addDef calls followed by endIns for every instruction,
+ *in routine order.
+ *
+ *Instructions that only add a constant to a full register (add/sub/inc/dec
+ *with an immediate, lea r, [r + disp]) also record it with addStep, for
+ *induction variable recognition.  Steps are kept sparse, sorted by
+ *instruction.
+ */
+class IFR_RegOps{
+
+  std::vector<unsigned> denseOf;      //machine register -> dense id + 1, 0 if unseen
+  std::vector<unsigned> names;        //dense id -> machine register
+
+public:
+
+  std::vector<unsigned> uses;         //dense ids; instruction i's are uses[useStart[i]..useStart[i+1])
+  std::vector<unsigned> useStart;
+  std::vector<unsigned> defs;
+  std::vector<unsigned> defStart;
+  std::vector<unsigned char> memFlags;
+
+  std::vector<unsigned> stepIns;
+  std::vector<unsigned> stepReg;      //dense id
+  std::vector<ADDRDELTA> stepDelta;
+
+  static const unsigned NoReg = (unsigned)-1;
+
+  IFR_RegOps();
+
+  void clear();
+  unsigned intern(unsigned machineReg);
+  unsigned lookup(unsigned machineReg) const;   //dense id, or NoReg
+  void addUse(unsigned machineReg);
+  void addDef(unsigned machineReg);
+  void addStep(unsigned machineReg, ADDRDELTA delta);   //reg += delta; also a use and def
+  void endIns(unsigned char flags);
+
+  /*Removes the def slots d with drop[d] set (e.g. registers a callee's
+   *summary shows it leaves alone); defs of steps are never dropped
+   */
+  void dropDefs(const std::vector<unsigned char> &drop);
+
+  /*Whether instruction ins adds a constant to dense register reg, and how much*/
+  bool step(unsigned ins, unsigned reg, ADDRDELTA &delta) const;
+
+  void save(IFR_BlobWriter &w) const;
+  bool load(IFR_BlobReader &r);
+
+  size_t bytes() const;
+
+  unsigned numIns() const { return memFlags.size(); }
+  unsigned numRegs() const { return names.size(); }
+  unsigned regName(unsigned dense) const { return names[dense]; }
+
+};
+
+/*Kinds of SSA value*/
+enum IFR_SSAKind { SSALiveIn = 0, SSADef = 1, SSAPhi = 2 };
+
+class IFR_SSAValue{
+
+public:
+
+  IFR_SSAKind kind;
+  unsigned var;       //dense register id, or IFR_SSA::heapVar() for memory
+  unsigned block;     //defining block (entry block for live-ins)
+  unsigned ins;       //defining instruction for SSADef, else IFR_SSA::NoIns
+
+};
+
+/*SSA form for a routine's registers, with memory versioned as one extra
+ *"heap" variable in the style of memory SSA: every instruction that writes
+ *memory (and every call) defines a new heap value, and every memory read
+ *uses the current one.
+ *
+ *Phis are placed semi-pruned (Briggs et al.): only variables that are
+ *live into some block get them, at DF+ of their definition blocks.
+ *Renaming is a single iterative walk of the dominator tree.  The results
+ *are read-only tables:
+ *
+ *  useDef[u]        value reaching use slot u of IFR_RegOps::uses
+ *  heapUse[i]       heap value read by instruction i (NoValue if none)
+ *  heapDef[i]       heap value defined by instruction i (NoValue if none)
+ *  phis of block b  phiList[phiStart[b]..phiStart[b+1])
+ *  phi arguments    one per CFG predecessor, in predecessor order
+ *  defValue[d]      value created by def slot d of IFR_RegOps::defs
+ *  users of value v def-use chain over register uses, phi arguments and
+ *                   heap reads
+ */
+class IFR_SSA{
+
+  unsigned nVars;                     //registers + heap
+
+  std::vector<IFR_SSAValue> values;
+  std::vector<unsigned> liveIn;       //live-in value of each variable
+
+  std::vector<unsigned> phiStart;
+  std::vector<unsigned> phiList;
+  std::vector<unsigned> phiArgStart;  //indexed by position in phiList
+  std::vector<unsigned> phiArgs;
+  std::vector<unsigned> argPhi;       //phi value owning each argument slot
+
+  std::vector<unsigned> useIns;       //instruction of each use slot
+  std::vector<unsigned> userStart;
+  std::vector<unsigned> users;        //use slot, or phi argument slot + numUseSlots,
+                                      //or instruction + numUseSlots + numArgSlots for heap reads
+
+  unsigned newValue(IFR_SSAKind kind, unsigned var, unsigned block, unsigned ins);
+  void placePhis(const IFR_CFG &cfg, const IFR_DomTree &domTree,
+                 const IFR_DomFrontiers &df, const IFR_RegOps &ops);
+  void rename(const IFR_CFG &cfg, const IFR_DomTree &domTree, const IFR_RegOps &ops);
+  void buildUsers();
+
+public:
+
+  static const unsigned NoValue = (unsigned)-1;
+  static const unsigned NoIns = (unsigned)-1;
+
+  std::vector<unsigned> useDef;
+  std::vector<unsigned> heapUse;
+  std::vector<unsigned> heapDef;
+  std::vector<unsigned> defValue;
+
+  IFR_SSA();
+
+  void build(const IFR_CFG &cfg, const IFR_DomTree &domTree,
+             const IFR_DomFrontiers &df, const IFR_RegOps &ops);
+
+  size_t bytes() const;
+
+  unsigned heapVar() const { return nVars - 1; }
+  unsigned numValues() const { return values.size(); }
+  const IFR_SSAValue &value(unsigned v) const { return values[v]; }
+
+  /*Value of dense register reg read by instruction ins, or NoValue if ins
+   *does not read it.
+   */
+  unsigned reachingDef(const IFR_RegOps &ops, unsigned ins, unsigned reg) const;
+
+  unsigned numPhis(unsigned b) const { return phiStart[b + 1] - phiStart[b]; }
+  unsigned phi(unsigned b, unsigned i) const { return phiList[ phiStart[b] + i ]; }
+  unsigned phiArg(unsigned b, unsigned i, unsigned pred) const {
+    return phiArgs[ phiArgStart[ phiStart[b] + i ] + pred ];
+  }
+
+  unsigned numUsers(unsigned v) const { return userStart[v + 1] - userStart[v]; }
+  unsigned user(unsigned v, unsigned i) const { return users[ userStart[v] + i ]; }
+  bool userIsPhi(unsigned u) const { return u >= useIns.size() && u - useIns.size() < argPhi.size(); }
+  unsigned userPhi(unsigned u) const { return argPhi[ u - useIns.size() ]; }
+  unsigned userIns(unsigned u) const {
+    return u < useIns.size() ? useIns[u] : u - useIns.size() - argPhi.size();
+  }
+
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "IFR_Serialize.h"
+
+using std::vector;
+
+void IFR_BlobWriter::putWord(UINT32 w){
+
+  bytes.push_back( w & 0xff );
+  bytes.push_back( (w >> 8) & 0xff );
+  bytes.push_back( (w >> 16) & 0xff );
+  bytes.push_back( (w >> 24) & 0xff );
+
+}
+
+void IFR_BlobWriter::putWide(UINT64 w){
+  putWord( (UINT32)w );
+  putWord( (UINT32)(w >> 32) );
+}
+
+void IFR_BlobWriter::putWords(const vector<unsigned> &v){
+
+  putWord( v.size() );
+  size_t at = bytes.size();
+  bytes.resize( at + 4 * v.size() );
+  for( size_t i = 0; i < v.size(); i++ ){
+    bytes[at++] = v[i] & 0xff;
+    bytes[at++] = (v[i] >> 8) & 0xff;
+    bytes[at++] = (v[i] >> 16) & 0xff;
+    bytes[at++] = (v[i] >> 24) & 0xff;
+  }
+
+}
+
+IFR_BlobReader::IFR_BlobReader(const unsigned char *data, size_t size){
+  cur = data;
+  end = data + size;
+  good = true;
+}
+
+UINT32 IFR_BlobReader::getWord(){
+
+  if( !good || end - cur < 4 ){
+    good = false;
+    return 0;
+  }
+  UINT32 w = cur[0] | (cur[1] << 8) | (cur[2] << 16) | ((UINT32)cur[3] << 24);
+  cur += 4;
+  return w;
+
+}
+
+UINT64 IFR_BlobReader::getWide(){
+  UINT64 lo = getWord();
+  UINT64 hi = getWord();
+  return lo | (hi << 32);
+}
+
+void IFR_BlobReader::getWords(vector<unsigned> &v){
+
+  UINT32 n = getWord();
+  if( !good || (size_t)(end - cur) / 4 < n ){
+    good = false;
+    v.clear();
+    return;
+  }
+  v.resize(n);
+  for( UINT32 i = 0; i < n; i++ ){
+    v[i] = cur[0] | (cur[1] << 8) | (cur[2] << 16) | ((UINT32)cur[3] << 24);
+    cur += 4;
+  }
+
+}
+
+bool IFR_ValidStarts(const vector<unsigned> &starts, size_t count){
+
+  if( starts.empty() || starts[0] != 0 || starts.back() != count ){ return false; }
+  for( unsigned i = 1; i < starts.size(); i++ ){
+    if( starts[i] < starts[i - 1] ){ return false; }
+  }
+  return true;
+
+}
+
+bool IFR_ValidIndices(const vector<unsigned> &v, unsigned n){
+
+  for( unsigned i = 0; i < v.size(); i++ ){
+    if( v[i] >= n ){ return false; }
+  }
+  return true;
+
+}
@@ -0,0 +1,51 @@
+#ifndef _IFR_SERIALIZE_H_
+#define _IFR_SERIALIZE_H_
+
+#include <vector>
+#include <string.h>
+#include "IFR_Types.h"
+
+/*Flat little-endian byte blobs for the analysis cache.  Everything is
+ *written as 32-bit words or word arrays with a length prefix, so a blob
+ *can be read straight out of a memory-mapped file.
+ */
+class IFR_BlobWriter{
+
+public:
+
+  std::vector<unsigned char> bytes;
+
+  void putWord(UINT32 w);
+  void putWide(UINT64 w);
+  void putWords(const std::vector<unsigned> &v);
+
+};
+
+/*Reads from memory it does not own.  Any overrun clears ok() and makes
+ *every later read return zeros, so callers check once at the end.
+ */
+class IFR_BlobReader{
+
+  const unsigned char *cur;
+  const unsigned char *end;
+  bool good;
+
+public:
+
+  IFR_BlobReader(const unsigned char *data, size_t size);
+
+  bool ok() const { return good; }
+  UINT32 getWord();
+  UINT64 getWide();
+  void getWords(std::vector<unsigned> &v);
+
+};
+
+/*Checks on arrays read back from a blob, before anything indexes with
+ *them: starts must run from 0 to count without decreasing, and every
+ *index must be below n
+ */
+bool IFR_ValidStarts(const std::vector<unsigned> &starts, size_t count);
+bool IFR_ValidIndices(const std::vector<unsigned> &v, unsigned n);
+
+#endif
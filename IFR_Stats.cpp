@@ -0,0 +1,162 @@
+#include <string.h>
+
+#include "IFR_Stats.h"
+
+using std::string;
+using std::vector;
+
+static const char *passNames[IFR_NUM_PASSES] = {
+  "code", "cfg", "blocks", "domtree", "df", "ssa", "loops", "ranges", "redundant", "regions",
+  "liveness", "coalesce", "postdom", "hoistends", "paths"
+};
+
+const unsigned IFR_Histogram::NumBuckets;
+
+IFR_RoutineProfile::IFR_RoutineProfile(){
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+    passTime[p] = 0;
+    passBytes[p] = 0;
+  }
+  ran = 0;
+  cacheTime = 0;
+  domIterations = 0;
+}
+
+double IFR_RoutineProfile::total() const{
+  double t = cacheTime;
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+    t += passTime[p];
+  }
+  return t;
+}
+
+IFR_Histogram::IFR_Histogram(){
+  memset(buckets, 0, sizeof(buckets));
+  count = 0;
+  sum = 0;
+  max = 0;
+}
+
+void IFR_Histogram::add(UINT64 v){
+
+  unsigned k = 0;
+  while( k + 1 < NumBuckets && (v >> k) != 0 ){ k++; }
+  buckets[k]++;
+  count++;
+  sum += v;
+  if( v > max ){ max = v; }
+
+}
+
+void IFR_Histogram::print(FILE *out, const char *title, const char *unit) const{
+
+  if( count == 0 ){ return; }
+  fprintf(out, "IFR stats: %s: %u routines, mean %.1f, max %llu %s\n", title, count,
+          (double)sum / count, (unsigned long long)max, unit);
+
+  unsigned fullest = 0;
+  for( unsigned k = 0; k < NumBuckets; k++ ){
+    if( buckets[k] > fullest ){ fullest = buckets[k]; }
+  }
+  for( unsigned k = 0; k < NumBuckets; k++ ){
+
+    if( buckets[k] == 0 ){ continue; }
+    unsigned long long lo = k == 0 ? 0 : 1ULL << (k - 1);
+    unsigned long long hi = k == 0 ? 0 : (1ULL << k) - 1;
+    char bar[41];
+    unsigned len = (unsigned)((UINT64)buckets[k] * 40 / fullest);
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    fprintf(out, "IFR stats:   %10llu - %-10llu %8u %s\n", lo, hi, buckets[k], bar);
+
+  }
+
+}
+
+IFR_StatsTable::IFR_StatsTable(unsigned slowestToKeep){
+
+  topN = slowestToKeep;
+  routines = 0;
+  totalTime = 0;
+  cacheTime = 0;
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+    passTime[p] = 0;
+    passMax[p] = 0;
+    passBytes[p] = 0;
+    passRuns[p] = 0;
+  }
+
+}
+
+void IFR_StatsTable::add(const string &name, const IFR_Analysis &a, double time){
+
+  const IFR_RoutineProfile &prof = *a.profile;
+  routines++;
+  totalTime += time;
+  cacheTime += prof.cacheTime;
+
+  UINT64 bytes = 0;
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+    if( (prof.ran & (1u << p)) == 0 ){ continue; }
+    passTime[p] += prof.passTime[p];
+    if( prof.passTime[p] > passMax[p] ){ passMax[p] = prof.passTime[p]; }
+    passBytes[p] += prof.passBytes[p];
+    passRuns[p]++;
+    bytes += prof.passBytes[p];
+  }
+
+  timeHist.add( (UINT64)(time * 1e6) );
+  insHist.add( a.code.ins.size() );
+  if( a.has(IFR_PASS_CFG) ){
+    blockHist.add( a.cfg.size() );
+    edgeHist.add( a.cfg.numEdges() );
+  }
+  if( prof.domIterations > 0 ){ iterHist.add(prof.domIterations); }
+  bytesHist.add(bytes);
+
+  if( topN == 0 || (slowest.size() == topN && time <= slowest.back().time) ){ return; }
+  Slowest s;
+  s.time = time;
+  s.name = name;
+  s.address = a.entry();
+  s.blocks = a.has(IFR_PASS_CFG) ? a.cfg.size() : 0;
+  s.ins = a.code.ins.size();
+  s.domIterations = prof.domIterations;
+  vector<Slowest>::iterator at = slowest.begin();
+  while( at != slowest.end() && at->time >= time ){ at++; }
+  slowest.insert(at, s);
+  if( slowest.size() > topN ){ slowest.pop_back(); }
+
+}
+
+void IFR_StatsTable::print(FILE *out) const{
+
+  fprintf(out, "IFR stats: %u routines, %.3f ms, %.3f ms of it loading cached results\n",
+          routines, totalTime * 1e3, cacheTime * 1e3);
+  if( routines == 0 ){ return; }
+
+  fprintf(out, "IFR stats: %-10s %8s %12s %10s %12s %12s\n", "pass", "routines", "total ms", "% time",
+          "max ms", "result KB");
+  for( unsigned p = 0; p < IFR_NUM_PASSES; p++ ){
+    if( passRuns[p] == 0 ){ continue; }
+    fprintf(out, "IFR stats: %-10s %8u %12.3f %9.1f%% %12.3f %12.1f\n", passNames[p], passRuns[p],
+            passTime[p] * 1e3, totalTime > 0 ? 100 * passTime[p] / totalTime : 0, passMax[p] * 1e3,
+            passBytes[p] / 1024.0);
+  }
+
+  timeHist.print(out, "time per routine", "us");
+  insHist.print(out, "instructions per routine", "instructions");
+  blockHist.print(out, "blocks per routine", "blocks");
+  edgeHist.print(out, "edges per routine", "edges");
+  iterHist.print(out, "CHK dominator sweeps per routine", "sweeps");
+  bytesHist.print(out, "result bytes per routine", "bytes");
+
+  if( slowest.empty() ){ return; }
+  fprintf(out, "IFR stats: %u slowest routines:\n", (unsigned)slowest.size());
+  for( unsigned i = 0; i < slowest.size(); i++ ){
+    const Slowest &s = slowest[i];
+    fprintf(out, "IFR stats:   %10.3f ms %p %6u blocks %7u ins %3u sweeps  %s\n", s.time * 1e3,
+            (void *)s.address, s.blocks, s.ins, s.domIterations, s.name.c_str());
+  }
+
+}
@@ -0,0 +1,98 @@
+#ifndef _IFR_STATS_H_
+#define _IFR_STATS_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "IFR_Types.h"
+#include "IFR_Analysis.h"
+#include "IFR_Clock.h"
+
+/*What one routine's passes cost, filled in by IFR_Analysis::run() when
+ *the analysis has a profile (-stats).  Bytes are the heap a pass's
+ *results hold afterwards, as reported by their bytes().
+ */
+class IFR_RoutineProfile{
+
+public:
+
+  double passTime[IFR_NUM_PASSES];
+  size_t passBytes[IFR_NUM_PASSES];
+  unsigned ran;               //passes run, as IFR_PASS_ bits
+  double cacheTime;           //looking up and loading the cached blob
+  unsigned domIterations;     //CHK fixpoint sweeps; 0 if Lengauer/Tarjan ran
+
+  IFR_RoutineProfile();
+
+  double total() const;
+
+};
+
+/*Counts of values in power of two buckets: bucket 0 holds 0, bucket k
+ *holds [2^(k-1), 2^k)
+ */
+class IFR_Histogram{
+
+public:
+
+  static const unsigned NumBuckets = 40;
+
+  unsigned buckets[NumBuckets];
+  unsigned count;
+  UINT64 sum;
+  UINT64 max;
+
+  IFR_Histogram();
+
+  void add(UINT64 v);
+
+  /*One line per non-empty bucket, with a bar scaled to the fullest*/
+  void print(FILE *out, const char *title, const char *unit) const;
+
+};
+
+/*Statistics over every routine added, for the Fini report*/
+class IFR_StatsTable{
+
+  class Slowest{
+  public:
+    double time;
+    std::string name;
+    ADDRINT address;
+    unsigned blocks;
+    unsigned ins;
+    unsigned domIterations;
+  };
+
+  unsigned topN;
+  std::vector<Slowest> slowest;     //sorted, slowest first, at most topN
+
+  unsigned routines;
+  double totalTime;
+  double passTime[IFR_NUM_PASSES];
+  double passMax[IFR_NUM_PASSES];
+  UINT64 passBytes[IFR_NUM_PASSES];
+  unsigned passRuns[IFR_NUM_PASSES];
+  double cacheTime;
+
+  IFR_Histogram timeHist;           //microseconds per routine
+  IFR_Histogram blockHist;
+  IFR_Histogram insHist;
+  IFR_Histogram edgeHist;
+  IFR_Histogram iterHist;           //CHK sweeps, routines that ran CHK
+  IFR_Histogram bytesHist;          //result bytes per routine
+
+public:
+
+  IFR_StatsTable(unsigned slowestToKeep);
+
+  /*a has a profile; time is what the routine cost its front end in all,
+   *which may be more than its passes (e.g. waiting on a worker)
+   */
+  void add(const std::string &name, const IFR_Analysis &a, double time);
+
+  void print(FILE *out) const;
+
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "IFR_Threads.h"
+
+#ifdef PIN
+
+void IFR_MutexInit(IFR_Mutex *m){ PIN_MutexInit(m); }
+void IFR_MutexFini(IFR_Mutex *m){ PIN_MutexFini(m); }
+void IFR_MutexLock(IFR_Mutex *m){ PIN_MutexLock(m); }
+void IFR_MutexUnlock(IFR_Mutex *m){ PIN_MutexUnlock(m); }
+
+void IFR_EventInit(IFR_Event *e){ PIN_SemaphoreInit(e); }
+void IFR_EventFini(IFR_Event *e){ PIN_SemaphoreFini(e); }
+void IFR_EventSet(IFR_Event *e){ PIN_SemaphoreSet(e); }
+void IFR_EventClear(IFR_Event *e){ PIN_SemaphoreClear(e); }
+void IFR_EventWait(IFR_Event *e){ PIN_SemaphoreWait(e); }
+
+bool IFR_SpawnThread(IFR_ThreadFunc fn, void *arg, IFR_Thread *t){
+  return PIN_SpawnInternalThread(fn, arg, 0, t) != INVALID_THREADID;
+}
+
+void IFR_JoinThread(IFR_Thread t){
+  PIN_WaitForThreadTermination(t, PIN_INFINITE_TIMEOUT, 0);
+}
+
+void IFR_Yield(){ PIN_Yield(); }
+
+#else
+
+#include <sched.h>
+
+void IFR_MutexInit(IFR_Mutex *m){ pthread_mutex_init(m, 0); }
+void IFR_MutexFini(IFR_Mutex *m){ pthread_mutex_destroy(m); }
+void IFR_MutexLock(IFR_Mutex *m){ pthread_mutex_lock(m); }
+void IFR_MutexUnlock(IFR_Mutex *m){ pthread_mutex_unlock(m); }
+
+void IFR_EventInit(IFR_Event *e){
+  pthread_mutex_init(&e->lock, 0);
+  pthread_cond_init(&e->cond, 0);
+  e->set = false;
+}
+
+void IFR_EventFini(IFR_Event *e){
+  pthread_cond_destroy(&e->cond);
+  pthread_mutex_destroy(&e->lock);
+}
+
+void IFR_EventSet(IFR_Event *e){
+  pthread_mutex_lock(&e->lock);
+  e->set = true;
+  pthread_cond_broadcast(&e->cond);
+  pthread_mutex_unlock(&e->lock);
+}
+
+void IFR_EventClear(IFR_Event *e){
+  pthread_mutex_lock(&e->lock);
+  e->set = false;
+  pthread_mutex_unlock(&e->lock);
+}
+
+void IFR_EventWait(IFR_Event *e){
+  pthread_mutex_lock(&e->lock);
+  while( !e->set ){ pthread_cond_wait(&e->cond, &e->lock); }
+  pthread_mutex_unlock(&e->lock);
+}
+
+class IFR_ThreadStart{
+public:
+  IFR_ThreadFunc fn;
+  void *arg;
+};
+
+static void *threadTrampoline(void *p){
+
+  IFR_ThreadStart start = *(IFR_ThreadStart *)p;
+  delete (IFR_ThreadStart *)p;
+  start.fn(start.arg);
+  return 0;
+
+}
+
+bool IFR_SpawnThread(IFR_ThreadFunc fn, void *arg, IFR_Thread *t){
+
+  IFR_ThreadStart *start = new IFR_ThreadStart();
+  start->fn = fn;
+  start->arg = arg;
+  if( pthread_create(t, 0, threadTrampoline, start) != 0 ){
+    delete start;
+    return false;
+  }
+  return true;
+
+}
+
+void IFR_JoinThread(IFR_Thread t){
+  pthread_join(t, 0);
+}
+
+void IFR_Yield(){ sched_yield(); }
+
+#endif
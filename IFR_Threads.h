@@ -0,0 +1,48 @@
+#ifndef _IFR_THREADS_H_
+#define _IFR_THREADS_H_
+
+/*The few threading primitives the analyses need.  In the Pin tool these
+ *are Pin's (tool threads must be Pin internal threads); elsewhere they
+ *are pthreads.
+ */
+#ifdef PIN
+#include <pin.H>
+typedef PIN_MUTEX IFR_Mutex;
+typedef PIN_SEMAPHORE IFR_Event;
+typedef PIN_THREAD_UID IFR_Thread;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t IFR_Mutex;
+typedef pthread_t IFR_Thread;
+class IFR_Event{
+public:
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool set;
+};
+#endif
+
+typedef void (*IFR_ThreadFunc)(void *arg);
+
+void IFR_MutexInit(IFR_Mutex *m);
+void IFR_MutexFini(IFR_Mutex *m);
+void IFR_MutexLock(IFR_Mutex *m);
+void IFR_MutexUnlock(IFR_Mutex *m);
+
+/*A flag threads can wait on; it stays set until cleared*/
+void IFR_EventInit(IFR_Event *e);
+void IFR_EventFini(IFR_Event *e);
+void IFR_EventSet(IFR_Event *e);
+void IFR_EventClear(IFR_Event *e);
+void IFR_EventWait(IFR_Event *e);
+
+bool IFR_SpawnThread(IFR_ThreadFunc fn, void *arg, IFR_Thread *t);
+void IFR_JoinThread(IFR_Thread t);
+void IFR_Yield();
+
+/*Atomically sets *word from expect to desired; true if it did*/
+inline bool IFR_CompareAndSwap(volatile unsigned *word, unsigned expect, unsigned desired){
+  return __sync_bool_compare_and_swap(word, expect, desired);
+}
+
+#endif
@@ -0,0 +1,352 @@
+#include <string.h>
+
+#include "IFR_Trace.h"
+#include "IFR_Analysis.h"
+
+using std::vector;
+
+/*Longest encoding of one access: ref 5 bytes, block 5, size 5, address 10*/
+#define IFR_TRACE_MAX_RECORD 25
+
+static inline unsigned char *putVarint(unsigned char *p, UINT64 v){
+  while( v >= 0x80 ){
+    *p++ = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (unsigned char)v;
+  return p;
+}
+
+static inline bool getVarint(const unsigned char *&p, const unsigned char *end, UINT64 &v){
+
+  v = 0;
+  for( unsigned shift = 0; shift < 64; shift += 7 ){
+    if( p == end ){ return false; }
+    unsigned char b = *p++;
+    v |= (UINT64)(b & 0x7f) << shift;
+    if( (b & 0x80) == 0 ){ return true; }
+  }
+  return false;
+
+}
+
+/*Small magnitudes of either sign to small unsigned numbers*/
+static inline UINT64 zigzag(INT64 v){
+  return ((UINT64)v << 1) ^ (UINT64)(v >> 63);
+}
+
+static inline INT64 unzigzag(UINT64 v){
+  return (INT64)(v >> 1) ^ -(INT64)(v & 1);
+}
+
+static void append(vector<unsigned char> &out, UINT64 v){
+  unsigned char buf[10];
+  out.insert(out.end(), buf, putVarint(buf, v));
+}
+
+void IFR_TraceDictionary::encode(const IFR_Analysis &a, UINT32 blockBase, vector<unsigned char> &payload){
+
+  const IFR_CFG &cfg = a.cfg;
+  append(payload, blockBase);
+  append(payload, cfg.size());
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+
+    append(payload, cfg.entry(b));
+    append(payload, a.memrefs.begin(cfg.insEnd(b)) - a.memrefs.begin(cfg.insBegin(b)));
+    for( unsigned in = cfg.insBegin(b); in < cfg.insEnd(b); in++ ){
+      for( unsigned k = a.memrefs.begin(in); k < a.memrefs.end(in); k++ ){
+        const IFR_MemoryRef &ref = a.memrefs.refs[k];
+        append(payload, a.code.ins[in].address - cfg.entry(b));
+        append(payload, (UINT64)ref.size << 2 | ref.type);
+        append(payload, ref.base == IFR_MemoryRef::NoReg ? 0 : (UINT64)ref.base + 1);
+        append(payload, ref.index == IFR_MemoryRef::NoReg ? 0 : (UINT64)ref.index + 1);
+        append(payload, ref.scale);
+        append(payload, zigzag(ref.displacement));
+      }
+    }
+
+  }
+
+}
+
+bool IFR_TraceDictionary::load(const unsigned char *payload, size_t size){
+
+  const unsigned char *p = payload, *end = payload + size;
+  UINT64 first, n;
+  if( !getVarint(p, end, first) || !getVarint(p, end, n) || first + n > (UINT64)1 << 32 ){ return false; }
+
+  if( blocks.size() < first + n ){
+    IFR_TraceBlock none;
+    none.entry = 0;
+    none.firstRef = 0;
+    none.numRefs = 0;
+    blocks.resize(first + n, none);
+  }
+
+  for( UINT64 b = first; b < first + n; b++ ){
+
+    UINT64 entry, numRefs;
+    if( !getVarint(p, end, entry) || !getVarint(p, end, numRefs) || numRefs > (UINT64)(end - p) ){
+      return false;
+    }
+    blocks[b].entry = entry;
+    blocks[b].firstRef = refs.size();
+    blocks[b].numRefs = numRefs;
+
+    for( UINT64 k = 0; k < numRefs; k++ ){
+      UINT64 offset, sizeType, base, index, scale, displacement;
+      if( !getVarint(p, end, offset) || !getVarint(p, end, sizeType) || !getVarint(p, end, base) ||
+          !getVarint(p, end, index) || !getVarint(p, end, scale) || !getVarint(p, end, displacement) ){
+        return false;
+      }
+      IFR_TraceRef r;
+      r.ins = entry + offset;
+      r.size = sizeType >> 2;
+      r.type = sizeType & 3;
+      r.base = base == 0 ? IFR_MemoryRef::NoReg : base - 1;
+      r.index = index == 0 ? IFR_MemoryRef::NoReg : index - 1;
+      r.scale = scale;
+      r.displacement = unzigzag(displacement);
+      refs.push_back(r);
+    }
+
+  }
+  return p == end;
+
+}
+
+const IFR_TraceRef *IFR_TraceDictionary::find(UINT32 block, unsigned ref) const{
+  if( block >= blocks.size() || ref >= blocks[block].numRefs ){ return 0; }
+  return &refs[ blocks[block].firstRef + ref ];
+}
+
+const unsigned IFR_TraceCoder::Slots;
+
+static inline unsigned slotOf(UINT32 block, UINT32 ref){
+  return ((block * 0x9e3779b1u) ^ (ref * 0x85ebca77u)) >> 20;
+}
+
+IFR_TraceCoder::IFR_TraceCoder(){
+  Slot empty;
+  memset(&empty, 0, sizeof(empty));
+  slots.assign(Slots, empty);
+  epoch = 0;
+  lastBlock = 0;
+  lastEa = 0;
+}
+
+/*Empties the table without touching it, until the epoch wraps*/
+void IFR_TraceCoder::reset(){
+  if( ++epoch == 0 ){
+    for( unsigned s = 0; s < Slots; s++ ){ slots[s].epoch = 0; }
+    epoch = 1;
+  }
+  lastBlock = 0;
+  lastEa = 0;
+}
+
+void IFR_TraceCoder::encode(UINT32 tid, UINT64 seq, const IFR_AccessRecord *records, UINT64 count,
+                            vector<unsigned char> &payload){
+
+  reset();
+  size_t start = payload.size();
+  payload.resize(start + 30 + count * IFR_TRACE_MAX_RECORD);
+  unsigned char *p = &payload[start];
+  p = putVarint(p, tid);
+  p = putVarint(p, seq);
+  p = putVarint(p, count);
+
+  for( UINT64 i = 0; i < count; i++ ){
+
+    const IFR_AccessRecord &r = records[i];
+    Slot &s = slots[ slotOf(r.block, r.ref) ];
+    bool hit = s.epoch == epoch && s.block == r.block && s.ref == r.ref;
+    bool explicitAttrs = !hit || s.size != r.size || s.write != r.write;
+    bool newBlock = r.block != lastBlock;
+
+    p = putVarint(p, (UINT64)r.ref << 2 | (UINT64)explicitAttrs << 1 | (UINT64)newBlock);
+    if( newBlock ){ p = putVarint(p, zigzag((INT64)r.block - (INT64)lastBlock)); }
+    if( explicitAttrs ){ p = putVarint(p, (UINT64)r.size << 1 | (r.write != 0)); }
+    p = putVarint(p, zigzag((INT64)(r.ea - (hit ? s.ea : lastEa))));
+
+    s.block = r.block;
+    s.ref = r.ref;
+    s.ea = r.ea;
+    s.size = r.size;
+    s.write = r.write != 0;
+    s.epoch = epoch;
+    lastBlock = r.block;
+    lastEa = r.ea;
+
+  }
+  payload.resize(p - &payload[0]);
+
+}
+
+bool IFR_TraceCoder::decode(const unsigned char *payload, size_t size, UINT32 &tid, UINT64 &seq,
+                            vector<IFR_AccessRecord> &records){
+
+  reset();
+  const unsigned char *p = payload, *end = payload + size;
+  UINT64 t, count;
+  if( !getVarint(p, end, t) || !getVarint(p, end, seq) || !getVarint(p, end, count) || count > size ){
+    return false;
+  }
+  tid = t;
+  records.resize(count);
+
+  for( UINT64 i = 0; i < count; i++ ){
+
+    UINT64 head, v;
+    if( !getVarint(p, end, head) || (head >> 2) > 0xffffffffULL ){ return false; }
+    IFR_AccessRecord &r = records[i];
+    r.ref = head >> 2;
+    r.block = lastBlock;
+    if( head & 1 ){
+      if( !getVarint(p, end, v) ){ return false; }
+      r.block = lastBlock + unzigzag(v);
+    }
+
+    Slot &s = slots[ slotOf(r.block, r.ref) ];
+    bool hit = s.epoch == epoch && s.block == r.block && s.ref == r.ref;
+    if( head & 2 ){
+      if( !getVarint(p, end, v) || (v >> 1) > 0xffffffffULL ){ return false; }
+      r.size = v >> 1;
+      r.write = v & 1;
+    }else if( hit ){
+      r.size = s.size;
+      r.write = s.write;
+    }else{
+      return false;
+    }
+    if( !getVarint(p, end, v) ){ return false; }
+    r.ea = (hit ? s.ea : lastEa) + unzigzag(v);
+
+    s.block = r.block;
+    s.ref = r.ref;
+    s.ea = r.ea;
+    s.size = r.size;
+    s.write = r.write;
+    s.epoch = epoch;
+    lastBlock = r.block;
+    lastEa = r.ea;
+
+  }
+  return p == end;
+
+}
+
+IFR_TraceWriter::IFR_TraceWriter(){
+  file = 0;
+  accesses = 0;
+  frames = 0;
+  bytesOut = 0;
+  failed = false;
+  IFR_MutexInit(&lock);
+}
+
+IFR_TraceWriter::~IFR_TraceWriter(){
+  close();
+  IFR_MutexFini(&lock);
+}
+
+bool IFR_TraceWriter::open(const char *path){
+
+  file = fopen(path, "wb");
+  if( file == 0 ){ return false; }
+  UINT32 header[2] = { IFR_TRACE_MAGIC, IFR_TRACE_VERSION };
+  failed = fwrite(header, sizeof(header), 1, file) != 1;
+  bytesOut = sizeof(header);
+  return true;
+
+}
+
+void IFR_TraceWriter::close(){
+
+  IFR_MutexLock(&lock);
+  if( file != 0 ){
+    failed |= fclose(file) != 0;
+    file = 0;
+  }
+  IFR_MutexUnlock(&lock);
+
+}
+
+void IFR_TraceWriter::write(IFR_TraceChunkKind kind, const vector<unsigned char> &payload){
+
+  unsigned char head[5];
+  head[0] = (unsigned char)kind;
+  UINT32 length = payload.size();
+  memcpy(head + 1, &length, sizeof(length));
+
+  IFR_MutexLock(&lock);
+  if( file != 0 ){
+    failed |= fwrite(head, sizeof(head), 1, file) != 1;
+    if( !payload.empty() ){ failed |= fwrite(&payload[0], payload.size(), 1, file) != 1; }
+    bytesOut += sizeof(head) + payload.size();
+  }
+  IFR_MutexUnlock(&lock);
+
+}
+
+void IFR_TraceWriter::writeFrame(IFR_TraceCoder &coder, UINT32 tid, UINT64 seq, const IFR_AccessRecord *records,
+                                 UINT64 count, vector<unsigned char> &scratch){
+
+  if( count == 0 ){ return; }
+  scratch.clear();
+  coder.encode(tid, seq, records, count, scratch);
+  write(TraceFrame, scratch);
+  __sync_fetch_and_add(&accesses, count);
+  __sync_fetch_and_add(&frames, 1);
+
+}
+
+IFR_TraceReader::IFR_TraceReader(){
+  file = 0;
+  bytesIn = 0;
+}
+
+IFR_TraceReader::~IFR_TraceReader(){
+  if( file != 0 ){ fclose(file); }
+}
+
+bool IFR_TraceReader::open(const char *path, const char *&error){
+
+  file = fopen(path, "rb");
+  if( file == 0 ){
+    error = "cannot open it";
+    return false;
+  }
+  UINT32 header[2];
+  if( fread(header, sizeof(header), 1, file) != 1 || header[0] != IFR_TRACE_MAGIC ){
+    error = "not an IFR trace";
+    return false;
+  }
+  if( header[1] != IFR_TRACE_VERSION ){
+    error = "a trace of another version";
+    return false;
+  }
+  bytesIn = sizeof(header);
+  return true;
+
+}
+
+bool IFR_TraceReader::next(IFR_TraceChunkKind &kind, vector<unsigned char> &payload, bool &truncated){
+
+  unsigned char head[5];
+  truncated = false;
+  size_t got = fread(head, 1, sizeof(head), file);
+  if( got == 0 ){ return false; }
+  truncated = true;
+  if( got != sizeof(head) ){ return false; }
+
+  UINT32 length;
+  memcpy(&length, head + 1, sizeof(length));
+  payload.resize(length);
+  if( length > 0 && fread(&payload[0], length, 1, file) != 1 ){ return false; }
+  kind = (IFR_TraceChunkKind)head[0];
+  bytesIn += sizeof(head) + length;
+  truncated = false;
+  return true;
+
+}
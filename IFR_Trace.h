@@ -0,0 +1,209 @@
+#ifndef _IFR_TRACE_H_
+#define _IFR_TRACE_H_
+
+#include <stdio.h>
+#include <vector>
+
+#include "IFR_Types.h"
+#include "IFR_Threads.h"
+
+class IFR_Analysis;
+
+/*Compact memory access traces.
+ *
+ *A trace file is a header (IFR_TRACE_MAGIC, IFR_TRACE_VERSION as two
+ *32-bit words) followed by chunks, each a kind byte, a 32-bit payload
+ *length and the payload:
+ *
+ *  TraceBlocks  the static part of accesses, once per routine: for each
+ *               of its blocks, in global block id order, the entry and
+ *               every memory reference (instruction, read/write, size,
+ *               base, index, scale, displacement)
+ *  TraceFrame   accesses of one thread, in execution order, and the
+ *               frame's number among that thread's; frames of a thread
+ *               may be written out of order when a consumer thread
+ *               writes some of them
+ *
+ *A frame is self-contained: its encoder state starts afresh, so frames
+ *can be decoded in any order or in parallel, and the blocks chunk of
+ *every block a frame mentions comes before it.  Within a frame each
+ *access, after the thread id and frame number and count as varints, is
+ *
+ *  varint  ref << 2 | explicit << 1 | newBlock
+ *  varint  zigzag(block - previous block)          if newBlock
+ *  varint  size << 1 | write                       if explicit
+ *  varint  zigzag(ea - predicted ea)
+ *
+ *with the prediction the last address of the same (block, ref) in this
+ *frame, found in a small direct-mapped table, or the frame's previous
+ *address when that slot holds another reference.  Strided loop
+ *accesses then cost a byte or two for the delta.  explicit is set
+ *when the slot missed or its size and direction changed, so size and
+ *write are only carried once per reference per frame.
+ */
+
+#define IFR_TRACE_MAGIC   0x54524649   //"IFRT"
+#define IFR_TRACE_VERSION 1
+
+enum IFR_TraceChunkKind { TraceBlocks = 1, TraceFrame = 2 };
+
+/*One buffered access, 24 bytes, as Pin's trace buffers fill them.
+ *Pin stores each fill argument at its IARG's width, so every field but
+ *ea is a UINT32 to match the IARG_UINT32 it is filled with.
+ */
+class IFR_AccessRecord{
+
+public:
+
+  ADDRINT ea;
+  UINT32 block;     //global block id: the routine's block base + its IFR_CFG block
+  UINT32 ref;       //memory reference number within the block, in IFR_MemRefTable order
+  UINT32 size;
+  UINT32 write;
+
+};
+
+/*Static description of one memory reference*/
+class IFR_TraceRef{
+
+public:
+
+  ADDRINT ins;
+  ADDRDELTA displacement;
+  UINT32 base;      //IFR_MemoryRef::NoReg when absent
+  UINT32 index;
+  UINT32 scale;
+  UINT32 size;
+  UINT32 type;      //a MemOpType
+
+};
+
+class IFR_TraceBlock{
+
+public:
+
+  ADDRINT entry;
+  unsigned firstRef;    //into IFR_TraceDictionary::refs
+  unsigned numRefs;
+
+};
+
+/*Every block the trace's chunks have described, by global block id.
+ *Block ids with no description (routines reported without a trace
+ *chunk) have an entry of 0 and no refs.
+ */
+class IFR_TraceDictionary{
+
+public:
+
+  std::vector<IFR_TraceBlock> blocks;
+  std::vector<IFR_TraceRef> refs;
+
+  /*Encodes the blocks of a, numbered from blockBase, as a TraceBlocks
+   *payload
+   */
+  static void encode(const IFR_Analysis &a, UINT32 blockBase, std::vector<unsigned char> &payload);
+
+  bool load(const unsigned char *payload, size_t size);
+
+  /*The reference an access is to, or null if the trace does not say*/
+  const IFR_TraceRef *find(UINT32 block, unsigned ref) const;
+
+};
+
+/*Per-thread state of frame encoding and decoding*/
+class IFR_TraceCoder{
+
+  static const unsigned Slots = 4096;
+
+  class Slot{
+  public:
+    UINT32 block;
+    UINT32 ref;
+    ADDRINT ea;
+    UINT32 size;
+    UINT32 write;
+    unsigned epoch;
+  };
+
+  std::vector<Slot> slots;
+  unsigned epoch;         //slots of older epochs are empty
+  UINT32 lastBlock;
+  ADDRINT lastEa;
+
+  void reset();
+
+public:
+
+  IFR_TraceCoder();
+
+  /*Appends a TraceFrame payload for count records, frame seq of thread tid*/
+  void encode(UINT32 tid, UINT64 seq, const IFR_AccessRecord *records, UINT64 count,
+              std::vector<unsigned char> &payload);
+
+  /*Decodes a TraceFrame payload; false if it is malformed*/
+  bool decode(const unsigned char *payload, size_t size, UINT32 &tid, UINT64 &seq,
+              std::vector<IFR_AccessRecord> &records);
+
+};
+
+/*Appends chunks to a trace file.  Safe to call from several threads;
+ *each chunk is written whole.
+ */
+class IFR_TraceWriter{
+
+  FILE *file;
+  IFR_Mutex lock;
+
+  IFR_TraceWriter(const IFR_TraceWriter &);
+  IFR_TraceWriter &operator=(const IFR_TraceWriter &);
+
+public:
+
+  UINT64 accesses;
+  UINT64 frames;
+  UINT64 bytesOut;
+  bool failed;
+
+  IFR_TraceWriter();
+  ~IFR_TraceWriter();
+
+  bool open(const char *path);
+  void close();
+  bool isOpen() const { return file != 0; }
+
+  void write(IFR_TraceChunkKind kind, const std::vector<unsigned char> &payload);
+
+  /*Encodes a frame with coder, which belongs to the calling thread*/
+  void writeFrame(IFR_TraceCoder &coder, UINT32 tid, UINT64 seq, const IFR_AccessRecord *records, UINT64 count,
+                  std::vector<unsigned char> &scratch);
+
+};
+
+/*Reads a trace file one chunk at a time*/
+class IFR_TraceReader{
+
+  FILE *file;
+  IFR_TraceReader(const IFR_TraceReader &);
+  IFR_TraceReader &operator=(const IFR_TraceReader &);
+
+public:
+
+  UINT64 bytesIn;
+
+  IFR_TraceReader();
+  ~IFR_TraceReader();
+
+  /*Opens path and checks its header; false (with a message in error) if
+   *it is not a trace of this version
+   */
+  bool open(const char *path, const char *&error);
+
+  /*The next chunk; false at the end of the file or on a truncated chunk,
+   *which truncated tells apart
+   */
+  bool next(IFR_TraceChunkKind &kind, std::vector<unsigned char> &payload, bool &truncated);
+
+};
+
+#endif
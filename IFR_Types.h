@@ -0,0 +1,29 @@
+#ifndef _IFR_TYPES_H_
+#define _IFR_TYPES_H_
+
+/*The analysis core only needs Pin's integer types.  Inside the tool they
+ *come from pin.H; the non-pin build (BLDTYPE != pin) defines them here.
+ */
+#ifdef PIN
+#include <pin.H>
+#else
+#include <stdint.h>
+typedef uintptr_t ADDRINT;
+typedef intptr_t ADDRDELTA;
+typedef int32_t INT32;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+#endif
+
+#include <stddef.h>
+#include <vector>
+
+/*Heap a vector holds, for the bytes() of analysis results*/
+template <class T> size_t IFR_Bytes(const std::vector<T> &v){
+  return v.capacity() * sizeof(T);
+}
+
+#endif
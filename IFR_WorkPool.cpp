@@ -0,0 +1,112 @@
+#include "IFR_WorkPool.h"
+
+using std::vector;
+
+IFR_WorkPool::IFR_WorkPool(){
+  task = 0;
+  taskArg = 0;
+}
+
+IFR_WorkPool::~IFR_WorkPool(){
+  reset();
+}
+
+void IFR_WorkPool::start(unsigned numThreads, const vector<unsigned> &items, Task t, void *arg){
+
+  reset();
+  task = t;
+  taskArg = arg;
+  if( numThreads == 0 ){ numThreads = 1; }
+
+  for( unsigned i = 0; i < numThreads; i++ ){
+    Worker *w = new Worker();
+    w->pool = this;
+    w->id = i;
+    w->started = false;
+    w->done = 0;
+    w->stolen = 0;
+    IFR_MutexInit(&w->lock);
+    workers.push_back(w);
+  }
+  for( unsigned i = 0; i < items.size(); i++ ){
+    workers[i % numThreads]->items.push_back(items[i]);
+  }
+
+  /*Workers that fail to start leave their items to be stolen*/
+  unsigned started = 0;
+  for( unsigned i = 0; i < numThreads; i++ ){
+    workers[i]->started = IFR_SpawnThread(workerMain, workers[i], &workers[i]->thread);
+    if( workers[i]->started ){ started++; }
+  }
+  if( started == 0 ){ work(workers[0]); }
+
+}
+
+void IFR_WorkPool::join(){
+
+  for( unsigned i = 0; i < workers.size(); i++ ){
+    if( workers[i]->started ){ IFR_JoinThread(workers[i]->thread); }
+    workers[i]->started = false;
+  }
+
+}
+
+void IFR_WorkPool::reset(){
+
+  join();
+  for( unsigned i = 0; i < workers.size(); i++ ){
+    IFR_MutexFini(&workers[i]->lock);
+    delete workers[i];
+  }
+  workers.clear();
+
+}
+
+void IFR_WorkPool::workerMain(void *w){
+  ((Worker *)w)->pool->work( (Worker *)w );
+}
+
+bool IFR_WorkPool::take(Worker *w, unsigned &item){
+
+  IFR_MutexLock(&w->lock);
+  bool got = !w->items.empty();
+  if( got ){
+    item = w->items.front();
+    w->items.pop_front();
+  }
+  IFR_MutexUnlock(&w->lock);
+  return got;
+
+}
+
+bool IFR_WorkPool::steal(Worker *w, unsigned &item){
+
+  for( unsigned k = 1; k < workers.size(); k++ ){
+
+    Worker *victim = workers[ (w->id + k) % workers.size() ];
+    IFR_MutexLock(&victim->lock);
+    bool got = !victim->items.empty();
+    if( got ){
+      item = victim->items.back();
+      victim->items.pop_back();
+    }
+    IFR_MutexUnlock(&victim->lock);
+    if( got ){
+      w->stolen++;
+      return true;
+    }
+
+  }
+  return false;
+
+}
+
+void IFR_WorkPool::work(Worker *w){
+
+  unsigned item;
+  while( take(w, item) || steal(w, item) ){
+    task(item, taskArg);
+    w->done++;
+  }
+
+}
@@ -0,0 +1,74 @@
+#ifndef _IFR_WORKPOOL_H_
+#define _IFR_WORKPOOL_H_
+
+#include <vector>
+#include <deque>
+#include "IFR_Threads.h"
+
+/*Runs a task over a fixed batch of items on a set of worker threads.
+ *
+ *Items are dealt round-robin into one deque per worker, so if the batch
+ *is sorted by decreasing cost each worker starts on its share of the
+ *expensive items.  A worker takes from the front of its own deque and,
+ *once that is empty, steals from the back of the others', where the
+ *cheapest items are.  Nothing is added after start(), so a worker that
+ *finds every deque empty is done.
+ *
+ *Tasks run on the pool's threads, so in the Pin tool they must not call
+ *Pin's instrumentation API.
+ */
+class IFR_WorkPool{
+
+public:
+
+  typedef void (*Task)(unsigned item, void *arg);
+
+private:
+
+  class Worker{
+  public:
+    IFR_WorkPool *pool;
+    unsigned id;
+    IFR_Mutex lock;
+    std::deque<unsigned> items;
+    IFR_Thread thread;
+    bool started;
+    unsigned done;
+    unsigned stolen;
+  };
+
+  std::vector<Worker *> workers;
+  Task task;
+  void *taskArg;
+
+  bool take(Worker *w, unsigned &item);
+  bool steal(Worker *w, unsigned &item);
+  void work(Worker *w);
+  void reset();
+  static void workerMain(void *w);
+
+  IFR_WorkPool(const IFR_WorkPool &);
+  IFR_WorkPool &operator=(const IFR_WorkPool &);
+
+public:
+
+  IFR_WorkPool();
+  ~IFR_WorkPool();
+
+  /*Starts numThreads workers over items and returns.  If no thread can be
+   *started the items are run on the calling thread before returning.
+   */
+  void start(unsigned numThreads, const std::vector<unsigned> &items, Task t, void *arg);
+
+  /*Waits for every worker to finish.  Their counts stay readable until
+   *the next start().
+   */
+  void join();
+
+  unsigned numThreads() const { return workers.size(); }
+  unsigned itemsDone(unsigned worker) const { return workers[worker]->done; }
+  unsigned itemsStolen(unsigned worker) const { return workers[worker]->stolen; }
+
+};
+
+#endif
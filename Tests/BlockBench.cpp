@@ -0,0 +1,166 @@
+/*Cost of the -blocks pass per routine, before and after blocks became
+ *ranges over a per-routine instruction array.
+ *
+ *"vector" is the old scheme: leaders collected and sorted, then each block
+ *a std::vector of instruction handles, copied into the block list.
+ *"arena" is the current one: one handle array and one block array per
+ *routine carved from an IFR_Arena, blocks taken from the CFG, and the
+ *arena reset after each routine.  Instruction records stand in for Pin's
+ *INS handles.  Heap allocations are counted by replacing operator new.
+ *
+ *  ./BlockBench [routines] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "IFR_InsRecord.h"
+#include "IFR_BasicBlock.h"
+#include "IFR_Arena.h"
+#include "IFR_Clock.h"
+#include "RoutineBuilder.h"
+
+using namespace std;
+
+static unsigned long allocations = 0;
+static unsigned long allocatedBytes = 0;
+
+void *operator new(size_t n){
+  allocations++;
+  allocatedBytes += n;
+  void *p = malloc(n ? n : 1);
+  if( p == 0 ){ throw std::bad_alloc(); }
+  return p;
+}
+
+void operator delete(void *p) throw(){
+  free(p);
+}
+
+void operator delete(void *p, size_t) throw(){
+  operator delete(p);
+}
+
+typedef const IFR_InsRecord *Handle;
+
+/*The block class as it was: owns a vector of handles, deep copied*/
+class VectorBlock{
+public:
+  ADDRINT target;
+  ADDRINT fallthrough;
+  vector<Handle> insns;
+  VectorBlock(){ target = fallthrough = 0; }
+  void clear(){ target = fallthrough = 0; insns.clear(); }
+};
+
+static void vectorBlocks(const IFR_RoutineCode &code, vector<VectorBlock> &bblist){
+
+  vector<ADDRINT> leaders = vector<ADDRINT>();
+  for( unsigned i = 0; i < code.ins.size(); i++ ){
+    const IFR_InsRecord &r = code.ins[i];
+    if( i == 0 ){ leaders.push_back(r.address); }
+    if( (r.kind == InsJump || r.kind == InsCondJump) && r.target != 0 ){
+      leaders.push_back(r.target);
+      leaders.push_back(r.next());
+    }
+  }
+  sort(leaders.begin(), leaders.end());
+  leaders.erase( unique(leaders.begin(), leaders.end()), leaders.end() );
+
+  VectorBlock bb = VectorBlock();
+  for( unsigned i = 0; i < code.ins.size(); i++ ){
+    const IFR_InsRecord &r = code.ins[i];
+    bb.insns.push_back(&r);
+    if( i + 1 == code.ins.size() || binary_search(leaders.begin(), leaders.end(), code.ins[i + 1].address) ){
+      if( r.kind == InsJump || r.kind == InsCondJump ){
+        bb.target = r.target;
+        bb.fallthrough = r.kind == InsCondJump ? r.next() : 0;
+      }else{
+        bb.target = 0;
+        bb.fallthrough = r.next();
+      }
+      bblist.push_back(bb);
+      bb.clear();
+    }
+  }
+
+}
+
+static void arenaBlocks(const IFR_RoutineCode &code, const IFR_CFG &cfg, IFR_Arena &arena,
+                        Handle *&insns, IFR_BasicBlock *&blocks){
+
+  insns = arena.allocArray<Handle>( code.ins.size() );
+  for( unsigned i = 0; i < code.ins.size(); i++ ){
+    insns[i] = &code.ins[i];
+  }
+  blocks = arena.allocArray<IFR_BasicBlock>( cfg.size() );
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    new (&blocks[b]) IFR_BasicBlock();
+    blocks[b].set(code, cfg, b);
+  }
+
+}
+
+int main(int argc, char **argv){
+
+  unsigned numRoutines = argc > 1 ? atoi(argv[1]) : 5000;
+  unsigned reps = argc > 2 ? atoi(argv[2]) : 5;
+
+  srand(1);
+  vector<IFR_RoutineCode> routines(numRoutines);
+  vector<IFR_CFG *> cfgs(numRoutines);
+  unsigned long totalIns = 0;
+  for( unsigned r = 0; r < numRoutines; r++ ){
+    unsigned n = 4 + rand() % 60;
+    if( rand() % 50 == 0 ){ n *= 20; }
+    makeRoutine(0x400000 + 0x100000 * (ADDRINT)r, n, routines[r]);
+    cfgs[r] = new IFR_CFG();
+    routines[r].buildCFG(*cfgs[r]);
+    totalIns += n;
+  }
+
+  unsigned long check = 0;
+
+  unsigned long allocs = allocations, bytes = allocatedBytes;
+  double start = IFR_Clock();
+  for( unsigned k = 0; k < reps; k++ ){
+    for( unsigned r = 0; r < numRoutines; r++ ){
+      vector<VectorBlock> bblist;
+      vectorBlocks(routines[r], bblist);
+      check += bblist.size();
+    }
+  }
+  double t = (IFR_Clock() - start) / reps;
+  printf("vector: %8.3f us/routine %7.2f allocs/routine %9.1f bytes/routine\n",
+         t * 1e6 / numRoutines, (double)(allocations - allocs) / reps / numRoutines,
+         (double)(allocatedBytes - bytes) / reps / numRoutines);
+
+  IFR_Arena arena = IFR_Arena();
+  allocs = allocations;
+  bytes = allocatedBytes;
+  start = IFR_Clock();
+  for( unsigned k = 0; k < reps; k++ ){
+    for( unsigned r = 0; r < numRoutines; r++ ){
+      Handle *insns = 0;
+      IFR_BasicBlock *blocks = 0;
+      arenaBlocks(routines[r], *cfgs[r], arena, insns, blocks);
+      check -= cfgs[r]->size();
+      arena.reset();
+    }
+  }
+  t = (IFR_Clock() - start) / reps;
+  printf("arena:  %8.3f us/routine %7.2f allocs/routine %9.1f bytes/routine (arena peak %lu bytes)\n",
+         t * 1e6 / numRoutines, (double)(allocations - allocs) / reps / numRoutines,
+         (double)(allocatedBytes - bytes) / reps / numRoutines, (unsigned long)arena.peakBytes());
+
+  printf("%u routines, %lu instructions, block counts %s\n",
+         numRoutines, totalIns, check == 0 ? "agree" : "DIFFER");
+
+  for( unsigned r = 0; r < numRoutines; r++ ){
+    delete cfgs[r];
+  }
+  return 0;
+
+}
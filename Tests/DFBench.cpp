@@ -0,0 +1,207 @@
+/*Dominance frontier and DF+ benchmark on deep loop nests.
+ *
+ *Compares the hash_map/set frontier pass the Pin driver used to run with
+ *IFR_DomFrontiers, and DF+ for a batch of synthetic registers computed by
+ *a hand-written Cytron worklist, IFR_IDF's DJ-graph walk, and IFR_IDF over
+ *flat frontiers.
+ *
+ *  ./DFBench [maxDepth] [width] [registers]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <ext/hash_map>
+
+#include "IFR_CFG.h"
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+#include "IFR_Clock.h"
+
+using namespace std;
+using __gnu_cxx::hash_map;
+
+static unsigned numBlocks;
+static vector< pair<unsigned, unsigned> > edges;
+
+static unsigned newBlock(){
+  return numBlocks++;
+}
+
+static void edge(unsigned from, unsigned to){
+  edges.push_back( pair<unsigned, unsigned>(from, to) );
+}
+
+static unsigned diamond(unsigned cur){
+  unsigned a = newBlock(), b = newBlock(), j = newBlock();
+  edge(cur, a); edge(cur, b); edge(a, j); edge(b, j);
+  return j;
+}
+
+/*A guarded loop whose body is width inner loops (or if/else diamonds at the
+ *innermost level) in sequence.  Returns the loop's exit block.
+ */
+static unsigned loopNest(unsigned cur, unsigned depth, unsigned width){
+
+  unsigned header = newBlock();
+  edge(cur, header);
+  unsigned c = header;
+  for( unsigned w = 0; w < width; w++ ){
+    c = (depth > 1) ? loopNest(c, depth - 1, width) : diamond(c);
+  }
+  unsigned latch = newBlock();
+  unsigned exit = newBlock();
+  edge(c, latch);
+  edge(latch, header);
+  edge(latch, exit);
+  edge(header, exit);
+  return exit;
+
+}
+
+static void makeCFG(unsigned depth, unsigned width, IFR_CFG &cfg){
+
+  numBlocks = 0;
+  edges.clear();
+  loopNest(newBlock(), depth, width);
+
+  cfg.clear();
+  for( unsigned b = 0; b < numBlocks; b++ ){
+    cfg.addBlock(16 * b, 4);
+  }
+  for( unsigned e = 0; e < edges.size(); e++ ){
+    cfg.addEdge(edges[e].first, 16 * edges[e].second);
+  }
+  cfg.finish();
+
+}
+
+/*The pass computeDominanceFrontiers ran over address-keyed maps, with the
+ *runner starting at the predecessor so both passes compute the same sets.
+ */
+static void hashMapDF(IFR_CFG &cfg,
+                      hash_map<ADDRINT, set<ADDRINT> > &pred,
+                      hash_map<ADDRINT, ADDRINT> &idom,
+                      hash_map<ADDRINT, set<ADDRINT> > &df){
+
+  for( unsigned b = 0; b < cfg.size(); b++ ){
+    ADDRINT i = cfg.entry(b);
+    if( pred[i].size() >= 2 ){
+      for( set<ADDRINT>::iterator pi = pred[i].begin(); pi != pred[i].end(); pi++ ){
+        ADDRINT runner = *pi;
+        while( runner != idom[i] && runner != 0 ){
+          df[runner].insert(i);
+          runner = idom[runner];
+        }
+      }
+    }
+  }
+
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned maxDepth = argc > 1 ? atoi(argv[1]) : 8;
+  unsigned width = argc > 2 ? atoi(argv[2]) : 3;
+  unsigned regs = argc > 3 ? atoi(argv[3]) : 64;
+
+  printf("%6s %8s %8s %12s %12s %12s %12s %12s %s\n", "depth", "blocks", "dfsize",
+         "hashmap-df", "flat-df", "cytron-idf", "sg-idf", "IFR_IDF+df", "agree");
+  for( unsigned depth = 1; depth <= maxDepth; depth++ ){
+
+    IFR_CFG cfg;
+    makeCFG(depth, width, cfg);
+    IFR_Dominators doms;
+    doms.compute(cfg, DomCHK);
+    IFR_DomTree tree;
+    tree.build(doms);
+    unsigned n = cfg.size();
+
+    hash_map<ADDRINT, set<ADDRINT> > pred, oldDF;
+    hash_map<ADDRINT, ADDRINT> idom;
+    for( unsigned b = 0; b < n; b++ ){
+      for( const unsigned *p = cfg.predBegin(b); p != cfg.predEnd(b); p++ ){
+        pred[ cfg.entry(b) ].insert( cfg.entry(*p) );
+      }
+      unsigned d = tree.idom(b);
+      idom[ cfg.entry(b) ] = (d == IFR_Dominators::NoBlock) ? 0 : cfg.entry(d);
+    }
+
+    double t0 = IFR_Clock();
+    hashMapDF(cfg, pred, idom, oldDF);
+    double t1 = IFR_Clock();
+    IFR_DomFrontiers df;
+    df.compute(cfg, tree);
+    double t2 = IFR_Clock();
+
+    bool agree = true;
+    for( unsigned b = 0; b < n; b++ ){
+      set<ADDRINT> &o = oldDF[ cfg.entry(b) ];
+      if( o.size() != (unsigned)(df.end(b) - df.begin(b)) ){ agree = false; continue; }
+      const unsigned *d = df.begin(b);
+      for( set<ADDRINT>::iterator i = o.begin(); i != o.end(); i++, d++ ){
+        if( cfg.entry(*d) != *i ){ agree = false; }
+      }
+    }
+
+    /*Each register is defined in a handful of random blocks*/
+    srand(depth);
+    vector< vector<unsigned> > defs(regs);
+    for( unsigned r = 0; r < regs; r++ ){
+      unsigned k = 1 + rand() % 8;
+      for( unsigned i = 0; i < k; i++ ){
+        defs[r].push_back( rand() % n );
+      }
+    }
+
+    /*Cytron et al.: worklist over the materialized frontiers*/
+    vector< vector<unsigned> > cytron(regs);
+    double t3 = IFR_Clock();
+    vector<unsigned> mark(n, 0), work;
+    for( unsigned r = 0; r < regs; r++ ){
+      unsigned stamp = 2 * r + 1;
+      work.assign(defs[r].begin(), defs[r].end());
+      for( unsigned i = 0; i < work.size(); i++ ){ mark[ work[i] ] = stamp; }
+      while( !work.empty() ){
+        unsigned x = work.back();
+        work.pop_back();
+        for( const unsigned *y = df.begin(x); y != df.end(x); y++ ){
+          if( mark[*y] == stamp + 1 ){ continue; }
+          bool wasQueued = mark[*y] == stamp;
+          mark[*y] = stamp + 1;
+          cytron[r].push_back(*y);
+          if( !wasQueued ){ work.push_back(*y); }
+        }
+      }
+    }
+    double t4 = IFR_Clock();
+
+    vector< vector<unsigned> > sg(regs), flat(regs);
+    IFR_IDF idf;
+    idf.init(cfg, tree, 0);
+    for( unsigned r = 0; r < regs; r++ ){
+      idf.compute(defs[r], sg[r]);
+    }
+    double t5 = IFR_Clock();
+    idf.init(cfg, tree, &df);
+    for( unsigned r = 0; r < regs; r++ ){
+      idf.compute(defs[r], flat[r]);
+    }
+    double t6 = IFR_Clock();
+
+    for( unsigned r = 0; r < regs; r++ ){
+      sort(cytron[r].begin(), cytron[r].end());
+      if( cytron[r] != sg[r] || cytron[r] != flat[r] ){ agree = false; }
+    }
+
+    printf("%6u %8u %8u %10.3fms %10.3fms %10.3fms %10.3fms %10.3fms %s\n", depth, n, df.numEntries(),
+           (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t4 - t3) * 1e3, (t5 - t4) * 1e3, (t6 - t5) * 1e3,
+           agree ? "yes" : "NO");
+
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,213 @@
+/*Compares the original set-intersection dominator fixpoint against the
+ *IFR_Dominators engine (CHK and Lengauer/Tarjan) on synthetic CFGs, then
+ *times IFR_DomTree dominance and nearest-common-dominator queries against
+ *walking the idom chain.
+ *
+ *  ./DomBench [maxBlocks] [maxBlocksForSetFixpoint]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <iterator>
+
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_Clock.h"
+
+using namespace std;
+
+/*A chain of blocks where each block falls through to the next and about a
+ *third also branch forward (if/else) or backward (loops) within a window,
+ *which is the shape findBlocks produces for compiled code.
+ */
+static void makeCFG(unsigned n, unsigned seed, IFR_CFG &cfg){
+
+  srand(seed);
+  cfg.clear();
+  for( unsigned i = 0; i < n; i++ ){
+    cfg.addBlock(16 * i, 4);
+  }
+  for( unsigned i = 0; i < n; i++ ){
+
+    if( i + 1 < n ){
+      cfg.addEdge(i, 16 * (i + 1));
+    }
+
+    if( rand() % 3 == 0 ){
+      unsigned window = 1 + rand() % 16;
+      unsigned t;
+      if( rand() % 4 == 0 ){
+        t = (i > window) ? i - window : 0;
+      }else{
+        t = (i + window < n) ? i + window : n - 1;
+      }
+      cfg.addEdge(i, 16 * t);
+    }
+
+  }
+  cfg.finish();
+
+}
+
+/*The algorithm computeDominators + computeIDoms used before the engine,
+ *transcribed over block indices.
+ */
+static void setFixpoint(const IFR_CFG &cfg, vector<unsigned> &idom){
+
+  unsigned n = cfg.size();
+  map<unsigned, set<unsigned> > dom;
+  set<unsigned> allNodes;
+  for( unsigned i = 0; i < n; i++ ){ allNodes.insert(i); }
+
+  dom[0].insert(0);
+  for( unsigned i = 1; i < n; i++ ){
+    dom[i].insert(allNodes.begin(), allNodes.end());
+  }
+
+  bool anyChange;
+  do{
+    anyChange = false;
+    for( unsigned i = 1; i < n; i++ ){
+      set<unsigned> intDoms;
+      bool firstPred = true;
+      for( const unsigned *p = cfg.predBegin(i); p != cfg.predEnd(i); p++ ){
+        set<unsigned> &pd = dom[ *p ];
+        if( firstPred ){
+          firstPred = false;
+          intDoms.insert(pd.begin(), pd.end());
+        }else{
+          set<unsigned> intersection;
+          set_intersection(intDoms.begin(), intDoms.end(), pd.begin(), pd.end(),
+                           inserter(intersection, intersection.begin()));
+          intDoms.swap(intersection);
+        }
+      }
+      intDoms.insert(i);
+      if( intDoms.size() != dom[i].size() ){
+        anyChange = true;
+      }
+      dom[i].swap(intDoms);
+    }
+  }while(anyChange);
+
+  idom.assign(n, IFR_Dominators::NoBlock);
+  for( unsigned b = 0; b < n; b++ ){
+    for( set<unsigned>::iterator di = dom[b].begin(); di != dom[b].end(); di++ ){
+      if( *di == b ){ continue; }
+      bool iDom = true;
+      for( set<unsigned>::iterator odi = dom[b].begin(); odi != dom[b].end(); odi++ ){
+        if( *odi == b || *odi == *di ){ continue; }
+        if( dom[*odi].find(*di) != dom[*odi].end() ){
+          iDom = false;
+        }
+      }
+      if( iDom ){
+        idom[b] = *di;
+      }
+    }
+  }
+
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned maxBlocks = argc > 1 ? atoi(argv[1]) : 100000;
+  unsigned maxSet = argc > 2 ? atoi(argv[2]) : 3000;
+
+  printf("%10s %14s %14s %14s %s\n", "blocks", "set-fixpoint", "chk", "lt", "agree");
+  for( unsigned n = 100; n <= maxBlocks; n *= 10 ){
+
+    IFR_CFG cfg;
+    makeCFG(n, n, cfg);
+
+    IFR_Dominators chk, lt;
+    double t0 = IFR_Clock();
+    chk.compute(cfg, DomCHK);
+    double t1 = IFR_Clock();
+    lt.compute(cfg, DomLT);
+    double t2 = IFR_Clock();
+
+    bool agree = true;
+    for( unsigned b = 0; b < n; b++ ){
+      if( chk.idom(b) != lt.idom(b) ){ agree = false; }
+    }
+
+    if( n <= maxSet ){
+
+      vector<unsigned> idom;
+      double s0 = IFR_Clock();
+      setFixpoint(cfg, idom);
+      double s1 = IFR_Clock();
+      for( unsigned b = 0; b < n; b++ ){
+        if( chk.reachable(b) && idom[b] != chk.idom(b) ){ agree = false; }
+      }
+      printf("%10u %12.3fms %12.3fms %12.3fms %s\n", n, (s1 - s0) * 1e3,
+             (t1 - t0) * 1e3, (t2 - t1) * 1e3, agree ? "yes" : "NO");
+
+    }else{
+
+      printf("%10u %14s %12.3fms %12.3fms %s\n", n, "skipped",
+             (t1 - t0) * 1e3, (t2 - t1) * 1e3, agree ? "yes" : "NO");
+
+    }
+
+  }
+
+  printf("\n%10s %14s %14s %14s %s\n", "blocks", "idom-walk", "domtree", "nca", "agree");
+  for( unsigned n = 100; n <= maxBlocks; n *= 10 ){
+
+    IFR_CFG cfg;
+    makeCFG(n, n, cfg);
+    IFR_Dominators doms;
+    doms.compute(cfg, DomCHK);
+    IFR_DomTree tree;
+    tree.build(doms);
+
+    const unsigned queries = 1000000;
+    vector<unsigned> qa(queries), qb(queries);
+    srand(n);
+    for( unsigned q = 0; q < queries; q++ ){
+      qa[q] = rand() % n;
+      qb[q] = rand() % n;
+    }
+
+    unsigned walkHits = 0, treeHits = 0, ncaSum = 0;
+    double t0 = IFR_Clock();
+    for( unsigned q = 0; q < queries; q++ ){
+      walkHits += doms.dominates(qa[q], qb[q]);
+    }
+    double t1 = IFR_Clock();
+    for( unsigned q = 0; q < queries; q++ ){
+      treeHits += tree.dominates(qa[q], qb[q]);
+    }
+    double t2 = IFR_Clock();
+    for( unsigned q = 0; q < queries; q++ ){
+      ncaSum += tree.nearestCommonDominator(qa[q], qb[q]);
+    }
+    double t3 = IFR_Clock();
+
+    /*Spot-check nca against the definition on the first few pairs*/
+    bool agree = walkHits == treeHits;
+    for( unsigned q = 0; q < 100 && n <= 10000; q++ ){
+      unsigned c = tree.nearestCommonDominator(qa[q], qb[q]);
+      if( c == IFR_Dominators::NoBlock ){ continue; }
+      if( !doms.dominates(c, qa[q]) || !doms.dominates(c, qb[q]) ){ agree = false; }
+      for( unsigned k = 0; k < n; k++ ){
+        if( k != c && doms.dominates(k, qa[q]) && doms.dominates(k, qb[q]) && doms.dominates(c, k) ){
+          agree = false;
+        }
+      }
+    }
+
+    printf("%10u %12.2fns %12.2fns %12.2fns %s\n", n, (t1 - t0) * 1e9 / queries,
+           (t2 - t1) * 1e9 / queries, (t3 - t2) * 1e9 / queries, agree ? "yes" : "NO");
+    if( ncaSum == 1 ){ printf("\n"); }  //keep the loop live
+
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,175 @@
+/*Cost of keeping dominators and dominance frontiers current as edges are
+ *discovered (IFR_DynDoms) against recomputing them from scratch.
+ *
+ *Routines are chains of blocks with if/else and loop edges, as in
+ *DomBench, except that some blocks are reached only through indirect
+ *jumps: they have no static predecessors, so they start out unreachable.
+ *Edges are then inserted one at a time, half of them to those blocks (as
+ *observed indirect jump targets) and half between random nearby blocks.
+ *After every insertion the tree and frontiers are checked against a full
+ *recomputation over the grown CFG.  Output is one JSON object per line:
+ *
+ *  {"bench":"DynDomBench","version":1,...}                    once
+ *  {"blocks":...,"reachable":...,"inserts":...,"update_us":...,"full_us":...,
+ *   "speedup":...,"moved_per_insert":...,"rebuilt_per_insert":...,
+ *   "visits_per_insert":...,"agree":...}                       per size
+ *
+ *  ./DynDomBench [-inserts n] [-max blocks] [-seed n]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+#include "IFR_DynDoms.h"
+#include "IFR_Clock.h"
+
+using namespace std;
+
+typedef vector< pair<unsigned, unsigned> > EdgeList;
+
+/*One in eight blocks is an indirect jump target with no static edge in.
+ *The chain steps over them, so every other block is reachable and the
+ *inserted edges land in the routine proper rather than in dead code.
+ */
+static void makeEdges(unsigned n, EdgeList &edges, vector<unsigned> &hidden){
+
+  vector<unsigned char> isHidden(n, 0);
+  for( unsigned i = 1; i < n; i++ ){
+    if( rand() % 8 == 0 ){
+      isHidden[i] = 1;
+      hidden.push_back(i);
+    }
+  }
+
+  unsigned last = 0;    //the last block the chain reached
+  for( unsigned i = 0; i < n; i++ ){
+    if( i > 0 && !isHidden[i] && last != i - 1 ){ edges.push_back(make_pair(last, i)); }
+    if( !isHidden[i] ){ last = i; }
+    if( i + 1 < n && !isHidden[i + 1] ){ edges.push_back(make_pair(i, i + 1)); }
+    if( rand() % 3 == 0 ){
+      unsigned window = 1 + rand() % 16;
+      unsigned t = rand() % 4 == 0 ? (i > window ? i - window : 0) : (i + window < n ? i + window : n - 1);
+      if( !isHidden[t] ){ edges.push_back(make_pair(i, t)); }
+    }
+  }
+
+}
+
+static void buildCFG(unsigned n, const EdgeList &edges, IFR_CFG &cfg){
+  cfg.clear();
+  for( unsigned i = 0; i < n; i++ ){ cfg.addBlock(16 * i, 4); }
+  for( unsigned e = 0; e < edges.size(); e++ ){ cfg.addEdge(edges[e].first, 16 * edges[e].second); }
+  cfg.finish();
+}
+
+static bool agrees(const IFR_DynDoms &dyn, const IFR_DomTree &tree, const IFR_DomFrontiers &df){
+
+  for( unsigned b = 0; b < dyn.size(); b++ ){
+    if( dyn.reachable(b) != tree.reachable(b) ){ return false; }
+    if( !tree.reachable(b) ){ continue; }
+    if( dyn.idom(b) != tree.idom(b) || dyn.depth(b) != tree.depth(b) ){ return false; }
+    const vector<unsigned> &f = dyn.frontier(b);
+    if( f.size() != (size_t)(df.end(b) - df.begin(b)) || !equal(f.begin(), f.end(), df.begin(b)) ){
+      return false;
+    }
+  }
+  return true;
+
+}
+
+static void usage(){
+  fprintf(stderr,"usage: DynDomBench [-inserts n] [-max blocks] [-seed n]\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned inserts = 200, maxBlocks = 100000, seed = 1;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-inserts") && i + 1 < argc ){ inserts = atoi(argv[++i]); }
+    else if( !strcmp(argv[i], "-max") && i + 1 < argc ){ maxBlocks = atoi(argv[++i]); }
+    else if( !strcmp(argv[i], "-seed") && i + 1 < argc ){ seed = atoi(argv[++i]); }
+    else{ usage(); }
+  }
+
+  printf("{\"bench\":\"DynDomBench\",\"version\":1,\"seed\":%u}\n", seed);
+  for( unsigned n = 1000; n <= maxBlocks; n *= 10 ){
+
+    srand(seed);
+    EdgeList edges;
+    vector<unsigned> hidden;
+    makeEdges(n, edges, hidden);
+
+    IFR_CFG cfg;
+    IFR_Dominators doms;
+    IFR_DomTree tree;
+    IFR_DomFrontiers df;
+    buildCFG(n, edges, cfg);
+    doms.compute(cfg, DomAuto);
+    tree.build(doms);
+    df.compute(cfg, tree);
+
+    IFR_DynDoms dyn;
+    dyn.init(cfg, tree, df);
+
+    double updateTime = 0, fullTime = 0;
+    unsigned done = 0, moved = 0, tries = 0;
+    bool agree = true;
+    /*Small routines can run out of new edges*/
+    while( done < inserts && agree && tries++ < 100 * inserts ){
+
+      /*An edge out of unreachable code changes nothing*/
+      unsigned x = rand() % n, y;
+      if( !dyn.reachable(x) ){ continue; }
+      if( done % 2 == 0 && !hidden.empty() ){
+        y = hidden[ rand() % hidden.size() ];
+      }else{
+        unsigned window = 1 + rand() % 64;
+        y = rand() % 2 ? (x > window ? x - window : 0) : (x + window < n ? x + window : n - 1);
+      }
+
+      double t0 = IFR_Clock();
+      bool added = dyn.insertEdge(x, y);
+      updateTime += IFR_Clock() - t0;
+      if( !added ){ continue; }
+      done++;
+      moved += dyn.movedBlocks().size();
+      edges.push_back(make_pair(x, y));
+
+      /*What an update replaces: the tree and frontiers from scratch over
+       *the grown CFG, which is not timed
+       */
+      buildCFG(n, edges, cfg);
+      t0 = IFR_Clock();
+      doms.compute(cfg, DomAuto);
+      tree.build(doms);
+      df.compute(cfg, tree);
+      fullTime += IFR_Clock() - t0;
+      agree = agrees(dyn, tree, df);
+
+    }
+    if( !agree ){
+      fprintf(stderr,"DynDomBench: %u blocks: insertion %u does not match a full recomputation\n", n, done);
+    }
+
+    double perUpdate = done ? updateTime / done : 0, perFull = done ? fullTime / done : 0;
+    unsigned reachable = 0;
+    for( unsigned b = 0; b < n; b++ ){ reachable += dyn.reachable(b); }
+    printf("{\"blocks\":%u,\"reachable\":%u,\"edges\":%u,\"inserts\":%u,\"update_us\":%.2f,\"full_us\":%.2f,\"speedup\":%.1f,"
+           "\"moved_per_insert\":%.2f,\"rebuilt_per_insert\":%.2f,\"visits_per_insert\":%.1f,\"agree\":%s}\n",
+           n, reachable, cfg.numEdges(), done, perUpdate * 1e6, perFull * 1e6, perUpdate > 0 ? perFull / perUpdate : 0,
+           done ? (double)moved / done : 0, done ? (double)dyn.frontiersRebuilt / done : 0,
+           done ? (double)dyn.visits / done : 0, agree ? "true" : "false");
+    fflush(stdout);
+    if( !agree ){ return 1; }
+
+  }
+  return 0;
+
+}
@@ -0,0 +1,147 @@
+/*Overhead and scaling of the IFRit runtime's metadata.
+ *
+ *Each thread makes a stream of 8 byte accesses, a given percentage of them
+ *to an array all threads share and the rest to its own array, with a
+ *region boundary every few accesses, the way the instrumented program
+ *would call IFR_ActiveSet::access and endAll.  The same stream runs
+ *natively, against the striped IFR_ActiveTable, and against a table of
+ *one stripe (one global lock) for 1, 2, 4, ... threads, and the table
+ *reports ns per access per thread, aggregate throughput and the overhead
+ *over native.  Writes to the shared array are IFR conflicts, counted.
+ *
+ *  ./IFRBench [maxThreads] [shared%] [write%] [regionLength] [stripeBits]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "IFR_ActiveTable.h"
+#include "IFR_Threads.h"
+#include "IFR_Clock.h"
+
+using namespace std;
+
+#define WORDS (1 << 16)       //per array
+#define ACCESSES 2000000      //per thread
+
+static unsigned sharedPct, writePct, regionLength;
+static UINT64 shared[WORDS];
+static IFR_ActiveTable *table;      //0: native
+static volatile unsigned ready, go;
+
+class Worker{
+public:
+  unsigned id;
+  UINT64 *own;
+  UINT64 sum;
+  UINT64 conflicts;
+  IFR_Thread thread;
+  char pad[64];
+};
+
+static inline UINT64 next(UINT64 &x){
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return x;
+}
+
+static void work(void *arg){
+
+  Worker *w = (Worker *)arg;
+  IFR_ActiveSet set;
+  UINT64 x = 88172645463325252ULL + w->id, sum = 0;
+
+  __sync_fetch_and_add(&ready, 1);
+  while( !go ){ IFR_Yield(); }
+
+  for( unsigned i = 0; i < ACCESSES; i++ ){
+
+    UINT64 r = next(x);
+    UINT64 *p = (r % 100 < sharedPct ? shared : w->own) + ((r >> 8) & (WORDS - 1));
+    bool write = (r >> 24) % 100 < writePct;
+    if( table != 0 ){
+      IFR_Conflict c;
+      set.access(*table, w->id, (ADDRINT)p, 8, write, (ADDRINT)i, c);
+    }
+    if( write ){
+      *(volatile UINT64 *)p = i;
+    }else{
+      sum += *(volatile UINT64 *)p;
+    }
+    if( table != 0 && i % regionLength == regionLength - 1 ){ set.endAll(*table, w->id); }
+
+  }
+  if( table != 0 ){ set.endAll(*table, w->id); }
+
+  w->sum = sum;
+  w->conflicts = set.conflicts;
+
+}
+
+/*Seconds for every thread's stream; conflicts in c*/
+static double run(unsigned threads, IFR_ActiveTable *t, UINT64 &c){
+
+  table = t;
+  ready = go = 0;
+  vector<Worker> workers(threads);
+  for( unsigned i = 0; i < threads; i++ ){
+    workers[i].id = i;
+    workers[i].own = new UINT64[WORDS]();
+    IFR_SpawnThread(work, &workers[i], &workers[i].thread);
+  }
+  while( ready < threads ){ IFR_Yield(); }
+
+  double t0 = IFR_Clock();
+  go = 1;
+  for( unsigned i = 0; i < threads; i++ ){
+    IFR_JoinThread(workers[i].thread);
+  }
+  double t1 = IFR_Clock();
+
+  c = 0;
+  for( unsigned i = 0; i < threads; i++ ){
+    c += workers[i].conflicts;
+    delete [] workers[i].own;
+  }
+  return t1 - t0;
+
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned maxThreads = argc > 1 ? atoi(argv[1]) : 32;
+  sharedPct = argc > 2 ? atoi(argv[2]) : 10;
+  writePct = argc > 3 ? atoi(argv[3]) : 0;
+  regionLength = argc > 4 ? atoi(argv[4]) : 16;
+  unsigned stripeBits = argc > 5 ? atoi(argv[5]) : 12;
+  if( maxThreads > IFR_ActiveTable::MaxThreads ){ maxThreads = IFR_ActiveTable::MaxThreads; }
+  if( regionLength == 0 ){ regionLength = 1; }
+
+  printf("%u accesses per thread, %u%% shared, %u%% writes, regions of %u accesses, %u stripes\n",
+         ACCESSES, sharedPct, writePct, regionLength, 1u << stripeBits);
+  printf("%8s %10s %10s %10s %10s %10s %12s %12s\n", "threads", "native", "striped", "global",
+         "overhead", "vs global", "Macc/s", "conflicts");
+
+  for( unsigned t = 1; t <= maxThreads; t *= 2 ){
+
+    IFR_ActiveTable striped, global;
+    striped.init(stripeBits);
+    global.init(0);
+
+    UINT64 c, cs, cg;
+    double native = run(t, 0, c);
+    double s = run(t, &striped, cs);
+    double g = run(t, &global, cg);
+
+    /*Wall time per access on each thread*/
+    double n = (double)ACCESSES;
+    printf("%8u %8.1fns %8.1fns %8.1fns %9.1fx %9.1fx %12.1f %12llu\n", t,
+           native * 1e9 / n, s * 1e9 / n, g * 1e9 / n, s / native, g / s,
+           t * n / s / 1e6, (unsigned long long)cs);
+
+  }
+
+  return 0;
+
+}
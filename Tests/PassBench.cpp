@@ -0,0 +1,443 @@
+/*Times every core analysis pass on synthetic routines of controllable
+ *shape, for tracking the passes across changes.
+ *
+ *A shape is a mix of statements: straight-line work blocks (loads, an ALU
+ *op and a store), if-cascades of arms conditional branches meeting at one
+ *join (fan-out 2 per branch, fan-in arms at the join), switches through
+ *a resolved jump table of width cases, calls, and loops nested up to
+ *depth deep with a counted induction register.  irreducible percent of
+ *loops also get a side entry into their latch, and quiet percent have a
+ *body that only calls, touching no memory, so the IFRs active before
+ *them are what their calls end (see IFR_Regions' hoisting).
+ *
+ *Each pass runs alone, its dependencies already computed, and is timed
+ *over enough repetitions to process about a million blocks.  Output is
+ *one JSON object per line, stable across versions of this benchmark
+ *unless "version" changes:
+ *
+ *  {"bench":"PassBench","version":1,"alg":...}                 once
+ *  {"shape":...,"blocks":...,"loops":...,"irreducible":...}    per routine
+ *  {"shape":...,"blocks":...,"pass":...,"ns_per_block":...,
+ *   "peak_bytes":...,"alloc_bytes":...}                        per pass
+ *  {"maxrss_kb":...}                                           once
+ *
+ *peak_bytes is the most heap the pass held above what was live when it
+ *started, including its results; alloc_bytes is everything it allocated.
+ *
+ *  ./PassBench [-lt] [-seed n] [-max blocks] [-shape name]
+ *  ./PassBench -custom depth,irreducible,arms,switch,loop%,if%,switch%
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "IFR_Analysis.h"
+#include "IFR_Clock.h"
+#include "RoutineBuilder.h"
+
+using namespace std;
+
+/*Heap accounting: every block carries its size in front of it*/
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static size_t allocatedBytes = 0;
+
+void *operator new(size_t n){
+  size_t *p = (size_t *)malloc(n + sizeof(size_t) * 2);
+  if( p == 0 ){ throw std::bad_alloc(); }
+  p[0] = n;
+  liveBytes += n;
+  allocatedBytes += n;
+  if( liveBytes > peakBytes ){ peakBytes = liveBytes; }
+  return p + 2;
+}
+
+void operator delete(void *q) throw(){
+  if( q == 0 ){ return; }
+  size_t *p = (size_t *)q - 2;
+  liveBytes -= p[0];
+  free(p);
+}
+
+void operator delete(void *q, size_t) throw(){
+  operator delete(q);
+}
+
+class Shape{
+
+public:
+
+  const char *name;
+  unsigned depth;         //deepest loop nesting
+  unsigned irreducible;   //percent of loops with a side entry
+  unsigned quiet;         //percent of loops whose body is only a call
+  unsigned arms;          //branches of an if-cascade
+  unsigned width;         //cases of a switch
+  unsigned loopPct;       //statement mix, percent; the rest is work
+  unsigned ifPct;
+  unsigned switchPct;
+
+};
+
+static Shape shapes[] = {
+  /*name          depth irr quiet arms width loop if switch*/
+  { "diamonds",     0,   0,   0,    2,   0,    0, 40,  0 },
+  { "fanin",        0,   0,   0,   16,   0,    0, 30,  0 },
+  { "loops",        3,   0,   0,    2,   0,   15, 20,  0 },
+  { "deeploops",   12,   0,   0,    2,   0,   35, 10,  0 },
+  { "irreducible",  3,  50,   0,    2,   0,   20, 20,  0 },
+  { "switch",       1,   0,   0,    2,  64,    5, 10, 10 },
+  { "callloops",    2,   0,  60,    2,   0,   25, 20,  0 },
+  { "mixed",        4,  10,  10,    4,  16,   10, 20,  3 }
+};
+static const unsigned numShapes = sizeof(shapes) / sizeof(shapes[0]);
+
+#define NUM_GPRS 8
+#define IV_REG(d) (NUM_GPRS + (d))      //induction register of the loop at depth d
+
+/*Emits one synthetic routine into an analysis' code, memrefs and regOps*/
+class Generator : public RoutineBuilder{
+
+  IFR_Analysis &a;
+  const Shape &s;
+
+  unsigned blocks;                    //leaders so far: labels, and instructions after jumps
+  unsigned lastLeader;
+
+  void place(unsigned label){
+    RoutineBuilder::place(label);
+    leader();
+  }
+
+  void leader(){
+    if( lastLeader != a.code.ins.size() ){
+      lastLeader = a.code.ins.size();
+      blocks++;
+    }
+  }
+
+  unsigned reg(){
+    return rand() % NUM_GPRS;
+  }
+
+  /*Adds one instruction; its refs and register operands go before*/
+  void emit(IFR_InsKind kind, unsigned char flags){
+    a.code.add(nextAddress(), 4, kind, 0);
+    a.memrefs.refStart.push_back(a.memrefs.refs.size());
+    a.regOps.endIns(flags);
+  }
+
+  void memref(unsigned b, ADDRDELTA disp, MemOpType type){
+    IFR_MemoryRef r(b, disp, IFR_MemoryRef::NoReg, 1, type);
+    r.size = 8;
+    a.memrefs.refs.push_back(r);
+    a.regOps.addUse(b);
+  }
+
+  void jump(IFR_InsKind kind, unsigned label){
+    target(label);
+    emit(kind, 0);
+    leader();
+  }
+
+  /*Within a loop, addresses are often strided off its induction register*/
+  void work(unsigned depth){
+
+    unsigned b = (depth > 0 && rand() % 2) ? IV_REG(depth - 1) : reg();
+    unsigned d = reg(), x = reg();
+    memref(b, 8 * (rand() % 4), MemRead);
+    a.regOps.addDef(d);
+    emit(InsOther, IFR_INS_MEMREAD);
+
+    a.regOps.addUse(d);
+    a.regOps.addUse(x);
+    a.regOps.addDef(d);
+    emit(InsOther, 0);
+
+    a.regOps.addUse(d);
+    memref(b, 8 * (rand() % 4), MemWrite);
+    emit(InsOther, IFR_INS_MEMWRITE);
+
+  }
+
+  void call(){
+    for( unsigned r = 0; r < NUM_GPRS / 2; r++ ){
+      a.regOps.addDef(r);
+    }
+    emit(InsCall, IFR_INS_CALL);
+  }
+
+  void compare(unsigned r){
+    a.regOps.addUse(r);
+    emit(InsOther, 0);
+  }
+
+  void ifCascade(unsigned depth){
+
+    unsigned join = newLabel();
+    vector<unsigned> armLabels;
+    for( unsigned i = 0; i + 1 < s.arms; i++ ){
+      armLabels.push_back(newLabel());
+      compare(reg());
+      jump(InsCondJump, armLabels.back());
+    }
+    work(depth);
+    jump(InsJump, join);
+    for( unsigned i = 0; i < armLabels.size(); i++ ){
+      place(armLabels[i]);
+      work(depth);
+      jump(InsJump, join);
+    }
+    place(join);
+
+  }
+
+  void switchStmt(unsigned depth){
+
+    unsigned join = newLabel(), other = newLabel();
+    unsigned index = reg();
+    compare(index);
+    jump(InsCondJump, other);
+
+    a.regOps.addUse(index);
+    unsigned table = newTable();
+    emit(InsIndirectJump, 0);
+    leader();
+    for( unsigned c = 0; c < s.width; c++ ){
+      unsigned label = newLabel();
+      addCase(table, label);
+      place(label);
+      work(depth);
+      jump(InsJump, join);
+    }
+    place(other);
+    work(depth);
+    place(join);
+
+  }
+
+  void loop(unsigned depth, unsigned budget){
+
+    unsigned head = newLabel(), latch = newLabel();
+    unsigned iv = IV_REG(depth);
+    if( (unsigned)(rand() % 100) < s.irreducible ){
+      compare(reg());
+      jump(InsCondJump, latch);
+    }
+    a.regOps.addDef(iv);
+    emit(InsOther, 0);
+
+    place(head);
+    if( (unsigned)(rand() % 100) < s.quiet ){
+      call();
+    }else{
+      sequence(depth + 1, budget);
+    }
+
+    place(latch);
+    a.regOps.addStep(iv, 8);
+    emit(InsOther, 0);
+    compare(iv);
+    jump(InsCondJump, head);
+
+  }
+
+  /*Emits statements until budget more blocks have started; needs ifPct
+   *or switchPct, since work alone starts none
+   */
+  void sequence(unsigned depth, unsigned budget){
+
+    unsigned start = blocks;
+    work(depth);
+    while( blocks - start < budget ){
+
+      unsigned r = rand() % 100;
+      unsigned left = budget - (blocks - start);
+      if( depth < s.depth && r < s.loopPct && left > 4 ){
+        loop(depth, 1 + rand() % (left / 2));
+      }else if( (r -= s.loopPct) < s.ifPct ){
+        ifCascade(depth);
+      }else if( (r -= s.ifPct) < s.switchPct && s.width > 0 ){
+        switchStmt(depth);
+      }else if( rand() % 16 == 0 ){
+        call();
+        work(depth);
+      }else{
+        work(depth);
+      }
+
+    }
+
+  }
+
+public:
+
+  Generator(IFR_Analysis &analysis, const Shape &shape, ADDRINT address)
+    : RoutineBuilder(analysis.code, address), a(analysis), s(shape){
+    blocks = 1;
+    lastLeader = 0;
+  }
+
+  void generate(unsigned blocks){
+
+    a.code.clear();
+    a.memrefs.clear();
+    a.regOps.clear();
+
+    sequence(0, blocks);
+    a.regOps.addUse(0);
+    emit(InsReturn, 0);
+    finish();
+
+  }
+
+};
+
+static const unsigned passes[] = {
+  IFR_PASS_CFG, IFR_PASS_DOMTREE, IFR_PASS_DF, IFR_PASS_SSA,
+  IFR_PASS_LOOPS, IFR_PASS_RANGES, IFR_PASS_REDUNDANT, IFR_PASS_REGIONS,
+  IFR_PASS_LIVENESS, IFR_PASS_COALESCE, IFR_PASS_POSTDOM, IFR_PASS_HOISTENDS, IFR_PASS_PATHS
+};
+static const char *passNames[] = {
+  "cfg", "domtree", "df", "ssa", "loops", "ranges", "redundant", "regions", "liveness", "coalesce", "postdom",
+  "hoistends", "paths"
+};
+static const unsigned numPasses = sizeof(passes) / sizeof(passes[0]);
+
+static void bench(const Shape &s, unsigned target, unsigned seed, IFR_DomAlgorithm alg){
+
+  const ADDRINT entry = 0x400000;
+  IFR_Analysis proto(entry, 0, 0, alg);
+  srand(seed);
+  Generator g(proto, s, entry);
+  g.generate(target);
+
+  /*One untimed run describes what was generated*/
+  {
+    IFR_Analysis a(entry, 0, 0, alg);
+    a.code = proto.code;
+    a.memrefs = proto.memrefs;
+    a.regOps = proto.regOps;
+    a.codeReady();
+    a.compute(IFR_PASS_RANGES | IFR_PASS_REDUNDANT | IFR_PASS_REGIONS | IFR_PASS_LIVENESS | IFR_PASS_COALESCE |
+              IFR_PASS_HOISTENDS | IFR_PASS_PATHS);
+    unsigned irreducible = 0, maxDepth = 0;
+    for( unsigned l = 0; l < a.loops.size(); l++ ){
+      if( a.loops.loop(l).kind == LoopIrreducible ){ irreducible++; }
+      maxDepth = max(maxDepth, a.loops.loop(l).depth);
+    }
+    printf("{\"shape\":\"%s\",\"target\":%u,\"blocks\":%u,\"edges\":%u,\"insns\":%u,\"memrefs\":%u,"
+           "\"loops\":%u,\"irreducible\":%u,\"max_depth\":%u,\"ssa_values\":%u,\"redundant\":%u,"
+           "\"liveness_sweeps\":%u,\"bitset_kernel\":\"%s\",\"coalesce_groups\":%u,\"coalesced\":%u,"
+           "\"control_deps\":%u,\"ends_hoisted\":%u,\"ends_unhoisted\":%u,\"paths\":%llu,\"path_probes\":%u}\n",
+           s.name, target, a.cfg.size(), a.cfg.numEdges(), (unsigned)a.code.ins.size(),
+           (unsigned)a.memrefs.refs.size(), a.loops.size(), irreducible, maxDepth,
+           a.ssa.numValues(), a.redundant.numRedundant,
+           a.liveness.sweeps(), IFR_BitsKernel(), (unsigned)a.coalesce.groups.size(), a.coalesce.numCoalesced,
+           a.postDom.numDependences(), a.regions.numHoisted, a.regions.numUnhoisted,
+           (unsigned long long)a.paths.numPaths, (unsigned)a.paths.probes.size());
+    target = a.cfg.size();
+  }
+
+  unsigned reps = max(3u, 1000000 / target);
+  vector<double> time(numPasses, 0);
+  vector<size_t> peak(numPasses, 0), allocated(numPasses, 0);
+  for( unsigned r = 0; r < reps; r++ ){
+
+    IFR_Analysis a(entry, 0, 0, alg);
+    a.code = proto.code;
+    a.memrefs = proto.memrefs;
+    a.regOps = proto.regOps;
+    a.codeReady();
+    for( unsigned p = 0; p < numPasses; p++ ){
+      size_t allocatedBefore = allocatedBytes, liveBefore = liveBytes;
+      peakBytes = liveBytes;
+      double t0 = IFR_Clock();
+      a.compute(passes[p]);
+      time[p] += IFR_Clock() - t0;
+      peak[p] = max(peak[p], peakBytes - liveBefore);
+      allocated[p] = max(allocated[p], allocatedBytes - allocatedBefore);
+    }
+
+  }
+
+  for( unsigned p = 0; p < numPasses; p++ ){
+    printf("{\"shape\":\"%s\",\"blocks\":%u,\"pass\":\"%s\",\"reps\":%u,\"ns_per_block\":%.2f,"
+           "\"peak_bytes\":%lu,\"alloc_bytes\":%lu}\n",
+           s.name, target, passNames[p], reps, time[p] * 1e9 / reps / target,
+           (unsigned long)peak[p], (unsigned long)allocated[p]);
+  }
+  fflush(stdout);
+
+}
+
+static void usage(){
+  fprintf(stderr,"usage: PassBench [-lt] [-seed n] [-max blocks] [-shape name]\n"
+                 "       PassBench [-lt] [-seed n] [-max blocks] -custom depth,irreducible,arms,switch,loop%%,if%%,switch%%\n"
+                 "shapes:");
+  for( unsigned i = 0; i < numShapes; i++ ){
+    fprintf(stderr," %s", shapes[i].name);
+  }
+  fprintf(stderr,"\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  IFR_DomAlgorithm alg = DomCHK;
+  unsigned seed = 1, maxBlocks = 100000;
+  const char *only = 0;
+  Shape custom;
+  bool useCustom = false;
+
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-lt") ){
+      alg = DomLT;
+    }else if( !strcmp(argv[i], "-seed") && i + 1 < argc ){
+      seed = atoi(argv[++i]);
+    }else if( !strcmp(argv[i], "-max") && i + 1 < argc ){
+      maxBlocks = atoi(argv[++i]);
+    }else if( !strcmp(argv[i], "-shape") && i + 1 < argc ){
+      only = argv[++i];
+    }else if( !strcmp(argv[i], "-custom") && i + 1 < argc ){
+      custom.name = "custom";
+      custom.quiet = 0;
+      if( sscanf(argv[++i], "%u,%u,%u,%u,%u,%u,%u", &custom.depth, &custom.irreducible, &custom.arms,
+                 &custom.width, &custom.loopPct, &custom.ifPct, &custom.switchPct) != 7 ||
+          custom.arms < 2 || custom.ifPct + (custom.width ? custom.switchPct : 0) == 0 ||
+          custom.loopPct + custom.ifPct + custom.switchPct > 100 ){
+        usage();
+      }
+      useCustom = true;
+    }else{
+      usage();
+    }
+  }
+
+  vector<const Shape *> run;
+  if( useCustom ){
+    run.push_back(&custom);
+  }
+  for( unsigned i = 0; i < numShapes && !useCustom; i++ ){
+    if( only == 0 || !strcmp(only, shapes[i].name) ){ run.push_back(&shapes[i]); }
+  }
+  if( run.empty() ){ usage(); }
+
+  printf("{\"bench\":\"PassBench\",\"version\":1,\"alg\":\"%s\",\"seed\":%u}\n",
+         alg == DomLT ? "lt" : "chk", seed);
+  for( unsigned i = 0; i < run.size(); i++ ){
+    for( unsigned n = 100; n <= maxBlocks; n *= 10 ){
+      bench(*run[i], n, seed + n, alg);
+    }
+  }
+
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  printf("{\"maxrss_kb\":%ld}\n", ru.ru_maxrss);
+  return 0;
+
+}
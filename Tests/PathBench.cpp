@@ -0,0 +1,442 @@
+/*Overhead of Ball-Larus path profiling (IFR_PathProfile) against naive
+ *per-block counting, on simulated runs of synthetic routines.
+ *
+ *A routine is a mix of statements: straight-line work, calls, if/else
+ *with nested ifs in the arms, loops nested up to depth deep, switches
+ *through a resolved jump table and guarded early returns.  irreducible
+ *percent of loops also get a side entry into their latch, and fallOff
+ *percent of routines end in a loop whose latch falls off the end of the
+ *routine instead of returning.  Every
+ *conditional jump gets a fixed bias, loop latches mostly iterate and
+ *switches favour one case, so a few paths carry most of the runs.
+ *
+ *The routine is then interpreted from its entry, over and over, with the
+ *path profile's probes run where the Pin tool would put them (before an
+ *instruction, on its branch taken or its fall through, or before a jump
+ *table for one target), and every path counted is checked to regenerate
+ *to exactly the blocks that ran.
+ *
+ *In the Pin tool a probe and a block count are each one analysis call, so
+ *overhead is counted rather than timed: per-block counting makes one call
+ *per block run, path profiling probes_per_block (make pathrun in Tests
+ *times the two under Pin).  Output is one JSON object per line:
+ *
+ *  {"bench":"PathBench","version":1,...}                          once
+ *  {"shape":...,"blocks":...,"irreducible":...,"paths":...,
+ *   "path_sites":...,"probes_per_block":...,"agree":...}          per routine
+ *
+ *  ./PathBench [-seed n] [-runs blocks] [-shape name]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "IFR_CFG.h"
+#include "IFR_Loops.h"
+#include "IFR_PathProfile.h"
+#include "IFR_Clock.h"
+#include "RoutineBuilder.h"
+
+using namespace std;
+
+class Shape{
+
+public:
+
+  const char *name;
+  unsigned statements;
+  unsigned depth;         //deepest loop nesting
+  unsigned loopPct;       //statement mix, percent; the rest is work and calls
+  unsigned ifPct;
+  unsigned switchPct;
+  unsigned returnPct;
+  unsigned irreducible;   //percent of loops with a side entry
+  unsigned fallOff;       //percent of routines ending in a loop with no return after it
+
+};
+
+static Shape shapes[] = {
+  /*name         stmts depth loop  if switch return irr fall*/
+  { "straight",    40,   0,    0,  10,   0,     5,    0,   0 },
+  { "branchy",     24,   0,    0,  60,   0,    10,    0,   0 },
+  { "loops",       30,   3,   25,  25,   0,     0,    0,  25 },
+  { "irreducible", 24,   3,   30,  20,   0,     5,   60,  50 },
+  { "switch",      20,   1,   10,  20,  15,     5,    0,   0 },
+  { "mixed",       30,   2,   15,  30,   5,     5,   10,  10 }
+};
+static const unsigned numShapes = sizeof(shapes) / sizeof(shapes[0]);
+
+/*Emits one synthetic routine*/
+class Generator : public RoutineBuilder{
+
+  const Shape &s;
+  unsigned nesting;
+
+  void emit(IFR_InsKind kind){
+    code.add(nextAddress(), 4, kind, 0);
+  }
+
+  void jump(IFR_InsKind kind, unsigned label){
+    target(label);
+    emit(kind);
+  }
+
+  void work(){
+    for( unsigned i = 1 + rand() % 3; i > 0; i-- ){ emit(InsOther); }
+  }
+
+  void arm(){
+    work();
+    if( nesting < 2 && rand() % 3 == 0 ){
+      nesting++;
+      ifElse();
+      nesting--;
+    }
+  }
+
+  void ifElse(){
+
+    unsigned other = newLabel(), join = newLabel();
+    emit(InsOther);
+    jump(InsCondJump, other);
+    arm();
+    if( rand() % 2 ){
+      jump(InsJump, join);
+      place(other);
+      arm();
+    }else{
+      place(other);
+    }
+    place(join);
+    work();
+
+  }
+
+  void loop(unsigned depth){
+
+    unsigned head = newLabel(), latch = newLabel();
+    if( (unsigned)(rand() % 100) < s.irreducible ){
+      emit(InsOther);
+      jump(InsCondJump, latch);
+    }
+    emit(InsOther);
+    place(head);
+    sequence(depth + 1, 1 + rand() % 4);
+    place(latch);
+    emit(InsOther);
+    latches.push_back(code.ins.size());
+    jump(InsCondJump, head);
+
+  }
+
+  void switchStmt(){
+
+    unsigned join = newLabel();
+    emit(InsOther);
+    unsigned table = newTable();
+    emit(InsIndirectJump);
+    for( unsigned c = 4 + rand() % 5; c > 0; c-- ){
+      unsigned label = newLabel();
+      addCase(table, label);
+      place(label);
+      work();
+      jump(InsJump, join);
+    }
+    place(join);
+    work();
+
+  }
+
+  void earlyReturn(){
+    unsigned skip = newLabel();
+    emit(InsOther);
+    guards.push_back(code.ins.size());
+    jump(InsCondJump, skip);
+    work();
+    emit(InsReturn);
+    place(skip);
+    work();
+  }
+
+  void sequence(unsigned depth, unsigned count){
+
+    work();
+    for( unsigned i = 0; i < count; i++ ){
+      unsigned r = rand() % 100;
+      if( depth < s.depth && r < s.loopPct ){
+        loop(depth);
+      }else if( (r -= s.loopPct) < s.ifPct ){
+        ifElse();
+      }else if( (r -= s.ifPct) < s.switchPct ){
+        switchStmt();
+      }else if( (r -= s.switchPct) < s.returnPct ){
+        earlyReturn();
+      }else if( rand() % 4 == 0 ){
+        emit(InsCall);
+        work();
+      }else{
+        work();
+      }
+    }
+
+  }
+
+public:
+
+  vector<unsigned> latches;   //conditional jumps back to a loop header
+  vector<unsigned> guards;    //conditional jumps around an early return
+
+  Generator(IFR_RoutineCode &c, const Shape &shape, ADDRINT address) : RoutineBuilder(c, address), s(shape){
+    nesting = 0;
+  }
+
+  void generate(){
+
+    code.clear();
+    sequence(0, s.statements);
+    if( (unsigned)(rand() % 100) < s.fallOff ){
+      loop(0);
+    }else{
+      emit(InsReturn);
+    }
+    finish();
+
+  }
+
+};
+
+
+/*Interprets a routine with its branches decided by fixed biases*/
+class Simulator{
+
+  const IFR_RoutineCode &code;
+  const IFR_CFG &cfg;
+  const IFR_PathProfile &pp;
+
+  vector<unsigned> blockAt;     //block entered at each instruction, or NoBlock
+  vector<unsigned> targetIns;   //direct jump targets
+  vector<unsigned> bias;        //conditional jumps: taken per 1024
+  vector<unsigned> probeStart;  //probes of instruction i are [probeStart[i], probeStart[i+1])
+  vector< vector<unsigned> > cases;   //jump tables: target instructions, hot case first
+  vector< vector<ADDRINT> > caseAddrs;
+
+  unsigned state;
+  UINT64 reg;
+  vector<unsigned> segment;
+  vector<unsigned> regenerated;
+
+  unsigned random(){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  void count(UINT64 id){
+    counts[id]++;
+    pp.path(id, regenerated);
+    if( regenerated != segment ){ agree = false; }
+    segment.clear();
+  }
+
+  void probe(const IFR_PathProbe &p){
+    fired[p.kind]++;
+    switch( p.kind ){
+      case ProbeEnter:   reg = 0; break;
+      case ProbeAdd:     reg += p.inc; break;
+      case ProbeEnd:     count(reg + p.inc); break;
+      case ProbeRestart: count(reg + p.inc); reg = p.reset; break;
+    }
+  }
+
+public:
+
+  map<UINT64, UINT64> counts;
+  UINT64 blocksRun;
+  UINT64 fired[4];    //by IFR_ProbeKind
+  bool agree;
+
+  Simulator(const IFR_RoutineCode &c, const IFR_CFG &g, const IFR_PathProfile &p,
+            const vector<unsigned> &latches, const vector<unsigned> &guards) : code(c), cfg(g), pp(p){
+
+    unsigned n = code.ins.size();
+    blockAt.assign(n, IFR_CFG::NoBlock);
+    for( unsigned b = 0; b < cfg.size(); b++ ){ blockAt[ cfg.insBegin(b) ] = b; }
+    targetIns.assign(n, 0);
+    bias.assign(n, 0);
+    probeStart.assign(n + 1, 0);
+    cases.assign(n, vector<unsigned>());
+    caseAddrs.assign(n, vector<ADDRINT>());
+
+    static const unsigned biases[] = { 51, 307, 512, 717, 973 };
+    for( unsigned i = 0; i < n; i++ ){
+      const IFR_InsRecord &r = code.ins[i];
+      if( r.kind == InsJump || r.kind == InsCondJump ){ targetIns[i] = code.find(r.target); }
+      if( r.kind == InsCondJump ){ bias[i] = biases[rand() % 5]; }
+      if( r.kind == InsIndirectJump && code.resolved(i) ){
+        unsigned t = code.table(i);
+        for( const ADDRINT *a = code.tableBegin(t); a != code.tableEnd(t); a++ ){
+          caseAddrs[i].push_back(*a);
+          cases[i].push_back( code.find(*a) );
+        }
+        unsigned hot = rand() % cases[i].size();
+        swap(cases[i][0], cases[i][hot]);
+        swap(caseAddrs[i][0], caseAddrs[i][hot]);
+      }
+      probeStart[i + 1] = pp.profiled() ? pp.probeEnd(i) : 0;
+    }
+    for( unsigned k = 0; k < latches.size(); k++ ){ bias[ latches[k] ] = 768 + rand() % 224; }
+    for( unsigned k = 0; k < guards.size(); k++ ){ bias[ guards[k] ] = 1014; }
+
+    state = 1;
+    reg = 0;
+    blocksRun = 0;
+    fired[0] = fired[1] = fired[2] = fired[3] = 0;
+    agree = true;
+
+  }
+
+  /*One call of the routine*/
+  void run(){
+
+    unsigned pc = 0;
+    for( ;; ){
+
+      const IFR_InsRecord &r = code.ins[pc];
+      unsigned b = blockAt[pc];
+      if( b != IFR_CFG::NoBlock ){
+        blocksRun++;
+        segment.push_back(b);
+      }
+
+      unsigned next = pc + 1;
+      ADDRINT to = 0;
+      bool taken = false, done = false;
+      switch( r.kind ){
+        case InsCondJump:
+          taken = random() % 1024 < bias[pc];
+          if( taken ){ next = targetIns[pc]; }
+          break;
+        case InsJump:
+          next = targetIns[pc];
+          break;
+        case InsIndirectJump: {
+          unsigned c = random() % 4 ? 0 : random() % cases[pc].size();
+          next = cases[pc][c];
+          to = caseAddrs[pc][c];
+          break;
+        }
+        case InsReturn:
+          done = true;
+          break;
+        default:
+          break;
+      }
+
+      for( unsigned k = probeStart[pc]; k < probeStart[pc + 1]; k++ ){
+        const IFR_PathProbe &p = pp.probes[k];
+        bool fires = p.point == ProbeBefore ? (p.target == 0 || p.target == to) : (p.point == ProbeTaken) == taken;
+        if( fires ){ probe(p); }
+      }
+      if( done || next >= code.ins.size() ){ return; }
+      pc = next;
+
+    }
+
+  }
+
+
+};
+
+static void bench(const Shape &s, unsigned seed, UINT64 budget){
+
+  srand(seed);
+  IFR_RoutineCode code;
+  Generator g(code, s, 0x400000);
+  g.generate();
+  IFR_CFG cfg;
+  code.buildCFG(cfg);
+  IFR_LoopForest loops;
+  loops.compute(cfg);
+  IFR_PathProfile pp;
+  double start = IFR_Clock();
+  pp.compute(code, cfg, loops);
+  double computeTime = IFR_Clock() - start;
+
+  if( !pp.profiled() ){
+    printf("{\"shape\":\"%s\",\"seed\":%u,\"blocks\":%u,\"status\":%u}\n", s.name, seed, cfg.size(), pp.status);
+    return;
+  }
+
+  Simulator sim(code, cfg, pp, g.latches, g.guards);
+  while( sim.blocksRun < budget ){ sim.run(); }
+
+  unsigned irreducible = 0;
+  for( unsigned l = 0; l < loops.size(); l++ ){
+    if( loops.loop(l).kind == LoopIrreducible ){ irreducible++; }
+  }
+
+  vector<UINT64> counts;
+  for( map<UINT64, UINT64>::iterator c = sim.counts.begin(); c != sim.counts.end(); c++ ){ counts.push_back(c->second); }
+  sort(counts.rbegin(), counts.rend());
+  UINT64 total = 0, top = 0;
+  for( unsigned i = 0; i < counts.size(); i++ ){
+    total += counts[i];
+    if( i < 10 ){ top += counts[i]; }
+  }
+  UINT64 probes = sim.fired[ProbeEnter] + sim.fired[ProbeAdd] + sim.fired[ProbeEnd] + sim.fired[ProbeRestart];
+  double run = (double)sim.blocksRun;
+
+  printf("{\"shape\":\"%s\",\"seed\":%u,\"blocks\":%u,\"edges\":%u,\"loops\":%u,\"irreducible\":%u,\"paths\":%llu,\"chords\":%u,"
+         "\"compute_us\":%.2f,\"block_sites\":%u,\"path_sites\":%u,\"adds\":%u,\"blocks_run\":%llu,"
+         "\"probes_per_block\":%.3f,\"adds_per_block\":%.3f,\"restarts_per_block\":%.3f,\"ends_per_block\":%.3f,"
+         "\"paths_run\":%u,\"top10_share\":%.3f,\"agree\":%s}\n",
+         s.name, seed, cfg.size(), cfg.numEdges(), loops.size(), irreducible, (unsigned long long)pp.numPaths, pp.numChords,
+         computeTime * 1e6, pp.numBlocks, (unsigned)pp.probes.size(), pp.numAdds, (unsigned long long)sim.blocksRun,
+         probes / run, sim.fired[ProbeAdd] / run, sim.fired[ProbeRestart] / run, sim.fired[ProbeEnd] / run,
+         (unsigned)counts.size(), total ? (double)top / total : 0.0, sim.agree ? "true" : "false");
+  fflush(stdout);
+  if( !sim.agree ){ fprintf(stderr,"PathBench: %s seed %u: a counted path does not regenerate to the blocks run\n", s.name, seed); }
+
+}
+
+static void usage(){
+  fprintf(stderr,"usage: PathBench [-seed n] [-runs blocks] [-shape name]\nshapes:");
+  for( unsigned i = 0; i < numShapes; i++ ){
+    fprintf(stderr," %s", shapes[i].name);
+  }
+  fprintf(stderr,"\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned seed = 1;
+  UINT64 budget = 4000000;
+  const char *only = 0;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-seed") && i + 1 < argc ){
+      seed = atoi(argv[++i]);
+    }else if( !strcmp(argv[i], "-runs") && i + 1 < argc ){
+      budget = strtoull(argv[++i], 0, 10);
+    }else if( !strcmp(argv[i], "-shape") && i + 1 < argc ){
+      only = argv[++i];
+    }else{
+      usage();
+    }
+  }
+
+  printf("{\"bench\":\"PathBench\",\"version\":1,\"seed\":%u,\"runs\":%llu}\n", seed, (unsigned long long)budget);
+  bool found = false;
+  for( unsigned i = 0; i < numShapes; i++ ){
+    if( only != 0 && strcmp(only, shapes[i].name) ){ continue; }
+    found = true;
+    for( unsigned k = 0; k < 4; k++ ){ bench(shapes[i], seed + k, budget); }
+  }
+  if( !found ){ usage(); }
+  return 0;
+
+}
@@ -0,0 +1,112 @@
+/*Scaling of whole-image analysis on IFR_WorkPool.
+ *
+ *Builds a synthetic image of routines as instruction records (sizes drawn
+ *from a heavy-tailed distribution, a few huge ones, like a real binary),
+ *then runs CFG construction, dominators, the dominator tree and
+ *dominance frontiers over every routine with 1, 2, 4, ... threads and
+ *reports wall time, speedup and how much work was stolen.
+ *
+ *  ./PoolBench [routines] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+#include "IFR_InsRecord.h"
+#include "IFR_Dominators.h"
+#include "IFR_DomTree.h"
+#include "IFR_DomFrontiers.h"
+#include "IFR_WorkPool.h"
+#include "IFR_Clock.h"
+#include "RoutineBuilder.h"
+
+using namespace std;
+
+class Result{
+public:
+  IFR_CFG cfg;
+  IFR_DomTree domTree;
+  IFR_DomFrontiers df;
+};
+
+static vector<IFR_RoutineCode> routines;
+static vector<Result *> results;
+
+static void analyze(unsigned item, void *){
+
+  Result *r = results[item];
+  routines[item].buildCFG(r->cfg);
+  IFR_Dominators doms;
+  doms.compute(r->cfg, DomAuto);
+  r->domTree.build(doms);
+  r->df.compute(r->cfg, r->domTree);
+
+}
+
+static bool bigger(unsigned a, unsigned b){
+  return routines[a].ins.size() > routines[b].ins.size();
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned n = argc > 1 ? atoi(argv[1]) : 20000;
+  unsigned maxThreads = argc > 2 ? atoi(argv[2]) : 8;
+
+  srand(1);
+  routines.resize(n);
+  unsigned long total = 0;
+  for( unsigned i = 0; i < n; i++ ){
+    unsigned size = (i % 1000 == 0) ? 20000 : 8u << (rand() % 8);
+    makeRoutine(0x100000 * (ADDRINT)(i + 1), size, routines[i]);
+    total += size;
+  }
+
+  vector<unsigned> items(n);
+  for( unsigned i = 0; i < n; i++ ){
+    items[i] = i;
+  }
+  sort(items.begin(), items.end(), bigger);
+
+  printf("%u routines, %lu instructions\n", n, total);
+  printf("%8s %12s %8s %10s %8s\n", "threads", "time", "speedup", "ns/ins", "stolen");
+
+  double base = 0;
+  unsigned checksum = 0;
+  for( unsigned t = 1; t <= maxThreads; t *= 2 ){
+
+    results.resize(n);
+    for( unsigned i = 0; i < n; i++ ){
+      results[i] = new Result();
+    }
+
+    IFR_WorkPool pool;
+    double t0 = IFR_Clock();
+    pool.start(t, items, analyze, 0);
+    pool.join();
+    double t1 = IFR_Clock();
+
+    unsigned stolen = 0;
+    for( unsigned w = 0; w < pool.numThreads(); w++ ){
+      stolen += pool.itemsStolen(w);
+    }
+
+    /*Every thread count must produce the same frontiers*/
+    unsigned sum = 0;
+    for( unsigned i = 0; i < n; i++ ){
+      sum += results[i]->df.numEntries() * 31 + results[i]->cfg.numEdges();
+      delete results[i];
+    }
+    if( t == 1 ){
+      base = t1 - t0;
+      checksum = sum;
+    }
+
+    printf("%8u %10.3fms %7.2fx %10.1f %8u%s\n", t, (t1 - t0) * 1e3, base / (t1 - t0),
+           (t1 - t0) * 1e9 / total, stolen, sum == checksum ? "" : "  MISMATCH");
+
+  }
+
+  return 0;
+
+}
@@ -0,0 +1,112 @@
+#ifndef _ROUTINE_BUILDER_H_
+#define _ROUTINE_BUILDER_H_
+
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+#include "IFR_InsRecord.h"
+
+/*Lays out a synthetic routine for the benchmarks, four bytes an
+ *instruction from base.  Jump targets are labels: newLabel() makes one,
+ *place() puts it at the next instruction, target() and newTable() say
+ *that the next instruction jumps to labels, and finish() patches the
+ *addresses in and adds the jump tables once the code is laid out.
+ */
+class RoutineBuilder{
+
+  std::vector<unsigned> labelIns;       //instruction a label is placed at
+  std::vector<unsigned> jumpIns;        //direct jumps and their labels
+  std::vector<unsigned> jumpLabel;
+  std::vector<unsigned> tableIns;       //indirect jumps, and their case labels
+  std::vector< std::vector<unsigned> > tableLabels;
+
+protected:
+
+  IFR_RoutineCode &code;
+  ADDRINT base;
+
+  RoutineBuilder(IFR_RoutineCode &c, ADDRINT address) : code(c){
+    base = address;
+  }
+
+  ADDRINT nextAddress() const { return base + 4 * code.ins.size(); }
+
+  unsigned newLabel(){
+    labelIns.push_back(IFR_RoutineCode::NoIns);
+    return labelIns.size() - 1;
+  }
+
+  void place(unsigned label){
+    labelIns[label] = code.ins.size();
+  }
+
+  /*The next instruction is a direct jump to label*/
+  void target(unsigned label){
+    jumpIns.push_back(code.ins.size());
+    jumpLabel.push_back(label);
+  }
+
+  /*The next instruction is an indirect jump through a table whose cases
+   *addCase() adds
+   */
+  unsigned newTable(){
+    tableIns.push_back(code.ins.size());
+    tableLabels.push_back(std::vector<unsigned>());
+    return tableIns.size() - 1;
+  }
+
+  void addCase(unsigned table, unsigned label){
+    tableLabels[table].push_back(label);
+  }
+
+  void finish(){
+
+    for( unsigned j = 0; j < jumpIns.size(); j++ ){
+      code.ins[ jumpIns[j] ].target = code.ins[ labelIns[ jumpLabel[j] ] ].address;
+    }
+    for( unsigned t = 0; t < tableIns.size(); t++ ){
+      std::vector<ADDRINT> targets;
+      for( unsigned c = 0; c < tableLabels[t].size(); c++ ){
+        targets.push_back( code.ins[ labelIns[ tableLabels[t][c] ] ].address );
+      }
+      std::sort(targets.begin(), targets.end());
+      targets.erase( std::unique(targets.begin(), targets.end()), targets.end() );
+      code.addTable(tableIns[t], targets);
+    }
+
+  }
+
+};
+
+/*A routine of n instructions at base with no labels to speak of:
+ *straight-line code with conditional branches forward (if/else) and
+ *backward (loops) within a window, the odd unconditional jump, and a
+ *return at the end.
+ */
+inline void makeRoutine(ADDRINT base, unsigned n, IFR_RoutineCode &code){
+
+  code.clear();
+  for( unsigned i = 0; i < n; i++ ){
+
+    ADDRINT a = base + 4 * i;
+    unsigned r = rand() % 100;
+    if( i + 1 == n ){
+      code.add(a, 4, InsReturn, 0);
+    }else if( r < 12 ){
+      unsigned window = 2 + rand() % 40;
+      unsigned t = (rand() % 3 == 0) ? (i > window ? i - window : 0) : std::min(i + window, n - 1);
+      code.add(a, 4, InsCondJump, base + 4 * t);
+    }else if( r < 14 ){
+      code.add(a, 4, InsJump, base + 4 * std::min(i + 1 + rand() % 20, n - 1));
+    }else if( r < 18 ){
+      code.add(a, 4, InsCall, 0x1000);
+    }else{
+      code.add(a, 4, InsOther, 0);
+    }
+
+  }
+
+}
+
+#endif
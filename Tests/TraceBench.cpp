@@ -0,0 +1,188 @@
+/*Compression and speed of the trace format (IFR_Trace.h) on synthetic
+ *access streams shaped like memory-bound loops:
+ *
+ *  stream   a[i] = b[i] + s * c[i] over large arrays
+ *  stencil  a 5-point stencil over a 2D grid, row by row
+ *  matmul   the inner product loop of a naive matrix multiply: one
+ *           operand walks a row, the other a column
+ *  chase    a linked list in random heap order, with stack spills
+ *  calls    short routines, each pushing and popping a few registers
+ *           and touching a global, called from a loop
+ *
+ *Streams are cut into frames the size of the Pin tool's default access
+ *buffer, encoded, decoded and checked against the originals.  Output is
+ *one JSON object per stream:
+ *
+ *  {"bench":"TraceBench","version":1,...}                          once
+ *  {"stream":...,"accesses":...,"bytes_per_access":...,
+ *   "vs_records":...,"vs_triples":...,"encode_maccess_s":...,
+ *   "decode_maccess_s":...}                                        per stream
+ *
+ *vs_records and vs_triples are how many times smaller the trace is than
+ *24-byte buffer records and than (tid, address, pc) triples.
+ *
+ *  ./TraceBench [-accesses n] [-frame records]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "IFR_Trace.h"
+#include "IFR_Clock.h"
+
+using namespace std;
+
+/*Appends accesses of one stream; block ids stand in for loop bodies*/
+class Stream{
+
+  vector<IFR_AccessRecord> &out;
+
+public:
+
+  Stream(vector<IFR_AccessRecord> &o) : out(o) {}
+
+  void access(UINT32 block, UINT32 ref, ADDRINT ea, UINT32 size, bool write){
+    IFR_AccessRecord r;
+    r.ea = ea;
+    r.block = block;
+    r.ref = ref;
+    r.size = size;
+    r.write = write;
+    out.push_back(r);
+  }
+
+};
+
+static const ADDRINT heap = 0x7f0000000000ULL;
+static const ADDRINT stack = 0x7ffffffde000ULL;
+static const ADDRINT globals = 0x601000;
+
+static void stream(Stream &s, unsigned n){
+  const ADDRINT a = heap, b = heap + 0x4000000, c = heap + 0x8000000;
+  for( unsigned i = 0; i < n / 3 + 1; i++ ){
+    s.access(40, 0, b + 8 * i, 8, false);
+    s.access(40, 1, c + 8 * i, 8, false);
+    s.access(40, 2, a + 8 * i, 8, true);
+  }
+}
+
+static void stencil(Stream &s, unsigned n){
+  const unsigned w = 1024;
+  const ADDRINT in = heap, out = heap + 8 * w * w;
+  for( unsigned k = 0; k < n / 6 + 1; k++ ){
+    unsigned i = 1 + (k / (w - 2)) % (w - 2), j = 1 + k % (w - 2);
+    ADDRINT at = 8 * (i * w + j);
+    s.access(7, 0, in + at, 8, false);
+    s.access(7, 1, in + at - 8, 8, false);
+    s.access(7, 2, in + at + 8, 8, false);
+    s.access(7, 3, in + at - 8 * w, 8, false);
+    s.access(7, 4, in + at + 8 * w, 8, false);
+    s.access(7, 5, out + at, 8, true);
+  }
+}
+
+static void matmul(Stream &s, unsigned n){
+  const unsigned m = 512;
+  const ADDRINT a = heap, b = heap + 8 * m * m, c = heap + 16 * m * m;
+  for( unsigned k = 0; k < n / 2 + 1; k++ ){
+    unsigned i = k / (m * m) % m, j = k / m % m, l = k % m;
+    s.access(12, 0, a + 8 * (i * m + l), 8, false);
+    s.access(12, 1, b + 8 * (l * m + j), 8, false);
+    if( l == m - 1 ){ s.access(13, 0, c + 8 * (i * m + j), 8, true); }
+  }
+}
+
+static void chase(Stream &s, unsigned n){
+  ADDRINT node = heap;
+  for( unsigned k = 0; k < n / 3 + 1; k++ ){
+    s.access(20, 0, node + 8, 8, false);                 //payload
+    s.access(20, 1, stack - 0x40, 8, true);              //spill
+    node = heap + (ADDRINT)(rand() % (1 << 20)) * 64;
+    s.access(20, 2, node, 8, false);                     //next
+  }
+}
+
+static void calls(Stream &s, unsigned n){
+  const ADDRINT sp = stack;
+  for( unsigned k = 0; k < n / 9 + 1; k++ ){
+    s.access(3, 0, globals + 8 * (k % 64), 4, false);
+    UINT32 callee = 100 + 10 * (k % 5);
+    s.access(3, 1, sp - 8, 8, true);                     //return address
+    for( unsigned r = 0; r < 3; r++ ){ s.access(callee, r, sp - 16 - 8 * r, 8, true); }
+    s.access(callee + 1, 0, globals + 0x400 + 8 * (k % 5), 8, true);
+    for( unsigned r = 0; r < 3; r++ ){ s.access(callee + 2, r, sp - 32 + 8 * r, 8, false); }
+  }
+}
+
+typedef void (*Generate)(Stream &, unsigned);
+
+static const char *names[] = { "stream", "stencil", "matmul", "chase", "calls" };
+static Generate generators[] = { stream, stencil, matmul, chase, calls };
+static const unsigned numStreams = sizeof(names) / sizeof(names[0]);
+
+static void usage(){
+  fprintf(stderr,"usage: TraceBench [-accesses n] [-frame records]\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+
+  unsigned total = 4000000, frame = 16384;
+  for( int i = 1; i < argc; i++ ){
+    if( !strcmp(argv[i], "-accesses") && i + 1 < argc ){ total = atoi(argv[++i]); }
+    else if( !strcmp(argv[i], "-frame") && i + 1 < argc ){ frame = atoi(argv[++i]); }
+    else{ usage(); }
+  }
+  if( frame == 0 ){ usage(); }
+
+  printf("{\"bench\":\"TraceBench\",\"version\":1,\"frame\":%u}\n", frame);
+  srand(1);
+  for( unsigned g = 0; g < numStreams; g++ ){
+
+    vector<IFR_AccessRecord> records;
+    Stream s(records);
+    generators[g](s, total);
+
+    IFR_TraceCoder coder;
+    vector< vector<unsigned char> > frames;
+    double t0 = IFR_Clock();
+    for( size_t at = 0; at < records.size(); at += frame ){
+      frames.push_back(vector<unsigned char>());
+      size_t count = records.size() - at < frame ? records.size() - at : frame;
+      coder.encode(1, frames.size() - 1, &records[at], count, frames.back());
+    }
+    double encodeTime = IFR_Clock() - t0;
+
+    size_t bytes = 0;
+    vector<IFR_AccessRecord> decoded;
+    UINT32 tid;
+    UINT64 seq;
+    bool same = true;
+    t0 = IFR_Clock();
+    for( size_t f = 0; f < frames.size(); f++ ){
+      bytes += frames[f].size() + 5;
+      same &= coder.decode(&frames[f][0], frames[f].size(), tid, seq, decoded) && tid == 1 && seq == f;
+      for( size_t i = 0; i < decoded.size() && same; i++ ){
+        const IFR_AccessRecord &a = decoded[i], &b = records[f * frame + i];
+        same = a.ea == b.ea && a.block == b.block && a.ref == b.ref && a.size == b.size && a.write == b.write;
+      }
+    }
+    double decodeTime = IFR_Clock() - t0;
+    if( !same ){
+      fprintf(stderr,"TraceBench: %s does not decode to what was encoded\n",names[g]);
+      return 1;
+    }
+
+    double perAccess = (double)bytes / records.size();
+    printf("{\"stream\":\"%s\",\"accesses\":%lu,\"bytes_per_access\":%.3f,\"vs_records\":%.1f,"
+           "\"vs_triples\":%.1f,\"encode_maccess_s\":%.1f,\"decode_maccess_s\":%.1f}\n",
+           names[g], (unsigned long)records.size(), perAccess, sizeof(IFR_AccessRecord) / perAccess,
+           (4 + 2 * sizeof(ADDRINT)) / perAccess, records.size() / encodeTime / 1e6,
+           records.size() / decodeTime / 1e6);
+    fflush(stdout);
+
+  }
+  return 0;
+
+}
@@ -0,0 +1,68 @@
+/*Array kernels for -accesses: almost every memory access is a strided
+ *reference in a counted loop.  Compare the event counts with
+ *-loop_ranges 1 and 0.
+ *
+ *  ./arrays [n] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 4096
+
+double a[N], b[N], c[N];
+double m[64][64];
+
+double sum(double *x, long n){
+  double s = 0;
+  long i;
+  for( i = 0; i < n; i++ ){
+    s += x[i];
+  }
+  return s;
+}
+
+void saxpy(double *y, double *x, double k, long n){
+  long i;
+  for( i = 0; i < n; i++ ){
+    y[i] += k * x[i];
+  }
+}
+
+void everyFourth(double *y, double *x, long n){
+  long i;
+  for( i = 0; i < n; i += 4 ){
+    y[i] = x[i];
+  }
+}
+
+void transpose(double t[64][64], double s[64][64]){
+  long i, j;
+  for( i = 0; i < 64; i++ ){
+    for( j = 0; j < 64; j++ ){
+      t[j][i] = s[i][j];
+    }
+  }
+}
+
+int main(int argc, char *argv[]){
+
+  long n = argc > 1 ? atol(argv[1]) : N;
+  long reps = argc > 2 ? atol(argv[2]) : 100;
+  long r, i;
+  double s = 0;
+  if( n > N ){ n = N; }
+
+  for( i = 0; i < n; i++ ){
+    a[i] = i;
+    b[i] = n - i;
+  }
+  for( r = 0; r < reps; r++ ){
+    saxpy(c, a, 0.5, n);
+    everyFourth(c, b, n);
+    s += sum(c, n);
+    transpose(m, m);
+  }
+  printf("%f\n", s);
+  return 0;
+
+}
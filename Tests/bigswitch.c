@@ -0,0 +1,100 @@
+/*A bytecode interpreter whose dispatch is one large switch, which the
+ *compiler lowers to a jump table: exercises jump table resolution and the
+ *passes on routines with a block of very high fan-out, and a loop whose
+ *every iteration goes through it.
+ *
+ *  ./bigswitch [instructions] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { NOP, PUSH, POP, DUP, SWAP, OVER, ADD, SUB, MUL, DIV, MOD, NEG,
+       AND, OR, XOR, NOT, SHL, SHR, INC, DEC, EQ, NE, LT, GT,
+       LE, GE, MIN, MAX, ABS, SQR, LOAD, STORE, JZ, JNZ, JMP, HALT,
+       NUM_OPS };
+
+#define STACK 256
+#define MEMORY 1024
+
+long run(const unsigned char *code, long n, long *mem){
+
+  long stack[STACK];
+  long sp = 1, pc = 0, steps = 0, t;
+  stack[0] = 0;
+
+  while( pc < n ){
+    unsigned char op = code[pc++];
+    steps++;
+    if( sp < 2 ){ stack[sp++] = steps; }
+    if( sp > STACK - 2 ){ sp = 2; }
+    switch( op ){
+      case NOP:   break;
+      case PUSH:  stack[sp++] = code[pc++ % n]; break;
+      case POP:   sp--; break;
+      case DUP:   stack[sp] = stack[sp - 1]; sp++; break;
+      case SWAP:  t = stack[sp - 1]; stack[sp - 1] = stack[sp - 2]; stack[sp - 2] = t; break;
+      case OVER:  stack[sp] = stack[sp - 2]; sp++; break;
+      case ADD:   sp--; stack[sp - 1] += stack[sp]; break;
+      case SUB:   sp--; stack[sp - 1] -= stack[sp]; break;
+      case MUL:   sp--; stack[sp - 1] *= stack[sp]; break;
+      case DIV:   sp--; stack[sp - 1] /= stack[sp] ? stack[sp] : 1; break;
+      case MOD:   sp--; stack[sp - 1] %= stack[sp] ? stack[sp] : 1; break;
+      case NEG:   stack[sp - 1] = -stack[sp - 1]; break;
+      case AND:   sp--; stack[sp - 1] &= stack[sp]; break;
+      case OR:    sp--; stack[sp - 1] |= stack[sp]; break;
+      case XOR:   sp--; stack[sp - 1] ^= stack[sp]; break;
+      case NOT:   stack[sp - 1] = ~stack[sp - 1]; break;
+      case SHL:   sp--; stack[sp - 1] <<= stack[sp] & 7; break;
+      case SHR:   sp--; stack[sp - 1] >>= stack[sp] & 7; break;
+      case INC:   stack[sp - 1]++; break;
+      case DEC:   stack[sp - 1]--; break;
+      case EQ:    sp--; stack[sp - 1] = stack[sp - 1] == stack[sp]; break;
+      case NE:    sp--; stack[sp - 1] = stack[sp - 1] != stack[sp]; break;
+      case LT:    sp--; stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+      case GT:    sp--; stack[sp - 1] = stack[sp - 1] > stack[sp]; break;
+      case LE:    sp--; stack[sp - 1] = stack[sp - 1] <= stack[sp]; break;
+      case GE:    sp--; stack[sp - 1] = stack[sp - 1] >= stack[sp]; break;
+      case MIN:   sp--; if( stack[sp] < stack[sp - 1] ){ stack[sp - 1] = stack[sp]; } break;
+      case MAX:   sp--; if( stack[sp] > stack[sp - 1] ){ stack[sp - 1] = stack[sp]; } break;
+      case ABS:   if( stack[sp - 1] < 0 ){ stack[sp - 1] = -stack[sp - 1]; } break;
+      case SQR:   stack[sp - 1] *= stack[sp - 1]; break;
+      case LOAD:  stack[sp - 1] = mem[stack[sp - 1] & (MEMORY - 1)]; break;
+      case STORE: sp--; mem[stack[sp] & (MEMORY - 1)] = stack[sp - 1]; break;
+      case JZ:    sp--; if( stack[sp] == 0 ){ pc += code[pc % n] % 8; } pc++; break;
+      case JNZ:   sp--; if( stack[sp] != 0 ){ pc += code[pc % n] % 8; } pc++; break;
+      case JMP:   pc += 1 + code[pc % n] % 8; break;
+      case HALT:  return stack[sp - 1] + steps;
+      default:    stack[sp - 1] += op; break;
+    }
+  }
+  return stack[sp - 1] + steps;
+
+}
+
+int main(int argc, char **argv){
+
+  long n = argc > 1 ? atol(argv[1]) : 1 << 20;
+  int reps = argc > 2 ? atoi(argv[2]) : 8;
+  unsigned char *code = malloc(n);
+  long *mem = calloc(MEMORY, sizeof(long));
+  long i, s = 0;
+  int r;
+
+  if( code == NULL || mem == NULL ){
+    fprintf(stderr,"bigswitch: out of memory\n");
+    return 1;
+  }
+  srand(1);
+  for( i = 0; i < n; i++ ){
+    code[i] = rand() % (NUM_OPS + 4);
+    if( code[i] == HALT ){ code[i] = NOP; }
+  }
+
+  for( r = 0; r < reps; r++ ){
+    s += run(code, n, mem);
+  }
+
+  printf("%ld\n", s);
+  return 0;
+
+}
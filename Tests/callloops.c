@@ -0,0 +1,63 @@
+/*Loops whose bodies are calls with register arguments, after a few reads
+ *of shared state, for measuring -hoist_ends: run it under
+ *
+ *  -ifrit -hoist_ends 0
+ *  -ifrit -hoist_ends 1
+ *
+ *and compare the boundary checks at Fini.  The reads before each loop
+ *leave IFRs active at its first call; nothing in the loop starts more.
+ *
+ *  ./callloops [threads] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+static volatile long scale = 3;
+static volatile long offset = 7;
+static volatile long rounds = 1000000;
+
+__attribute__((noinline)) static long mix(long x, long i){
+  return (x * 31 + i) ^ (x >> 7);
+}
+
+__attribute__((noinline)) static long fold(long x, long i){
+  return x + (i & 15);
+}
+
+static void *worker(void *arg){
+
+  long seed = (long)arg, x = seed * scale + offset, n = rounds, i;
+  for( i = 0; i < n; i++ ){
+    x = mix(x, i);
+  }
+
+  x += scale;
+  for( i = 0; i < n; i++ ){
+    x = fold(x, i);
+  }
+  return (void *)x;
+
+}
+
+int main(int argc, char **argv){
+
+  int threads = argc > 1 ? atoi(argv[1]) : 4;
+  pthread_t tids[64];
+  long sum = 0;
+  int t;
+
+  if( argc > 2 ){ rounds = atol(argv[2]); }
+  if( threads < 1 || threads > 64 ){ threads = 4; }
+  for( t = 0; t < threads; t++ ){
+    pthread_create(&tids[t], NULL, worker, (void *)(long)t);
+  }
+  for( t = 0; t < threads; t++ ){
+    void *r;
+    pthread_join(tids[t], &r);
+    sum += (long)r;
+  }
+  printf("%d threads, %ld rounds: %ld\n", threads, rounds, sum);
+  return 0;
+
+}
@@ -0,0 +1,126 @@
+/*Deeply nested loops for the loop forest, -loop_ranges and the dominator
+ *passes: a six deep tensor contraction, a blocked matrix multiply, and a
+ *scanner whose gotos enter one loop in two places (irreducible).
+ *
+ *  ./deeploops [n] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define B 8
+
+/*out[i][j][k] = sum over a,b,c of x[i][a][b] * y[b][c][j] * z[c][k]*/
+double contract(double *out, double *x, double *y, double *z, int n){
+  int i, j, k, a, b, c;
+  double s = 0;
+  for( i = 0; i < n; i++ ){
+    for( j = 0; j < n; j++ ){
+      for( k = 0; k < n; k++ ){
+        double t = 0;
+        for( a = 0; a < n; a++ ){
+          for( b = 0; b < n; b++ ){
+            for( c = 0; c < n; c++ ){
+              t += x[(i * n + a) * n + b] * y[(b * n + c) * n + j] * z[c * n + k];
+            }
+          }
+        }
+        out[(i * n + j) * n + k] = t;
+        s += t;
+      }
+    }
+  }
+  return s;
+}
+
+void blockedMultiply(double *c, double *a, double *b, int n){
+  int ii, jj, kk, i, j, k;
+  for( ii = 0; ii < n; ii += B ){
+    for( jj = 0; jj < n; jj += B ){
+      for( kk = 0; kk < n; kk += B ){
+        for( i = ii; i < ii + B && i < n; i++ ){
+          for( j = jj; j < jj + B && j < n; j++ ){
+            double t = c[i * n + j];
+            for( k = kk; k < kk + B && k < n; k++ ){
+              t += a[i * n + k] * b[k * n + j];
+            }
+            c[i * n + j] = t;
+          }
+        }
+      }
+    }
+  }
+}
+
+/*Counts words and digit runs; the loop is entered at the top or, when the
+ *buffer starts with a digit, in the middle
+ */
+long scan(const char *p, long n){
+  long words = 0, i = 0;
+  if( n > 0 && p[0] >= '0' && p[0] <= '9' ){
+    goto digits;
+  }
+  while( i < n ){
+    if( p[i] == ' ' ){
+      i++;
+      continue;
+    }
+    words++;
+    while( i < n && p[i] != ' ' && (p[i] < '0' || p[i] > '9') ){
+      i++;
+    }
+digits:
+    while( i < n && p[i] >= '0' && p[i] <= '9' ){
+      i++;
+    }
+  }
+  return words;
+}
+
+int main(int argc, char **argv){
+
+  int n = argc > 1 ? atoi(argv[1]) : 12;
+  int reps = argc > 2 ? atoi(argv[2]) : 4;
+  int m = n * 8, i, r;
+  long len = 1 << 16;
+  double *x = malloc(n * n * n * sizeof(double));
+  double *y = malloc(n * n * n * sizeof(double));
+  double *z = malloc(n * n * sizeof(double));
+  double *out = malloc(n * n * n * sizeof(double));
+  double *a = malloc(m * m * sizeof(double));
+  double *b = malloc(m * m * sizeof(double));
+  double *c = calloc(m * m, sizeof(double));
+  char *text = malloc(len);
+  double s = 0;
+  long words = 0;
+
+  if( x == NULL || y == NULL || z == NULL || out == NULL || a == NULL || b == NULL || c == NULL || text == NULL ){
+    fprintf(stderr,"deeploops: out of memory\n");
+    return 1;
+  }
+  for( i = 0; i < n * n * n; i++ ){
+    x[i] = i % 7;
+    y[i] = i % 5;
+  }
+  for( i = 0; i < n * n; i++ ){
+    z[i] = i % 3;
+  }
+  for( i = 0; i < m * m; i++ ){
+    a[i] = i % 11;
+    b[i] = i % 13;
+  }
+  srand(1);
+  for( i = 0; i < len; i++ ){
+    int k = rand() % 4;
+    text[i] = k == 0 ? ' ' : k == 1 ? '0' + rand() % 10 : 'a' + rand() % 26;
+  }
+
+  for( r = 0; r < reps; r++ ){
+    s += contract(out, x, y, z, n);
+    blockedMultiply(c, a, b, m);
+    words += scan(text + r, len - r);
+  }
+
+  printf("%g %g %ld\n", s, c[m * m - 1], words);
+  return 0;
+
+}
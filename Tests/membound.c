@@ -0,0 +1,70 @@
+/*Memory-bound kernel for comparing -accesses delivery: nearly every
+ *instruction touches memory, and little else happens between accesses.
+ *Run it under each mode and compare the access event rates at Fini:
+ *
+ *  -accesses -loop_ranges 0
+ *  -accesses -loop_ranges 0 -buffered
+ *  -accesses -loop_ranges 0 -buffered -buffer_consumer
+ *
+ *  ./membound [megabytes] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+/*Streaming: read one array, write another*/
+long copyScale(long *dst, long *src, long n){
+  long i, s = 0;
+  for( i = 0; i < n; i++ ){
+    dst[i] = 3 * src[i];
+    s += dst[i];
+  }
+  return s;
+}
+
+/*Dependent loads through a random cycle, so addresses are not strided*/
+long chase(long *next, long steps){
+  long p = 0, i;
+  for( i = 0; i < steps; i++ ){
+    p = next[p];
+  }
+  return p;
+}
+
+int main(int argc, char **argv){
+
+  long mb = argc > 1 ? atol(argv[1]) : 16;
+  int reps = argc > 2 ? atoi(argv[2]) : 4;
+  long n = mb * 1024 * 1024 / sizeof(long);
+  long *a = malloc(n * sizeof(long));
+  long *b = malloc(n * sizeof(long));
+  long i, s = 0;
+  int r;
+
+  if( a == NULL || b == NULL ){
+    fprintf(stderr,"membound: out of memory\n");
+    return 1;
+  }
+
+  /*Sattolo's shuffle: one cycle through every element*/
+  for( i = 0; i < n; i++ ){
+    a[i] = i;
+  }
+  srand(1);
+  for( i = n - 1; i > 0; i-- ){
+    long j = ((long)rand() * RAND_MAX + rand()) % i;
+    long t = a[i];
+    a[i] = a[j];
+    a[j] = t;
+  }
+
+  for( r = 0; r < reps; r++ ){
+    s += copyScale(b, a, n);
+    s += chase(a, n);
+  }
+
+  printf("%ld\n", s);
+  free(a);
+  free(b);
+  return 0;
+
+}
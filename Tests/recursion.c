@@ -0,0 +1,118 @@
+/*Recursive routines for the call graph: self recursion (fib, quicksort),
+ *mutual recursion forming one strongly connected component (a recursive
+ *descent expression parser), and leaf routines whose summaries let their
+ *callers' analyses see past the calls (-callgraph).
+ *
+ *  ./recursion [n] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+long fib(int n){
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+/*Leaf: touches nothing but registers*/
+static long mix(long a, long b){
+  return (a * 31) ^ (b >> 3);
+}
+
+void quicksort(long *a, long lo, long hi){
+  long i = lo, j = hi, pivot;
+  if( lo >= hi ){ return; }
+  pivot = a[(lo + hi) / 2];
+  while( i <= j ){
+    while( a[i] < pivot ){ i++; }
+    while( a[j] > pivot ){ j--; }
+    if( i <= j ){
+      long t = a[i];
+      a[i] = a[j];
+      a[j] = t;
+      i++;
+      j--;
+    }
+  }
+  quicksort(a, lo, j);
+  quicksort(a, i, hi);
+}
+
+/*expr := term {+ term}; term := factor {* factor}; factor := digit | (expr)*/
+static const char *p;
+long expr(void);
+
+long factor(void){
+  long v;
+  if( *p == '(' ){
+    p++;
+    v = expr();
+    if( *p == ')' ){ p++; }
+    return v;
+  }
+  v = *p >= '0' && *p <= '9' ? *p - '0' : 0;
+  if( *p ){ p++; }
+  return v;
+}
+
+long term(void){
+  long v = factor();
+  while( *p == '*' ){
+    p++;
+    v = mix(v, factor());
+  }
+  return v;
+}
+
+long expr(void){
+  long v = term();
+  while( *p == '+' ){
+    p++;
+    v += term();
+  }
+  return v;
+}
+
+/*Random well-formed expression of the given depth into s; returns its end*/
+char *generate(char *s, int depth){
+  if( depth == 0 || rand() % 3 == 0 ){
+    *s++ = '0' + rand() % 10;
+    return s;
+  }
+  *s++ = '(';
+  s = generate(s, depth - 1);
+  *s++ = rand() % 2 ? '+' : '*';
+  s = generate(s, depth - 1);
+  *s++ = ')';
+  return s;
+}
+
+int main(int argc, char **argv){
+
+  int n = argc > 1 ? atoi(argv[1]) : 24;
+  int reps = argc > 2 ? atoi(argv[2]) : 4;
+  long len = 1L << 16, i, s = 0;
+  long *a = malloc(len * sizeof(long));
+  char *text = malloc(1 << 20);
+  int r;
+
+  if( a == NULL || text == NULL ){
+    fprintf(stderr,"recursion: out of memory\n");
+    return 1;
+  }
+  srand(1);
+  *generate(text, 16) = '\0';
+
+  for( r = 0; r < reps; r++ ){
+    s += fib(n);
+    for( i = 0; i < len; i++ ){
+      a[i] = rand();
+    }
+    quicksort(a, 0, len - 1);
+    s += a[len / 2];
+    p = text;
+    s += expr();
+  }
+
+  printf("%ld\n", s);
+  return 0;
+
+}
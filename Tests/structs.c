@@ -0,0 +1,90 @@
+/*Struct-heavy code, where most accesses are fields off one pointer and
+ *spills off the frame pointer, for measuring -coalesce: run it under
+ *
+ *  -accesses -coalesce 0
+ *  -accesses -coalesce 1
+ *
+ *and compare the access events and the operand checks coalesced at Fini.
+ *
+ *  ./structs [orders] [reps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+struct order{
+  long id;
+  long customer;
+  int quantity;
+  int status;
+  double price;
+  double discount;
+  double tax;
+  double total;
+  struct order *next;
+};
+
+struct summary{
+  long count;
+  long items;
+  double revenue;
+  double taxes;
+  double largest;
+  long open;
+  long shipped;
+};
+
+/*Every field of one order, read and written in one straight block*/
+static void price(struct order *o){
+  double gross = o->quantity * o->price;
+  o->discount = o->quantity > 10 ? 0.05 * gross : 0;
+  o->tax = 0.08 * (gross - o->discount);
+  o->total = gross - o->discount + o->tax;
+}
+
+static void tally(struct summary *s, const struct order *o){
+  s->count++;
+  s->items += o->quantity;
+  s->revenue += o->total;
+  s->taxes += o->tax;
+  if( o->total > s->largest ){ s->largest = o->total; }
+  s->open += o->status == 0;
+  s->shipped += o->status == 2;
+}
+
+int main(int argc, char **argv){
+
+  long n = argc > 1 ? atol(argv[1]) : 200000;
+  int reps = argc > 2 ? atoi(argv[2]) : 20;
+  struct order *orders = malloc(n * sizeof(struct order));
+  struct summary s = { 0, 0, 0, 0, 0, 0, 0 };
+  struct order *o;
+  long i;
+  int r;
+
+  if( orders == NULL ){
+    fprintf(stderr,"structs: out of memory\n");
+    return 1;
+  }
+
+  for( i = 0; i < n; i++ ){
+    orders[i].id = i;
+    orders[i].customer = rand() % 1000;
+    orders[i].quantity = 1 + rand() % 20;
+    orders[i].status = rand() % 3;
+    orders[i].price = (rand() % 10000) / 100.0;
+    orders[i].next = i + 1 < n ? &orders[i + 1] : NULL;
+  }
+
+  for( r = 0; r < reps; r++ ){
+    for( o = orders; o != NULL; o = o->next ){
+      price(o);
+      tally(&s, o);
+    }
+  }
+
+  printf("%ld orders, %ld items, revenue %.2f, taxes %.2f, largest %.2f, %ld open, %ld shipped\n",
+         s.count, s.items, s.revenue, s.taxes, s.largest, s.open, s.shipped);
+  free(orders);
+  return 0;
+
+}